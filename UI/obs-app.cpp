@@ -449,6 +449,9 @@ bool OBSApp::InitGlobalConfigDefaults()
 	config_set_default_bool(globalConfig, "BasicWindow",
 				"MultiviewDrawAreas", true);
 
+	config_set_default_bool(globalConfig, "Audio", "ParallelRender", true);
+	config_set_default_bool(globalConfig, "Video", "ParallelInputs", false);
+
 #ifdef _WIN32
 	uint32_t winver = GetWindowsVersion();
 
@@ -1281,7 +1284,13 @@ static bool StartupOBS(const char *locale, profiler_name_store_t *store)
 	if (GetConfigPath(path, sizeof(path), "obs-studio/plugin_config") <= 0)
 		return false;
 
-	return obs_startup(locale, path, store);
+	if (!obs_startup(locale, path, store))
+		return false;
+
+	if (GetConfigPath(path, sizeof(path), "obs-studio/shader_cache") > 0)
+		obs_set_shader_cache_path(path);
+
+	return true;
 }
 
 inline void OBSApp::ResetHotkeyState(bool inFocus)
@@ -1734,6 +1743,7 @@ static auto ProfilerFree = [](void *) {
 
 	profiler_print(snap.get());
 	profiler_print_time_between_calls(snap.get());
+	profiler_print_values();
 
 	SaveProfilerData(snap);
 
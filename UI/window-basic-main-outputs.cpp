@@ -787,6 +787,8 @@ bool SimpleOutput::StartStreaming(obs_service_t *service)
 	int delaySec = config_get_int(main->Config(), "Output", "DelaySec");
 	bool preserveDelay =
 		config_get_bool(main->Config(), "Output", "DelayPreserve");
+	int delayMemMax =
+		config_get_int(main->Config(), "Output", "DelayMemoryMax");
 	const char *bindIP =
 		config_get_string(main->Config(), "Output", "BindIP");
 	bool enableNewSocketLoop = config_get_bool(main->Config(), "Output",
@@ -811,6 +813,9 @@ bool SimpleOutput::StartStreaming(obs_service_t *service)
 
 	obs_output_set_delay(streamOutput, useDelay ? delaySec : 0,
 			     preserveDelay ? OBS_OUTPUT_DELAY_PRESERVE : 0);
+	obs_output_set_delay_memory_limit(
+		streamOutput, (uint64_t)delayMemMax * 1024 * 1024,
+		config_get_string(main->Config(), "SimpleOutput", "FilePath"));
 
 	obs_output_set_reconnect_settings(streamOutput, maxRetries, retryDelay);
 
@@ -904,6 +909,8 @@ bool SimpleOutput::ConfigureRecording(bool updateReplayBuffer)
 		config_get_int(main->Config(), "SimpleOutput", "RecRBTime");
 	int rbSize =
 		config_get_int(main->Config(), "SimpleOutput", "RecRBSize");
+	bool rbDiskBuffer = config_get_bool(main->Config(), "SimpleOutput",
+					    "RecRBDiskBuffer");
 
 	os_dir_t *dir = path && path[0] ? os_opendir(path) : nullptr;
 
@@ -960,6 +967,7 @@ bool SimpleOutput::ConfigureRecording(bool updateReplayBuffer)
 		obs_data_set_int(settings, "max_time_sec", rbTime);
 		obs_data_set_int(settings, "max_size_mb",
 				 usingRecordingPreset ? rbSize : 0);
+		obs_data_set_bool(settings, "disk_buffer", rbDiskBuffer);
 	} else {
 		obs_data_set_string(settings, ffmpegOutput ? "url" : "path",
 				    strPath.c_str());
@@ -1639,6 +1647,8 @@ bool AdvancedOutput::StartStreaming(obs_service_t *service)
 	int delaySec = config_get_int(main->Config(), "Output", "DelaySec");
 	bool preserveDelay =
 		config_get_bool(main->Config(), "Output", "DelayPreserve");
+	int delayMemMax =
+		config_get_int(main->Config(), "Output", "DelayMemoryMax");
 	const char *bindIP =
 		config_get_string(main->Config(), "Output", "BindIP");
 	bool enableNewSocketLoop = config_get_bool(main->Config(), "Output",
@@ -1663,6 +1673,9 @@ bool AdvancedOutput::StartStreaming(obs_service_t *service)
 
 	obs_output_set_delay(streamOutput, useDelay ? delaySec : 0,
 			     preserveDelay ? OBS_OUTPUT_DELAY_PRESERVE : 0);
+	obs_output_set_delay_memory_limit(
+		streamOutput, (uint64_t)delayMemMax * 1024 * 1024,
+		config_get_string(main->Config(), "AdvOut", "RecFilePath"));
 
 	obs_output_set_reconnect_settings(streamOutput, maxRetries, retryDelay);
 
@@ -1818,6 +1831,8 @@ bool AdvancedOutput::StartReplayBuffer()
 					     "RecRBSuffix");
 		rbTime = config_get_int(main->Config(), "AdvOut", "RecRBTime");
 		rbSize = config_get_int(main->Config(), "AdvOut", "RecRBSize");
+		bool rbDiskBuffer = config_get_bool(main->Config(), "AdvOut",
+						    "RecRBDiskBuffer");
 
 		os_dir_t *dir = path && path[0] ? os_opendir(path) : nullptr;
 
@@ -1874,6 +1889,7 @@ bool AdvancedOutput::StartReplayBuffer()
 		obs_data_set_int(settings, "max_time_sec", rbTime);
 		obs_data_set_int(settings, "max_size_mb",
 				 usesBitrate ? 0 : rbSize);
+		obs_data_set_bool(settings, "disk_buffer", rbDiskBuffer);
 
 		obs_output_update(replayBuffer, settings);
 
@@ -1234,6 +1234,8 @@ bool OBSBasic::InitBasicConfigDefaults()
 	config_set_default_bool(basicConfig, "SimpleOutput", "RecRB", false);
 	config_set_default_int(basicConfig, "SimpleOutput", "RecRBTime", 20);
 	config_set_default_int(basicConfig, "SimpleOutput", "RecRBSize", 512);
+	config_set_default_bool(basicConfig, "SimpleOutput", "RecRBDiskBuffer",
+				false);
 	config_set_default_string(basicConfig, "SimpleOutput", "RecRBPrefix",
 				  "Replay");
 
@@ -1274,6 +1276,8 @@ bool OBSBasic::InitBasicConfigDefaults()
 	config_set_default_bool(basicConfig, "AdvOut", "RecRB", false);
 	config_set_default_uint(basicConfig, "AdvOut", "RecRBTime", 20);
 	config_set_default_int(basicConfig, "AdvOut", "RecRBSize", 512);
+	config_set_default_bool(basicConfig, "AdvOut", "RecRBDiskBuffer",
+				false);
 
 	config_set_default_uint(basicConfig, "Video", "BaseCX", cx);
 	config_set_default_uint(basicConfig, "Video", "BaseCY", cy);
@@ -1292,6 +1296,7 @@ bool OBSBasic::InitBasicConfigDefaults()
 	config_set_default_bool(basicConfig, "Output", "DelayEnable", false);
 	config_set_default_uint(basicConfig, "Output", "DelaySec", 20);
 	config_set_default_bool(basicConfig, "Output", "DelayPreserve", true);
+	config_set_default_uint(basicConfig, "Output", "DelayMemoryMax", 0);
 
 	config_set_default_bool(basicConfig, "Output", "Reconnect", true);
 	config_set_default_uint(basicConfig, "Output", "RetryDelay", 10);
@@ -1570,6 +1575,11 @@ void OBSBasic::OBSInit()
 	if (!ResetAudio())
 		throw "Failed to initialize audio";
 
+	obs_set_parallel_audio_render(config_get_bool(
+		App()->GlobalConfig(), "Audio", "ParallelRender"));
+	obs_set_parallel_video_inputs(config_get_bool(
+		App()->GlobalConfig(), "Video", "ParallelInputs"));
+
 	ret = ResetVideo();
 
 	switch (ret) {
@@ -315,6 +315,11 @@ static int decode_packet(struct mp_decode *d, int *got_frame)
 			return ret;
 		}
 
+		/* frames handed out by reference may still use the buffers
+		 * of the previous transfer, so let FFmpeg allocate new ones
+		 * instead of writing into them */
+		av_frame_unref(d->sw_frame);
+
 		int err = av_hwframe_transfer_data(d->sw_frame, d->hw_frame, 0);
 		if (err != 0) {
 			ret = 0;
@@ -318,6 +318,12 @@ static void mp_media_next_audio(mp_media_t *m)
 	m->a_cb(m->opaque, &audio);
 }
 
+static void mp_media_release_frame(void *param)
+{
+	AVFrame *f = param;
+	av_frame_free(&f);
+}
+
 static void mp_media_next_video(mp_media_t *m, bool preload)
 {
 	struct mp_decode *d = &m->v;
@@ -411,10 +417,24 @@ static void mp_media_next_video(mp_media_t *m, bool preload)
 		d->got_first_keyframe = true;
 	}
 
-	if (preload)
+	if (preload) {
 		m->v_preload_cb(m->opaque, frame);
-	else
-		m->v_cb(m->opaque, frame);
+		return;
+	}
+
+	/* hand a reference to the decoded buffers to the callback instead of
+	 * having the frame copied, the decoder allocates new buffers for the
+	 * frames after this one */
+	if (m->v_owned_cb && !m->swscale && f->buf[0]) {
+		AVFrame *ref = av_frame_clone(f);
+		if (ref) {
+			m->v_owned_cb(m->opaque, frame, mp_media_release_frame,
+				      ref);
+			return;
+		}
+	}
+
+	m->v_cb(m->opaque, frame);
 }
 
 static void mp_media_calc_next_ns(mp_media_t *m)
@@ -725,6 +745,7 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 	pthread_mutex_init_value(&media->mutex);
 	media->opaque = info->opaque;
 	media->v_cb = info->v_cb;
+	media->v_owned_cb = info->v_owned_cb;
 	media->a_cb = info->a_cb;
 	media->stop_cb = info->stop_cb;
 	media->v_preload_cb = info->v_preload_cb;
@@ -39,6 +39,9 @@ extern "C" {
 #endif
 
 typedef void (*mp_video_cb)(void *opaque, struct obs_source_frame *frame);
+typedef void (*mp_video_owned_cb)(void *opaque, struct obs_source_frame *frame,
+				  obs_source_frame_release_t release,
+				  void *param);
 typedef void (*mp_audio_cb)(void *opaque, struct obs_source_audio *audio);
 typedef void (*mp_stop_cb)(void *opaque);
 
@@ -48,6 +51,7 @@ struct mp_media {
 	mp_video_cb v_preload_cb;
 	mp_stop_cb stop_cb;
 	mp_video_cb v_cb;
+	mp_video_owned_cb v_owned_cb;
 	mp_audio_cb a_cb;
 	void *opaque;
 
@@ -103,6 +107,7 @@ struct mp_media_info {
 	void *opaque;
 
 	mp_video_cb v_cb;
+	mp_video_owned_cb v_owned_cb;
 	mp_video_cb v_preload_cb;
 	mp_audio_cb a_cb;
 	mp_stop_cb stop_cb;
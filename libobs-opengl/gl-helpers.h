@@ -209,6 +209,22 @@ static inline bool gl_get_integer_v(GLenum pname, GLint *params)
 	return gl_success("glGetIntegerv");
 }
 
+/* 64-bit FNV-1a, used to name cached program binaries */
+static inline uint64_t gl_hash_str(uint64_t hash, const char *str)
+{
+	if (!str)
+		return hash;
+
+	for (; *str; str++) {
+		hash ^= (uint8_t)*str;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+#define GL_HASH_SEED 0xcbf29ce484222325ULL
+
 extern bool gl_init_face(GLenum target, GLenum type, uint32_t num_levels,
 			 GLenum format, GLint internal_format, bool compressed,
 			 uint32_t width, uint32_t height, uint32_t size,
@@ -22,6 +22,9 @@
 #include <graphics/vec4.h>
 #include <graphics/matrix3.h>
 #include <graphics/matrix4.h>
+#include <util/file-serializer.h>
+#include <util/platform.h>
+#include <util/dstr.h>
 #include "gl-subsystem.h"
 #include "gl-shaderparser.h"
 
@@ -37,6 +40,35 @@ static inline void shader_param_free(struct gs_shader_param *param)
 	da_free(param->def_value);
 }
 
+static size_t shader_param_size(enum gs_shader_param_type type)
+{
+	switch ((uint32_t)type) {
+	case GS_SHADER_PARAM_FLOAT:
+		return sizeof(float);
+	case GS_SHADER_PARAM_BOOL:
+	case GS_SHADER_PARAM_INT:
+		return sizeof(int);
+	case GS_SHADER_PARAM_INT2:
+		return sizeof(int) * 2;
+	case GS_SHADER_PARAM_INT3:
+		return sizeof(int) * 3;
+	case GS_SHADER_PARAM_INT4:
+		return sizeof(int) * 4;
+	case GS_SHADER_PARAM_VEC2:
+		return sizeof(float) * 2;
+	case GS_SHADER_PARAM_VEC3:
+		return sizeof(float) * 3;
+	case GS_SHADER_PARAM_VEC4:
+		return sizeof(float) * 4;
+	case GS_SHADER_PARAM_MATRIX4X4:
+		return sizeof(float) * 4 * 4;
+	case GS_SHADER_PARAM_TEXTURE:
+		return sizeof(void *);
+	}
+
+	return 0;
+}
+
 static inline void shader_attrib_free(struct shader_attrib *attrib)
 {
 	bfree(attrib->name);
@@ -65,11 +97,13 @@ static void gl_get_shader_info(GLuint shader, const char *file,
 		bfree(errors);
 }
 
-static bool gl_add_param(struct gs_shader *shader, struct shader_var *var,
+static bool gl_add_param(struct gs_shader *shader,
+			 struct gl_shader_parser *glsp, struct shader_var *var,
 			 GLint *texture_id)
 {
 	struct gs_shader_param param = {0};
 
+	param.in_block = gl_is_block_param(glsp, var);
 	param.array_count = var->array_count;
 	param.name = bstrdup(var->name);
 	param.shader = shader;
@@ -96,7 +130,7 @@ static inline bool gl_add_params(struct gs_shader *shader,
 	GLint tex_id = 0;
 
 	for (i = 0; i < glsp->parser.params.num; i++)
-		if (!gl_add_param(shader, glsp->parser.params.array + i,
+		if (!gl_add_param(shader, glsp, glsp->parser.params.array + i,
 				  &tex_id))
 			return false;
 
@@ -201,6 +235,9 @@ static bool gl_shader_init(struct gs_shader *shader,
 	if (!gl_success("glCreateShader") || !shader->obj)
 		return false;
 
+	shader->hash = gl_hash_str(GL_HASH_SEED, glsp->gl_string.array);
+	shader->block_name = glsp->block_name;
+
 	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array,
 		       0);
 	if (!gl_success("glShaderSource"))
@@ -457,11 +494,164 @@ static inline bool validate_param(struct program_param *pp,
 	return true;
 }
 
+static void program_set_block_param(struct program_param *pp)
+{
+	struct program_block *block = pp->block;
+	size_t size = shader_param_size(pp->param->type);
+	uint8_t *dst;
+
+	if (!validate_param(pp, size) || pp->offset + size > block->data.num)
+		return;
+
+	/* blocks are only uploaded again if a parameter actually changed */
+	dst = block->data.array + pp->offset;
+	if (memcmp(dst, pp->param->cur_value.array, size) == 0)
+		return;
+
+	memcpy(dst, pp->param->cur_value.array, size);
+	block->dirty = true;
+}
+
+/*
+ *   Parameter blocks of all programs are streamed into one uniform buffer.
+ * Each upload is appended after the previous one and bound with
+ * glBindBufferRange, so a block that changes between two draws never
+ * overwrites data a draw in flight still reads.  Writes are unsynchronized,
+ * and once the buffer is full its storage is orphaned with glBufferData, so
+ * the driver never has to wait for the GPU or copy the buffer.
+ */
+
+#define UNIFORM_RING_SIZE (1024 * 1024)
+
+static bool uniform_ring_init(struct gs_device *device)
+{
+	GLint align = 0;
+
+	if (!gl_get_integer_v(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align) ||
+	    align <= 0)
+		return false;
+	if (!gl_create_buffer(GL_UNIFORM_BUFFER, &device->uniform_ring,
+			      UNIFORM_RING_SIZE, NULL, GL_STREAM_DRAW))
+		return false;
+
+	device->uniform_ring_align = (size_t)align;
+	device->uniform_ring_pos = 0;
+	device->uniform_ring_generation = 1;
+
+	for (size_t i = 0; i < GL_PARAMS_BINDING_COUNT; i++)
+		device->cur_uniform_offsets[i] = SIZE_MAX;
+	return true;
+}
+
+static bool uniform_ring_orphan(struct gs_device *device)
+{
+	glBufferData(GL_UNIFORM_BUFFER, UNIFORM_RING_SIZE, NULL,
+		     GL_STREAM_DRAW);
+	if (!gl_success("glBufferData"))
+		return false;
+
+	/* every block written so far has to be written again */
+	device->uniform_ring_pos = 0;
+	device->uniform_ring_generation++;
+
+	for (size_t i = 0; i < GL_PARAMS_BINDING_COUNT; i++)
+		device->cur_uniform_offsets[i] = SIZE_MAX;
+	return true;
+}
+
+static bool uniform_ring_write(struct gs_device *device,
+			       struct program_block *block)
+{
+	const GLbitfield access = GL_MAP_WRITE_BIT |
+				  GL_MAP_INVALIDATE_RANGE_BIT |
+				  GL_MAP_UNSYNCHRONIZED_BIT;
+	size_t align = device->uniform_ring_align;
+	size_t size = block->data.num;
+	size_t pos = (device->uniform_ring_pos + align - 1) / align * align;
+	bool success = false;
+	void *ptr;
+
+	if (!gl_bind_buffer(GL_UNIFORM_BUFFER, device->uniform_ring))
+		return false;
+
+	if (pos + size > UNIFORM_RING_SIZE) {
+		if (!uniform_ring_orphan(device))
+			goto exit;
+		pos = 0;
+	}
+
+	ptr = glMapBufferRange(GL_UNIFORM_BUFFER, pos, size, access);
+	if (!gl_success("glMapBufferRange") || !ptr)
+		goto exit;
+
+	memcpy(ptr, block->data.array, size);
+	glUnmapBuffer(GL_UNIFORM_BUFFER);
+
+	block->ring_offset = pos;
+	block->ring_generation = device->uniform_ring_generation;
+	device->uniform_ring_pos = pos + size;
+	success = true;
+
+exit:
+	gl_bind_buffer(GL_UNIFORM_BUFFER, 0);
+	return success;
+}
+
+static void program_upload_block(struct gs_program *program,
+				 struct program_block *block)
+{
+	struct gs_device *device = program->device;
+
+	if (!block->data.num)
+		return;
+
+	if (block->dirty ||
+	    block->ring_generation != device->uniform_ring_generation) {
+		if (!uniform_ring_write(device, block))
+			return;
+		block->dirty = false;
+	}
+
+	if (device->cur_uniform_offsets[block->binding] != block->ring_offset) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, block->binding,
+				  device->uniform_ring, block->ring_offset,
+				  block->data.num);
+		if (gl_success("glBindBufferRange"))
+			device->cur_uniform_offsets[block->binding] =
+				block->ring_offset;
+	}
+}
+
+static void program_upload_blocks(struct gs_program *program)
+{
+	struct gs_device *device = program->device;
+	uint32_t generation;
+
+	if (!device->uniform_ring && !uniform_ring_init(device))
+		return;
+
+	generation = device->uniform_ring_generation;
+
+	for (size_t i = 0; i < GL_PARAMS_BINDING_COUNT; i++)
+		program_upload_block(program, program->blocks + i);
+
+	/* orphaning the ring discards the blocks written before it */
+	if (generation != device->uniform_ring_generation) {
+		for (size_t i = 0; i < GL_PARAMS_BINDING_COUNT; i++)
+			program_upload_block(program, program->blocks + i);
+	}
+}
+
 static void program_set_param_data(struct gs_program *program,
 				   struct program_param *pp)
 {
 	void *array = pp->param->cur_value.array;
 
+	if (pp->block) {
+		program_set_block_param(pp);
+		return;
+	}
+
 	if (pp->param->type == GS_SHADER_PARAM_BOOL ||
 	    pp->param->type == GS_SHADER_PARAM_INT) {
 		if (validate_param(pp, sizeof(int))) {
@@ -536,6 +726,8 @@ void program_update_params(struct gs_program *program)
 		struct program_param *pp = program->params.array + i;
 		program_set_param_data(program, pp);
 	}
+
+	program_upload_blocks(program);
 }
 
 static void print_link_errors(GLuint program)
@@ -589,10 +781,81 @@ static inline bool assign_program_attribs(struct gs_program *program)
 	return true;
 }
 
+static bool assign_program_block_param(struct gs_program *program,
+				       struct program_block *block,
+				       struct gs_shader_param *param)
+{
+	struct program_param info = {0};
+	struct dstr name = {0};
+	const GLchar *name_ptr;
+	GLuint index = GL_INVALID_INDEX;
+	GLint offset = -1;
+
+	/* the whole block was optimized out */
+	if (!block->data.num)
+		return true;
+
+	dstr_printf(&name, "%s.%s", param->shader->block_name, param->name);
+	name_ptr = name.array;
+	glGetUniformIndices(program->obj, 1, &name_ptr, &index);
+	dstr_free(&name);
+
+	if (!gl_success("glGetUniformIndices"))
+		return false;
+	if (index == GL_INVALID_INDEX)
+		return true;
+
+	glGetActiveUniformsiv(program->obj, 1, &index, GL_UNIFORM_OFFSET,
+			      &offset);
+	if (!gl_success("glGetActiveUniformsiv") || offset < 0)
+		return false;
+
+	info.obj = -1;
+	info.param = param;
+	info.block = block;
+	info.offset = (size_t)offset;
+	da_push_back(program->params, &info);
+	return true;
+}
+
+static bool assign_program_block(struct gs_program *program,
+				 struct gs_shader *shader, GLuint binding)
+{
+	struct program_block *block = program->blocks + binding;
+	GLuint index;
+	GLint size = 0;
+
+	block->binding = binding;
+
+	index = glGetUniformBlockIndex(program->obj, shader->block_name);
+	if (!gl_success("glGetUniformBlockIndex"))
+		return false;
+	if (index == GL_INVALID_INDEX)
+		return true;
+
+	glGetActiveUniformBlockiv(program->obj, index,
+				  GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+	if (!gl_success("glGetActiveUniformBlockiv") || size <= 0)
+		return false;
+
+	glUniformBlockBinding(program->obj, index, binding);
+	if (!gl_success("glUniformBlockBinding"))
+		return false;
+
+	da_resize(block->data, size);
+	memset(block->data.array, 0, size);
+	block->dirty = true;
+	return true;
+}
+
 static bool assign_program_param(struct gs_program *program,
+				 struct program_block *block,
 				 struct gs_shader_param *param)
 {
-	struct program_param info;
+	struct program_param info = {0};
+
+	if (param->in_block)
+		return assign_program_block_param(program, block, param);
 
 	info.obj = glGetUniformLocation(program->obj, param->name);
 	if (!gl_success("glGetUniformLocation"))
@@ -608,11 +871,17 @@ static bool assign_program_param(struct gs_program *program,
 }
 
 static inline bool assign_program_shader_params(struct gs_program *program,
-						struct gs_shader *shader)
+						struct gs_shader *shader,
+						GLuint binding)
 {
+	struct program_block *block = program->blocks + binding;
+
+	if (!assign_program_block(program, shader, binding))
+		return false;
+
 	for (size_t i = 0; i < shader->params.num; i++) {
 		struct gs_shader_param *param = shader->params.array + i;
-		if (!assign_program_param(program, param))
+		if (!assign_program_param(program, block, param))
 			return false;
 	}
 
@@ -621,58 +890,187 @@ static inline bool assign_program_shader_params(struct gs_program *program,
 
 static inline bool assign_program_params(struct gs_program *program)
 {
-	if (!assign_program_shader_params(program, program->vertex_shader))
+	if (!assign_program_shader_params(program, program->vertex_shader,
+					  GL_PARAMS_BINDING_VERTEX))
 		return false;
-	if (!assign_program_shader_params(program, program->pixel_shader))
+	if (!assign_program_shader_params(program, program->pixel_shader,
+					  GL_PARAMS_BINDING_PIXEL))
 		return false;
 
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+#define PROGRAM_BINARY_MAGIC 0x4e42474f /* "OGBN" */
+#define MAX_PROGRAM_BINARY_SIZE (64 * 1024 * 1024)
+
+struct program_binary_header {
+	uint32_t magic;
+	uint32_t format;
+	uint64_t renderer_hash;
+	uint32_t size;
+};
+
+static inline void get_program_binary_path(struct dstr *path,
+					   struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
-	int linked = false;
+	dstr_printf(path, "%s/gl-%016llx-%016llx-%016llx.bin",
+		    program->device->cache_path,
+		    (unsigned long long)program->device->renderer_hash,
+		    (unsigned long long)program->vertex_shader->hash,
+		    (unsigned long long)program->pixel_shader->hash);
+}
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
+static bool program_load_binary(struct gs_program *program)
+{
+	struct gs_device *device = program->device;
+	struct program_binary_header header;
+	struct serializer s;
+	struct dstr path = {0};
+	uint8_t *data = NULL;
+	GLint linked = GL_FALSE;
+
+	if (!device->cache_path)
+		return false;
 
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	get_program_binary_path(&path, program);
+	if (!file_input_serializer_init(&s, path.array)) {
+		dstr_free(&path);
+		return false;
+	}
+
+	if (s_read(&s, &header, sizeof(header)) == sizeof(header) &&
+	    header.magic == PROGRAM_BINARY_MAGIC &&
+	    header.renderer_hash == device->renderer_hash && header.size &&
+	    header.size <= MAX_PROGRAM_BINARY_SIZE) {
+		data = bmalloc(header.size);
+
+		if (s_read(&s, data, header.size) == header.size) {
+			glProgramBinary(program->obj, header.format, data,
+					header.size);
+			if (gl_success("glProgramBinary"))
+				glGetProgramiv(program->obj, GL_LINK_STATUS,
+					       &linked);
+		}
+	}
+
+	file_input_serializer_free(&s);
+
+	/* stale or unsupported binaries are relinked and saved again */
+	if (linked != GL_TRUE)
+		os_unlink(path.array);
+
+	bfree(data);
+	dstr_free(&path);
+	return linked == GL_TRUE;
+}
+
+static void program_save_binary(struct gs_program *program)
+{
+	struct gs_device *device = program->device;
+	struct program_binary_header header = {0};
+	struct serializer s;
+	struct dstr path = {0};
+	GLint size = 0;
+	GLsizei length = 0;
+	GLenum format = 0;
+	uint8_t *data;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (!gl_success("glGetProgramiv") || size <= 0)
+		return;
+
+	data = bmalloc(size);
+	glGetProgramBinary(program->obj, size, &length, &format, data);
+	if (!gl_success("glGetProgramBinary") || length <= 0)
+		goto exit;
+
+	if (os_mkdirs(device->cache_path) == MKDIR_ERROR)
+		goto exit;
+
+	get_program_binary_path(&path, program);
+	if (!file_output_serializer_init_safe(&s, path.array, "tmp"))
+		goto exit;
+
+	header.magic = PROGRAM_BINARY_MAGIC;
+	header.format = format;
+	header.renderer_hash = device->renderer_hash;
+	header.size = (uint32_t)length;
+
+	s_write(&s, &header, sizeof(header));
+	s_write(&s, data, length);
+	file_output_serializer_free(&s);
+
+exit:
+	dstr_free(&path);
+	bfree(data);
+}
+
+static bool program_link(struct gs_program *program)
+{
+	bool cache = !!program->device->cache_path;
+	int linked = false;
 
 	glAttachShader(program->obj, program->vertex_shader->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
 	glAttachShader(program->obj, program->pixel_shader->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
+
+	if (cache) {
+		glProgramParameteri(program->obj,
+				    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+				    GL_TRUE);
+		cache = gl_success("glProgramParameteri");
+	}
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
+		goto detach;
 
 	if (linked == GL_FALSE) {
 		print_link_errors(program->obj);
-		goto error;
+		goto detach;
 	}
 
-	if (!assign_program_attribs(program))
-		goto error;
-	if (!assign_program_params(program))
-		goto error;
+	if (cache)
+		program_save_binary(program);
+
+detach:
+	glDetachShader(program->obj, program->pixel_shader->obj);
+	gl_success("glDetachShader (pixel)");
 
+detach_vertex:
 	glDetachShader(program->obj, program->vertex_shader->obj);
 	gl_success("glDetachShader (vertex)");
 
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
+	return linked == GL_TRUE;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
+		goto error;
+
+	if (!program_load_binary(program) && !program_link(program))
+		goto error;
+
+	if (!assign_program_attribs(program))
+		goto error;
+	if (!assign_program_params(program))
+		goto error;
 
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
@@ -683,14 +1081,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
@@ -706,6 +1096,9 @@ void gs_program_destroy(struct gs_program *program)
 		gl_success("glUseProgram (zero)");
 	}
 
+	for (size_t i = 0; i < GL_PARAMS_BINDING_COUNT; i++)
+		da_free(program->blocks[i].data);
+
 	da_free(program->attribs);
 	da_free(program->params);
 
@@ -723,46 +1116,10 @@ void gs_program_destroy(struct gs_program *program)
 void gs_shader_set_val(gs_sparam_t *param, const void *val, size_t size)
 {
 	int count = param->array_count;
-	size_t expected_size = 0;
+	size_t expected_size = shader_param_size(param->type);
 	if (!count)
 		count = 1;
 
-	switch ((uint32_t)param->type) {
-	case GS_SHADER_PARAM_FLOAT:
-		expected_size = sizeof(float);
-		break;
-	case GS_SHADER_PARAM_BOOL:
-	case GS_SHADER_PARAM_INT:
-		expected_size = sizeof(int);
-		break;
-	case GS_SHADER_PARAM_INT2:
-		expected_size = sizeof(int) * 2;
-		break;
-	case GS_SHADER_PARAM_INT3:
-		expected_size = sizeof(int) * 3;
-		break;
-	case GS_SHADER_PARAM_INT4:
-		expected_size = sizeof(int) * 4;
-		break;
-	case GS_SHADER_PARAM_VEC2:
-		expected_size = sizeof(float) * 2;
-		break;
-	case GS_SHADER_PARAM_VEC3:
-		expected_size = sizeof(float) * 3;
-		break;
-	case GS_SHADER_PARAM_VEC4:
-		expected_size = sizeof(float) * 4;
-		break;
-	case GS_SHADER_PARAM_MATRIX4X4:
-		expected_size = sizeof(float) * 4 * 4;
-		break;
-	case GS_SHADER_PARAM_TEXTURE:
-		expected_size = sizeof(void *);
-		break;
-	default:
-		expected_size = 0;
-	}
-
 	expected_size *= count;
 	if (!expected_size)
 		return;
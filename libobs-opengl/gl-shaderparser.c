@@ -120,15 +120,112 @@ static void gl_write_var(struct gl_shader_parser *glsp, struct shader_var *var)
 	dstr_cat(&glsp->gl_string, var->name);
 }
 
+/* std140 layout of these matches the packed parameter data */
+static bool gl_is_block_type(const char *type)
+{
+	static const char *types[] = {"bool",   "int",    "int2",   "int3",
+				      "int4",   "float",  "float2", "float3",
+				      "float4", "float4x4"};
+
+	for (size_t i = 0; i < sizeof(types) / sizeof(*types); i++) {
+		if (strcmp(type, types[i]) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static const struct cf_token *gl_prev_token(const struct cf_token *token,
+					    const struct cf_token *start)
+{
+	while (token > start) {
+		token--;
+		if (token->type != CFTOKEN_SPACETAB &&
+		    token->type != CFTOKEN_NEWLINE)
+			return token;
+	}
+
+	return NULL;
+}
+
+/* checks whether a function parameter or local variable hides a uniform */
+static bool gl_is_param_shadowed(struct gl_shader_parser *glsp,
+				 const char *name)
+{
+	for (size_t i = 0; i < glsp->parser.funcs.num; i++) {
+		struct shader_func *func = glsp->parser.funcs.array + i;
+		const struct cf_token *token;
+
+		for (size_t j = 0; j < func->params.num; j++) {
+			if (strcmp(func->params.array[j].name, name) == 0)
+				return true;
+		}
+
+		for (token = func->start; token && token != func->end;
+		     token++) {
+			const struct cf_token *prev;
+
+			if (token->type == CFTOKEN_NONE)
+				break;
+			if (token->type != CFTOKEN_NAME ||
+			    strref_cmp(&token->str, name) != 0)
+				continue;
+
+			/* "type name" is a declaration */
+			prev = gl_prev_token(token, func->start);
+			if (prev && prev->type == CFTOKEN_NAME &&
+			    strref_cmp(&prev->str, "return") != 0)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static inline bool gl_use_block_param(struct gl_shader_parser *glsp,
+				      struct shader_var *var)
+{
+	return var->var_type == SHADER_VAR_UNIFORM && !var->array_count &&
+	       gl_is_block_type(var->type) &&
+	       !gl_is_param_shadowed(glsp, var->name);
+}
+
+/*
+ * Uniforms other than textures and arrays are packed into one std140
+ * uniform block per shader, so they can be uploaded with a single buffer
+ * update instead of a glUniform call each.  The block has an instance name
+ * so vertex and pixel shaders can both use a uniform of the same name.
+ */
 static inline void gl_write_params(struct gl_shader_parser *glsp)
 {
 	size_t i;
 	for (i = 0; i < glsp->parser.params.num; i++) {
 		struct shader_var *var = glsp->parser.params.array + i;
+
+		if (gl_use_block_param(glsp, var)) {
+			da_push_back(glsp->block_params, &var);
+			continue;
+		}
+
 		gl_write_var(glsp, var);
 		dstr_cat(&glsp->gl_string, ";\n");
 	}
 
+	if (glsp->block_params.num) {
+		dstr_catf(&glsp->gl_string, "\nlayout(std140) uniform %s {\n",
+			  glsp->block_name);
+
+		for (i = 0; i < glsp->block_params.num; i++) {
+			struct shader_var *var = glsp->block_params.array[i];
+
+			dstr_cat(&glsp->gl_string, "\t");
+			gl_write_type(glsp, var->type);
+			dstr_catf(&glsp->gl_string, " %s;\n", var->name);
+		}
+
+		dstr_catf(&glsp->gl_string, "} %s;\n", glsp->block_instance);
+	}
+
 	dstr_cat(&glsp->gl_string, "\n");
 }
 
@@ -397,6 +494,20 @@ static bool gl_write_texture_code(struct gl_shader_parser *glsp,
 	return true;
 }
 
+static bool gl_write_block_param(struct gl_shader_parser *glsp,
+				 struct cf_token *token, struct shader_var *var)
+{
+	const struct cf_token *prev = gl_prev_token(
+		token, cf_preprocessor_get_tokens(&glsp->parser.cfp.pp));
+
+	/* struct member of the same name */
+	if (prev && strref_cmp(&prev->str, ".") == 0)
+		return false;
+
+	dstr_catf(&glsp->gl_string, "%s.%s", glsp->block_instance, var->name);
+	return true;
+}
+
 static bool gl_write_intrinsic(struct gl_shader_parser *glsp,
 			       struct cf_token **p_token)
 {
@@ -425,6 +536,8 @@ static bool gl_write_intrinsic(struct gl_shader_parser *glsp,
 		struct shader_var *var = sp_getparam(glsp, token);
 		if (var && astrcmp_n(var->type, "texture", 7) == 0)
 			written = gl_write_texture_code(glsp, &token, var);
+		else if (var && gl_is_block_param(glsp, var))
+			written = gl_write_block_param(glsp, token, var);
 		else
 			written = false;
 	}
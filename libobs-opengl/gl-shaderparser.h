@@ -26,6 +26,9 @@
 #include <util/dstr.h>
 #include <graphics/shader-parser.h>
 
+#define GL_VERTEX_PARAMS_BLOCK "_vertex_shader_params_block"
+#define GL_PIXEL_PARAMS_BLOCK "_pixel_shader_params_block"
+
 struct gl_parser_attrib {
 	struct dstr name;
 	const char *mapping;
@@ -46,11 +49,16 @@ struct gl_shader_parser {
 	enum gs_shader_type type;
 	const char *input_prefix;
 	const char *output_prefix;
+	const char *block_name;
+	const char *block_instance;
 	struct shader_parser parser;
 	struct dstr gl_string;
 
 	DARRAY(uint32_t) texture_samplers;
 	DARRAY(struct gl_parser_attrib) attribs;
+
+	/* uniforms packed into the std140 uniform block of the shader */
+	DARRAY(struct shader_var *) block_params;
 };
 
 static inline void gl_shader_parser_init(struct gl_shader_parser *glsp,
@@ -61,15 +69,20 @@ static inline void gl_shader_parser_init(struct gl_shader_parser *glsp,
 	if (type == GS_SHADER_VERTEX) {
 		glsp->input_prefix = "_input_attrib";
 		glsp->output_prefix = "_vertex_shader_attrib";
+		glsp->block_name = GL_VERTEX_PARAMS_BLOCK;
+		glsp->block_instance = "_vertex_shader_params";
 	} else if (type == GS_SHADER_PIXEL) {
 		glsp->input_prefix = "_vertex_shader_attrib";
 		glsp->output_prefix = "_pixel_shader_attrib";
+		glsp->block_name = GL_PIXEL_PARAMS_BLOCK;
+		glsp->block_instance = "_pixel_shader_params";
 	}
 
 	shader_parser_init(&glsp->parser);
 	dstr_init(&glsp->gl_string);
 	da_init(glsp->texture_samplers);
 	da_init(glsp->attribs);
+	da_init(glsp->block_params);
 }
 
 static inline void gl_shader_parser_free(struct gl_shader_parser *glsp)
@@ -80,9 +93,21 @@ static inline void gl_shader_parser_free(struct gl_shader_parser *glsp)
 
 	da_free(glsp->attribs);
 	da_free(glsp->texture_samplers);
+	da_free(glsp->block_params);
 	dstr_free(&glsp->gl_string);
 	shader_parser_free(&glsp->parser);
 }
 
+static inline bool gl_is_block_param(struct gl_shader_parser *glsp,
+				     struct shader_var *var)
+{
+	for (size_t i = 0; i < glsp->block_params.num; i++) {
+		if (glsp->block_params.array[i] == var)
+			return true;
+	}
+
+	return false;
+}
+
 extern bool gl_shader_parse(struct gl_shader_parser *glsp,
 			    const char *shader_str, const char *file);
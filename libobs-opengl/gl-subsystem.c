@@ -17,6 +17,9 @@
 ******************************************************************************/
 
 #include <graphics/matrix3.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <obs-config.h>
 #include "gl-subsystem.h"
 
 /* Goofy Windows.h macros need to be removed */
@@ -147,6 +150,13 @@ static bool gl_init_extensions(struct gs_device *device)
 	else
 		device->copy_type = COPY_TYPE_FBO_BLIT;
 
+	if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) {
+		GLint formats = 0;
+
+		if (gl_get_integer_v(GL_NUM_PROGRAM_BINARY_FORMATS, &formats))
+			device->program_binary = formats > 0;
+	}
+
 	return true;
 }
 
@@ -274,9 +284,12 @@ void device_destroy(gs_device_t *device)
 			gs_program_destroy(device->first_program);
 
 		gl_delete_vertex_arrays(1, &device->empty_vao);
+		if (device->uniform_ring)
+			gl_delete_buffers(1, &device->uniform_ring);
 
 		da_free(device->proj_stack);
 		gl_platform_destroy(device->plat);
+		bfree(device->cache_path);
 		bfree(device);
 	}
 }
@@ -1377,6 +1390,59 @@ void device_projection_pop(gs_device_t *device)
 	da_pop_back(device->proj_stack);
 }
 
+/* removes program binaries of other drivers or versions of libobs, which
+ * are never loaded again */
+static void remove_stale_binaries(struct gs_device *device)
+{
+	struct dstr prefix = {0};
+	struct dstr path = {0};
+	struct os_dirent *ent;
+	os_dir_t *dir;
+
+	dir = os_opendir(device->cache_path);
+	if (!dir)
+		return;
+
+	dstr_printf(&prefix, "gl-%016llx-",
+		    (unsigned long long)device->renderer_hash);
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		const char *ext = os_get_path_extension(ent->d_name);
+
+		if (ent->directory || !ext || strcmp(ext, ".bin") != 0 ||
+		    strncmp(ent->d_name, "gl-", 3) != 0 ||
+		    strncmp(ent->d_name, prefix.array, prefix.len) == 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", device->cache_path, ent->d_name);
+		os_unlink(path.array);
+	}
+
+	os_closedir(dir);
+	dstr_free(&prefix);
+	dstr_free(&path);
+}
+
+void device_set_cache_path(gs_device_t *device, const char *path)
+{
+	uint64_t hash = GL_HASH_SEED;
+
+	bfree(device->cache_path);
+	device->cache_path = path && device->program_binary ? bstrdup(path)
+							    : NULL;
+
+	/* binaries are only valid for the same driver, and the shaders they
+	 * were built from are generated differently by other versions */
+	hash = gl_hash_str(hash, (const char *)glGetString(GL_VENDOR));
+	hash = gl_hash_str(hash, (const char *)glGetString(GL_RENDERER));
+	hash = gl_hash_str(hash, (const char *)glGetString(GL_VERSION));
+	hash = gl_hash_str(hash, OBS_VERSION);
+	device->renderer_hash = hash;
+
+	if (device->cache_path)
+		remove_stale_binaries(device);
+}
+
 void device_debug_marker_begin(gs_device_t *device, const char *markername,
 			       const float color[4])
 {
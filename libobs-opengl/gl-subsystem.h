@@ -415,6 +415,7 @@ struct gs_shader_param {
 	DARRAY(uint8_t) cur_value;
 	DARRAY(uint8_t) def_value;
 	bool changed;
+	bool in_block;
 };
 
 enum attrib_type {
@@ -436,6 +437,8 @@ struct gs_shader {
 	gs_device_t *device;
 	enum gs_shader_type type;
 	GLuint obj;
+	uint64_t hash;
+	const char *block_name;
 
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
@@ -445,9 +448,28 @@ struct gs_shader {
 	DARRAY(gs_samplerstate_t *) samplers;
 };
 
+#define GL_PARAMS_BINDING_VERTEX 0
+#define GL_PARAMS_BINDING_PIXEL 1
+#define GL_PARAMS_BINDING_COUNT 2
+
+/* parameter block of one shader of a program.  the data is copied into the
+ * device's uniform ring whenever it changes, see gl-shader.c */
+struct program_block {
+	GLuint binding;
+	DARRAY(uint8_t) data;
+	bool dirty;
+
+	size_t ring_offset;
+	uint32_t ring_generation;
+};
+
 struct program_param {
 	GLint obj;
 	struct gs_shader_param *param;
+
+	/* for parameters in a uniform block, obj is unused */
+	struct program_block *block;
+	size_t offset;
 };
 
 struct gs_program {
@@ -459,6 +481,8 @@ struct gs_program {
 	DARRAY(struct program_param) params;
 	DARRAY(GLint) attribs;
 
+	struct program_block blocks[GL_PARAMS_BINDING_COUNT];
+
 	struct gs_program **prev_next;
 	struct gs_program *next;
 };
@@ -595,6 +619,11 @@ struct gs_device {
 	struct gl_platform *plat;
 	enum copy_type copy_type;
 
+	/* program binary cache */
+	bool program_binary;
+	uint64_t renderer_hash;
+	char *cache_path;
+
 	GLuint empty_vao;
 
 	gs_texture_t *cur_render_target;
@@ -611,6 +640,12 @@ struct gs_device {
 
 	struct gs_program *first_program;
 
+	GLuint uniform_ring;
+	size_t uniform_ring_pos;
+	size_t uniform_ring_align;
+	uint32_t uniform_ring_generation;
+	size_t cur_uniform_offsets[GL_PARAMS_BINDING_COUNT];
+
 	enum gs_cull_mode cur_cull_mode;
 	struct gs_rect cur_viewport;
 
@@ -0,0 +1,619 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Caches the output of the effect parser on disk, so effects that have not
+ * changed can be created without preprocessing and parsing them again.
+ *
+ *   Cache files are named after a hash of the libobs version and the graphics
+ * device name, followed by a hash of the effect text and its path.  They store
+ * the parameters, techniques and the generated shader text of each pass, along
+ * with a hash of every file the effect includes so that changes to included
+ * files are detected as well.
+ *
+ *   Files written by other versions of libobs or for other devices are removed
+ * when the cache path is set, and the directory is kept below a fixed size.
+ */
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "../util/file-serializer.h"
+#include "../util/platform.h"
+#include "../util/darray.h"
+#include "../util/dstr.h"
+#include "../obs-config.h"
+#include "effect.h"
+
+#define CACHE_MAGIC 0x58464f53 /* "SOFX" */
+#define CACHE_VERSION 1
+#define MAX_CACHE_STRING (16 * 1024 * 1024)
+#define MAX_CACHE_COUNT 4096
+#define MAX_CACHE_SIZE (64 * 1024 * 1024)
+
+static inline uint64_t hash_data(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+
+	/* 64-bit FNV-1a */
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static inline uint64_t hash_str(uint64_t hash, const char *str)
+{
+	return str ? hash_data(hash, str, strlen(str) + 1) : hash;
+}
+
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+/* the generated shader text depends on the parser as well as the effect */
+static uint64_t get_cache_generation(void)
+{
+	uint32_t version = CACHE_VERSION;
+	uint32_t api_version = LIBOBS_API_VER;
+	uint64_t hash = HASH_SEED;
+
+	hash = hash_data(hash, &version, sizeof(version));
+	hash = hash_data(hash, &api_version, sizeof(api_version));
+	hash = hash_str(hash, OBS_VERSION);
+	hash = hash_str(hash, gs_get_device_name());
+	return hash;
+}
+
+static void get_cache_file(struct dstr *path, const char *cache_path,
+			   const char *effect_string, const char *file)
+{
+	uint64_t hash = HASH_SEED;
+
+	hash = hash_str(hash, file);
+	hash = hash_str(hash, effect_string);
+
+	dstr_printf(path, "%s/%016llx-%016llx.effect", cache_path,
+		    (unsigned long long)get_cache_generation(),
+		    (unsigned long long)hash);
+}
+
+static inline void get_location(struct dstr *location, const char *file,
+				const char *tech, size_t pass_idx,
+				enum gs_shader_type type)
+{
+	dstr_printf(location, "%s (%s shader, technique %s, pass %u)", file,
+		    type == GS_SHADER_VERTEX ? "Vertex" : "Pixel", tech,
+		    (unsigned)pass_idx);
+}
+
+/* ------------------------------------------------------------------------- */
+/* saving */
+
+static inline void write_u32(struct serializer *s, uint32_t val)
+{
+	s_write(s, &val, sizeof(val));
+}
+
+static inline void write_u64(struct serializer *s, uint64_t val)
+{
+	s_write(s, &val, sizeof(val));
+}
+
+static void write_str(struct serializer *s, const char *str)
+{
+	uint32_t len = str ? (uint32_t)strlen(str) : 0;
+
+	write_u32(s, len);
+	s_write(s, str, len);
+}
+
+static void write_param(struct serializer *s,
+			const struct gs_effect_param *param)
+{
+	write_str(s, param->name);
+	write_u32(s, (uint32_t)param->type);
+	write_u32(s, (uint32_t)param->default_val.num);
+	s_write(s, param->default_val.array, param->default_val.num);
+
+	write_u32(s, (uint32_t)param->annotations.num);
+	for (size_t i = 0; i < param->annotations.num; i++)
+		write_param(s, param->annotations.array + i);
+}
+
+static void write_pass_params(struct serializer *s,
+			      const struct darray *pass_params)
+{
+	const struct pass_shaderparam *params = pass_params->array;
+
+	write_u32(s, (uint32_t)pass_params->num);
+	for (size_t i = 0; i < pass_params->num; i++)
+		write_str(s, params[i].eparam->name);
+}
+
+static bool pass_params_valid(const struct darray *pass_params)
+{
+	const struct pass_shaderparam *params = pass_params->array;
+
+	for (size_t i = 0; i < pass_params->num; i++) {
+		if (!params[i].eparam)
+			return false;
+	}
+
+	return true;
+}
+
+static bool effect_cacheable(const gs_effect_t *effect,
+			     const struct effect_parser *ep)
+{
+	size_t shader_idx = 0;
+
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		const struct gs_effect_technique *tech =
+			effect->techniques.array + i;
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			const struct gs_effect_pass *pass =
+				tech->passes.array + j;
+
+			if (!pass_params_valid(&pass->vertshader_params.da) ||
+			    !pass_params_valid(&pass->pixelshader_params.da))
+				return false;
+
+			shader_idx += 2;
+		}
+	}
+
+	return shader_idx == ep->shaders.num;
+}
+
+void effect_cache_save(const gs_effect_t *effect,
+		       const struct effect_parser *ep, const char *cache_path,
+		       const char *effect_string, const char *file)
+{
+	const struct cf_preprocessor *pp = &ep->cfp.pp;
+	struct serializer s;
+	struct dstr path = {0};
+	size_t shader_idx = 0;
+
+	if (!effect_cacheable(effect, ep))
+		return;
+
+	if (os_mkdirs(cache_path) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "Could not create effect cache '%s'",
+		     cache_path);
+		return;
+	}
+
+	get_cache_file(&path, cache_path, effect_string, file);
+	if (!file_output_serializer_init_safe(&s, path.array, "tmp")) {
+		dstr_free(&path);
+		return;
+	}
+
+	write_u32(&s, CACHE_MAGIC);
+	write_u32(&s, CACHE_VERSION);
+
+	write_u32(&s, (uint32_t)pp->dependencies.num);
+	for (size_t i = 0; i < pp->dependencies.num; i++) {
+		const struct cf_lexer *dep = pp->dependencies.array + i;
+
+		write_str(&s, dep->file);
+		write_u64(&s, hash_str(HASH_SEED, dep->base_lexer.text));
+	}
+
+	write_u32(&s, (uint32_t)effect->params.num);
+	for (size_t i = 0; i < effect->params.num; i++)
+		write_param(&s, effect->params.array + i);
+
+	write_u32(&s, (uint32_t)effect->techniques.num);
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		const struct gs_effect_technique *tech =
+			effect->techniques.array + i;
+
+		write_str(&s, tech->name);
+		write_u32(&s, (uint32_t)tech->passes.num);
+
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			const struct gs_effect_pass *pass =
+				tech->passes.array + j;
+
+			write_str(&s, pass->name);
+			write_str(&s, ep->shaders.array[shader_idx++]);
+			write_pass_params(&s, &pass->vertshader_params.da);
+			write_str(&s, ep->shaders.array[shader_idx++]);
+			write_pass_params(&s, &pass->pixelshader_params.da);
+		}
+	}
+
+	file_output_serializer_free(&s);
+	dstr_free(&path);
+}
+
+/* ------------------------------------------------------------------------- */
+/* loading */
+
+struct cache_reader {
+	struct serializer s;
+	bool error;
+};
+
+static inline void read_data(struct cache_reader *r, void *data, size_t size)
+{
+	if (size && s_read(&r->s, data, size) != size)
+		r->error = true;
+}
+
+static inline uint32_t read_u32(struct cache_reader *r)
+{
+	uint32_t val = 0;
+	read_data(r, &val, sizeof(val));
+	return val;
+}
+
+static inline uint64_t read_u64(struct cache_reader *r)
+{
+	uint64_t val = 0;
+	read_data(r, &val, sizeof(val));
+	return val;
+}
+
+static inline uint32_t read_count(struct cache_reader *r)
+{
+	uint32_t count = read_u32(r);
+	if (count > MAX_CACHE_COUNT)
+		r->error = true;
+	return r->error ? 0 : count;
+}
+
+static char *read_str(struct cache_reader *r)
+{
+	uint32_t len = read_u32(r);
+	char *str;
+
+	if (r->error || len > MAX_CACHE_STRING) {
+		r->error = true;
+		return NULL;
+	}
+
+	str = bmalloc(len + 1);
+	read_data(r, str, len);
+	str[len] = 0;
+	return str;
+}
+
+static bool dependencies_valid(struct cache_reader *r)
+{
+	uint32_t num = read_count(r);
+
+	for (uint32_t i = 0; i < num && !r->error; i++) {
+		char *dep_file = read_str(r);
+		uint64_t hash = read_u64(r);
+		char *text;
+
+		if (r->error) {
+			bfree(dep_file);
+			return false;
+		}
+
+		text = os_quick_read_utf8_file(dep_file);
+		bfree(dep_file);
+
+		if (!text)
+			return false;
+		if (hash_str(HASH_SEED, text) != hash) {
+			bfree(text);
+			return false;
+		}
+
+		bfree(text);
+	}
+
+	return !r->error;
+}
+
+static void read_param(struct cache_reader *r, gs_effect_t *effect,
+		       struct gs_effect_param *param,
+		       enum effect_section section)
+{
+	uint32_t size;
+	uint32_t num;
+
+	param->name = read_str(r);
+	param->section = section;
+	param->effect = effect;
+	param->type = (enum gs_shader_param_type)read_u32(r);
+
+	size = read_u32(r);
+	if (r->error || size > MAX_CACHE_STRING) {
+		r->error = true;
+		return;
+	}
+
+	da_resize(param->default_val, size);
+	read_data(r, param->default_val.array, size);
+
+	num = read_count(r);
+	da_resize(param->annotations, num);
+	for (uint32_t i = 0; i < num && !r->error; i++)
+		read_param(r, effect, param->annotations.array + i,
+			   EFFECT_ANNOTATION);
+}
+
+static bool read_pass_params(struct cache_reader *r, gs_effect_t *effect,
+			     gs_shader_t *shader, struct darray *pass_params)
+{
+	uint32_t num = read_count(r);
+
+	darray_resize(sizeof(struct pass_shaderparam), pass_params, num);
+
+	for (uint32_t i = 0; i < num && !r->error; i++) {
+		struct pass_shaderparam *param = darray_item(
+			sizeof(struct pass_shaderparam), pass_params, i);
+		char *name = read_str(r);
+
+		if (r->error)
+			break;
+
+		param->eparam = gs_effect_get_param_by_name(effect, name);
+		param->sparam = gs_shader_get_param_by_name(shader, name);
+		bfree(name);
+
+		if (!param->eparam || !param->sparam)
+			return false;
+	}
+
+	return !r->error;
+}
+
+static gs_shader_t *read_shader(struct cache_reader *r, const char *file,
+				const char *tech, size_t pass_idx,
+				enum gs_shader_type type)
+{
+	struct dstr location = {0};
+	gs_shader_t *shader = NULL;
+	char *shader_str = read_str(r);
+
+	if (!r->error) {
+		get_location(&location, file, tech, pass_idx, type);
+
+		if (type == GS_SHADER_VERTEX)
+			shader = gs_vertexshader_create(shader_str,
+							location.array, NULL);
+		else
+			shader = gs_pixelshader_create(shader_str,
+						       location.array, NULL);
+	}
+
+	dstr_free(&location);
+	bfree(shader_str);
+	return shader;
+}
+
+static bool read_pass(struct cache_reader *r, gs_effect_t *effect,
+		      struct gs_effect_technique *tech,
+		      struct gs_effect_pass *pass, size_t pass_idx,
+		      const char *file)
+{
+	pass->name = read_str(r);
+	pass->section = EFFECT_PASS;
+
+	pass->vertshader = read_shader(r, file, tech->name, pass_idx,
+				       GS_SHADER_VERTEX);
+	if (!pass->vertshader)
+		return false;
+	if (!read_pass_params(r, effect, pass->vertshader,
+			      &pass->vertshader_params.da))
+		return false;
+
+	pass->pixelshader = read_shader(r, file, tech->name, pass_idx,
+					GS_SHADER_PIXEL);
+	if (!pass->pixelshader)
+		return false;
+
+	return read_pass_params(r, effect, pass->pixelshader,
+				&pass->pixelshader_params.da);
+}
+
+static bool read_effect(struct cache_reader *r, gs_effect_t *effect,
+			const char *file)
+{
+	uint32_t num;
+
+	if (read_u32(r) != CACHE_MAGIC || read_u32(r) != CACHE_VERSION)
+		return false;
+	if (!dependencies_valid(r))
+		return false;
+
+	num = read_count(r);
+	da_resize(effect->params, num);
+	for (uint32_t i = 0; i < num && !r->error; i++) {
+		struct gs_effect_param *param = effect->params.array + i;
+
+		read_param(r, effect, param, EFFECT_PARAM);
+		if (r->error)
+			return false;
+
+		if (strcmp(param->name, "ViewProj") == 0)
+			effect->view_proj = param;
+		else if (strcmp(param->name, "World") == 0)
+			effect->world = param;
+	}
+
+	num = read_count(r);
+	da_resize(effect->techniques, num);
+	for (uint32_t i = 0; i < num && !r->error; i++) {
+		struct gs_effect_technique *tech = effect->techniques.array + i;
+		uint32_t num_passes;
+
+		tech->name = read_str(r);
+		tech->section = EFFECT_TECHNIQUE;
+		tech->effect = effect;
+
+		num_passes = read_count(r);
+		da_resize(tech->passes, num_passes);
+
+		for (uint32_t j = 0; j < num_passes && !r->error; j++) {
+			if (!read_pass(r, effect, tech, tech->passes.array + j,
+				       j, file))
+				return false;
+		}
+	}
+
+	return !r->error;
+}
+
+static void clear_effect(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->params.num; i++)
+		effect_param_free(effect->params.array + i);
+	for (size_t i = 0; i < effect->techniques.num; i++)
+		effect_technique_free(effect->techniques.array + i);
+
+	da_free(effect->params);
+	da_free(effect->techniques);
+	effect->view_proj = NULL;
+	effect->world = NULL;
+}
+
+bool effect_cache_load(gs_effect_t *effect, const char *cache_path,
+		       const char *effect_string, const char *file)
+{
+	struct cache_reader r = {0};
+	struct dstr path = {0};
+	bool success;
+
+	get_cache_file(&path, cache_path, effect_string, file);
+
+	if (!file_input_serializer_init(&r.s, path.array)) {
+		dstr_free(&path);
+		return false;
+	}
+
+	success = read_effect(&r, effect, file);
+	file_input_serializer_free(&r.s);
+
+	if (!success) {
+		blog(LOG_DEBUG, "Effect cache for '%s' is out of date", file);
+		clear_effect(effect);
+		os_unlink(path.array);
+	}
+
+	dstr_free(&path);
+	return success;
+}
+
+/* ------------------------------------------------------------------------- */
+/* pruning */
+
+struct cache_entry {
+	char *path;
+	int64_t size;
+	time_t mtime;
+};
+
+static int cmp_cache_entry(const void *a, const void *b)
+{
+	const struct cache_entry *entry_a = a;
+	const struct cache_entry *entry_b = b;
+
+	if (entry_a->mtime == entry_b->mtime)
+		return 0;
+	return entry_a->mtime < entry_b->mtime ? -1 : 1;
+}
+
+static inline bool is_stale_effect(const char *name, const char *prefix)
+{
+	const char *ext = os_get_path_extension(name);
+
+	return ext && strcmp(ext, ".effect") == 0 &&
+	       strncmp(name, prefix, strlen(prefix)) != 0;
+}
+
+void effect_cache_prune(const char *cache_path)
+{
+	DARRAY(struct cache_entry) entries;
+	struct dstr prefix = {0};
+	struct dstr path = {0};
+	struct os_dirent *ent;
+	os_dir_t *dir;
+	int64_t total = 0;
+	size_t removed = 0;
+
+	dir = os_opendir(cache_path);
+	if (!dir)
+		return;
+
+	da_init(entries);
+	dstr_printf(&prefix, "%016llx-",
+		    (unsigned long long)get_cache_generation());
+
+	while ((ent = os_readdir(dir)) != NULL) {
+		struct cache_entry entry;
+		struct stat st;
+
+		if (ent->directory)
+			continue;
+
+		dstr_printf(&path, "%s/%s", cache_path, ent->d_name);
+
+		if (is_stale_effect(ent->d_name, prefix.array)) {
+			if (os_unlink(path.array) == 0)
+				removed++;
+			continue;
+		}
+
+		if (os_stat(path.array, &st) != 0)
+			continue;
+
+		entry.path = bstrdup(path.array);
+		entry.size = (int64_t)st.st_size;
+		entry.mtime = st.st_mtime;
+		total += entry.size;
+		da_push_back(entries, &entry);
+	}
+
+	os_closedir(dir);
+
+	/* the graphics device keeps its own files (such as program binaries)
+	 * in the same directory, so the limit covers every file in it.  the
+	 * oldest files are removed until the directory is at half the limit,
+	 * so this does not have to happen again on every start */
+	if (total > MAX_CACHE_SIZE) {
+		qsort(entries.array, entries.num, sizeof(*entries.array),
+		      cmp_cache_entry);
+
+		for (size_t i = 0; i < entries.num; i++) {
+			if (total <= MAX_CACHE_SIZE / 2)
+				break;
+			if (os_unlink(entries.array[i].path) != 0)
+				continue;
+
+			total -= entries.array[i].size;
+			removed++;
+		}
+	}
+
+	if (removed)
+		blog(LOG_INFO, "Removed %u old files from the shader cache",
+		     (unsigned)removed);
+
+	for (size_t i = 0; i < entries.num; i++)
+		bfree(entries.array[i].path);
+	da_free(entries);
+	dstr_free(&prefix);
+	dstr_free(&path);
+}
@@ -67,6 +67,8 @@ void ep_free(struct effect_parser *ep)
 		ep_sampler_free(ep->samplers.array + i);
 	for (i = 0; i < ep->techniques.num; i++)
 		ep_technique_free(ep->techniques.array + i);
+	for (i = 0; i < ep->shaders.num; i++)
+		bfree(ep->shaders.array[i]);
 
 	ep->cur_pass = NULL;
 	cf_parser_free(&ep->cfp);
@@ -75,6 +77,7 @@ void ep_free(struct effect_parser *ep)
 	da_free(ep->funcs);
 	da_free(ep->samplers);
 	da_free(ep->techniques);
+	da_free(ep->shaders);
 }
 
 static inline struct ep_func *ep_getfunc(struct effect_parser *ep,
@@ -1991,7 +1994,9 @@ static inline bool ep_compile_pass_shader(struct effect_parser *ep,
 	dstr_free(&location);
 	dstr_array_free(used_params.array, used_params.num);
 	darray_free(&used_params);
-	dstr_free(&shader_str);
+
+	/* kept for the effect cache */
+	da_push_back(ep->shaders, &shader_str.array);
 
 	return success;
 }
@@ -270,6 +270,9 @@ struct effect_parser {
 	DARRAY(struct cf_token) tokens;
 	struct gs_effect_pass *cur_pass;
 
+	/* generated vertex and pixel shader of each pass, in order */
+	DARRAY(char *) shaders;
+
 	struct cf_parser cfp;
 };
 
@@ -282,6 +285,7 @@ static inline void ep_init(struct effect_parser *ep)
 	da_init(ep->techniques);
 	da_init(ep->files);
 	da_init(ep->tokens);
+	da_init(ep->shaders);
 
 	ep->cur_pass = NULL;
 	cf_parser_init(&ep->cfp);
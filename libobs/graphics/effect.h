@@ -189,6 +189,15 @@ static inline void effect_free(gs_effect_t *effect)
 	effect->effect_dir = NULL;
 }
 
+/* on-disk cache of parsed effects, see effect-cache.c */
+extern bool effect_cache_load(gs_effect_t *effect, const char *cache_path,
+			      const char *effect_string, const char *file);
+extern void effect_cache_save(const gs_effect_t *effect,
+			      const struct effect_parser *ep,
+			      const char *cache_path, const char *effect_string,
+			      const char *file);
+extern void effect_cache_prune(const char *cache_path);
+
 EXPORT void effect_upload_params(gs_effect_t *effect, bool changed_only);
 EXPORT void effect_upload_shader_params(gs_effect_t *effect,
 					gs_shader_t *shader,
@@ -261,6 +261,7 @@ struct gs_exports {
 					   gs_samplerstate_t *sampler);
 
 	bool (*device_nv12_available)(gs_device_t *device);
+	void (*device_set_cache_path)(gs_device_t *device, const char *path);
 
 	void (*device_debug_marker_begin)(gs_device_t *device,
 					  const char *markername,
@@ -322,6 +323,31 @@ struct blend_state {
 	enum gs_blend_type dest_a;
 };
 
+struct gs_pooled_texture {
+	gs_texture_t *tex;
+	uint32_t cx, cy;
+	enum gs_color_format format;
+	uint32_t flags;
+	uint64_t size;
+	uint64_t last_used;
+};
+
+struct gs_texture_pool {
+	DARRAY(struct gs_pooled_texture) textures;
+	DARRAY(struct gs_pooled_texture) in_use;
+	uint64_t bytes_held;
+	uint64_t budget;
+	uint64_t counter;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
+extern void gs_texture_pool_free(struct gs_texture_pool *pool);
+extern void gs_texture_pool_forget(struct gs_texture_pool *pool,
+				   gs_texture_t *tex);
+
 struct graphics_subsystem {
 	void *module;
 	gs_device_t *device;
@@ -353,4 +379,10 @@ struct graphics_subsystem {
 
 	struct blend_state cur_blend_state;
 	DARRAY(struct blend_state) blend_state_stack;
+
+	uint64_t draw_calls;
+
+	char *cache_path;
+
+	struct gs_texture_pool texture_pool;
 };
@@ -178,6 +178,7 @@ int gs_create(graphics_t **pgraphics, const char *module, uint32_t adapter)
 	graphics_t *graphics = bzalloc(sizeof(struct graphics_subsystem));
 	pthread_mutex_init_value(&graphics->mutex);
 	pthread_mutex_init_value(&graphics->effect_mutex);
+	graphics->texture_pool.budget = GS_TEXTURE_POOL_DEFAULT_BUDGET;
 
 	graphics->module = os_dlopen(module);
 	if (!graphics->module) {
@@ -228,6 +229,8 @@ void gs_destroy(graphics_t *graphics)
 			effect = next;
 		}
 
+		gs_texture_pool_free(&graphics->texture_pool);
+
 		graphics->exports.gs_vertexbuffer_destroy(
 			graphics->sprite_buffer);
 		graphics->exports.gs_vertexbuffer_destroy(
@@ -242,6 +245,7 @@ void gs_destroy(graphics_t *graphics)
 	da_free(graphics->matrix_stack);
 	da_free(graphics->viewport_stack);
 	da_free(graphics->blend_state_stack);
+	bfree(graphics->cache_path);
 	if (graphics->module)
 		os_dlclose(graphics->module);
 	bfree(graphics);
@@ -826,6 +830,7 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename,
 		return NULL;
 
 	struct gs_effect *effect = bzalloc(sizeof(struct gs_effect));
+	const char *cache_path = thread_graphics->cache_path;
 	struct effect_parser parser;
 	bool success;
 
@@ -833,7 +838,21 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename,
 	effect->effect_path = bstrdup(filename);
 
 	ep_init(&parser);
-	success = ep_parse(&parser, effect, effect_string, filename);
+
+	if (filename && cache_path)
+		success = effect_cache_load(effect, cache_path, effect_string,
+					    filename);
+	else
+		success = false;
+
+	if (!success) {
+		success = ep_parse(&parser, effect, effect_string, filename);
+
+		if (success && filename && cache_path)
+			effect_cache_save(effect, &parser, cache_path,
+					  effect_string, filename);
+	}
+
 	if (!success) {
 		if (error_string)
 			*error_string =
@@ -858,6 +877,23 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename,
 	return effect;
 }
 
+void gs_set_cache_path(const char *path)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid("gs_set_cache_path"))
+		return;
+
+	bfree(graphics->cache_path);
+	graphics->cache_path = path && *path ? bstrdup(path) : NULL;
+
+	if (graphics->exports.device_set_cache_path)
+		graphics->exports.device_set_cache_path(graphics->device,
+							graphics->cache_path);
+	if (graphics->cache_path)
+		effect_cache_prune(graphics->cache_path);
+}
+
 gs_shader_t *gs_vertexshader_create_from_file(const char *file,
 					      char **error_string)
 {
@@ -1764,6 +1800,17 @@ void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert,
 
 	graphics->exports.device_draw(graphics->device, draw_mode, start_vert,
 				      num_verts);
+	graphics->draw_calls++;
+}
+
+uint64_t gs_get_draw_call_count(void)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid("gs_get_draw_call_count"))
+		return 0;
+
+	return graphics->draw_calls;
 }
 
 void gs_end_scene(void)
@@ -2243,6 +2290,7 @@ void gs_texture_destroy(gs_texture_t *tex)
 	if (!tex)
 		return;
 
+	gs_texture_pool_forget(&graphics->texture_pool, tex);
 	graphics->exports.gs_texture_destroy(tex);
 }
 
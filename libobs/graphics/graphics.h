@@ -249,6 +249,7 @@ struct gs_shader;
 struct gs_swap_chain;
 struct gs_timer;
 struct gs_texrender;
+struct gs_sprite_batch;
 struct gs_shader_param;
 struct gs_effect;
 struct gs_effect_technique;
@@ -267,6 +268,7 @@ typedef struct gs_swap_chain gs_swapchain_t;
 typedef struct gs_timer gs_timer_t;
 typedef struct gs_timer_range gs_timer_range_t;
 typedef struct gs_texture_render gs_texrender_t;
+typedef struct gs_sprite_batch gs_sprite_batch_t;
 typedef struct gs_shader gs_shader_t;
 typedef struct gs_shader_param gs_sparam_t;
 typedef struct gs_effect gs_effect_t;
@@ -441,6 +443,45 @@ EXPORT void gs_texrender_end(gs_texrender_t *texrender);
 EXPORT void gs_texrender_reset(gs_texrender_t *texrender);
 EXPORT gs_texture_t *gs_texrender_get_texture(const gs_texrender_t *texrender);
 
+/* ---------------------------------------------------
+ * sprite batch helper functions
+ * --------------------------------------------------- */
+
+#define GS_SPRITE_BATCH_TEXTURES 8
+
+EXPORT gs_sprite_batch_t *gs_sprite_batch_create(uint32_t max_sprites);
+EXPORT void gs_sprite_batch_destroy(gs_sprite_batch_t *batch);
+EXPORT bool gs_sprite_batch_add(gs_sprite_batch_t *batch, gs_texture_t *tex,
+				uint32_t flip);
+EXPORT uint32_t gs_sprite_batch_count(const gs_sprite_batch_t *batch);
+EXPORT void gs_sprite_batch_draw(gs_sprite_batch_t *batch, gs_effect_t *effect,
+				 const char *technique);
+
+/* ---------------------------------------------------
+ * texture pool
+ * --------------------------------------------------- */
+
+#define GS_TEXTURE_POOL_DEFAULT_BUDGET (256ULL * 1024 * 1024)
+
+struct gs_texture_pool_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+
+	/* idle textures currently held by the pool */
+	uint64_t bytes_held;
+	uint32_t textures_held;
+	uint64_t budget;
+};
+
+EXPORT gs_texture_t *gs_texture_pool_acquire(uint32_t width, uint32_t height,
+					     enum gs_color_format color_format,
+					     uint32_t flags);
+EXPORT void gs_texture_pool_release(gs_texture_t *tex);
+EXPORT void gs_texture_pool_set_budget(uint64_t bytes);
+EXPORT void gs_texture_pool_clear(void);
+EXPORT void gs_texture_pool_get_stats(struct gs_texture_pool_stats *stats);
+
 /* ---------------------------------------------------
  * graphics subsystem
  * --------------------------------------------------- */
@@ -539,6 +580,12 @@ EXPORT gs_effect_t *gs_effect_create_from_file(const char *file,
 EXPORT gs_effect_t *gs_effect_create(const char *effect_string,
 				     const char *filename, char **error_string);
 
+/**
+ * Sets the directory used to cache parsed effects and compiled shaders
+ * between sessions.  NULL disables the cache.
+ */
+EXPORT void gs_set_cache_path(const char *path);
+
 EXPORT gs_shader_t *gs_vertexshader_create_from_file(const char *file,
 						     char **error_string);
 EXPORT gs_shader_t *gs_pixelshader_create_from_file(const char *file,
@@ -674,6 +721,9 @@ EXPORT void gs_draw(enum gs_draw_mode draw_mode, uint32_t start_vert,
 		    uint32_t num_verts);
 EXPORT void gs_end_scene(void);
 
+/** Returns the number of draw calls made since the graphics were created */
+EXPORT uint64_t gs_get_draw_call_count(void);
+
 #define GS_CLEAR_COLOR (1 << 0)
 #define GS_CLEAR_DEPTH (1 << 1)
 #define GS_CLEAR_STENCIL (1 << 2)
@@ -0,0 +1,203 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Collects sprites into a single dynamic vertex buffer so that a run of
+ * sprites sharing the same effect and render state can be drawn with one
+ * draw call.  Each sprite is transformed by the matrix that is current when
+ * it is added, and up to GS_SPRITE_BATCH_TEXTURES different textures can be
+ * used by one batch.  The slot of the texture of each vertex is stored in the
+ * z component of its texture coordinate.
+ */
+
+#include <stdio.h>
+#include "graphics.h"
+#include "vec4.h"
+#include "matrix4.h"
+
+#define DEFAULT_MAX_SPRITES 128
+#define VERTS_PER_SPRITE 6
+
+struct gs_sprite_batch {
+	gs_vertbuffer_t *vb;
+
+	uint32_t max_sprites;
+	uint32_t num_sprites;
+
+	gs_texture_t *textures[GS_SPRITE_BATCH_TEXTURES];
+	uint32_t num_textures;
+};
+
+gs_sprite_batch_t *gs_sprite_batch_create(uint32_t max_sprites)
+{
+	struct gs_sprite_batch *batch;
+	struct gs_vb_data *vbd;
+	size_t num_verts;
+
+	if (!max_sprites)
+		max_sprites = DEFAULT_MAX_SPRITES;
+
+	num_verts = (size_t)max_sprites * VERTS_PER_SPRITE;
+
+	vbd = gs_vbdata_create();
+	vbd->num = num_verts;
+	vbd->points = bzalloc(sizeof(struct vec3) * num_verts);
+	vbd->num_tex = 1;
+	vbd->tvarray = bzalloc(sizeof(struct gs_tvertarray));
+	vbd->tvarray[0].width = 4;
+	vbd->tvarray[0].array = bzalloc(sizeof(struct vec4) * num_verts);
+
+	batch = bzalloc(sizeof(struct gs_sprite_batch));
+	batch->max_sprites = max_sprites;
+	batch->vb = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+	if (!batch->vb) {
+		bfree(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+void gs_sprite_batch_destroy(gs_sprite_batch_t *batch)
+{
+	if (batch) {
+		gs_vertexbuffer_destroy(batch->vb);
+		bfree(batch);
+	}
+}
+
+static bool get_texture_slot(struct gs_sprite_batch *batch, gs_texture_t *tex,
+			     uint32_t *slot)
+{
+	for (uint32_t i = 0; i < batch->num_textures; i++) {
+		if (batch->textures[i] == tex) {
+			*slot = i;
+			return true;
+		}
+	}
+
+	if (batch->num_textures == GS_SPRITE_BATCH_TEXTURES)
+		return false;
+
+	*slot = batch->num_textures;
+	batch->textures[batch->num_textures++] = tex;
+	return true;
+}
+
+static inline void set_vert(struct gs_vb_data *data, size_t idx,
+			    const struct vec3 *pos, float u, float v,
+			    float slot)
+{
+	struct vec4 *tvarray = data->tvarray[0].array;
+
+	vec3_copy(data->points + idx, pos);
+	vec4_set(tvarray + idx, u, v, slot, 0.0f);
+}
+
+bool gs_sprite_batch_add(gs_sprite_batch_t *batch, gs_texture_t *tex,
+			 uint32_t flip)
+{
+	struct gs_vb_data *data;
+	struct matrix4 mat;
+	struct vec3 corners[4];
+	float start_u, end_u;
+	float start_v, end_v;
+	float cx, cy;
+	uint32_t slot;
+	size_t idx;
+
+	if (!batch || !tex)
+		return false;
+	if (gs_get_texture_type(tex) != GS_TEXTURE_2D ||
+	    gs_texture_is_rect(tex))
+		return false;
+	if (batch->num_sprites == batch->max_sprites)
+		return false;
+	if (!get_texture_slot(batch, tex, &slot))
+		return false;
+
+	cx = (float)gs_texture_get_width(tex);
+	cy = (float)gs_texture_get_height(tex);
+
+	gs_matrix_get(&mat);
+	vec3_zero(&corners[0]);
+	vec3_set(&corners[1], cx, 0.0f, 0.0f);
+	vec3_set(&corners[2], 0.0f, cy, 0.0f);
+	vec3_set(&corners[3], cx, cy, 0.0f);
+	for (size_t i = 0; i < 4; i++)
+		vec3_transform(&corners[i], &corners[i], &mat);
+
+	start_u = (flip & GS_FLIP_U) ? 1.0f : 0.0f;
+	end_u = (flip & GS_FLIP_U) ? 0.0f : 1.0f;
+	start_v = (flip & GS_FLIP_V) ? 1.0f : 0.0f;
+	end_v = (flip & GS_FLIP_V) ? 0.0f : 1.0f;
+
+	/* same winding as the triangle strip of gs_draw_sprite */
+	data = gs_vertexbuffer_get_data(batch->vb);
+	idx = (size_t)batch->num_sprites * VERTS_PER_SPRITE;
+	set_vert(data, idx++, &corners[0], start_u, start_v, (float)slot);
+	set_vert(data, idx++, &corners[1], end_u, start_v, (float)slot);
+	set_vert(data, idx++, &corners[2], start_u, end_v, (float)slot);
+	set_vert(data, idx++, &corners[2], start_u, end_v, (float)slot);
+	set_vert(data, idx++, &corners[1], end_u, start_v, (float)slot);
+	set_vert(data, idx++, &corners[3], end_u, end_v, (float)slot);
+
+	batch->num_sprites++;
+	return true;
+}
+
+uint32_t gs_sprite_batch_count(const gs_sprite_batch_t *batch)
+{
+	return batch ? batch->num_sprites : 0;
+}
+
+void gs_sprite_batch_draw(gs_sprite_batch_t *batch, gs_effect_t *effect,
+			  const char *technique)
+{
+	if (!batch || !batch->num_sprites)
+		return;
+
+	for (uint32_t i = 0; i < GS_SPRITE_BATCH_TEXTURES; i++) {
+		gs_texture_t *tex = i < batch->num_textures
+					    ? batch->textures[i]
+					    : batch->textures[0];
+		char name[16];
+		gs_eparam_t *param;
+
+		snprintf(name, sizeof(name), "image%u", i);
+		param = gs_effect_get_param_by_name(effect, name);
+		if (param)
+			gs_effect_set_texture(param, tex);
+	}
+
+	gs_vertexbuffer_flush(batch->vb);
+
+	/* vertices are already transformed */
+	gs_matrix_push();
+	gs_matrix_identity();
+
+	while (gs_effect_loop(effect, technique)) {
+		gs_load_vertexbuffer(batch->vb);
+		gs_load_indexbuffer(NULL);
+		gs_draw(GS_TRIS, 0, batch->num_sprites * VERTS_PER_SPRITE);
+	}
+
+	gs_matrix_pop();
+
+	batch->num_sprites = 0;
+	batch->num_textures = 0;
+}
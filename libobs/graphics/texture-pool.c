@@ -0,0 +1,243 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Keeps released textures around so they can be reused by the next request
+ * of the same size, format and flags instead of being destroyed and created
+ * again, which causes stalls and fragments video memory when sources are
+ * resized or scenes are switched.
+ *
+ *   Idle textures are kept in a flat array that is searched linearly; the
+ * pool only ever holds as many of them as fit in the budget, so that is
+ * cheaper than maintaining an index.  Only idle textures count towards the
+ * budget.  When the memory they use goes over it, the least recently released
+ * textures are destroyed.
+ *
+ *   Textures that are handed out are tracked so they can be returned without
+ * querying their flags from the device, and are forgotten when they are
+ * destroyed directly.  There's no limit to how many of them there are, and
+ * every texture that is destroyed has to be looked up, so they are kept
+ * sorted by address and found with a binary search.
+ */
+
+#include "graphics-internal.h"
+
+static inline struct gs_texture_pool *get_pool(void)
+{
+	graphics_t *graphics = gs_get_context();
+	return graphics ? &graphics->texture_pool : NULL;
+}
+
+static inline uint64_t get_texture_size(uint32_t cx, uint32_t cy,
+					enum gs_color_format format)
+{
+	return (uint64_t)cx * cy * gs_get_format_bpp(format) / 8;
+}
+
+/* index of the first texture in use at or after the address of tex */
+static size_t in_use_lower_bound(struct gs_texture_pool *pool,
+				 gs_texture_t *tex)
+{
+	size_t lo = 0;
+	size_t hi = pool->in_use.num;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if ((uintptr_t)pool->in_use.array[mid].tex < (uintptr_t)tex)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static size_t find_in_use(struct gs_texture_pool *pool, gs_texture_t *tex)
+{
+	size_t idx = in_use_lower_bound(pool, tex);
+
+	if (idx < pool->in_use.num && pool->in_use.array[idx].tex == tex)
+		return idx;
+
+	return DARRAY_INVALID;
+}
+
+static void add_in_use(struct gs_texture_pool *pool,
+		       const struct gs_pooled_texture *pt)
+{
+	size_t idx = in_use_lower_bound(pool, pt->tex);
+	da_insert(pool->in_use, idx, pt);
+}
+
+static void pool_remove(struct gs_texture_pool *pool, size_t idx)
+{
+	pool->bytes_held -= pool->textures.array[idx].size;
+	da_erase(pool->textures, idx);
+}
+
+static void pool_evict_lru(struct gs_texture_pool *pool)
+{
+	size_t lru = 0;
+
+	for (size_t i = 1; i < pool->textures.num; i++) {
+		if (pool->textures.array[i].last_used <
+		    pool->textures.array[lru].last_used)
+			lru = i;
+	}
+
+	gs_texture_destroy(pool->textures.array[lru].tex);
+	pool_remove(pool, lru);
+	pool->evictions++;
+}
+
+static void pool_trim(struct gs_texture_pool *pool)
+{
+	while (pool->textures.num && pool->bytes_held > pool->budget)
+		pool_evict_lru(pool);
+}
+
+gs_texture_t *gs_texture_pool_acquire(uint32_t width, uint32_t height,
+				      enum gs_color_format color_format,
+				      uint32_t flags)
+{
+	struct gs_texture_pool *pool = get_pool();
+	struct gs_pooled_texture pt = {0};
+
+	if (!pool)
+		return NULL;
+
+	for (size_t i = 0; i < pool->textures.num; i++) {
+		struct gs_pooled_texture *idle = pool->textures.array + i;
+
+		if (idle->cx == width && idle->cy == height &&
+		    idle->format == color_format && idle->flags == flags) {
+			gs_texture_t *tex = idle->tex;
+
+			add_in_use(pool, idle);
+			pool_remove(pool, i);
+			pool->hits++;
+			return tex;
+		}
+	}
+
+	pool->misses++;
+
+	pt.tex = gs_texture_create(width, height, color_format, 1, NULL,
+				   flags);
+	if (!pt.tex)
+		return NULL;
+
+	pt.cx = width;
+	pt.cy = height;
+	pt.format = color_format;
+	pt.flags = flags;
+	pt.size = get_texture_size(width, height, color_format);
+	add_in_use(pool, &pt);
+	return pt.tex;
+}
+
+void gs_texture_pool_release(gs_texture_t *tex)
+{
+	struct gs_texture_pool *pool = get_pool();
+	struct gs_pooled_texture *pt;
+	size_t idx;
+
+	if (!tex)
+		return;
+
+	/* not from the pool */
+	idx = pool ? find_in_use(pool, tex) : DARRAY_INVALID;
+	if (idx == DARRAY_INVALID) {
+		gs_texture_destroy(tex);
+		return;
+	}
+
+	pt = da_push_back_new(pool->textures);
+	*pt = pool->in_use.array[idx];
+	pt->last_used = ++pool->counter;
+	da_erase(pool->in_use, idx);
+
+	pool->bytes_held += pt->size;
+	pool_trim(pool);
+}
+
+/* called by gs_texture_destroy, so a texture from the pool that is destroyed
+ * directly is not mistaken for another texture later created at the same
+ * address */
+void gs_texture_pool_forget(struct gs_texture_pool *pool, gs_texture_t *tex)
+{
+	size_t idx = find_in_use(pool, tex);
+
+	if (idx != DARRAY_INVALID)
+		da_erase(pool->in_use, idx);
+}
+
+void gs_texture_pool_set_budget(uint64_t bytes)
+{
+	struct gs_texture_pool *pool = get_pool();
+
+	if (!pool)
+		return;
+
+	pool->budget = bytes;
+	pool_trim(pool);
+}
+
+void gs_texture_pool_clear(void)
+{
+	struct gs_texture_pool *pool = get_pool();
+
+	if (!pool)
+		return;
+
+	for (size_t i = 0; i < pool->textures.num; i++)
+		gs_texture_destroy(pool->textures.array[i].tex);
+
+	da_resize(pool->textures, 0);
+	pool->bytes_held = 0;
+}
+
+void gs_texture_pool_get_stats(struct gs_texture_pool_stats *stats)
+{
+	struct gs_texture_pool *pool = get_pool();
+
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!pool)
+		return;
+
+	stats->hits = pool->hits;
+	stats->misses = pool->misses;
+	stats->evictions = pool->evictions;
+	stats->bytes_held = pool->bytes_held;
+	stats->textures_held = (uint32_t)pool->textures.num;
+	stats->budget = pool->budget;
+}
+
+void gs_texture_pool_free(struct gs_texture_pool *pool)
+{
+	for (size_t i = 0; i < pool->textures.num; i++)
+		gs_texture_destroy(pool->textures.array[i].tex);
+
+	/* textures still in use are destroyed by their owners */
+	da_free(pool->textures);
+	da_free(pool->in_use);
+	pool->bytes_held = 0;
+}
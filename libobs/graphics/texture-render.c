@@ -49,7 +49,7 @@ gs_texrender_t *gs_texrender_create(enum gs_color_format format,
 void gs_texrender_destroy(gs_texrender_t *texrender)
 {
 	if (texrender) {
-		gs_texture_destroy(texrender->target);
+		gs_texture_pool_release(texrender->target);
 		gs_zstencil_destroy(texrender->zs);
 		bfree(texrender);
 	}
@@ -61,7 +61,7 @@ static bool texrender_resetbuffer(gs_texrender_t *texrender, uint32_t cx,
 	if (!texrender)
 		return false;
 
-	gs_texture_destroy(texrender->target);
+	gs_texture_pool_release(texrender->target);
 	gs_zstencil_destroy(texrender->zs);
 
 	texrender->target = NULL;
@@ -69,15 +69,15 @@ static bool texrender_resetbuffer(gs_texrender_t *texrender, uint32_t cx,
 	texrender->cx = cx;
 	texrender->cy = cy;
 
-	texrender->target = gs_texture_create(cx, cy, texrender->format, 1,
-					      NULL, GS_RENDER_TARGET);
+	texrender->target = gs_texture_pool_acquire(cx, cy, texrender->format,
+						    GS_RENDER_TARGET);
 	if (!texrender->target)
 		return false;
 
 	if (texrender->zsformat != GS_ZS_NONE) {
 		texrender->zs = gs_zstencil_create(cx, cy, texrender->zsformat);
 		if (!texrender->zs) {
-			gs_texture_destroy(texrender->target);
+			gs_texture_pool_release(texrender->target);
 			texrender->target = NULL;
 
 			return false;
@@ -69,6 +69,10 @@ struct audio_output {
 	void *input_param;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[MAX_AUDIO_MIXES];
+
+	/* bit per mix that has at least one connected input, protected by
+	 * input_mutex */
+	uint32_t active_mixes;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -166,7 +170,8 @@ static inline void do_audio_output(struct audio_output *audio, size_t mix_idx,
 	pthread_mutex_unlock(&audio->input_mutex);
 }
 
-static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
+static inline void clamp_audio_output(struct audio_output *audio,
+				      uint32_t active_mixes, size_t bytes)
 {
 	size_t float_size = bytes / sizeof(float);
 
@@ -174,7 +179,7 @@ static inline void clamp_audio_output(struct audio_output *audio, size_t bytes)
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
 		/* do not process mixing if a specific mix is inactive */
-		if (!mix->inputs.num)
+		if ((active_mixes & (1 << mix_idx)) == 0)
 			continue;
 
 		for (size_t plane = 0; plane < audio->planes; plane++) {
@@ -209,22 +214,23 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 
 	/* get mixers */
 	pthread_mutex_lock(&audio->input_mutex);
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
-		if (audio->mixes[i].inputs.num)
-			active_mixes |= (1 << i);
-	}
+	active_mixes = audio->active_mixes;
 	pthread_mutex_unlock(&audio->input_mutex);
 
-	/* clear mix buffers */
+	/* clear mix buffers, inactive mixes are never mixed into or output so
+	 * they can be left alone */
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 
+		for (size_t i = 0; i < audio->planes; i++)
+			data[mix_idx].data[i] = mix->buffer[i];
+
+		if ((active_mixes & (1 << mix_idx)) == 0)
+			continue;
+
 		memset(mix->buffer[0], 0,
 		       AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS *
 			       sizeof(float));
-
-		for (size_t i = 0; i < audio->planes; i++)
-			data[mix_idx].data[i] = mix->buffer[i];
 	}
 
 	/* get new audio data */
@@ -234,11 +240,13 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 		return;
 
 	/* clamps audio data to -1.0..1.0 */
-	clamp_audio_output(audio, bytes);
+	clamp_audio_output(audio, active_mixes, bytes);
 
 	/* output */
-	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		if ((active_mixes & (1 << i)) != 0)
+			do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
+	}
 }
 
 static void *audio_thread(void *param)
@@ -300,6 +308,16 @@ static size_t audio_get_input_idx(const audio_t *audio, size_t mix_idx,
 	return DARRAY_INVALID;
 }
 
+static inline void update_active_mixes(struct audio_output *audio)
+{
+	audio->active_mixes = 0;
+
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		if (audio->mixes[i].inputs.num)
+			audio->active_mixes |= (1 << i);
+	}
+}
+
 static inline bool audio_input_init(struct audio_input *input,
 				    struct audio_output *audio)
 {
@@ -364,8 +382,10 @@ bool audio_output_connect(audio_t *audio, size_t mi,
 				audio->info.samples_per_sec;
 
 		success = audio_input_init(&input, audio);
-		if (success)
+		if (success) {
 			da_push_back(mix->inputs, &input);
+			update_active_mixes(audio);
+		}
 	}
 
 	pthread_mutex_unlock(&audio->input_mutex);
@@ -386,6 +406,7 @@ void audio_output_disconnect(audio_t *audio, size_t mix_idx,
 		struct audio_mix *mix = &audio->mixes[mix_idx];
 		audio_input_free(mix->inputs.array + idx);
 		da_erase(mix->inputs, idx);
+		update_active_mixes(audio);
 	}
 
 	pthread_mutex_unlock(&audio->input_mutex);
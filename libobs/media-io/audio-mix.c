@@ -0,0 +1,217 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "audio-mix.h"
+
+#include "../util/sse-intrin.h"
+
+#if !NEEDS_SIMDE && (defined(_M_IX86) || defined(_M_X64) || \
+		     defined(__i386__) || defined(__x86_64__))
+#define AUDIO_MIX_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX_TARGET
+#else
+#define AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+typedef void (*mix_add_t)(float *dst, const float *src, size_t count);
+typedef void (*mix_add_mul_t)(float *dst, const float *src, const float *mul,
+			      size_t count);
+
+/* ------------------------------------------------------------------------- */
+
+static void mix_add_scalar(float *dst, const float *src, size_t count)
+{
+	register float *out = dst;
+	register const float *in = src;
+	register const float *end = in + count;
+
+	while (in < end)
+		*(out++) += *(in++);
+}
+
+static void mix_add_mul_scalar(float *dst, const float *src, const float *mul,
+			       size_t count)
+{
+	register float *out = dst;
+	register const float *in = src;
+	register const float *buf = mul;
+	register const float *end = in + count;
+
+	while (in < end)
+		*(out++) += *(in++) * *(buf++);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void mix_add_sse2(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 d0 = _mm_loadu_ps(dst + i);
+		__m128 d1 = _mm_loadu_ps(dst + i + 4);
+		__m128 s0 = _mm_loadu_ps(src + i);
+		__m128 s1 = _mm_loadu_ps(src + i + 4);
+
+		_mm_storeu_ps(dst + i, _mm_add_ps(d0, s0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(d1, s1));
+	}
+
+	mix_add_scalar(dst + i, src + i, count - i);
+}
+
+static void mix_add_mul_sse2(float *dst, const float *src, const float *mul,
+			     size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 d0 = _mm_loadu_ps(dst + i);
+		__m128 d1 = _mm_loadu_ps(dst + i + 4);
+		__m128 s0 = _mm_loadu_ps(src + i);
+		__m128 s1 = _mm_loadu_ps(src + i + 4);
+		__m128 m0 = _mm_loadu_ps(mul + i);
+		__m128 m1 = _mm_loadu_ps(mul + i + 4);
+
+		_mm_storeu_ps(dst + i, _mm_add_ps(d0, _mm_mul_ps(s0, m0)));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(d1, _mm_mul_ps(s1, m1)));
+	}
+
+	mix_add_mul_scalar(dst + i, src + i, mul + i, count - i);
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef AUDIO_MIX_X86
+AVX_TARGET static void mix_add_avx(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 d0 = _mm256_loadu_ps(dst + i);
+		__m256 d1 = _mm256_loadu_ps(dst + i + 8);
+		__m256 s0 = _mm256_loadu_ps(src + i);
+		__m256 s1 = _mm256_loadu_ps(src + i + 8);
+
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(d0, s0));
+		_mm256_storeu_ps(dst + i + 8, _mm256_add_ps(d1, s1));
+	}
+
+	_mm256_zeroupper();
+	mix_add_sse2(dst + i, src + i, count - i);
+}
+
+AVX_TARGET static void mix_add_mul_avx(float *dst, const float *src,
+				       const float *mul, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m256 d0 = _mm256_loadu_ps(dst + i);
+		__m256 d1 = _mm256_loadu_ps(dst + i + 8);
+		__m256 s0 = _mm256_loadu_ps(src + i);
+		__m256 s1 = _mm256_loadu_ps(src + i + 8);
+		__m256 m0 = _mm256_loadu_ps(mul + i);
+		__m256 m1 = _mm256_loadu_ps(mul + i + 8);
+
+		_mm256_storeu_ps(dst + i,
+				 _mm256_add_ps(d0, _mm256_mul_ps(s0, m0)));
+		_mm256_storeu_ps(dst + i + 8,
+				 _mm256_add_ps(d1, _mm256_mul_ps(s1, m1)));
+	}
+
+	_mm256_zeroupper();
+	mix_add_mul_sse2(dst + i, src + i, mul + i, count - i);
+}
+
+static bool cpu_has_avx(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	/* AVX + OSXSAVE, then make sure the OS saves the YMM registers */
+	if ((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0)
+		return false;
+	return (_xgetbv(0) & 0x6) == 0x6;
+#else
+	__builtin_cpu_init();
+	return !!__builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static enum audio_mix_kernel cur_kernel = AUDIO_MIX_KERNEL_SSE2;
+static mix_add_t mix_add_func = mix_add_sse2;
+static mix_add_mul_t mix_add_mul_func = mix_add_mul_sse2;
+
+bool audio_mix_set_kernel(enum audio_mix_kernel kernel)
+{
+	switch (kernel) {
+	case AUDIO_MIX_KERNEL_SCALAR:
+		mix_add_func = mix_add_scalar;
+		mix_add_mul_func = mix_add_mul_scalar;
+		break;
+	case AUDIO_MIX_KERNEL_SSE2:
+		mix_add_func = mix_add_sse2;
+		mix_add_mul_func = mix_add_mul_sse2;
+		break;
+	case AUDIO_MIX_KERNEL_AVX:
+#ifdef AUDIO_MIX_X86
+		if (!cpu_has_avx())
+			return false;
+		mix_add_func = mix_add_avx;
+		mix_add_mul_func = mix_add_mul_avx;
+		break;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+
+	cur_kernel = kernel;
+	return true;
+}
+
+enum audio_mix_kernel audio_mix_get_kernel(void)
+{
+	return cur_kernel;
+}
+
+void audio_mix_init(void)
+{
+	if (!audio_mix_set_kernel(AUDIO_MIX_KERNEL_AVX))
+		audio_mix_set_kernel(AUDIO_MIX_KERNEL_SSE2);
+}
+
+void audio_mix_add(float *dst, const float *src, size_t count)
+{
+	mix_add_func(dst, src, count);
+}
+
+void audio_mix_add_mul(float *dst, const float *src, const float *mul,
+		       size_t count)
+{
+	mix_add_mul_func(dst, src, mul, count);
+}
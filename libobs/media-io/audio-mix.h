@@ -0,0 +1,57 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Float audio mixing kernels
+ *
+ *   The fastest implementation available on the running CPU is selected by
+ * audio_mix_init().  Until then (or if it's never called) the SSE2 versions
+ * are used, which map to NEON through SIMDE on ARM.  Buffers do not need to
+ * be aligned.
+ */
+
+enum audio_mix_kernel {
+	AUDIO_MIX_KERNEL_SCALAR,
+	AUDIO_MIX_KERNEL_SSE2,
+	AUDIO_MIX_KERNEL_AVX,
+};
+
+/** Selects the mixing kernels for the current CPU */
+EXPORT void audio_mix_init(void);
+
+/** Forces a specific kernel set, returns false if the CPU doesn't support it */
+EXPORT bool audio_mix_set_kernel(enum audio_mix_kernel kernel);
+EXPORT enum audio_mix_kernel audio_mix_get_kernel(void);
+
+/** dst[i] += src[i] */
+EXPORT void audio_mix_add(float *dst, const float *src, size_t count);
+
+/** dst[i] += src[i] * mul[i] */
+EXPORT void audio_mix_add_mul(float *dst, const float *src, const float *mul,
+			      size_t count);
+
+#ifdef __cplusplus
+}
+#endif
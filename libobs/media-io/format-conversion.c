@@ -15,10 +15,24 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <string.h>
+
 #include "format-conversion.h"
 
 #include "../util/sse-intrin.h"
 
+#if !NEEDS_SIMDE && (defined(_M_IX86) || defined(_M_X64) || \
+		     defined(__i386__) || defined(__x86_64__))
+#define FORMAT_CONVERSION_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
 /* ...surprisingly, if I don't use a macro to force inlining, it causes the
  * CPU usage to boost by a tremendous amount in debug builds. */
 
@@ -316,3 +330,599 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize,
 		}
 	}
 }
+
+/* ------------------------------------------------------------------------- */
+/* Same size conversions used by the native video scaler.  Unlike the
+ * functions above, these take the width separately, handle odd sizes and
+ * don't require aligned buffers.  For 4:2:0 output, start_y must be even. */
+
+static inline uint8_t avg_2x2(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	return (uint8_t)(((uint32_t)a + b + c + d + 2) >> 2);
+}
+
+static inline void copy_rows(const uint8_t *input, uint32_t in_linesize,
+			     uint32_t width, uint32_t start_y, uint32_t end_y,
+			     uint8_t *output, uint32_t out_linesize)
+{
+	for (uint32_t y = start_y; y < end_y; y++)
+		memcpy(output + y * out_linesize, input + y * in_linesize,
+		       width);
+}
+
+void convert_nv12_to_i420(const uint8_t *const input[],
+			  const uint32_t in_linesize[], uint32_t width,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	uint32_t width_d2 = (width + 1) / 2;
+	uint32_t end_y_d2 = (end_y + 1) / 2;
+	__m128i mask = _mm_set1_epi16(0x00FF);
+
+	copy_rows(input[0], in_linesize[0], width, start_y, end_y, output[0],
+		  out_linesize[0]);
+
+	for (uint32_t y = start_y / 2; y < end_y_d2; y++) {
+		const uint8_t *uv = input[1] + y * in_linesize[1];
+		uint8_t *u = output[1] + y * out_linesize[1];
+		uint8_t *v = output[2] + y * out_linesize[2];
+		uint32_t x = 0;
+
+		for (; x + 16 <= width_d2; x += 16) {
+			const __m128i *in = (const __m128i *)(uv + x * 2);
+			__m128i uv0 = _mm_loadu_si128(in);
+			__m128i uv1 = _mm_loadu_si128(in + 1);
+
+			__m128i u_val =
+				_mm_packus_epi16(_mm_and_si128(uv0, mask),
+						 _mm_and_si128(uv1, mask));
+			__m128i v_val =
+				_mm_packus_epi16(_mm_srli_epi16(uv0, 8),
+						 _mm_srli_epi16(uv1, 8));
+
+			_mm_storeu_si128((__m128i *)(u + x), u_val);
+			_mm_storeu_si128((__m128i *)(v + x), v_val);
+		}
+
+		for (; x < width_d2; x++) {
+			u[x] = uv[x * 2];
+			v[x] = uv[x * 2 + 1];
+		}
+	}
+}
+
+void convert_i420_to_nv12(const uint8_t *const input[],
+			  const uint32_t in_linesize[], uint32_t width,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	uint32_t width_d2 = (width + 1) / 2;
+	uint32_t end_y_d2 = (end_y + 1) / 2;
+
+	copy_rows(input[0], in_linesize[0], width, start_y, end_y, output[0],
+		  out_linesize[0]);
+
+	for (uint32_t y = start_y / 2; y < end_y_d2; y++) {
+		const uint8_t *u = input[1] + y * in_linesize[1];
+		const uint8_t *v = input[2] + y * in_linesize[2];
+		uint8_t *uv = output[1] + y * out_linesize[1];
+		uint32_t x = 0;
+
+		for (; x + 16 <= width_d2; x += 16) {
+			__m128i u_val = _mm_loadu_si128((const __m128i *)&u[x]);
+			__m128i v_val = _mm_loadu_si128((const __m128i *)&v[x]);
+			__m128i *out = (__m128i *)(uv + x * 2);
+
+			_mm_storeu_si128(out, _mm_unpacklo_epi8(u_val, v_val));
+			_mm_storeu_si128(out + 1,
+					 _mm_unpackhi_epi8(u_val, v_val));
+		}
+
+		for (; x < width_d2; x++) {
+			uv[x * 2] = u[x];
+			uv[x * 2 + 1] = v[x];
+		}
+	}
+}
+
+/* averages 2x2 blocks of 16 pixels wide rows into 8 16-bit values */
+static FORCE_INLINE __m128i avg_2x2_epi16(const uint8_t *row0,
+					  const uint8_t *row1)
+{
+	__m128i mask = _mm_set1_epi16(0x00FF);
+	__m128i line0 = _mm_loadu_si128((const __m128i *)row0);
+	__m128i line1 = _mm_loadu_si128((const __m128i *)row1);
+
+	__m128i sum = _mm_add_epi16(_mm_and_si128(line0, mask),
+				    _mm_srli_epi16(line0, 8));
+	sum = _mm_add_epi16(sum, _mm_and_si128(line1, mask));
+	sum = _mm_add_epi16(sum, _mm_srli_epi16(line1, 8));
+	sum = _mm_add_epi16(sum, _mm_set1_epi16(2));
+	return _mm_srli_epi16(sum, 2);
+}
+
+static inline void downsample_row(const uint8_t *row0, const uint8_t *row1,
+				  uint32_t width, uint8_t *out, size_t stride)
+{
+	uint32_t x = 0;
+
+	for (; x + 1 < width; x += 2) {
+		*out = avg_2x2(row0[x], row0[x + 1], row1[x], row1[x + 1]);
+		out += stride;
+	}
+
+	if (x < width)
+		*out = avg_2x2(row0[x], row0[x], row1[x], row1[x]);
+}
+
+void convert_i444_to_nv12(const uint8_t *const input[],
+			  const uint32_t in_linesize[], uint32_t width,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	copy_rows(input[0], in_linesize[0], width, start_y, end_y, output[0],
+		  out_linesize[0]);
+
+	for (uint32_t y = start_y; y < end_y; y += 2) {
+		uint32_t y1 = y + 1 < end_y ? y + 1 : y;
+		const uint8_t *u0 = input[1] + y * in_linesize[1];
+		const uint8_t *u1 = input[1] + y1 * in_linesize[1];
+		const uint8_t *v0 = input[2] + y * in_linesize[2];
+		const uint8_t *v1 = input[2] + y1 * in_linesize[2];
+		uint8_t *uv = output[1] + (y / 2) * out_linesize[1];
+		uint32_t x = 0;
+
+		for (; x + 16 <= width; x += 16) {
+			__m128i u_val = avg_2x2_epi16(u0 + x, u1 + x);
+			__m128i v_val = avg_2x2_epi16(v0 + x, v1 + x);
+
+			u_val = _mm_packus_epi16(u_val, u_val);
+			v_val = _mm_packus_epi16(v_val, v_val);
+			_mm_storeu_si128((__m128i *)(uv + x),
+					 _mm_unpacklo_epi8(u_val, v_val));
+		}
+
+		downsample_row(u0 + x, u1 + x, width - x, uv + x, 2);
+		downsample_row(v0 + x, v1 + x, width - x, uv + x + 1, 2);
+	}
+}
+
+void convert_i444_to_i420(const uint8_t *const input[],
+			  const uint32_t in_linesize[], uint32_t width,
+			  uint32_t start_y, uint32_t end_y, uint8_t *output[],
+			  const uint32_t out_linesize[])
+{
+	copy_rows(input[0], in_linesize[0], width, start_y, end_y, output[0],
+		  out_linesize[0]);
+
+	for (uint32_t y = start_y; y < end_y; y += 2) {
+		uint32_t y1 = y + 1 < end_y ? y + 1 : y;
+
+		for (size_t plane = 1; plane < 3; plane++) {
+			const uint8_t *row0 =
+				input[plane] + y * in_linesize[plane];
+			const uint8_t *row1 =
+				input[plane] + y1 * in_linesize[plane];
+			uint8_t *out =
+				output[plane] + (y / 2) * out_linesize[plane];
+			uint32_t x = 0;
+
+			for (; x + 16 <= width; x += 16) {
+				__m128i val = avg_2x2_epi16(row0 + x, row1 + x);
+				val = _mm_packus_epi16(val, val);
+				_mm_storel_epi64((__m128i *)(out + x / 2), val);
+			}
+
+			downsample_row(row0 + x, row1 + x, width - x,
+				       out + x / 2, 1);
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define RGB_Y_SHIFT 14
+#define RGB_UV_SHIFT (RGB_Y_SHIFT + 2)
+
+static inline int16_t to_fixed(double val)
+{
+	val *= (double)(1 << RGB_Y_SHIFT);
+	return (int16_t)(val < 0.0 ? val - 0.5 : val + 0.5);
+}
+
+void rgb_to_yuv_coeffs_init(struct rgb_to_yuv_coeffs *coeffs,
+			    enum video_format format,
+			    enum video_colorspace colorspace,
+			    enum video_range_type range)
+{
+	const bool bgr = format != VIDEO_FORMAT_RGBA;
+	const bool full = resolve_video_range(VIDEO_FORMAT_NV12, range) ==
+			  VIDEO_RANGE_FULL;
+	const double kr = colorspace == VIDEO_CS_709 ? 0.2126 : 0.299;
+	const double kb = colorspace == VIDEO_CS_709 ? 0.0722 : 0.114;
+	const double kg = 1.0 - kr - kb;
+	const double y_scale = full ? 1.0 : 219.0 / 255.0;
+	const double uv_scale = full ? 1.0 : 224.0 / 255.0;
+
+	double y[3] = {kr * y_scale, kg * y_scale, kb * y_scale};
+	double u[3] = {-kr / (2.0 * (1.0 - kb)) * uv_scale,
+		       -kg / (2.0 * (1.0 - kb)) * uv_scale, 0.5 * uv_scale};
+	double v[3] = {0.5 * uv_scale, -kg / (2.0 * (1.0 - kr)) * uv_scale,
+		       -kb / (2.0 * (1.0 - kr)) * uv_scale};
+
+	for (size_t i = 0; i < 8; i++) {
+		size_t c = i & 3;
+		size_t idx = bgr ? 2 - c : c;
+
+		if (c == 3) {
+			coeffs->y[i] = coeffs->u[i] = coeffs->v[i] = 0;
+			continue;
+		}
+
+		coeffs->y[i] = to_fixed(y[idx]);
+		coeffs->u[i] = to_fixed(u[idx]);
+		coeffs->v[i] = to_fixed(v[idx]);
+	}
+
+	coeffs->y_offset = ((full ? 0 : 16) << RGB_Y_SHIFT) +
+			   (1 << (RGB_Y_SHIFT - 1));
+	coeffs->uv_offset = (128 << RGB_UV_SHIFT) + (1 << (RGB_UV_SHIFT - 1));
+}
+
+static inline uint8_t clamp_u8(int32_t val)
+{
+	return val < 0 ? 0 : (val > 255 ? 255 : (uint8_t)val);
+}
+
+static inline uint8_t rgbx_to_y(const struct rgb_to_yuv_coeffs *coeffs,
+				const uint8_t *px)
+{
+	int32_t val = px[0] * coeffs->y[0] + px[1] * coeffs->y[1] +
+		      px[2] * coeffs->y[2] + coeffs->y_offset;
+	return clamp_u8(val >> RGB_Y_SHIFT);
+}
+
+/* converts a 2x2 block (or what is left of it at the edges) */
+static inline void rgbx_to_nv12_block(const struct rgb_to_yuv_coeffs *coeffs,
+				      const uint8_t *row0, const uint8_t *row1,
+				      bool two_cols, uint8_t *lum0,
+				      uint8_t *lum1, uint8_t *uv)
+{
+	const uint8_t *next0 = two_cols ? row0 + 4 : row0;
+	const uint8_t *next1 = two_cols ? row1 + 4 : row1;
+	int32_t sum[3];
+	int32_t u, v;
+
+	lum0[0] = rgbx_to_y(coeffs, row0);
+	if (two_cols)
+		lum0[1] = rgbx_to_y(coeffs, next0);
+	if (lum1) {
+		lum1[0] = rgbx_to_y(coeffs, row1);
+		if (two_cols)
+			lum1[1] = rgbx_to_y(coeffs, next1);
+	}
+
+	for (size_t c = 0; c < 3; c++)
+		sum[c] = row0[c] + next0[c] + row1[c] + next1[c];
+
+	u = sum[0] * coeffs->u[0] + sum[1] * coeffs->u[1] +
+	    sum[2] * coeffs->u[2] + coeffs->uv_offset;
+	v = sum[0] * coeffs->v[0] + sum[1] * coeffs->v[1] +
+	    sum[2] * coeffs->v[2] + coeffs->uv_offset;
+
+	uv[0] = clamp_u8(u >> RGB_UV_SHIFT);
+	uv[1] = clamp_u8(v >> RGB_UV_SHIFT);
+}
+
+static inline void rgbx_to_nv12_tail(const struct rgb_to_yuv_coeffs *coeffs,
+				     const uint8_t *row0, const uint8_t *row1,
+				     uint32_t x, uint32_t width, uint8_t *lum0,
+				     uint8_t *lum1, uint8_t *uv)
+{
+	for (; x < width; x += 2) {
+		rgbx_to_nv12_block(coeffs, row0 + x * 4, row1 + x * 4,
+				   x + 1 < width, lum0 + x,
+				   lum1 ? lum1 + x : NULL, uv + x);
+	}
+}
+
+/* sums the two pixels in each 64-bit half of a and b, giving the sums of the
+ * four pixels as 32-bit values */
+static FORCE_INLINE __m128i hadd_pixel_epi32(__m128i a, __m128i b)
+{
+	__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+				     _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+				    _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+/* 4 pixels of luma */
+static FORCE_INLINE uint32_t rgbx_to_y_sse2(__m128i px, __m128i y_coeffs,
+					    __m128i y_offset)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), y_coeffs);
+	__m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), y_coeffs);
+	__m128i val = _mm_add_epi32(hadd_pixel_epi32(lo, hi), y_offset);
+
+	val = _mm_srai_epi32(val, RGB_Y_SHIFT);
+	val = _mm_packs_epi32(val, val);
+	val = _mm_packus_epi16(val, val);
+	return (uint32_t)_mm_cvtsi128_si32(val);
+}
+
+/* 2 interleaved chroma pairs from 4x2 pixels */
+static FORCE_INLINE uint32_t rgbx_to_uv_sse2(__m128i px0, __m128i px1,
+					     __m128i u_coeffs,
+					     __m128i v_coeffs,
+					     __m128i uv_offset)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(px0, zero),
+				   _mm_unpacklo_epi8(px1, zero));
+	__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(px0, zero),
+				   _mm_unpackhi_epi8(px1, zero));
+	__m128i sum, u, v, val;
+
+	lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+	hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+	sum = _mm_unpacklo_epi64(lo, hi);
+
+	u = _mm_madd_epi16(sum, u_coeffs);
+	v = _mm_madd_epi16(sum, v_coeffs);
+
+	/* u0 u1 v0 v1 -> u0 v0 u1 v1 */
+	val = _mm_add_epi32(hadd_pixel_epi32(u, v), uv_offset);
+	val = _mm_srai_epi32(val, RGB_UV_SHIFT);
+	val = _mm_shuffle_epi32(val, _MM_SHUFFLE(3, 1, 2, 0));
+	val = _mm_packs_epi32(val, val);
+	val = _mm_packus_epi16(val, val);
+	return (uint32_t)_mm_cvtsi128_si32(val);
+}
+
+static void convert_rgbx_to_nv12_sse2(const uint8_t *input,
+				      uint32_t in_linesize, uint32_t width,
+				      uint32_t start_y, uint32_t end_y,
+				      uint8_t *output[],
+				      const uint32_t out_linesize[],
+				      const struct rgb_to_yuv_coeffs *coeffs)
+{
+	__m128i y_coeffs = _mm_loadu_si128((const __m128i *)coeffs->y);
+	__m128i u_coeffs = _mm_loadu_si128((const __m128i *)coeffs->u);
+	__m128i v_coeffs = _mm_loadu_si128((const __m128i *)coeffs->v);
+	__m128i y_offset = _mm_set1_epi32(coeffs->y_offset);
+	__m128i uv_offset = _mm_set1_epi32(coeffs->uv_offset);
+
+	for (uint32_t y = start_y; y < end_y; y += 2) {
+		bool two_rows = y + 1 < end_y;
+		const uint8_t *row0 = input + y * in_linesize;
+		const uint8_t *row1 = two_rows ? row0 + in_linesize : row0;
+		uint8_t *lum0 = output[0] + y * out_linesize[0];
+		uint8_t *lum1 = two_rows ? lum0 + out_linesize[0] : NULL;
+		uint8_t *uv = output[1] + (y / 2) * out_linesize[1];
+		uint32_t x = 0;
+
+		for (; x + 4 <= width; x += 4) {
+			const uint8_t *in0 = row0 + x * 4;
+			const uint8_t *in1 = row1 + x * 4;
+			__m128i px0 = _mm_loadu_si128((const __m128i *)in0);
+			__m128i px1 = _mm_loadu_si128((const __m128i *)in1);
+			uint32_t val;
+
+			val = rgbx_to_y_sse2(px0, y_coeffs, y_offset);
+			memcpy(lum0 + x, &val, sizeof(val));
+			if (lum1) {
+				val = rgbx_to_y_sse2(px1, y_coeffs, y_offset);
+				memcpy(lum1 + x, &val, sizeof(val));
+			}
+
+			val = rgbx_to_uv_sse2(px0, px1, u_coeffs, v_coeffs,
+					      uv_offset);
+			memcpy(uv + x, &val, sizeof(val));
+		}
+
+		rgbx_to_nv12_tail(coeffs, row0, row1, x, width, lum0, lum1,
+				  uv);
+	}
+}
+
+#ifdef FORMAT_CONVERSION_X86
+/* same as the SSE2 versions, with each 128-bit lane handling 4 pixels */
+AVX2_TARGET static inline __m256i hadd_pixel_epi32_avx2(__m256i a, __m256i b)
+{
+	__m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(a),
+					_mm256_castsi256_ps(b),
+					_MM_SHUFFLE(2, 0, 2, 0));
+	__m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(a),
+				       _mm256_castsi256_ps(b),
+				       _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm256_add_epi32(_mm256_castps_si256(even),
+				_mm256_castps_si256(odd));
+}
+
+/* packs the low 32 bits of each lane to 8 bytes */
+AVX2_TARGET static inline uint64_t pack_lanes_avx2(__m256i val)
+{
+	__m128i lo, hi;
+
+	val = _mm256_packs_epi32(val, val);
+	val = _mm256_packus_epi16(val, val);
+
+	lo = _mm256_castsi256_si128(val);
+	hi = _mm256_extracti128_si256(val, 1);
+	return (uint64_t)(uint32_t)_mm_cvtsi128_si32(lo) |
+	       ((uint64_t)(uint32_t)_mm_cvtsi128_si32(hi) << 32);
+}
+
+AVX2_TARGET static inline uint64_t rgbx_to_y_avx2(__m256i px,
+						  __m256i y_coeffs,
+						  __m256i y_offset)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero),
+				       y_coeffs);
+	__m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero),
+				       y_coeffs);
+	__m256i val = _mm256_add_epi32(hadd_pixel_epi32_avx2(lo, hi), y_offset);
+
+	return pack_lanes_avx2(_mm256_srai_epi32(val, RGB_Y_SHIFT));
+}
+
+AVX2_TARGET static inline uint64_t
+rgbx_to_uv_avx2(__m256i px0, __m256i px1, __m256i u_coeffs, __m256i v_coeffs,
+		__m256i uv_offset)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(px0, zero),
+				      _mm256_unpacklo_epi8(px1, zero));
+	__m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(px0, zero),
+				      _mm256_unpackhi_epi8(px1, zero));
+	__m256i sum, u, v, val;
+
+	lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+	hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+	sum = _mm256_unpacklo_epi64(lo, hi);
+
+	u = _mm256_madd_epi16(sum, u_coeffs);
+	v = _mm256_madd_epi16(sum, v_coeffs);
+
+	val = _mm256_add_epi32(hadd_pixel_epi32_avx2(u, v), uv_offset);
+	val = _mm256_srai_epi32(val, RGB_UV_SHIFT);
+	val = _mm256_shuffle_epi32(val, _MM_SHUFFLE(3, 1, 2, 0));
+	return pack_lanes_avx2(val);
+}
+
+AVX2_TARGET static void
+convert_rgbx_to_nv12_avx2(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t start_y, uint32_t end_y,
+			  uint8_t *output[], const uint32_t out_linesize[],
+			  const struct rgb_to_yuv_coeffs *coeffs)
+{
+	__m256i y_coeffs = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)coeffs->y));
+	__m256i u_coeffs = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)coeffs->u));
+	__m256i v_coeffs = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)coeffs->v));
+	__m256i y_offset = _mm256_set1_epi32(coeffs->y_offset);
+	__m256i uv_offset = _mm256_set1_epi32(coeffs->uv_offset);
+
+	for (uint32_t y = start_y; y < end_y; y += 2) {
+		bool two_rows = y + 1 < end_y;
+		const uint8_t *row0 = input + y * in_linesize;
+		const uint8_t *row1 = two_rows ? row0 + in_linesize : row0;
+		uint8_t *lum0 = output[0] + y * out_linesize[0];
+		uint8_t *lum1 = two_rows ? lum0 + out_linesize[0] : NULL;
+		uint8_t *uv = output[1] + (y / 2) * out_linesize[1];
+		uint32_t x = 0;
+
+		for (; x + 8 <= width; x += 8) {
+			__m256i px0 = _mm256_loadu_si256(
+				(const __m256i *)(row0 + x * 4));
+			__m256i px1 = _mm256_loadu_si256(
+				(const __m256i *)(row1 + x * 4));
+			uint64_t val;
+
+			val = rgbx_to_y_avx2(px0, y_coeffs, y_offset);
+			memcpy(lum0 + x, &val, sizeof(val));
+			if (lum1) {
+				val = rgbx_to_y_avx2(px1, y_coeffs, y_offset);
+				memcpy(lum1 + x, &val, sizeof(val));
+			}
+
+			val = rgbx_to_uv_avx2(px0, px1, u_coeffs, v_coeffs,
+					      uv_offset);
+			memcpy(uv + x, &val, sizeof(val));
+		}
+
+		rgbx_to_nv12_tail(coeffs, row0, row1, x, width, lum0, lum1,
+				  uv);
+	}
+
+	_mm256_zeroupper();
+}
+
+static bool cpu_has_avx2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	/* AVX + OSXSAVE, then make sure the OS saves the YMM registers */
+	if ((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0)
+		return false;
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return !!__builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+void convert_rgbx_to_nv12(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t start_y, uint32_t end_y,
+			  uint8_t *output[], const uint32_t out_linesize[],
+			  const struct rgb_to_yuv_coeffs *coeffs)
+{
+#ifdef FORMAT_CONVERSION_X86
+	/* the result is the same every time, so racing on it is harmless */
+	static volatile int use_avx2 = -1;
+	if (use_avx2 == -1)
+		use_avx2 = cpu_has_avx2();
+
+	if (use_avx2) {
+		convert_rgbx_to_nv12_avx2(input, in_linesize, width, start_y,
+					  end_y, output, out_linesize, coeffs);
+		return;
+	}
+#endif
+
+	convert_rgbx_to_nv12_sse2(input, in_linesize, width, start_y, end_y,
+				  output, out_linesize, coeffs);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Slice-parallel version.  Bands are kept to a multiple of this many rows so
+ * that every band starts on an even row and isn't too small to be worth
+ * handing to another thread. */
+
+#define SLICE_ROWS 32
+
+struct conversion_slices {
+	const uint8_t *input;
+	uint32_t in_linesize;
+	uint8_t **output;
+	const uint32_t *out_linesize;
+	uint32_t width;
+	const struct rgb_to_yuv_coeffs *coeffs;
+};
+
+static void rgbx_to_nv12_slice(void *param, size_t start, size_t end)
+{
+	struct conversion_slices *cs = param;
+	convert_rgbx_to_nv12(cs->input, cs->in_linesize, cs->width,
+			     (uint32_t)start, (uint32_t)end, cs->output,
+			     cs->out_linesize, cs->coeffs);
+}
+
+void convert_rgbx_to_nv12_mt(os_task_pool_t *pool, const uint8_t *input,
+			     uint32_t in_linesize, uint32_t width,
+			     uint32_t start_y, uint32_t end_y,
+			     uint8_t *output[], const uint32_t out_linesize[],
+			     const struct rgb_to_yuv_coeffs *coeffs)
+{
+	struct conversion_slices cs = {.input = input,
+				       .in_linesize = in_linesize,
+				       .output = output,
+				       .out_linesize = out_linesize,
+				       .width = width,
+				       .coeffs = coeffs};
+
+	os_task_pool_parallel_for(pool, start_y, end_y, SLICE_ROWS,
+				  rgbx_to_nv12_slice, &cs);
+}
@@ -18,6 +18,8 @@
 #pragma once
 
 #include "../util/c99defs.h"
+#include "../util/task-pool.h"
+#include "video-io.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,6 +58,69 @@ EXPORT void decompress_422(const uint8_t *input, uint32_t in_linesize,
 			   uint32_t start_y, uint32_t end_y, uint8_t *output,
 			   uint32_t out_linesize, bool leading_lum);
 
+/*
+ * Same size conversions between formats (used by the video scaler when no
+ * resampling is needed).  Buffers don't need to be aligned, and for 4:2:0
+ * output formats start_y must be even.
+ */
+
+EXPORT void convert_nv12_to_i420(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t width,
+				 uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[],
+				 const uint32_t out_linesize[]);
+
+EXPORT void convert_i420_to_nv12(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t width,
+				 uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[],
+				 const uint32_t out_linesize[]);
+
+EXPORT void convert_i444_to_nv12(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t width,
+				 uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[],
+				 const uint32_t out_linesize[]);
+
+EXPORT void convert_i444_to_i420(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t width,
+				 uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[],
+				 const uint32_t out_linesize[]);
+
+/* fixed point coefficients for 32-bit RGBA, BGRA or BGRX pixels */
+struct rgb_to_yuv_coeffs {
+	int16_t y[8];
+	int16_t u[8];
+	int16_t v[8];
+	int32_t y_offset;
+	int32_t uv_offset;
+};
+
+EXPORT void rgb_to_yuv_coeffs_init(struct rgb_to_yuv_coeffs *coeffs,
+				   enum video_format format,
+				   enum video_colorspace colorspace,
+				   enum video_range_type range);
+
+EXPORT void convert_rgbx_to_nv12(const uint8_t *input, uint32_t in_linesize,
+				 uint32_t width, uint32_t start_y,
+				 uint32_t end_y, uint8_t *output[],
+				 const uint32_t out_linesize[],
+				 const struct rgb_to_yuv_coeffs *coeffs);
+
+/*
+ * Slice-parallel version of convert_rgbx_to_nv12.  The rows are split into
+ * bands that are converted on the task pool, and the function returns once
+ * the whole range has been converted.  With a NULL pool it's the same as the
+ * single-threaded version.
+ */
+EXPORT void convert_rgbx_to_nv12_mt(os_task_pool_t *pool,
+				    const uint8_t *input, uint32_t in_linesize,
+				    uint32_t width, uint32_t start_y,
+				    uint32_t end_y, uint8_t *output[],
+				    const uint32_t out_linesize[],
+				    const struct rgb_to_yuv_coeffs *coeffs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,7 @@
 #include "../util/profiler.h"
 #include "../util/threading.h"
 #include "../util/darray.h"
+#include "../util/circlebuf.h"
 
 #include "format-conversion.h"
 #include "video-io.h"
@@ -32,11 +33,21 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
+/* kept small so that a slow input can't hold on to most of the cache */
+#define MAX_INPUT_QUEUE 2
 
 struct cached_frame_info {
 	struct video_data frame;
 	int skipped;
 	int count;
+
+	/* number of queued input frames still referencing this frame */
+	volatile long refs;
+};
+
+struct video_input_frame {
+	struct video_data frame;
+	size_t cache_idx;
 };
 
 struct video_input {
@@ -47,14 +58,19 @@ struct video_input {
 
 	void (*callback)(void *param, struct video_data *frame);
 	void *param;
-};
 
-static inline void video_input_free(struct video_input *input)
-{
-	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-		video_frame_free(&input->frame[i]);
-	video_scaler_destroy(input->scaler);
-}
+	/* parallel inputs only */
+	struct video_output *video;
+	pthread_t thread;
+	bool thread_active;
+	volatile bool stop;
+	os_sem_t *queue_semaphore;
+	pthread_mutex_t queue_mutex;
+	struct circlebuf queue;
+	uint32_t pending_skips;
+	volatile long skipped_frames;
+	volatile long total_frames;
+};
 
 struct video_output {
 	struct video_output_info info;
@@ -71,13 +87,18 @@ struct video_output {
 	bool initialized;
 
 	pthread_mutex_t input_mutex;
-	DARRAY(struct video_input) inputs;
+	DARRAY(struct video_input *) inputs;
 
 	size_t available_frames;
 	size_t first_added;
 	size_t last_added;
 	struct cached_frame_info cache[MAX_CACHE_SIZE];
 
+	/* parallel inputs only: frames that have been passed to the inputs but
+	 * are still in use by at least one of them, starting at first_queued */
+	size_t queued_frames;
+	size_t first_queued;
+
 	volatile bool raw_active;
 	volatile long gpu_refs;
 };
@@ -134,7 +155,7 @@ static inline bool video_output_cur_frame(struct video_output *video)
 	pthread_mutex_lock(&video->input_mutex);
 
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array + i;
+		struct video_input *input = video->inputs.array[i];
 		struct video_data frame = frame_info->frame;
 
 		if (scale_video_output(input, &frame))
@@ -169,9 +190,230 @@ static inline bool video_output_cur_frame(struct video_output *video)
 	return complete;
 }
 
+/* ------------------------------------------------------------------------- */
+/* parallel inputs: each input has its own thread and a queue of references to
+ * the cached frames, so a slow input only delays itself */
+
+/* cached frames are handed back in the order they were queued, a frame that
+ * was released early waits for the frames in front of it */
+static void reclaim_queued_frames(struct video_output *video)
+{
+	while (video->queued_frames) {
+		size_t idx = video->first_queued;
+		if (os_atomic_load_long(&video->cache[idx].refs))
+			break;
+
+		if (++video->first_queued == video->info.cache_size)
+			video->first_queued = 0;
+		video->queued_frames--;
+
+		if (++video->available_frames == video->info.cache_size)
+			video->last_added = video->first_added;
+	}
+}
+
+static void release_queued_frame(struct video_output *video, size_t cache_idx)
+{
+	if (os_atomic_dec_long(&video->cache[cache_idx].refs) == 0) {
+		pthread_mutex_lock(&video->data_mutex);
+		reclaim_queued_frames(video);
+		pthread_mutex_unlock(&video->data_mutex);
+	}
+}
+
+static bool video_input_queue_frame(struct video_input *input,
+				    struct cached_frame_info *frame_info,
+				    size_t cache_idx)
+{
+	struct video_input_frame item = {frame_info->frame, cache_idx};
+	bool queued = false;
+
+	pthread_mutex_lock(&input->queue_mutex);
+
+	if (input->queue.size < MAX_INPUT_QUEUE * sizeof(item)) {
+		item.frame.skipped = input->pending_skips;
+		input->pending_skips = 0;
+
+		os_atomic_inc_long(&frame_info->refs);
+		circlebuf_push_back(&input->queue, &item, sizeof(item));
+		queued = true;
+	} else {
+		/* passed on with the next frame that gets queued */
+		input->pending_skips++;
+	}
+
+	pthread_mutex_unlock(&input->queue_mutex);
+
+	os_atomic_inc_long(&input->total_frames);
+
+	if (queued)
+		os_sem_post(input->queue_semaphore);
+	else
+		os_atomic_inc_long(&input->skipped_frames);
+
+	return queued;
+}
+
+static inline bool video_output_queue_cur_frame(struct video_output *video)
+{
+	struct cached_frame_info *frame_info;
+	size_t cache_idx;
+	bool input_skipped = false;
+	bool complete;
+	bool skipped;
+
+	/* -------------------------------- */
+
+	pthread_mutex_lock(&video->data_mutex);
+
+	cache_idx = video->first_added;
+	frame_info = &video->cache[cache_idx];
+
+	pthread_mutex_unlock(&video->data_mutex);
+
+	/* -------------------------------- */
+
+	pthread_mutex_lock(&video->input_mutex);
+
+	for (size_t i = 0; i < video->inputs.num; i++) {
+		struct video_input *input = video->inputs.array[i];
+		if (!video_input_queue_frame(input, frame_info, cache_idx))
+			input_skipped = true;
+	}
+
+	pthread_mutex_unlock(&video->input_mutex);
+
+	/* -------------------------------- */
+
+	pthread_mutex_lock(&video->data_mutex);
+
+	frame_info->frame.timestamp += video->frame_time;
+	complete = --frame_info->count == 0;
+	skipped = frame_info->skipped > 0;
+
+	if (complete) {
+		if (++video->first_added == video->info.cache_size)
+			video->first_added = 0;
+
+		video->queued_frames++;
+		reclaim_queued_frames(video);
+
+	} else if (skipped) {
+		--frame_info->skipped;
+	}
+
+	if ((!complete && skipped) || input_skipped)
+		os_atomic_inc_long(&video->skipped_frames);
+
+	pthread_mutex_unlock(&video->data_mutex);
+
+	/* -------------------------------- */
+
+	return complete;
+}
+
+static void *video_input_thread(void *param)
+{
+	struct video_input *input = param;
+	struct video_output *video = input->video;
+
+	os_set_thread_name("video-io: video input thread");
+
+	const char *video_input_thread_name =
+		profile_store_name(obs_get_profiler_name_store(),
+				   "video_input_thread(%s)", video->info.name);
+
+	while (os_sem_wait(input->queue_semaphore) == 0) {
+		struct video_input_frame item;
+
+		if (input->stop)
+			break;
+
+		pthread_mutex_lock(&input->queue_mutex);
+		circlebuf_pop_front(&input->queue, &item, sizeof(item));
+		pthread_mutex_unlock(&input->queue_mutex);
+
+		profile_start(video_input_thread_name);
+
+		if (scale_video_output(input, &item.frame))
+			input->callback(input->param, &item.frame);
+
+		release_queued_frame(video, item.cache_idx);
+
+		profile_end(video_input_thread_name);
+
+		profile_reenable_thread();
+	}
+
+	return NULL;
+}
+
+static bool video_input_start(struct video_input *input,
+			      struct video_output *video)
+{
+	input->video = video;
+
+	if (pthread_mutex_init(&input->queue_mutex, NULL) != 0)
+		return false;
+	if (os_sem_init(&input->queue_semaphore, 0) != 0)
+		return false;
+	if (pthread_create(&input->thread, NULL, video_input_thread, input) !=
+	    0)
+		return false;
+
+	input->thread_active = true;
+	return true;
+}
+
+static void video_input_stop(struct video_input *input)
+{
+	struct video_input_frame item;
+
+	if (input->thread_active) {
+		input->stop = true;
+		os_sem_post(input->queue_semaphore);
+		pthread_join(input->thread, NULL);
+		input->thread_active = false;
+	}
+
+	while (input->queue.size) {
+		circlebuf_pop_front(&input->queue, &item, sizeof(item));
+		release_queued_frame(input->video, item.cache_idx);
+	}
+}
+
+static void video_input_free(struct video_input *input)
+{
+	if (input->video) {
+		video_input_stop(input);
+
+		long skipped = os_atomic_load_long(&input->skipped_frames);
+		long total = os_atomic_load_long(&input->total_frames);
+		if (skipped)
+			blog(LOG_INFO,
+			     "video-io: Video input stopped, number of "
+			     "frames skipped by this input: %ld/%ld",
+			     skipped, total);
+
+		circlebuf_free(&input->queue);
+		os_sem_destroy(input->queue_semaphore);
+		pthread_mutex_destroy(&input->queue_mutex);
+	}
+
+	for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+		video_frame_free(&input->frame[i]);
+	video_scaler_destroy(input->scaler);
+	bfree(input);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void *video_thread(void *param)
 {
 	struct video_output *video = param;
+	bool (*output_cur_frame)(struct video_output *) =
+		video->info.parallel_inputs ? video_output_queue_cur_frame
+					    : video_output_cur_frame;
 
 	os_set_thread_name("video-io: video thread");
 
@@ -184,7 +426,7 @@ static void *video_thread(void *param)
 			break;
 
 		profile_start(video_thread_name);
-		while (!video->stop && !video_output_cur_frame(video)) {
+		while (!video->stop && !output_cur_frame(video)) {
 			os_atomic_inc_long(&video->total_frames);
 		}
 
@@ -270,7 +512,7 @@ void video_output_close(video_t *video)
 	video_output_stop(video);
 
 	for (size_t i = 0; i < video->inputs.num; i++)
-		video_input_free(&video->inputs.array[i]);
+		video_input_free(video->inputs.array[i]);
 	da_free(video->inputs);
 
 	for (size_t i = 0; i < video->info.cache_size; i++)
@@ -288,7 +530,7 @@ static size_t video_get_input_idx(const video_t *video,
 				  void *param)
 {
 	for (size_t i = 0; i < video->inputs.num; i++) {
-		struct video_input *input = video->inputs.array + i;
+		struct video_input *input = video->inputs.array[i];
 		if (input->callback == callback && input->param == param)
 			return i;
 	}
@@ -351,27 +593,35 @@ bool video_output_connect(
 	pthread_mutex_lock(&video->input_mutex);
 
 	if (video_get_input_idx(video, callback, param) == DARRAY_INVALID) {
-		struct video_input input;
-		memset(&input, 0, sizeof(input));
+		struct video_input *input = bzalloc(sizeof(*input));
 
-		input.callback = callback;
-		input.param = param;
+		input->callback = callback;
+		input->param = param;
 
 		if (conversion) {
-			input.conversion = *conversion;
+			input->conversion = *conversion;
 		} else {
-			input.conversion.format = video->info.format;
-			input.conversion.width = video->info.width;
-			input.conversion.height = video->info.height;
+			input->conversion.format = video->info.format;
+			input->conversion.width = video->info.width;
+			input->conversion.height = video->info.height;
 		}
 
-		if (input.conversion.width == 0)
-			input.conversion.width = video->info.width;
-		if (input.conversion.height == 0)
-			input.conversion.height = video->info.height;
+		if (input->conversion.width == 0)
+			input->conversion.width = video->info.width;
+		if (input->conversion.height == 0)
+			input->conversion.height = video->info.height;
+
+		success = video_input_init(input, video);
+		if (success && video->info.parallel_inputs) {
+			success = video_input_start(input, video);
+			if (!success)
+				blog(LOG_ERROR, "video_output_connect: Failed "
+						"to start input thread");
+		}
 
-		success = video_input_init(&input, video);
-		if (success) {
+		if (!success) {
+			video_input_free(input);
+		} else {
 			if (video->inputs.num == 0) {
 				if (!os_atomic_load_long(&video->gpu_refs)) {
 					reset_frames(video);
@@ -412,11 +662,13 @@ void video_output_disconnect(video_t *video,
 	if (!video || !callback)
 		return;
 
+	struct video_input *input = NULL;
+
 	pthread_mutex_lock(&video->input_mutex);
 
 	size_t idx = video_get_input_idx(video, callback, param);
 	if (idx != DARRAY_INVALID) {
-		video_input_free(video->inputs.array + idx);
+		input = video->inputs.array[idx];
 		da_erase(video->inputs, idx);
 
 		if (video->inputs.num == 0) {
@@ -428,6 +680,11 @@ void video_output_disconnect(video_t *video,
 	}
 
 	pthread_mutex_unlock(&video->input_mutex);
+
+	/* the input's thread is stopped outside of the lock so that the other
+	 * inputs keep receiving frames in the meantime */
+	if (input)
+		video_input_free(input);
 }
 
 bool video_output_active(const video_t *video)
@@ -453,7 +710,17 @@ bool video_output_lock_frame(video_t *video, struct video_frame *frame,
 
 	pthread_mutex_lock(&video->data_mutex);
 
-	if (video->available_frames == 0) {
+	if (video->available_frames == 0 &&
+	    video->queued_frames == video->info.cache_size) {
+		/* every cached frame is still in use by the parallel inputs, so
+		 * there is no frame left that can be repeated instead */
+		for (int i = 0; i < count; i++) {
+			os_atomic_inc_long(&video->skipped_frames);
+			os_atomic_inc_long(&video->total_frames);
+		}
+		locked = false;
+
+	} else if (video->available_frames == 0) {
 		video->cache[video->last_added].count += count;
 		video->cache[video->last_added].skipped += count;
 		locked = false;
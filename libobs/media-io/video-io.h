@@ -87,6 +87,10 @@ struct video_data {
 	uint8_t *data[MAX_AV_PLANES];
 	uint32_t linesize[MAX_AV_PLANES];
 	uint64_t timestamp;
+
+	/* number of frames that were dropped right before this one because
+	 * the receiver fell behind (parallel inputs only) */
+	uint32_t skipped;
 };
 
 struct video_output_info {
@@ -101,6 +105,10 @@ struct video_output_info {
 
 	enum video_colorspace colorspace;
 	enum video_range_type range;
+
+	/* give each connected input its own thread instead of calling them one
+	 * after another from the video thread */
+	bool parallel_inputs;
 };
 
 static inline bool format_is_yuv(enum video_format format)
@@ -16,13 +16,26 @@
 ******************************************************************************/
 
 #include "../util/bmem.h"
+#include "format-conversion.h"
 #include "video-scaler.h"
 
 #include <libswscale/swscale.h>
 
+typedef void (*native_convert_t)(const uint8_t *const input[],
+				 const uint32_t in_linesize[], uint32_t width,
+				 uint32_t start_y, uint32_t end_y,
+				 uint8_t *output[],
+				 const uint32_t out_linesize[]);
+
 struct video_scaler {
 	struct SwsContext *swscale;
 	int src_height;
+
+	/* used instead of swscale when only the format changes */
+	native_convert_t native_convert;
+	bool native_rgbx;
+	struct rgb_to_yuv_coeffs coeffs;
+	uint32_t width;
 };
 
 static inline enum AVPixelFormat
@@ -113,6 +126,50 @@ static inline int get_ffmpeg_range_type(enum video_range_type type)
 	return 0;
 }
 
+static inline bool is_709(enum video_colorspace cs)
+{
+	return cs == VIDEO_CS_709;
+}
+
+static bool init_native_conversion(struct video_scaler *scaler,
+				   const struct video_scale_info *dst,
+				   const struct video_scale_info *src)
+{
+	enum video_format from = src->format;
+	enum video_format to = dst->format;
+
+	if (dst->width != src->width || dst->height != src->height)
+		return false;
+
+	if (from == VIDEO_FORMAT_RGBA || from == VIDEO_FORMAT_BGRA ||
+	    from == VIDEO_FORMAT_BGRX) {
+		if (to != VIDEO_FORMAT_NV12)
+			return false;
+
+		rgb_to_yuv_coeffs_init(&scaler->coeffs, from, dst->colorspace,
+				       dst->range);
+		scaler->native_rgbx = true;
+		return true;
+	}
+
+	/* YUV to YUV conversions only repack the planes */
+	if (resolve_video_range(from, src->range) !=
+		    resolve_video_range(to, dst->range) ||
+	    is_709(src->colorspace) != is_709(dst->colorspace))
+		return false;
+
+	if (from == VIDEO_FORMAT_NV12 && to == VIDEO_FORMAT_I420)
+		scaler->native_convert = convert_nv12_to_i420;
+	else if (from == VIDEO_FORMAT_I420 && to == VIDEO_FORMAT_NV12)
+		scaler->native_convert = convert_i420_to_nv12;
+	else if (from == VIDEO_FORMAT_I444 && to == VIDEO_FORMAT_NV12)
+		scaler->native_convert = convert_i444_to_nv12;
+	else if (from == VIDEO_FORMAT_I444 && to == VIDEO_FORMAT_I420)
+		scaler->native_convert = convert_i444_to_i420;
+
+	return scaler->native_convert != NULL;
+}
+
 #define FIXED_1_0 (1 << 16)
 
 int video_scaler_create(video_scaler_t **scaler_out,
@@ -138,6 +195,12 @@ int video_scaler_create(video_scaler_t **scaler_out,
 
 	scaler = bzalloc(sizeof(struct video_scaler));
 	scaler->src_height = src->height;
+	scaler->width = src->width;
+
+	if (init_native_conversion(scaler, dst, src)) {
+		*scaler_out = scaler;
+		return VIDEO_SCALER_SUCCESS;
+	}
 
 	scaler->swscale = sws_getCachedContext(NULL, src->width, src->height,
 					       format_src, dst->width,
@@ -181,6 +244,20 @@ bool video_scaler_scale(video_scaler_t *scaler, uint8_t *output[],
 	if (!scaler)
 		return false;
 
+	if (scaler->native_rgbx) {
+		convert_rgbx_to_nv12(input[0], in_linesize[0], scaler->width, 0,
+				     scaler->src_height, output, out_linesize,
+				     &scaler->coeffs);
+		return true;
+	}
+
+	if (scaler->native_convert) {
+		scaler->native_convert(input, in_linesize, scaler->width, 0,
+				       scaler->src_height, output,
+				       out_linesize);
+		return true;
+	}
+
 	int ret = sws_scale(scaler->swscale, input, (const int *)in_linesize, 0,
 			    scaler->src_height, output,
 			    (const int *)out_linesize);
@@ -36,7 +36,10 @@ static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 			da_push_back(audio->render_order, &s);
 	}
 
-	UNUSED_PARAMETER(parent);
+	if (parent) {
+		struct audio_tree_edge edge = {parent, source};
+		da_push_back(audio->render_edges, &edge);
+	}
 }
 
 static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
@@ -45,12 +48,19 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 }
 
 static inline void mix_audio(struct audio_output_data *mixes,
-			     obs_source_t *source, size_t channels,
-			     size_t sample_rate, struct ts_info *ts)
+			     obs_source_t *source, uint32_t mixers,
+			     size_t channels, size_t sample_rate,
+			     struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
 
+	/* mixes the source isn't assigned to only contain silence, and
+	 * inactive mixes aren't output at all */
+	mixers &= source->audio_mixers;
+	if (!mixers)
+		return;
+
 	if (source->audio_ts < ts->start || ts->end <= source->audio_ts)
 		return;
 
@@ -64,17 +74,14 @@ static inline void mix_audio(struct audio_output_data *mixes,
 	}
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
+		if ((mixers & (1 << mix_idx)) == 0)
+			continue;
 
-			mix += start_point;
-			end = aud + total_floats;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch];
+			float *aud = source->audio_output_buf[mix_idx][ch];
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_mix_add(mix + start_point, aud, total_floats);
 		}
 	}
 }
@@ -373,6 +380,100 @@ static inline const char *calc_min_ts(struct obs_core_data *data,
 	return buffering_name;
 }
 
+struct audio_render_info {
+	obs_source_t **sources;
+	uint32_t mixers;
+	size_t channels;
+	size_t sample_rate;
+	size_t audio_size;
+};
+
+static void render_audio_sources(void *param, size_t start, size_t end)
+{
+	struct audio_render_info *info = param;
+
+	for (size_t i = start; i < end; i++)
+		obs_source_audio_render(info->sources[i], info->mixers,
+					info->channels, info->sample_rate,
+					info->audio_size);
+}
+
+/* a source can only be rendered once every source it mixes has been, so each
+ * source gets a level one higher than the highest level of its children.
+ * the edges were pushed children first, so one pass is usually enough. */
+static size_t calc_render_levels(struct obs_core_audio *audio)
+{
+	size_t num = audio->render_order.num;
+	size_t max_level = 0;
+	bool changed = true;
+
+	da_resize(audio->render_levels, num);
+	memset(audio->render_levels.array, 0, num * sizeof(size_t));
+
+	for (size_t pass = 0; changed && pass < num; pass++) {
+		changed = false;
+
+		for (size_t i = 0; i < audio->render_edges.num; i++) {
+			struct audio_tree_edge *edge =
+				&audio->render_edges.array[i];
+			size_t parent = da_find(audio->render_order,
+						&edge->parent, 0);
+			size_t child = da_find(audio->render_order,
+					       &edge->child, 0);
+			size_t *levels = audio->render_levels.array;
+
+			if (parent == DARRAY_INVALID || child == DARRAY_INVALID)
+				continue;
+			if (levels[parent] > levels[child])
+				continue;
+
+			levels[parent] = levels[child] + 1;
+			if (levels[parent] > max_level)
+				max_level = levels[parent];
+			changed = true;
+		}
+	}
+
+	return max_level;
+}
+
+/* sources only touch their own buffers while rendering, and read the output
+ * of their children, so every source of a level (including the audio filters
+ * of sources rendered on this thread) can be rendered in parallel once the
+ * level below it is done. */
+static void render_audio_tree(struct obs_core_audio *audio, uint32_t mixers,
+			      size_t channels, size_t sample_rate,
+			      size_t audio_size)
+{
+	os_task_pool_t *pool = obs->task_pool;
+	struct audio_render_info info = {NULL, mixers, channels, sample_rate,
+					 audio_size};
+	size_t max_level;
+
+	if (!os_task_pool_get_threads(pool) ||
+	    !os_atomic_load_bool(&obs->parallel_audio_render)) {
+		info.sources = audio->render_order.array;
+		render_audio_sources(&info, 0, audio->render_order.num);
+		return;
+	}
+
+	max_level = calc_render_levels(audio);
+
+	for (size_t level = 0; level <= max_level; level++) {
+		da_resize(audio->render_level, 0);
+
+		for (size_t i = 0; i < audio->render_order.num; i++) {
+			if (audio->render_levels.array[i] == level)
+				da_push_back(audio->render_level,
+					     &audio->render_order.array[i]);
+		}
+
+		info.sources = audio->render_level.array;
+		os_task_pool_parallel_for(pool, 0, audio->render_level.num, 1,
+					  render_audio_sources, &info);
+	}
+}
+
 static inline void release_audio_sources(struct obs_core_audio *audio)
 {
 	for (size_t i = 0; i < audio->render_order.num; i++)
@@ -393,6 +494,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	uint64_t min_ts;
 
 	da_resize(audio->render_order, 0);
+	da_resize(audio->render_edges, 0);
 	da_resize(audio->root_nodes, 0);
 
 	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
@@ -431,11 +533,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* render audio data */
-	for (size_t i = 0; i < audio->render_order.num; i++) {
-		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate,
-					audio_size);
-	}
+	render_audio_tree(audio, mixers, channels, sample_rate, audio_size);
 
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
@@ -461,8 +559,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 			pthread_mutex_lock(&source->audio_buf_mutex);
 
 			if (source->audio_output_buf[0][0] && source->audio_ts)
-				mix_audio(mixes, source, channels, sample_rate,
-					  &ts);
+				mix_audio(mixes, source, mixers, channels,
+					  sample_rate, &ts);
 
 			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
@@ -15,6 +15,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <inttypes.h>
 #include "obs.h"
 #include "obs-internal.h"
 
@@ -41,7 +42,8 @@ const char *obs_encoder_get_display_name(const char *id)
 }
 
 static bool init_encoder(struct obs_encoder *encoder, const char *name,
-			 obs_data_t *settings, obs_data_t *hotkey_data)
+			 obs_data_t *settings, obs_data_t *hotkey_data,
+			 bool private)
 {
 	pthread_mutexattr_t attr;
 
@@ -49,13 +51,14 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 	pthread_mutex_init_value(&encoder->callbacks_mutex);
 	pthread_mutex_init_value(&encoder->outputs_mutex);
 	pthread_mutex_init_value(&encoder->pause.mutex);
+	pthread_mutex_init_value(&encoder->async_mutex);
 
 	if (pthread_mutexattr_init(&attr) != 0)
 		return false;
 	if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
 		return false;
 	if (!obs_context_data_init(&encoder->context, OBS_OBJ_TYPE_ENCODER,
-				   settings, name, hotkey_data, false))
+				   settings, name, hotkey_data, private))
 		return false;
 	if (pthread_mutex_init(&encoder->init_mutex, &attr) != 0)
 		return false;
@@ -65,6 +68,8 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 		return false;
 	if (pthread_mutex_init(&encoder->pause.mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&encoder->async_mutex, NULL) != 0)
+		return false;
 
 	if (encoder->orig_info.get_defaults) {
 		encoder->orig_info.get_defaults(encoder->context.settings);
@@ -79,7 +84,8 @@ static bool init_encoder(struct obs_encoder *encoder, const char *name,
 
 static struct obs_encoder *
 create_encoder(const char *id, enum obs_encoder_type type, const char *name,
-	       obs_data_t *settings, size_t mixer_idx, obs_data_t *hotkey_data)
+	       obs_data_t *settings, size_t mixer_idx, obs_data_t *hotkey_data,
+	       bool private)
 {
 	struct obs_encoder *encoder;
 	struct obs_encoder_info *ei = find_encoder(id);
@@ -103,7 +109,7 @@ create_encoder(const char *id, enum obs_encoder_type type, const char *name,
 		encoder->orig_info = *ei;
 	}
 
-	success = init_encoder(encoder, name, settings, hotkey_data);
+	success = init_encoder(encoder, name, settings, hotkey_data, private);
 	if (!success) {
 		blog(LOG_ERROR, "creating encoder '%s' (%s) failed", name, id);
 		obs_encoder_destroy(encoder);
@@ -113,8 +119,11 @@ create_encoder(const char *id, enum obs_encoder_type type, const char *name,
 	encoder->control = bzalloc(sizeof(obs_weak_encoder_t));
 	encoder->control->encoder = encoder;
 
-	obs_context_data_insert(&encoder->context, &obs->data.encoders_mutex,
-				&obs->data.first_encoder);
+	/* private encoders can't be enumerated or looked up by name */
+	if (!private)
+		obs_context_data_insert(&encoder->context,
+					&obs->data.encoders_mutex,
+					&obs->data.first_encoder);
 
 	blog(LOG_DEBUG, "encoder '%s' (%s) created", name, id);
 	return encoder;
@@ -127,7 +136,7 @@ obs_encoder_t *obs_video_encoder_create(const char *id, const char *name,
 	if (!name || !id)
 		return NULL;
 	return create_encoder(id, OBS_ENCODER_VIDEO, name, settings, 0,
-			      hotkey_data);
+			      hotkey_data, false);
 }
 
 obs_encoder_t *obs_audio_encoder_create(const char *id, const char *name,
@@ -137,10 +146,16 @@ obs_encoder_t *obs_audio_encoder_create(const char *id, const char *name,
 	if (!name || !id)
 		return NULL;
 	return create_encoder(id, OBS_ENCODER_AUDIO, name, settings, mixer_idx,
-			      hotkey_data);
+			      hotkey_data, false);
 }
 
 static void receive_video(void *param, struct video_data *frame);
+static void start_async_encode(struct obs_encoder *encoder,
+			       const struct video_scale_info *info);
+static void stop_async_encode(struct obs_encoder *encoder);
+static bool dedup_attach(struct obs_encoder *encoder);
+static void dedup_detach(struct obs_encoder *encoder);
+static struct obs_encoder *dedup_get_shared(struct obs_encoder *encoder);
 static void receive_audio(void *param, size_t mix_idx, struct audio_data *data);
 
 static inline void get_audio_info(const struct obs_encoder *encoder,
@@ -201,8 +216,10 @@ static void add_connection(struct obs_encoder *encoder)
 		struct audio_convert_info audio_info = {0};
 		get_audio_info(encoder, &audio_info);
 
-		audio_output_connect(encoder->media, encoder->mixer_idx,
-				     &audio_info, receive_audio, encoder);
+		if (!dedup_attach(encoder))
+			audio_output_connect(encoder->media, encoder->mixer_idx,
+					     &audio_info, receive_audio,
+					     encoder);
 	} else {
 		struct video_scale_info info = {0};
 		get_video_info(encoder, &info);
@@ -210,6 +227,7 @@ static void add_connection(struct obs_encoder *encoder)
 		if (gpu_encode_available(encoder)) {
 			start_gpu_encode(encoder);
 		} else {
+			start_async_encode(encoder, &info);
 			start_raw_video(encoder->media, &info, receive_video,
 					encoder);
 		}
@@ -221,13 +239,18 @@ static void add_connection(struct obs_encoder *encoder)
 static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
-		audio_output_disconnect(encoder->media, encoder->mixer_idx,
-					receive_audio, encoder);
+		if (encoder->dedup_shared)
+			dedup_detach(encoder);
+		else
+			audio_output_disconnect(encoder->media,
+						encoder->mixer_idx,
+						receive_audio, encoder);
 	} else {
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
 		} else {
 			stop_raw_video(encoder->media, receive_video, encoder);
+			stop_async_encode(encoder);
 		}
 	}
 
@@ -269,10 +292,12 @@ static void obs_encoder_actually_destroy(obs_encoder_t *encoder)
 		if (encoder->context.data)
 			encoder->info.destroy(encoder->context.data);
 		da_free(encoder->callbacks);
+		da_free(encoder->dedup_clients);
 		pthread_mutex_destroy(&encoder->init_mutex);
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
 		pthread_mutex_destroy(&encoder->pause.mutex);
+		pthread_mutex_destroy(&encoder->async_mutex);
 		obs_context_data_free(&encoder->context);
 		if (encoder->owns_info_id)
 			bfree((void *)encoder->info.id);
@@ -389,6 +414,8 @@ obs_properties_t *obs_encoder_properties(const obs_encoder_t *encoder)
 
 void obs_encoder_update(obs_encoder_t *encoder, obs_data_t *settings)
 {
+	struct obs_encoder *shared;
+
 	if (!obs_encoder_valid(encoder, "obs_encoder_update"))
 		return;
 
@@ -397,6 +424,13 @@ void obs_encoder_update(obs_encoder_t *encoder, obs_data_t *settings)
 	if (encoder->info.update && encoder->context.data)
 		encoder->info.update(encoder->context.data,
 				     encoder->context.settings);
+
+	/* the shared encoder does the actual encoding for this one */
+	shared = dedup_get_shared(encoder);
+	if (shared) {
+		obs_encoder_update(shared, encoder->context.settings);
+		obs_encoder_release(shared);
+	}
 }
 
 bool obs_encoder_get_extra_data(const obs_encoder_t *encoder,
@@ -594,6 +628,8 @@ void obs_encoder_start(obs_encoder_t *encoder,
 	pthread_mutex_unlock(&encoder->init_mutex);
 }
 
+static void trim_encoder_packet_pool(void);
+
 static inline bool obs_encoder_stop_internal(
 	obs_encoder_t *encoder,
 	void (*new_packet)(void *param, struct encoder_packet *packet),
@@ -615,6 +651,7 @@ static inline bool obs_encoder_stop_internal(
 	if (last) {
 		remove_connection(encoder, true);
 		encoder->initialized = false;
+		trim_encoder_packet_pool();
 
 		if (encoder->destroy_on_stop) {
 			pthread_mutex_unlock(&encoder->init_mutex);
@@ -844,7 +881,6 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 				    struct encoder_packet *packet)
 {
 	struct encoder_packet first_packet;
-	DARRAY(uint8_t) data;
 	uint8_t *sei;
 	size_t size;
 
@@ -852,25 +888,24 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 	if (!packet->keyframe)
 		return;
 
-	da_init(data);
-
 	if (!get_sei(encoder, &sei, &size) || !sei || !size) {
 		cb->new_packet(cb->param, packet);
 		cb->sent_first_packet = true;
 		return;
 	}
 
-	da_push_back_array(data, sei, size);
-	da_push_back_array(data, packet->data, packet->size);
-
+	/* outputs keep references to packets, so this needs to be a
+	 * reference counted packet like all the others */
 	first_packet = *packet;
-	first_packet.data = data.array;
-	first_packet.size = data.num;
+	first_packet.size = size + packet->size;
+	obs_encoder_packet_alloc_data(&first_packet);
+	memcpy(first_packet.data, sei, size);
+	memcpy(first_packet.data + size, packet->data, packet->size);
 
 	cb->new_packet(cb->param, &first_packet);
 	cb->sent_first_packet = true;
 
-	da_free(data);
+	obs_encoder_packet_release(&first_packet);
 }
 
 static inline void send_packet(struct obs_encoder *encoder,
@@ -884,19 +919,28 @@ static inline void send_packet(struct obs_encoder *encoder,
 		cb->new_packet(cb->param, packet);
 }
 
+static void force_stop_outputs(struct obs_encoder *encoder)
+{
+	pthread_mutex_lock(&encoder->outputs_mutex);
+	for (size_t i = 0; i < encoder->outputs.num; i++) {
+		struct obs_output *output = encoder->outputs.array[i];
+		obs_output_force_stop(output);
+
+		pthread_mutex_lock(&output->interleaved_mutex);
+		output->info.encoded_packet(output->context.data, NULL);
+		pthread_mutex_unlock(&output->interleaved_mutex);
+	}
+	pthread_mutex_unlock(&encoder->outputs_mutex);
+}
+
+static void force_stop_dedup_clients(struct obs_encoder *encoder);
+
 void full_stop(struct obs_encoder *encoder)
 {
 	if (encoder) {
-		pthread_mutex_lock(&encoder->outputs_mutex);
-		for (size_t i = 0; i < encoder->outputs.num; i++) {
-			struct obs_output *output = encoder->outputs.array[i];
-			obs_output_force_stop(output);
-
-			pthread_mutex_lock(&output->interleaved_mutex);
-			output->info.encoded_packet(output->context.data, NULL);
-			pthread_mutex_unlock(&output->interleaved_mutex);
-		}
-		pthread_mutex_unlock(&encoder->outputs_mutex);
+		force_stop_outputs(encoder);
+		if (encoder->dedup_is_shared)
+			force_stop_dedup_clients(encoder);
 
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 		da_free(encoder->callbacks);
@@ -904,45 +948,68 @@ void full_stop(struct obs_encoder *encoder)
 
 		remove_connection(encoder, false);
 		encoder->initialized = false;
+		trim_encoder_packet_pool();
 	}
 }
 
-void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
-			     bool received, struct encoder_packet *pkt)
+/* sends a packet to every callback of the encoder.  the packet's data is
+ * copied once and every output then shares that copy by reference, unless it
+ * already is a reference counted instance, as packets of a shared audio
+ * encoder are */
+static void send_received_packet(struct obs_encoder *encoder,
+				 struct encoder_packet *pkt, bool is_instance)
 {
-	if (!success) {
-		blog(LOG_ERROR, "Error encoding with encoder '%s'",
-		     encoder->context.name);
-		full_stop(encoder);
-		return;
+	if (!encoder->first_received) {
+		encoder->offset_usec = packet_dts_usec(pkt);
+		encoder->first_received = true;
 	}
 
-	if (received) {
-		if (!encoder->first_received) {
-			encoder->offset_usec = packet_dts_usec(pkt);
-			encoder->first_received = true;
-		}
+	/* we use system time here to ensure sync with other encoders,
+	 * you do not want to use relative timestamps here */
+	pkt->dts_usec = encoder->start_ts / 1000 + packet_dts_usec(pkt) -
+			encoder->offset_usec;
+	pkt->sys_dts_usec = pkt->dts_usec;
 
-		/* we use system time here to ensure sync with other encoders,
-		 * you do not want to use relative timestamps here */
-		pkt->dts_usec = encoder->start_ts / 1000 +
-				packet_dts_usec(pkt) - encoder->offset_usec;
-		pkt->sys_dts_usec = pkt->dts_usec;
+	pthread_mutex_lock(&encoder->pause.mutex);
+	pkt->sys_dts_usec += encoder->pause.ts_offset / 1000;
+	pthread_mutex_unlock(&encoder->pause.mutex);
 
-		pthread_mutex_lock(&encoder->pause.mutex);
-		pkt->sys_dts_usec += encoder->pause.ts_offset / 1000;
-		pthread_mutex_unlock(&encoder->pause.mutex);
+	pthread_mutex_lock(&encoder->callbacks_mutex);
 
-		pthread_mutex_lock(&encoder->callbacks_mutex);
+	if (encoder->callbacks.num) {
+		struct encoder_packet shared;
+
+		if (is_instance)
+			obs_encoder_packet_ref(&shared, pkt);
+		else
+			obs_encoder_packet_create_instance(&shared, pkt);
 
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
 			struct encoder_callback *cb;
+			struct encoder_packet packet = shared;
+
 			cb = encoder->callbacks.array + (i - 1);
-			send_packet(encoder, cb, pkt);
+			send_packet(encoder, cb, &packet);
 		}
 
-		pthread_mutex_unlock(&encoder->callbacks_mutex);
+		obs_encoder_packet_release(&shared);
+	}
+
+	pthread_mutex_unlock(&encoder->callbacks_mutex);
+}
+
+void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
+			     bool received, struct encoder_packet *pkt)
+{
+	if (!success) {
+		blog(LOG_ERROR, "Error encoding with encoder '%s'",
+		     encoder->context.name);
+		full_stop(encoder);
+		return;
 	}
+
+	if (received)
+		send_received_packet(encoder, pkt, false);
 }
 
 static const char *do_encode_name = "do_encode";
@@ -973,6 +1040,217 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 	return success;
 }
 
+/* ------------------------------------------------------------------------- */
+/* async video encoding */
+
+static inline bool encoder_uses_async(const struct obs_encoder *encoder)
+{
+	return encoder->info.type == OBS_ENCODER_VIDEO &&
+	       encoder->info.submit_frame && encoder->info.receive_packet;
+}
+
+static bool drain_async_packets(struct obs_encoder *encoder)
+{
+	for (;;) {
+		struct encoder_packet pkt = {0};
+		bool received = false;
+
+		pkt.timebase_num = encoder->timebase_num;
+		pkt.timebase_den = encoder->timebase_den;
+		pkt.encoder = encoder;
+
+		if (!encoder->info.receive_packet(encoder->context.data, &pkt,
+						  &received))
+			return false;
+		if (!received)
+			return true;
+
+		send_off_encoder_packet(encoder, true, true, &pkt);
+	}
+}
+
+static bool encode_async_frame(struct obs_encoder *encoder,
+			       struct encoder_async_frame *slot)
+{
+	struct encoder_frame enc_frame;
+	bool success;
+
+	memset(&enc_frame, 0, sizeof(struct encoder_frame));
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		enc_frame.data[i] = slot->frame.data[i];
+		enc_frame.linesize[i] = slot->frame.linesize[i];
+	}
+
+	enc_frame.frames = 1;
+	enc_frame.pts = slot->pts;
+
+	profile_start(encoder->profile_encoder_encode_name);
+	success = encoder->info.submit_frame(encoder->context.data,
+					     &enc_frame) &&
+		  drain_async_packets(encoder);
+	profile_end(encoder->profile_encoder_encode_name);
+
+	return success;
+}
+
+static void *async_encode_thread(void *param)
+{
+	struct obs_encoder *encoder = param;
+
+	os_set_thread_name("obs async encode thread");
+
+	while (os_sem_wait(encoder->async_sem) == 0) {
+		struct encoder_async_frame *slot = NULL;
+
+		/* frames still queued when stopping are encoded so that the
+		 * output receives every frame it was handed */
+		pthread_mutex_lock(&encoder->async_mutex);
+		if (encoder->async_queued)
+			slot = &encoder->async_frames[encoder->async_head];
+		pthread_mutex_unlock(&encoder->async_mutex);
+
+		if (!slot) {
+			if (os_atomic_load_bool(&encoder->async_stop))
+				break;
+			continue;
+		}
+
+		profile_start(do_encode_name);
+		bool success = encode_async_frame(encoder, slot);
+		profile_end(do_encode_name);
+
+		pthread_mutex_lock(&encoder->async_mutex);
+		encoder->async_head =
+			(encoder->async_head + 1) % ENCODER_ASYNC_QUEUE_SIZE;
+		encoder->async_queued--;
+		pthread_mutex_unlock(&encoder->async_mutex);
+
+		/* full_stop joins this thread, so leave it to the video
+		 * thread to stop the encoder */
+		if (!success) {
+			blog(LOG_ERROR, "Error encoding with encoder '%s'",
+			     encoder->context.name);
+			os_atomic_set_bool(&encoder->async_error, true);
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static void free_async_frames(struct obs_encoder *encoder)
+{
+	for (size_t i = 0; i < ENCODER_ASYNC_QUEUE_SIZE; i++)
+		video_frame_free(&encoder->async_frames[i].frame);
+}
+
+static void start_async_encode(struct obs_encoder *encoder,
+			       const struct video_scale_info *info)
+{
+	if (!encoder_uses_async(encoder))
+		return;
+
+	if (!encoder->profile_encoder_encode_name)
+		encoder->profile_encoder_encode_name =
+			profile_store_name(obs_get_profiler_name_store(),
+					   "encode(%s)", encoder->context.name);
+
+	for (size_t i = 0; i < ENCODER_ASYNC_QUEUE_SIZE; i++)
+		video_frame_init(&encoder->async_frames[i].frame, info->format,
+				 info->width, info->height);
+
+	encoder->async_format = info->format;
+	encoder->async_height = info->height;
+	encoder->async_head = 0;
+	encoder->async_queued = 0;
+	encoder->async_total_frames = 0;
+	encoder->async_skipped_frames = 0;
+	encoder->async_stop = false;
+	encoder->async_error = false;
+
+	if (os_sem_init(&encoder->async_sem, 0) != 0)
+		goto fail;
+	if (pthread_create(&encoder->async_thread, NULL, async_encode_thread,
+			   encoder) != 0)
+		goto fail;
+
+	encoder->async_thread_active = true;
+	return;
+
+fail:
+	blog(LOG_WARNING,
+	     "Failed to start async encode thread for encoder "
+	     "'%s', encoding on the video thread",
+	     encoder->context.name);
+	os_sem_destroy(encoder->async_sem);
+	encoder->async_sem = NULL;
+	free_async_frames(encoder);
+}
+
+static void stop_async_encode(struct obs_encoder *encoder)
+{
+	if (!encoder->async_thread_active)
+		return;
+
+	os_atomic_set_bool(&encoder->async_stop, true);
+	os_sem_post(encoder->async_sem);
+	pthread_join(encoder->async_thread, NULL);
+	encoder->async_thread_active = false;
+
+	os_sem_destroy(encoder->async_sem);
+	encoder->async_sem = NULL;
+	free_async_frames(encoder);
+
+	if (encoder->async_skipped_frames)
+		blog(LOG_INFO,
+		     "encoder '%s': skipped %" PRIu32 " of %" PRIu32
+		     " frames because the encode queue was full",
+		     encoder->context.name, encoder->async_skipped_frames,
+		     encoder->async_total_frames);
+}
+
+static void queue_async_frame(struct obs_encoder *encoder,
+			      struct video_data *frame)
+{
+	struct encoder_async_frame *slot;
+	struct video_frame src;
+	size_t idx;
+
+	encoder->async_total_frames++;
+
+	pthread_mutex_lock(&encoder->async_mutex);
+	if (encoder->async_queued == ENCODER_ASYNC_QUEUE_SIZE) {
+		encoder->async_skipped_frames++;
+		pthread_mutex_unlock(&encoder->async_mutex);
+		return;
+	}
+	idx = (encoder->async_head + encoder->async_queued) %
+	      ENCODER_ASYNC_QUEUE_SIZE;
+	pthread_mutex_unlock(&encoder->async_mutex);
+
+	/* only the encode thread moves the head, and it never reads past the
+	 * queued count, so the free slot can be filled without the lock */
+	slot = &encoder->async_frames[idx];
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		src.data[i] = frame->data[i];
+		src.linesize[i] = frame->linesize[i];
+	}
+
+	video_frame_copy(&slot->frame, &src, encoder->async_format,
+			 encoder->async_height);
+	slot->pts = encoder->cur_pts;
+
+	pthread_mutex_lock(&encoder->async_mutex);
+	encoder->async_queued++;
+	pthread_mutex_unlock(&encoder->async_mutex);
+
+	os_sem_post(encoder->async_sem);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline bool video_pause_check_internal(struct pause_data *pause,
 					      uint64_t ts)
 {
@@ -1029,9 +1307,26 @@ static void receive_video(void *param, struct video_data *frame)
 		enc_frame.linesize[i] = frame->linesize[i];
 	}
 
-	if (!encoder->start_ts)
+	/* frames the video output dropped because this encoder fell behind
+	 * still take up time in the stream */
+	if (encoder->start_ts)
+		encoder->cur_pts += frame->skipped * encoder->timebase_num;
+	else
 		encoder->start_ts = frame->timestamp;
 
+	if (encoder->async_thread_active) {
+		if (os_atomic_load_bool(&encoder->async_error)) {
+			full_stop(encoder);
+			goto wait_for_audio;
+		}
+
+		/* a skipped frame still advances the pts, which keeps the
+		 * timestamps of the encoded frames in sync with audio */
+		queue_async_frame(encoder, frame);
+		encoder->cur_pts += encoder->timebase_num;
+		goto wait_for_audio;
+	}
+
 	enc_frame.frames = 1;
 	enc_frame.pts = encoder->cur_pts;
 
@@ -1275,6 +1570,304 @@ end:
 	profile_end(receive_audio_name);
 }
 
+/* ------------------------------------------------------------------------- */
+/* audio encoder deduplication */
+
+static pthread_mutex_t dedup_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct obs_encoder *) dedup_encoders = {0};
+
+static bool dedup_config_matches(struct obs_encoder *a,
+				 struct obs_encoder *b)
+{
+	char *a_json;
+	const char *b_json;
+	bool matches;
+
+	if (a->mixer_idx != b->mixer_idx || a->media != b->media)
+		return false;
+	if (strcmp(a->orig_info.id, b->orig_info.id) != 0)
+		return false;
+	if (a->context.settings == b->context.settings)
+		return true;
+
+	/* obs_data_get_json frees the text it returned the last time it was
+	 * called on the same data, and encoders may share their settings */
+	a_json = bstrdup(obs_data_get_json(a->context.settings));
+	b_json = obs_data_get_json(b->context.settings);
+	matches = a_json && b_json && strcmp(a_json, b_json) == 0;
+	bfree(a_json);
+
+	return matches;
+}
+
+static inline bool dedup_matches(struct obs_encoder *shared,
+				 struct obs_encoder *encoder)
+{
+	return shared->samplerate == encoder->samplerate &&
+	       dedup_config_matches(shared, encoder);
+}
+
+static struct obs_encoder *dedup_find(struct obs_encoder *encoder)
+{
+	for (size_t i = 0; i < dedup_encoders.num; i++) {
+		struct obs_encoder *shared = dedup_encoders.array[i];
+		if (dedup_matches(shared, encoder))
+			return shared;
+	}
+
+	return NULL;
+}
+
+static inline bool has_outputs(struct obs_encoder *encoder)
+{
+	bool has_outputs;
+
+	pthread_mutex_lock(&encoder->outputs_mutex);
+	has_outputs = encoder->outputs.num > 0;
+	pthread_mutex_unlock(&encoder->outputs_mutex);
+
+	return has_outputs;
+}
+
+/* whether another audio encoder that is not already encoding on its own has
+ * the same configuration and is used by an output, so it may start sharing
+ * encoding with this one later on */
+static bool dedup_has_candidate(struct obs_encoder *encoder)
+{
+	struct obs_encoder *other;
+	bool found = false;
+
+	pthread_mutex_lock(&dedup_mutex);
+	pthread_mutex_lock(&obs->data.encoders_mutex);
+
+	other = obs->data.first_encoder;
+	while (other && !found) {
+		if (other != encoder &&
+		    other->orig_info.type == OBS_ENCODER_AUDIO &&
+		    other->orig_info.id &&
+		    (!encoder_active(other) || other->dedup_shared) &&
+		    dedup_config_matches(other, encoder))
+			found = has_outputs(other);
+
+		other = (struct obs_encoder *)other->context.next;
+	}
+
+	pthread_mutex_unlock(&obs->data.encoders_mutex);
+	pthread_mutex_unlock(&dedup_mutex);
+	return found;
+}
+
+static struct obs_encoder *create_dedup_encoder(struct obs_encoder *encoder)
+{
+	struct obs_encoder *shared;
+	obs_data_t *settings = obs_data_create();
+	struct dstr name = {0};
+
+	/* updates are forwarded to the shared encoder, so it needs its own
+	 * settings even when its clients share theirs */
+	obs_data_apply(settings, encoder->context.settings);
+
+	dstr_printf(&name, "%s (shared)", encoder->context.name);
+	shared = create_encoder(encoder->orig_info.id, OBS_ENCODER_AUDIO,
+				name.array, settings, encoder->mixer_idx, NULL,
+				true);
+	dstr_free(&name);
+	obs_data_release(settings);
+
+	if (!shared)
+		return NULL;
+
+	shared->dedup_is_shared = true;
+	obs_encoder_set_audio(shared, encoder->media);
+	return shared;
+}
+
+static inline int64_t dedup_pts_to_ns(struct obs_encoder *shared, int64_t pts)
+{
+	return pts * 1000000000LL * (int64_t)shared->timebase_num /
+	       (int64_t)shared->timebase_den;
+}
+
+static inline int64_t dedup_ns_to_pts(struct obs_encoder *shared, int64_t ns)
+{
+	return ns * (int64_t)shared->timebase_den /
+	       ((int64_t)shared->timebase_num * 1000000000LL);
+}
+
+/* applies the start offset and pause state of a single encoder to the
+ * packets of the shared encoder.  packets are whole audio frames, so pausing
+ * drops or keeps a frame depending on where its middle falls. */
+static void dedup_packet(void *param, struct encoder_packet *pkt)
+{
+	struct obs_encoder *encoder = param;
+	struct obs_encoder *shared = pkt->encoder;
+	struct encoder_packet packet = *pkt;
+	int64_t frame_ns = (int64_t)audio_frames_to_ns(shared->samplerate,
+						       shared->framesize);
+	int64_t ts = (int64_t)shared->start_ts +
+		     dedup_pts_to_ns(shared, pkt->pts);
+	bool skip = false;
+
+	if (!encoder->first_received) {
+		encoder->first_raw_ts = (uint64_t)ts;
+		encoder->first_received = true;
+	}
+
+	if (!encoder->start_ts) {
+		struct obs_encoder *pair = encoder->paired_encoder;
+		int64_t start_ts = ts;
+
+		if (pair) {
+			/* no video yet, or audio still not synced with the
+			 * video starting point */
+			start_ts = (int64_t)pair->start_ts;
+			if (!start_ts || ts + frame_ns <= start_ts)
+				return;
+		}
+
+		/* the base pts is the shared pts at the starting point */
+		encoder->start_ts = (uint64_t)start_ts;
+		encoder->dedup_base_pts =
+			pkt->pts + dedup_ns_to_pts(shared, start_ts - ts);
+	}
+
+	pthread_mutex_lock(&encoder->pause.mutex);
+	if (encoder->pause.ts_start) {
+		int64_t mid_ts = ts + frame_ns / 2;
+
+		if (encoder->pause.ts_end &&
+		    mid_ts >= (int64_t)encoder->pause.ts_end) {
+			encoder->pause.ts_start = 0;
+			encoder->pause.ts_end = 0;
+		} else if (mid_ts >= (int64_t)encoder->pause.ts_start) {
+			encoder->dedup_base_pts += (int64_t)shared->framesize;
+			skip = true;
+		}
+	}
+	pthread_mutex_unlock(&encoder->pause.mutex);
+
+	if (skip)
+		return;
+
+	packet.pts -= encoder->dedup_base_pts;
+	packet.dts -= encoder->dedup_base_pts;
+	packet.encoder = encoder;
+	send_received_packet(encoder, &packet, true);
+}
+
+/* an audio encoder only shares encoding when another encoder with the same
+ * configuration is encoding or may start to.  the shared encoder is private
+ * and is only ever started, stopped or released with dedup_mutex unlocked,
+ * since the audio thread takes dedup_mutex while it holds the audio output's
+ * input mutex when the shared encoder fails. */
+static bool dedup_attach(struct obs_encoder *encoder)
+{
+	struct obs_encoder *shared;
+	struct obs_encoder *created = NULL;
+
+	if (encoder->dedup_is_shared || !encoder->orig_info.id)
+		return false;
+
+	pthread_mutex_lock(&dedup_mutex);
+	shared = dedup_find(encoder);
+	pthread_mutex_unlock(&dedup_mutex);
+
+	if (!shared) {
+		if (!dedup_has_candidate(encoder))
+			return false;
+
+		created = create_dedup_encoder(encoder);
+		if (!created)
+			return false;
+	}
+
+	pthread_mutex_lock(&dedup_mutex);
+
+	/* another encoder may have been attached in the meantime */
+	shared = dedup_find(encoder);
+	if (shared) {
+		blog(LOG_INFO, "audio encoder '%s' shares encoding with '%s'",
+		     encoder->context.name, shared->context.name);
+	} else if (created) {
+		shared = created;
+		created = NULL;
+		da_push_back(dedup_encoders, &shared);
+	}
+
+	if (shared) {
+		da_push_back(shared->dedup_clients, &encoder);
+		encoder->dedup_shared = shared;
+		encoder->dedup_base_pts = 0;
+	}
+
+	pthread_mutex_unlock(&dedup_mutex);
+
+	obs_encoder_release(created);
+	if (!shared)
+		return false;
+
+	/* the shared encoder is shut down whenever it has no clients left, so
+	 * it may have to be initialized again */
+	if (!obs_encoder_initialize(shared)) {
+		dedup_detach(encoder);
+		return false;
+	}
+
+	obs_encoder_start(shared, dedup_packet, encoder);
+	return true;
+}
+
+static void dedup_detach(struct obs_encoder *encoder)
+{
+	struct obs_encoder *shared = encoder->dedup_shared;
+	bool last;
+
+	pthread_mutex_lock(&dedup_mutex);
+
+	da_erase_item(shared->dedup_clients, &encoder);
+	encoder->dedup_shared = NULL;
+
+	last = !shared->dedup_clients.num;
+	if (last) {
+		da_erase_item(dedup_encoders, &shared);
+		if (!dedup_encoders.num)
+			da_free(dedup_encoders);
+	}
+
+	pthread_mutex_unlock(&dedup_mutex);
+
+	obs_encoder_stop(shared, dedup_packet, encoder);
+
+	if (last)
+		obs_encoder_release(shared);
+}
+
+static struct obs_encoder *dedup_get_shared(struct obs_encoder *encoder)
+{
+	struct obs_encoder *shared;
+
+	pthread_mutex_lock(&dedup_mutex);
+	shared = obs_encoder_get_ref(encoder->dedup_shared);
+	pthread_mutex_unlock(&dedup_mutex);
+
+	return shared;
+}
+
+static void force_stop_dedup_clients(struct obs_encoder *encoder)
+{
+	DARRAY(struct obs_encoder *) clients;
+
+	pthread_mutex_lock(&dedup_mutex);
+	da_init(clients);
+	da_copy(clients, encoder->dedup_clients);
+	pthread_mutex_unlock(&dedup_mutex);
+
+	for (size_t i = 0; i < clients.num; i++)
+		force_stop_outputs(clients.array[i]);
+
+	da_free(clients);
+}
+
 void obs_encoder_add_output(struct obs_encoder *encoder,
 			    struct obs_output *output)
 {
@@ -1297,18 +1890,202 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 	pthread_mutex_unlock(&encoder->outputs_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* encoder packet buffers
+ *
+ *   Packet data is always preceded by its reference count.  Buffers made by
+ * obs_encoder_packet_create_instance come from a pool of power-of-two sized
+ * buffers, have PACKET_POOL_FLAG set in their reference count, and go back to
+ * the pool once released, so a steady stream of packets of similar sizes
+ * doesn't need any allocations.  The idle buffers are limited in number and
+ * total size, and are freed whenever an encoder stops. */
+
+#define PACKET_POOL_FLAG 0x40000000L
+#define PACKET_POOL_MIN_SHIFT 12
+#define PACKET_POOL_CLASSES 12
+#define PACKET_POOL_MAX_FREE 16
+#define PACKET_POOL_MAX_FREE_BYTES (16 * 1024 * 1024)
+
+struct packet_buffer {
+	struct packet_buffer *next;
+	size_t size_class;
+	long refs;
+};
+
+struct packet_pool {
+	struct packet_buffer *free_buffers[PACKET_POOL_CLASSES];
+	size_t num_free[PACKET_POOL_CLASSES];
+	size_t bytes_free;
+
+	uint64_t bytes_allocated;
+	uint64_t bytes_copied;
+};
+
+static pthread_mutex_t packet_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct packet_pool packet_pool = {0};
+
+static inline size_t packet_class_size(size_t size_class)
+{
+	return (size_t)1 << (size_class + PACKET_POOL_MIN_SHIFT);
+}
+
+static inline size_t get_packet_class(size_t size)
+{
+	size_t size_class = 0;
+
+	while (size_class < PACKET_POOL_CLASSES &&
+	       packet_class_size(size_class) < size)
+		size_class++;
+
+	return size_class;
+}
+
+static inline uint8_t *packet_buffer_data(struct packet_buffer *buf)
+{
+	return (uint8_t *)(&buf->refs + 1);
+}
+
+static long *alloc_packet_refs(size_t size)
+{
+	size_t size_class = get_packet_class(size);
+	struct packet_buffer *buf;
+	long *p_refs;
+
+	/* packets too big for the pool are allocated on their own */
+	if (size_class == PACKET_POOL_CLASSES) {
+		p_refs = bmalloc(size + sizeof(long));
+		*p_refs = 1;
+
+		pthread_mutex_lock(&packet_pool_mutex);
+		packet_pool.bytes_allocated += size + sizeof(long);
+		packet_pool.bytes_copied += size;
+		pthread_mutex_unlock(&packet_pool_mutex);
+		return p_refs;
+	}
+
+	pthread_mutex_lock(&packet_pool_mutex);
+	buf = packet_pool.free_buffers[size_class];
+	if (buf) {
+		packet_pool.free_buffers[size_class] = buf->next;
+		packet_pool.num_free[size_class]--;
+		packet_pool.bytes_free -= packet_class_size(size_class);
+	} else {
+		size_t alloc_size = offsetof(struct packet_buffer, refs) +
+				    sizeof(long) +
+				    packet_class_size(size_class);
+		packet_pool.bytes_allocated += alloc_size;
+	}
+	packet_pool.bytes_copied += size;
+	pthread_mutex_unlock(&packet_pool_mutex);
+
+	if (!buf) {
+		buf = bmalloc(offsetof(struct packet_buffer, refs) +
+			      sizeof(long) + packet_class_size(size_class));
+		buf->size_class = size_class;
+	}
+
+	buf->next = NULL;
+	buf->refs = PACKET_POOL_FLAG | 1;
+	return &buf->refs;
+}
+
+static void recycle_packet_buffer(long *p_refs)
+{
+	struct packet_buffer *buf =
+		(struct packet_buffer *)((uint8_t *)p_refs -
+					 offsetof(struct packet_buffer, refs));
+	size_t size_class = buf->size_class;
+	size_t class_size = packet_class_size(size_class);
+
+	pthread_mutex_lock(&packet_pool_mutex);
+	if (packet_pool.num_free[size_class] < PACKET_POOL_MAX_FREE &&
+	    packet_pool.bytes_free + class_size <= PACKET_POOL_MAX_FREE_BYTES) {
+		buf->next = packet_pool.free_buffers[size_class];
+		packet_pool.free_buffers[size_class] = buf;
+		packet_pool.num_free[size_class]++;
+		packet_pool.bytes_free += class_size;
+		buf = NULL;
+	}
+	pthread_mutex_unlock(&packet_pool_mutex);
+
+	bfree(buf);
+}
+
+/* frees the idle buffers, buffers still in use return to the pool later */
+static void trim_encoder_packet_pool(void)
+{
+	struct packet_buffer *free_buffers[PACKET_POOL_CLASSES];
+
+	pthread_mutex_lock(&packet_pool_mutex);
+	memcpy(free_buffers, packet_pool.free_buffers, sizeof(free_buffers));
+	memset(packet_pool.free_buffers, 0, sizeof(packet_pool.free_buffers));
+	memset(packet_pool.num_free, 0, sizeof(packet_pool.num_free));
+	packet_pool.bytes_free = 0;
+	pthread_mutex_unlock(&packet_pool_mutex);
+
+	for (size_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+		struct packet_buffer *buf = free_buffers[i];
+
+		while (buf) {
+			struct packet_buffer *next = buf->next;
+			bfree(buf);
+			buf = next;
+		}
+	}
+}
+
+void free_encoder_packet_pool(void)
+{
+	trim_encoder_packet_pool();
+
+	blog(LOG_INFO,
+	     "Encoder packets: %" PRIu64 " bytes allocated, "
+	     "%" PRIu64 " bytes copied",
+	     packet_pool.bytes_allocated, packet_pool.bytes_copied);
+
+	packet_pool.bytes_allocated = 0;
+	packet_pool.bytes_copied = 0;
+}
+
+uint64_t obs_get_encoder_packet_bytes_allocated(void)
+{
+	uint64_t bytes;
+
+	pthread_mutex_lock(&packet_pool_mutex);
+	bytes = packet_pool.bytes_allocated;
+	pthread_mutex_unlock(&packet_pool_mutex);
+
+	return bytes;
+}
+
+uint64_t obs_get_encoder_packet_bytes_copied(void)
+{
+	uint64_t bytes;
+
+	pthread_mutex_lock(&packet_pool_mutex);
+	bytes = packet_pool.bytes_copied;
+	pthread_mutex_unlock(&packet_pool_mutex);
+
+	return bytes;
+}
+
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 					const struct encoder_packet *src)
 {
 	long *p_refs;
 
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
+	p_refs = alloc_packet_refs(src->size);
 	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
 	memcpy(dst->data, src->data, src->size);
 }
 
+void obs_encoder_packet_alloc_data(struct encoder_packet *packet)
+{
+	long *p_refs = alloc_packet_refs(packet->size);
+	packet->data = (void *)(p_refs + 1);
+}
+
 /* OBS_DEPRECATED */
 void obs_duplicate_encoder_packet(struct encoder_packet *dst,
 				  const struct encoder_packet *src)
@@ -1343,8 +2120,12 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 
 	if (pkt->data) {
 		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
+		long refs = os_atomic_dec_long(p_refs);
+
+		if (refs == 0)
 			bfree(p_refs);
+		else if (refs == PACKET_POOL_FLAG)
+			recycle_packet_buffer(p_refs);
 	}
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
@@ -1476,3 +2257,17 @@ bool obs_encoder_paused(const obs_encoder_t *encoder)
 		       ? os_atomic_load_bool(&encoder->paused)
 		       : false;
 }
+
+uint32_t obs_encoder_get_queued_frames(const obs_encoder_t *encoder)
+{
+	return obs_encoder_valid(encoder, "obs_encoder_get_queued_frames")
+		       ? (uint32_t)encoder->async_queued
+		       : 0;
+}
+
+uint32_t obs_encoder_get_skipped_frames(const obs_encoder_t *encoder)
+{
+	return obs_encoder_valid(encoder, "obs_encoder_get_skipped_frames")
+		       ? encoder->async_skipped_frames
+		       : 0;
+}
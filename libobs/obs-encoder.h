@@ -261,6 +261,35 @@ struct obs_encoder_info {
 			       uint64_t lock_key, uint64_t *next_key,
 			       struct encoder_packet *packet,
 			       bool *received_packet);
+
+	/**
+	 * Video encoder only (optional):  Submits a raw frame to the encoder
+	 * without waiting for its packets.  If both submit_frame and
+	 * receive_packet are implemented, libobs copies raw frames into a
+	 * bounded queue and calls them from a dedicated thread instead of
+	 * calling encode from the video thread.
+	 *
+	 * @param  data   Data associated with this encoder context
+	 * @param  frame  Raw video data to encode
+	 * @return        true if successful, false on critical failure
+	 */
+	bool (*submit_frame)(void *data, struct encoder_frame *frame);
+
+	/**
+	 * Video encoder only (optional):  Gets the next packet produced by
+	 * frames submitted with submit_frame.  Called repeatedly after each
+	 * submitted frame until no packet is received.
+	 *
+	 * @param       data             Data associated with this encoder
+	 *                               context
+	 * @param[out]  packet           Encoder packet output, if any
+	 * @param[out]  received_packet  Set to true if a packet was received,
+	 *                               false otherwise
+	 * @return                       true if successful, false on critical
+	 *                               failure
+	 */
+	bool (*receive_packet)(void *data, struct encoder_packet *packet,
+			       bool *received_packet);
 };
 
 EXPORT void obs_register_encoder_s(const struct obs_encoder_info *info,
@@ -0,0 +1,182 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-interleave.h"
+
+static void queue_pop_front(struct interleave_queue *queue,
+			    struct encoder_packet *packet)
+{
+	*packet = queue->packets.array[queue->head++];
+
+	/* popping only moves the head, the array is compacted once most of
+	 * it is unused */
+	if (queue->head == queue->packets.num) {
+		da_resize(queue->packets, 0);
+		queue->head = 0;
+	} else if (queue->head >= 64 && queue->head * 2 >= queue->packets.num) {
+		da_erase_range(queue->packets, 0, queue->head);
+		queue->head = 0;
+	}
+}
+
+static inline bool heap_before(struct interleave_queues *iq, size_t a,
+			       size_t b)
+{
+	return packet_before(interleave_queue_first(iq, iq->heap[a]),
+			     interleave_queue_first(iq, iq->heap[b]));
+}
+
+static inline void heap_swap(struct interleave_queues *iq, size_t a, size_t b)
+{
+	uint8_t temp = iq->heap[a];
+	iq->heap[a] = iq->heap[b];
+	iq->heap[b] = temp;
+}
+
+static void heap_sift_up(struct interleave_queues *iq, size_t pos)
+{
+	while (pos) {
+		size_t parent = (pos - 1) / 2;
+		if (!heap_before(iq, pos, parent))
+			break;
+
+		heap_swap(iq, pos, parent);
+		pos = parent;
+	}
+}
+
+static void heap_sift_down(struct interleave_queues *iq, size_t pos)
+{
+	size_t size = iq->heap_size;
+
+	for (;;) {
+		size_t child = pos * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && heap_before(iq, child + 1, child))
+			child++;
+		if (!heap_before(iq, child, pos))
+			break;
+
+		heap_swap(iq, pos, child);
+		pos = child;
+	}
+}
+
+void interleave_rebuild(struct interleave_queues *iq)
+{
+	iq->heap_size = 0;
+
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		if (queue_size(&iq->queues[i]))
+			iq->heap[iq->heap_size++] = (uint8_t)i;
+	}
+
+	for (size_t i = iq->heap_size / 2; i > 0; i--)
+		heap_sift_down(iq, i - 1);
+}
+
+void interleave_insert(struct interleave_queues *iq,
+		       const struct encoder_packet *packet)
+{
+	size_t queue_idx = packet_queue_idx(packet);
+	struct interleave_queue *queue = &iq->queues[queue_idx];
+	size_t idx = queue->packets.num;
+
+	/* packets of a track almost always arrive in order */
+	while (idx > queue->head &&
+	       packet_before(packet, queue->packets.array + idx - 1))
+		idx--;
+
+	if (idx == queue->packets.num)
+		da_push_back(queue->packets, packet);
+	else
+		da_insert(queue->packets, idx, packet);
+
+	if (queue_size(queue) == 1) {
+		size_t pos = iq->heap_size++;
+		iq->heap[pos] = (uint8_t)queue_idx;
+		heap_sift_up(iq, pos);
+	} else if (idx == queue->head) {
+		interleave_rebuild(iq);
+	}
+}
+
+void interleave_pop(struct interleave_queues *iq)
+{
+	struct interleave_queue *queue = &iq->queues[iq->heap[0]];
+	struct encoder_packet packet;
+
+	queue_pop_front(queue, &packet);
+
+	if (!queue_size(queue))
+		iq->heap[0] = iq->heap[--iq->heap_size];
+	heap_sift_down(iq, 0);
+}
+
+void interleave_discard_to(struct interleave_queues *iq,
+			   const struct encoder_packet *last, bool inclusive)
+{
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &iq->queues[i];
+		struct encoder_packet packet;
+
+		while (queue_size(queue)) {
+			struct encoder_packet *first =
+				queue->packets.array + queue->head;
+
+			if (inclusive ? packet_before(last, first)
+				      : !packet_before(first, last))
+				break;
+
+			queue_pop_front(queue, &packet);
+			obs_encoder_packet_release(&packet);
+		}
+	}
+
+	interleave_rebuild(iq);
+}
+
+void interleave_discard_before(struct interleave_queues *iq, int64_t dts_usec)
+{
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &iq->queues[i];
+		struct encoder_packet packet;
+
+		while (queue_size(queue) &&
+		       queue->packets.array[queue->head].dts_usec < dts_usec) {
+			queue_pop_front(queue, &packet);
+			obs_encoder_packet_release(&packet);
+		}
+	}
+
+	interleave_rebuild(iq);
+}
+
+void interleave_free(struct interleave_queues *iq)
+{
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &iq->queues[i];
+
+		for (size_t j = queue->head; j < queue->packets.num; j++)
+			obs_encoder_packet_release(queue->packets.array + j);
+		da_free(queue->packets);
+		queue->head = 0;
+	}
+
+	iq->heap_size = 0;
+}
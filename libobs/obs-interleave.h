@@ -0,0 +1,110 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ *   Interleave queues of an output.  Each track (video, and each audio mix)
+ * has its own queue in timestamp order, and a min-heap of the non-empty
+ * queues keyed on their first packets keeps track of which packet is next,
+ * so inserting and removing packets costs O(log k) for k tracks.
+ */
+
+#include "util/darray.h"
+#include "obs.h"
+
+/* packets of a single track, in timestamp order */
+struct interleave_queue {
+	DARRAY(struct encoder_packet) packets;
+	size_t head;
+};
+
+/* one queue for video, one per audio mix */
+#define MAX_INTERLEAVE_QUEUES (MAX_AUDIO_MIXES + 1)
+
+struct interleave_queues {
+	struct interleave_queue queues[MAX_INTERLEAVE_QUEUES];
+	uint8_t heap[MAX_INTERLEAVE_QUEUES];
+	size_t heap_size;
+};
+
+static inline size_t packet_queue_idx(const struct encoder_packet *packet)
+{
+	return packet->type == OBS_ENCODER_VIDEO ? 0 : packet->track_idx + 1;
+}
+
+/* orders by timestamp, with video before audio of the same timestamp */
+static inline bool packet_before(const struct encoder_packet *a,
+				 const struct encoder_packet *b)
+{
+	if (a->dts_usec != b->dts_usec)
+		return a->dts_usec < b->dts_usec;
+	if (a->type != b->type)
+		return a->type == OBS_ENCODER_VIDEO;
+	return packet_queue_idx(a) < packet_queue_idx(b);
+}
+
+static inline size_t queue_size(const struct interleave_queue *queue)
+{
+	return queue->packets.num - queue->head;
+}
+
+static inline struct encoder_packet *
+interleave_queue_first(struct interleave_queues *iq, size_t idx)
+{
+	struct interleave_queue *queue = &iq->queues[idx];
+	return queue_size(queue) ? queue->packets.array + queue->head : NULL;
+}
+
+static inline struct encoder_packet *
+interleave_queue_last(struct interleave_queues *iq, size_t idx)
+{
+	struct interleave_queue *queue = &iq->queues[idx];
+	return queue_size(queue) ? queue->packets.array + queue->packets.num - 1
+				 : NULL;
+}
+
+/* the next packet of the interleave order, or NULL if there are none */
+static inline struct encoder_packet *
+interleave_first(struct interleave_queues *iq)
+{
+	return iq->heap_size ? interleave_queue_first(iq, iq->heap[0]) : NULL;
+}
+
+/* takes ownership of the packet's reference */
+extern void interleave_insert(struct interleave_queues *iq,
+			      const struct encoder_packet *packet);
+
+/* removes the first packet of the interleave order without releasing it */
+extern void interleave_pop(struct interleave_queues *iq);
+
+/* needed whenever packets were removed or changed other than through
+ * interleave_insert and interleave_pop */
+extern void interleave_rebuild(struct interleave_queues *iq);
+
+/* releases every packet that comes before (or, if inclusive, at) the
+ * specified packet in the interleave order */
+extern void interleave_discard_to(struct interleave_queues *iq,
+				  const struct encoder_packet *last,
+				  bool inclusive);
+
+/* releases every packet with a timestamp below dts_usec */
+extern void interleave_discard_before(struct interleave_queues *iq,
+				      int64_t dts_usec);
+
+/* releases every packet */
+extern void interleave_free(struct interleave_queues *iq);
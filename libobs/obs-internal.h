@@ -24,6 +24,7 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/task-pool.h"
 #include "callback/signal.h"
 #include "callback/proc.h"
 
@@ -32,9 +33,13 @@
 
 #include "media-io/audio-resampler.h"
 #include "media-io/video-io.h"
+#include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-mix.h"
+#include "media-io/format-conversion.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
 
 #define NUM_TEXTURES 2
 #define NUM_CHANNELS 3
@@ -257,7 +262,9 @@ struct obs_core_video {
 	gs_effect_t *area_effect;
 	gs_effect_t *bilinear_lowres_effect;
 	gs_effect_t *premultiplied_alpha_effect;
+	gs_effect_t *sprite_batch_effect;
 	gs_samplerstate_t *point_sampler;
+	gs_sprite_batch_t *sprite_batch;
 	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
 	int cur_texture;
 	long raw_active;
@@ -283,6 +290,7 @@ struct obs_core_video {
 	bool thread_initialized;
 
 	bool gpu_conversion;
+	struct rgb_to_yuv_coeffs cpu_conversion_coeffs;
 	const char *conversion_techs[NUM_CHANNELS];
 	bool conversion_needed;
 	float conversion_width_i;
@@ -310,11 +318,19 @@ struct obs_core_video {
 
 struct audio_monitor;
 
+struct audio_tree_edge {
+	struct obs_source *parent;
+	struct obs_source *child;
+};
+
 struct obs_core_audio {
 	audio_t *audio;
 
 	DARRAY(struct obs_source *) render_order;
 	DARRAY(struct obs_source *) root_nodes;
+	DARRAY(struct obs_source *) render_level;
+	DARRAY(size_t) render_levels;
+	DARRAY(struct audio_tree_edge) render_edges;
 
 	uint64_t buffered_ts;
 	struct circlebuf buffered_timestamps;
@@ -411,9 +427,15 @@ struct obs_core {
 
 	char *locale;
 	char *module_config_path;
+	char *shader_cache_path;
 	bool name_store_owned;
 	profiler_name_store_t *name_store;
 
+	/* shared worker threads for short parallel jobs */
+	os_task_pool_t *task_pool;
+	volatile bool parallel_audio_render;
+	volatile bool parallel_video_inputs;
+
 	/* segmented into multiple sub-structures to keep things a bit more
 	 * clean and organized */
 	struct obs_core_video video;
@@ -523,10 +545,25 @@ static inline bool obs_weak_ref_get_ref(struct obs_weak_ref *ref)
 /* ------------------------------------------------------------------------- */
 /* sources  */
 
+struct async_owned_frame;
+
 struct async_frame {
 	struct obs_source_frame *frame;
 	long unused_count;
-	bool used;
+	volatile bool used;
+};
+
+/* Single-producer/single-consumer queue of async frames.  The producer is the
+ * thread outputting frames, which pushes without locking.  The consumer is
+ * the graphics thread, which only reads or pops with async_mutex held.  Head
+ * and tail wrap at twice the size so a full ring can be told apart from an
+ * empty one. */
+#define ASYNC_FRAME_RING_SIZE 32
+
+struct async_frame_ring {
+	struct obs_source_frame *frames[ASYNC_FRAME_RING_SIZE];
+	volatile long head;
+	volatile long tail;
 };
 
 enum audio_action_type {
@@ -588,6 +625,9 @@ struct obs_source {
 	/* used to temporarily disable sources if needed */
 	bool enabled;
 
+	/* incremented whenever the video of a static source changes */
+	volatile long video_version;
+
 	/* timing (if video is present, is based upon video) */
 	volatile bool timing_set;
 	volatile uint64_t timing_adjust;
@@ -648,8 +688,11 @@ struct obs_source {
 	bool async_decoupled;
 	struct obs_source_frame *async_preload_frame;
 	DARRAY(struct async_frame) async_cache;
-	DARRAY(struct obs_source_frame *) async_frames;
+	DARRAY(struct async_owned_frame *) async_owned_frames;
+	struct async_frame_ring async_frames;
 	pthread_mutex_t async_mutex;
+	volatile long async_frames_lost;
+	volatile long async_frames_late;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -824,6 +867,58 @@ extern bool set_async_texture_size(struct obs_source *source,
 extern void remove_async_frame(obs_source_t *source,
 			       struct obs_source_frame *frame);
 
+#define ASYNC_FRAME_RING_MASK (ASYNC_FRAME_RING_SIZE * 2 - 1)
+
+static inline size_t async_frames_count(const obs_source_t *source)
+{
+	const struct async_frame_ring *ring = &source->async_frames;
+	long head = os_atomic_load_long(&ring->head);
+	long tail = os_atomic_load_long(&ring->tail);
+
+	return (size_t)((tail - head) & ASYNC_FRAME_RING_MASK);
+}
+
+/* consumer only, idx must be less than async_frames_count() */
+static inline struct obs_source_frame *
+async_frames_peek(const obs_source_t *source, size_t idx)
+{
+	const struct async_frame_ring *ring = &source->async_frames;
+	size_t pos = (size_t)os_atomic_load_long(&ring->head) + idx;
+
+	return ring->frames[pos & (ASYNC_FRAME_RING_SIZE - 1)];
+}
+
+/* consumer only */
+static inline void async_frames_pop(obs_source_t *source)
+{
+	struct async_frame_ring *ring = &source->async_frames;
+	long head = os_atomic_load_long(&ring->head);
+
+	os_atomic_set_long(&ring->head, (head + 1) & ASYNC_FRAME_RING_MASK);
+}
+
+/* producer only */
+static inline bool async_frames_push(obs_source_t *source,
+				     struct obs_source_frame *frame)
+{
+	struct async_frame_ring *ring = &source->async_frames;
+	long tail = os_atomic_load_long(&ring->tail);
+
+	if (async_frames_count(source) == ASYNC_FRAME_RING_SIZE)
+		return false;
+
+	ring->frames[tail & (ASYNC_FRAME_RING_SIZE - 1)] = frame;
+	os_atomic_set_long(&ring->tail, (tail + 1) & ASYNC_FRAME_RING_MASK);
+	return true;
+}
+
+/* requires async_mutex so the consumer can't be reading at the same time */
+static inline void async_frames_clear(obs_source_t *source)
+{
+	struct async_frame_ring *ring = &source->async_frames;
+	os_atomic_set_long(&ring->head, os_atomic_load_long(&ring->tail));
+}
+
 extern void set_deinterlace_texture_size(obs_source_t *source);
 extern void deinterlace_process_last_frame(obs_source_t *source,
 					   uint64_t sys_time);
@@ -843,6 +938,17 @@ struct delay_data {
 	enum delay_msg msg;
 	uint64_t ts;
 	struct encoder_packet packet;
+	bool spilled;
+};
+
+/* append-only file holding the data of delayed packets that didn't fit in
+ * the memory limit, deleted once every packet in it has been sent */
+struct delay_segment {
+	char *path;
+	FILE *write_file;
+	FILE *read_file;
+	uint64_t size;
+	size_t num_packets;
 };
 
 typedef void (*encoded_callback_t)(void *data, struct encoder_packet *packet);
@@ -892,7 +998,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleave_queues interleave;
 	int stop_code;
 
 	int reconnect_retry_sec;
@@ -955,6 +1061,26 @@ struct obs_output {
 	volatile bool delay_active;
 	volatile bool delay_capturing;
 
+	uint64_t delay_max_memory;
+	uint64_t delay_memory;
+	char *delay_spill_dir;
+	DARRAY(struct delay_segment) delay_segments;
+	uint64_t delay_segment_id;
+	volatile bool delay_spill_error;
+
+	/* packets waiting to be written by the spill thread, the sizes of the
+	 * packets on disk, and the data the spill thread has read back in */
+	pthread_mutex_t delay_spill_mutex;
+	os_sem_t *delay_spill_sem;
+	pthread_t delay_spill_thread;
+	bool delay_spill_thread_active;
+	volatile bool delay_spill_stop;
+	struct circlebuf delay_spill_queue;   /* struct encoder_packet */
+	struct circlebuf delay_spill_written; /* size_t */
+	struct circlebuf delay_spill_read;    /* uint8_t * */
+	size_t delay_spill_read_size;
+	bool delay_spill_writing;
+
 	char *last_error_message;
 
 	float audio_data[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES];
@@ -985,6 +1111,8 @@ extern void obs_output_remove_encoder(struct obs_output *output,
 extern void
 obs_encoder_packet_create_instance(struct encoder_packet *dst,
 				   const struct encoder_packet *src);
+extern void obs_encoder_packet_alloc_data(struct encoder_packet *packet);
+extern void free_encoder_packet_pool(void);
 void obs_output_destroy(obs_output_t *output);
 
 /* ------------------------------------------------------------------------- */
@@ -1001,6 +1129,13 @@ struct encoder_callback {
 	void *param;
 };
 
+#define ENCODER_ASYNC_QUEUE_SIZE 3
+
+struct encoder_async_frame {
+	struct video_frame frame;
+	int64_t pts;
+};
+
 struct obs_encoder {
 	struct obs_context_data context;
 	struct obs_encoder_info info;
@@ -1049,6 +1184,14 @@ struct obs_encoder {
 	uint64_t first_raw_ts;
 	uint64_t start_ts;
 
+	/* active audio encoders with identical settings on the same mix share
+	 * one private encoder, which does the actual encoding and fans its
+	 * packets out to each of them */
+	struct obs_encoder *dedup_shared;
+	DARRAY(struct obs_encoder *) dedup_clients;
+	bool dedup_is_shared;
+	int64_t dedup_base_pts;
+
 	pthread_mutex_t outputs_mutex;
 	DARRAY(obs_output_t *) outputs;
 
@@ -1063,6 +1206,21 @@ struct obs_encoder {
 	struct pause_data pause;
 
 	const char *profile_encoder_encode_name;
+
+	/* raw frames waiting for the async encode thread */
+	pthread_mutex_t async_mutex;
+	os_sem_t *async_sem;
+	pthread_t async_thread;
+	bool async_thread_active;
+	volatile bool async_stop;
+	volatile bool async_error;
+	struct encoder_async_frame async_frames[ENCODER_ASYNC_QUEUE_SIZE];
+	size_t async_head;
+	size_t async_queued;
+	enum video_format async_format;
+	uint32_t async_height;
+	uint32_t async_total_frames;
+	uint32_t async_skipped_frames;
 };
 
 extern struct obs_encoder_info *find_encoder(const char *id);
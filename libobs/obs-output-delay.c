@@ -18,6 +18,12 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 static inline bool delay_active(const struct obs_output *output)
 {
 	return os_atomic_load_bool(&output->delay_active);
@@ -28,6 +34,351 @@ static inline bool delay_capturing(const struct obs_output *output)
 	return os_atomic_load_bool(&output->delay_capturing);
 }
 
+/* ------------------------------------------------------------------------- */
+/* disk spilling
+ *
+ *   When a memory limit is set, packets that don't fit are handed to a spill
+ * thread that appends their data to segment files, and the packet stays in
+ * delay_data without it, so delay_data remains the timestamp index for
+ * everything that's delayed.  Packets are written and sent in the same order,
+ * so each segment is only ever read sequentially.
+ *
+ *   The spill thread also reads the written packets back in ahead of when
+ * they're due, so the encoder thread never touches the disk or waits for the
+ * spill thread.  A spilled packet is either in the read queue, on disk, or
+ * still in the spill queue waiting to be written, in that order.  One that
+ * is due before it has been written is taken straight from the spill queue,
+ * and if writing fails the remaining packets simply stay in memory.  One
+ * that is on disk or being written right now is sent the next time packets
+ * are popped instead. */
+
+#define DELAY_SEGMENT_SIZE (64ULL * 1024 * 1024)
+#define DELAY_READ_AHEAD_SIZE (1024 * 1024)
+#define DELAY_PREFETCH_SIZE (4 * 1024 * 1024)
+
+static void free_segment(struct delay_segment *seg)
+{
+	if (seg->write_file)
+		fclose(seg->write_file);
+	if (seg->read_file)
+		fclose(seg->read_file);
+
+	os_unlink(seg->path);
+	bfree(seg->path);
+}
+
+static void stop_spill_thread(struct obs_output *output)
+{
+	if (!output->delay_spill_thread_active)
+		return;
+
+	os_atomic_set_bool(&output->delay_spill_stop, true);
+	os_sem_post(output->delay_spill_sem);
+	pthread_join(output->delay_spill_thread, NULL);
+
+	output->delay_spill_thread_active = false;
+	os_atomic_set_bool(&output->delay_spill_stop, false);
+}
+
+static void free_segments(struct obs_output *output)
+{
+	struct encoder_packet packet;
+
+	stop_spill_thread(output);
+
+	while (output->delay_spill_queue.size) {
+		circlebuf_pop_front(&output->delay_spill_queue, &packet,
+				    sizeof(packet));
+		obs_encoder_packet_release(&packet);
+	}
+
+	while (output->delay_spill_read.size) {
+		circlebuf_pop_front(&output->delay_spill_read, &packet.data,
+				    sizeof(packet.data));
+		obs_encoder_packet_release(&packet);
+	}
+
+	for (size_t i = 0; i < output->delay_segments.num; i++)
+		free_segment(output->delay_segments.array + i);
+
+	circlebuf_free(&output->delay_spill_queue);
+	circlebuf_free(&output->delay_spill_written);
+	circlebuf_free(&output->delay_spill_read);
+	da_free(output->delay_segments);
+	output->delay_memory = 0;
+	output->delay_spill_read_size = 0;
+	os_atomic_set_bool(&output->delay_spill_error, false);
+}
+
+/* cuts off whatever part of a packet made it to disk, so the segment still
+ * ends on a packet boundary */
+static void truncate_segment(const char *path, uint64_t size)
+{
+	FILE *file = os_fopen(path, "r+b");
+	int ret;
+
+	if (!file)
+		return;
+
+#ifdef _WIN32
+	ret = _chsize_s(_fileno(file), (__int64)size);
+#else
+	ret = ftruncate(fileno(file), (off_t)size);
+#endif
+	if (ret != 0)
+		blog(LOG_WARNING, "Failed to truncate delay file '%s'", path);
+
+	fclose(file);
+}
+
+static inline bool write_packet(FILE *file, const struct encoder_packet *packet)
+{
+	return fwrite(packet->data, 1, packet->size, file) == packet->size &&
+	       fflush(file) == 0;
+}
+
+/* writes the packet at the front of the spill queue.  the segments are only
+ * used by the spill thread, so the lock is only held to update the queues */
+static void spill_front_packet(struct obs_output *output)
+{
+	struct delay_segment *seg;
+	struct encoder_packet packet;
+	struct dstr path = {0};
+	uint64_t seg_size = 0;
+	bool success;
+
+	pthread_mutex_lock(&output->delay_spill_mutex);
+
+	if (!output->delay_spill_queue.size ||
+	    os_atomic_load_bool(&output->delay_spill_error)) {
+		pthread_mutex_unlock(&output->delay_spill_mutex);
+		return;
+	}
+
+	circlebuf_peek_front(&output->delay_spill_queue, &packet,
+			     sizeof(packet));
+	output->delay_spill_writing = true;
+
+	seg = da_end(output->delay_segments);
+	if (!seg || !seg->write_file)
+		dstr_printf(&path, "%s/.obs-delay-%llu-%llu.tmp",
+			    output->delay_spill_dir,
+			    (unsigned long long)os_gettime_ns(),
+			    (unsigned long long)output->delay_segment_id++);
+
+	pthread_mutex_unlock(&output->delay_spill_mutex);
+
+	if (path.array) {
+		struct delay_segment new_seg = {0};
+
+		new_seg.path = path.array;
+		new_seg.write_file = os_fopen(path.array, "wb");
+		seg = da_push_back_new(output->delay_segments);
+		*seg = new_seg;
+	}
+
+	seg_size = seg->size;
+	success = seg->write_file && write_packet(seg->write_file, &packet);
+
+	if (success) {
+		seg->size += packet.size;
+		seg->num_packets++;
+
+		/* full segments are closed for writing so they can be deleted
+		 * as soon as they've been read */
+		if (seg->size >= DELAY_SEGMENT_SIZE) {
+			fclose(seg->write_file);
+			seg->write_file = NULL;
+		}
+
+	} else {
+		blog(LOG_WARNING,
+		     "Output '%s': Failed to write to delay file '%s', "
+		     "keeping delayed packets in memory",
+		     output->context.name, seg->path);
+
+		/* no more packets are written to the segment, and the partial
+		 * packet is cut off so it can be read to the end */
+		if (seg->write_file) {
+			fclose(seg->write_file);
+			seg->write_file = NULL;
+			truncate_segment(seg->path, seg_size);
+		}
+
+		if (!seg->num_packets) {
+			free_segment(seg);
+			da_pop_back(output->delay_segments);
+		}
+	}
+
+	pthread_mutex_lock(&output->delay_spill_mutex);
+
+	if (success) {
+		circlebuf_pop_front(&output->delay_spill_queue, NULL,
+				    sizeof(packet));
+		circlebuf_push_back(&output->delay_spill_written, &packet.size,
+				    sizeof(packet.size));
+	} else {
+		os_atomic_set_bool(&output->delay_spill_error, true);
+	}
+
+	output->delay_spill_writing = false;
+	pthread_mutex_unlock(&output->delay_spill_mutex);
+
+	if (success)
+		obs_encoder_packet_release(&packet);
+}
+
+/* reads the next written packet from the oldest segment */
+static uint8_t *read_spilled_packet(struct obs_output *output, size_t size)
+{
+	struct encoder_packet packet = {.size = size};
+	struct delay_segment *seg;
+	FILE *file;
+
+	seg = output->delay_segments.array;
+	file = seg->read_file;
+
+	if (!file) {
+		file = os_fopen(seg->path, "rb");
+		if (file)
+			setvbuf(file, NULL, _IOFBF, DELAY_READ_AHEAD_SIZE);
+		seg->read_file = file;
+	} else {
+		/* the segment may have grown since the last read hit its
+		 * end */
+		clearerr(file);
+	}
+
+	if (file) {
+		obs_encoder_packet_alloc_data(&packet);
+		if (fread(packet.data, 1, size, file) != size)
+			obs_encoder_packet_release(&packet);
+	}
+
+	if (--seg->num_packets == 0 && !seg->write_file) {
+		free_segment(seg);
+		da_erase(output->delay_segments, 0);
+	}
+
+	return packet.data;
+}
+
+/* keeps the read queue filled with the packets that are sent next.  a packet
+ * that couldn't be read is queued without data and dropped when it's due */
+static void prefetch_packets(struct obs_output *output)
+{
+	while (!os_atomic_load_bool(&output->delay_spill_stop)) {
+		uint8_t *data;
+		size_t size;
+
+		pthread_mutex_lock(&output->delay_spill_mutex);
+		if (!output->delay_spill_written.size ||
+		    output->delay_spill_read_size >= DELAY_PREFETCH_SIZE) {
+			pthread_mutex_unlock(&output->delay_spill_mutex);
+			break;
+		}
+		circlebuf_peek_front(&output->delay_spill_written, &size,
+				     sizeof(size));
+		pthread_mutex_unlock(&output->delay_spill_mutex);
+
+		data = read_spilled_packet(output, size);
+
+		pthread_mutex_lock(&output->delay_spill_mutex);
+		circlebuf_pop_front(&output->delay_spill_written, NULL,
+				    sizeof(size));
+		circlebuf_push_back(&output->delay_spill_read, &data,
+				    sizeof(data));
+		output->delay_spill_read_size += size;
+		pthread_mutex_unlock(&output->delay_spill_mutex);
+	}
+}
+
+static void *spill_thread(void *data)
+{
+	struct obs_output *output = data;
+
+	os_set_thread_name("obs-output-delay: spill thread");
+
+	while (os_sem_wait(output->delay_spill_sem) == 0) {
+		if (os_atomic_load_bool(&output->delay_spill_stop))
+			break;
+
+		spill_front_packet(output);
+		prefetch_packets(output);
+	}
+
+	return NULL;
+}
+
+/* moves the packet data to the spill queue, which the spill thread writes to
+ * disk */
+static bool spill_packet(struct obs_output *output, struct delay_data *dd)
+{
+	if (!output->delay_spill_thread_active) {
+		if (pthread_create(&output->delay_spill_thread, NULL,
+				   spill_thread, output) != 0) {
+			blog(LOG_WARNING,
+			     "Output '%s': Failed to create delay spill "
+			     "thread, keeping delayed packets in memory",
+			     output->context.name);
+			return false;
+		}
+
+		output->delay_spill_thread_active = true;
+	}
+
+	pthread_mutex_lock(&output->delay_spill_mutex);
+	circlebuf_push_back(&output->delay_spill_queue, &dd->packet,
+			    sizeof(dd->packet));
+	pthread_mutex_unlock(&output->delay_spill_mutex);
+
+	os_sem_post(output->delay_spill_sem);
+
+	dd->packet.data = NULL;
+	dd->spilled = true;
+	return true;
+}
+
+/* takes the data of a spilled packet that is due without touching the disk.
+ * returns false if it hasn't been read back in yet, or is being written right
+ * now, in which case it stays in delay_data until packets are popped again */
+static bool take_spilled_packet(struct obs_output *output,
+				struct delay_data *dd)
+{
+	bool taken = true;
+
+	pthread_mutex_lock(&output->delay_spill_mutex);
+
+	if (output->delay_spill_read.size) {
+		circlebuf_pop_front(&output->delay_spill_read,
+				    &dd->packet.data, sizeof(dd->packet.data));
+		output->delay_spill_read_size -= dd->packet.size;
+
+	} else if (!output->delay_spill_written.size &&
+		   !output->delay_spill_writing) {
+		circlebuf_pop_front(&output->delay_spill_queue, &dd->packet,
+				    sizeof(dd->packet));
+	} else {
+		taken = false;
+	}
+
+	pthread_mutex_unlock(&output->delay_spill_mutex);
+
+	/* lets the spill thread read in the next packets */
+	os_sem_post(output->delay_spill_sem);
+	return taken;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline bool should_spill(struct obs_output *output, size_t size)
+{
+	return size && output->delay_max_memory && output->delay_spill_dir &&
+	       !os_atomic_load_bool(&output->delay_spill_error) &&
+	       output->delay_memory + size > output->delay_max_memory;
+}
+
 static inline void push_packet(struct obs_output *output,
 			       struct encoder_packet *packet, uint64_t t)
 {
@@ -35,9 +386,17 @@ static inline void push_packet(struct obs_output *output,
 
 	dd.msg = DELAY_MSG_PACKET;
 	dd.ts = t;
-	obs_encoder_packet_create_instance(&dd.packet, packet);
+	obs_encoder_packet_ref(&dd.packet, packet);
 
 	pthread_mutex_lock(&output->delay_mutex);
+
+	if (should_spill(output, dd.packet.size) &&
+	    !spill_packet(output, &dd))
+		os_atomic_set_bool(&output->delay_spill_error, true);
+
+	if (!dd.spilled)
+		output->delay_memory += dd.packet.size;
+
 	circlebuf_push_back(&output->delay_data, &dd, sizeof(dd));
 	pthread_mutex_unlock(&output->delay_mutex);
 }
@@ -72,6 +431,8 @@ void obs_output_cleanup_delay(obs_output_t *output)
 		}
 	}
 
+	free_segments(output);
+
 	output->active_delay_ns = 0;
 	os_atomic_set_long(&output->delay_restart_refs, 0);
 }
@@ -81,6 +442,7 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 	uint64_t elapsed_time;
 	struct delay_data dd;
 	bool popped = false;
+	bool dropped = false;
 	bool preserve;
 
 	/* ------------------------------------------------ */
@@ -96,18 +458,32 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 		if (preserve && output->reconnecting) {
 			output->active_delay_ns = elapsed_time;
 
-		} else if (elapsed_time > output->active_delay_ns) {
+		} else if (elapsed_time > output->active_delay_ns &&
+			   (!dd.spilled || take_spilled_packet(output, &dd))) {
 			circlebuf_pop_front(&output->delay_data, NULL,
 					    sizeof(dd));
 			popped = true;
 		}
 	}
 
+	if (popped && dd.msg == DELAY_MSG_PACKET) {
+		if (!dd.spilled) {
+			output->delay_memory -= dd.packet.size;
+
+		} else if (!dd.packet.data) {
+			blog(LOG_ERROR,
+			     "Output '%s': Failed to read delayed packet "
+			     "from disk, dropping it",
+			     output->context.name);
+			dropped = true;
+		}
+	}
+
 	pthread_mutex_unlock(&output->delay_mutex);
 
 	/* ------------------------------------------------ */
 
-	if (popped)
+	if (popped && !dropped)
 		process_delay_data(output, &dd);
 
 	return popped;
@@ -212,3 +588,23 @@ uint32_t obs_output_get_active_delay(const obs_output_t *output)
 		       ? (uint32_t)(output->active_delay_ns / 1000000000ULL)
 		       : 0;
 }
+
+void obs_output_set_delay_memory_limit(obs_output_t *output,
+				       uint64_t max_bytes,
+				       const char *spill_dir)
+{
+	if (!obs_output_valid(output, "obs_output_set_delay_memory_limit"))
+		return;
+
+	/* the spill thread reads the directory when it starts a segment */
+	pthread_mutex_lock(&output->delay_mutex);
+	pthread_mutex_lock(&output->delay_spill_mutex);
+	bfree(output->delay_spill_dir);
+	output->delay_spill_dir = NULL;
+	if (spill_dir && *spill_dir)
+		output->delay_spill_dir = bstrdup(spill_dir);
+	output->delay_max_memory = max_bytes;
+	os_atomic_set_bool(&output->delay_spill_error, false);
+	pthread_mutex_unlock(&output->delay_spill_mutex);
+	pthread_mutex_unlock(&output->delay_mutex);
+}
@@ -106,6 +106,7 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 	output = bzalloc(sizeof(struct obs_output));
 	pthread_mutex_init_value(&output->interleaved_mutex);
 	pthread_mutex_init_value(&output->delay_mutex);
+	pthread_mutex_init_value(&output->delay_spill_mutex);
 	pthread_mutex_init_value(&output->caption_mutex);
 	pthread_mutex_init_value(&output->pause.mutex);
 
@@ -113,6 +114,10 @@ obs_output_t *obs_output_create(const char *id, const char *name,
 		goto fail;
 	if (pthread_mutex_init(&output->delay_mutex, NULL) != 0)
 		goto fail;
+	if (pthread_mutex_init(&output->delay_spill_mutex, NULL) != 0)
+		goto fail;
+	if (os_sem_init(&output->delay_spill_sem, 0) != 0)
+		goto fail;
 	if (pthread_mutex_init(&output->caption_mutex, NULL) != 0)
 		goto fail;
 	if (pthread_mutex_init(&output->pause.mutex, NULL) != 0)
@@ -166,14 +171,6 @@ fail:
 	return NULL;
 }
 
-static inline void free_packets(struct obs_output *output)
-{
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array +
-					   i);
-	da_free(output->interleaved_packets);
-}
-
 static inline void clear_audio_buffers(obs_output_t *output)
 {
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
@@ -202,7 +199,7 @@ void obs_output_destroy(obs_output_t *output)
 		if (output->context.data)
 			output->info.destroy(output->context.data);
 
-		free_packets(output);
+		interleave_free(&output->interleave);
 
 		if (output->video_encoder) {
 			obs_encoder_remove_output(output->video_encoder,
@@ -217,15 +214,19 @@ void obs_output_destroy(obs_output_t *output)
 		}
 
 		clear_audio_buffers(output);
+		obs_output_cleanup_delay(output);
 
 		os_event_destroy(output->stopping_event);
 		pthread_mutex_destroy(&output->pause.mutex);
 		pthread_mutex_destroy(&output->caption_mutex);
 		pthread_mutex_destroy(&output->interleaved_mutex);
 		pthread_mutex_destroy(&output->delay_mutex);
+		pthread_mutex_destroy(&output->delay_spill_mutex);
+		os_sem_destroy(output->delay_spill_sem);
 		os_event_destroy(output->reconnect_stop_event);
 		obs_context_data_free(&output->context);
 		circlebuf_free(&output->delay_data);
+		bfree(output->delay_spill_dir);
 		if (output->owns_info_id)
 			bfree((void *)output->info.id);
 		if (output->last_error_message)
@@ -1255,7 +1256,12 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out;
+
+	if (!interleave_first(&output->interleave))
+		return;
+
+	out = *interleave_first(&output->interleave);
 
 	/* do not send an interleaved packet if there's no packet of the
 	 * opposing type of a higher timestamp in the interleave buffer.
@@ -1263,7 +1269,7 @@ static inline void send_interleaved(struct obs_output *output)
 	if (!has_higher_opposing_ts(output, &out))
 		return;
 
-	da_erase(output->interleaved_packets, 0);
+	interleave_pop(&output->interleave);
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1310,184 +1316,131 @@ static inline void set_higher_ts(struct obs_output *output,
 
 static inline struct encoder_packet *
 find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		       size_t audio_idx);
-static int find_first_packet_type_idx(struct obs_output *output,
-				      enum obs_encoder_type type,
-				      size_t audio_idx);
+		       size_t audio_idx)
+{
+	size_t idx = type == OBS_ENCODER_VIDEO ? 0 : audio_idx + 1;
+	return interleave_queue_first(&output->interleave, idx);
+}
+
+static inline struct encoder_packet *
+find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
+		      size_t audio_idx)
+{
+	size_t idx = type == OBS_ENCODER_VIDEO ? 0 : audio_idx + 1;
+	return interleave_queue_last(&output->interleave, idx);
+}
 
 /* gets the point where audio and video are closest together */
-static size_t get_interleaved_start_idx(struct obs_output *output)
+static struct encoder_packet
+get_interleaved_start_packet(struct obs_output *output)
 {
 	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
 	struct encoder_packet *first_video =
 		find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
-	size_t video_idx = DARRAY_INVALID;
-	size_t idx = 0;
-
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		int64_t diff;
-
-		if (packet->type != OBS_ENCODER_AUDIO) {
-			if (packet == first_video)
-				video_idx = i;
-			continue;
-		}
-
-		diff = llabs(packet->dts_usec - first_video->dts_usec);
-		if (diff < closest_diff) {
-			closest_diff = diff;
-			idx = i;
+	struct encoder_packet *closest = NULL;
+
+	for (size_t i = 1; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &output->interleave.queues[i];
+
+		for (size_t j = queue->head; j < queue->packets.num; j++) {
+			struct encoder_packet *packet =
+				queue->packets.array + j;
+			int64_t diff =
+				llabs(packet->dts_usec - first_video->dts_usec);
+
+			if (diff < closest_diff ||
+			    (closest && diff == closest_diff &&
+			     packet_before(packet, closest))) {
+				closest_diff = diff;
+				closest = packet;
+			}
 		}
 	}
 
-	return video_idx < idx ? video_idx : idx;
+	return (closest && packet_before(closest, first_video)) ? *closest
+								 : *first_video;
 }
 
-static int prune_premature_packets(struct obs_output *output)
+static int prune_premature_packets(struct obs_output *output,
+				   struct encoder_packet *last)
 {
 	size_t audio_mixes = num_audio_mixes(output);
 	struct encoder_packet *video;
-	int video_idx;
-	int max_idx;
 	int64_t duration_usec;
 	int64_t max_diff = 0;
 	int64_t diff = 0;
 
-	video_idx = find_first_packet_type_idx(output, OBS_ENCODER_VIDEO, 0);
-	if (video_idx == -1) {
+	video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
+	if (!video) {
 		output->received_video = false;
 		return -1;
 	}
 
-	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	*last = *video;
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < audio_mixes; i++) {
 		struct encoder_packet *audio;
-		int audio_idx;
 
-		audio_idx = find_first_packet_type_idx(output,
-						       OBS_ENCODER_AUDIO, i);
-		if (audio_idx == -1) {
+		audio = find_first_packet_type(output, OBS_ENCODER_AUDIO, i);
+		if (!audio) {
 			output->received_audio = false;
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
-		if (audio_idx > max_idx)
-			max_idx = audio_idx;
+		if (packet_before(last, audio))
+			*last = *audio;
 
 		diff = audio->dts_usec - video->dts_usec;
 		if (diff > max_diff)
 			max_diff = diff;
 	}
 
-	return diff > duration_usec ? max_idx + 1 : 0;
+	return diff > duration_usec ? 1 : 0;
 }
 
-static void discard_to_idx(struct obs_output *output, size_t idx)
-{
-	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		obs_encoder_packet_release(packet);
-	}
+#define DEBUG_STARTING_PACKETS 0
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+#if DEBUG_STARTING_PACKETS == 1
+static void debug_interleaved_packets(struct obs_output *output)
+{
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &output->interleave.queues[i];
+
+		for (size_t j = queue->head; j < queue->packets.num; j++) {
+			struct encoder_packet *packet =
+				queue->packets.array + j;
+			blog(LOG_DEBUG, "packet: %s %d, ts: %lld",
+			     packet->type == OBS_ENCODER_AUDIO ? "audio"
+							       : "video",
+			     (int)packet->track_idx, packet->dts_usec);
+		}
+	}
 }
-
-#define DEBUG_STARTING_PACKETS 0
+#endif
 
 static bool prune_interleaved_packets(struct obs_output *output)
 {
-	size_t start_idx = 0;
-	int prune_start = prune_premature_packets(output);
+	struct encoder_packet start;
+	int prune = prune_premature_packets(output, &start);
 
 #if DEBUG_STARTING_PACKETS == 1
-	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
-		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video",
-		     (int)packet->track_idx, packet->dts_usec,
-		     (int)i < prune_start ? "true" : "false");
-	}
+	blog(LOG_DEBUG, "--------- Pruning! %d (up to %lld) ---------", prune,
+	     prune == 1 ? start.dts_usec : 0);
+	debug_interleaved_packets(output);
 #endif
 
 	/* prunes the first video packet if it's too far away from audio */
-	if (prune_start == -1)
+	if (prune == -1)
 		return false;
-	else if (prune_start != 0)
-		start_idx = (size_t)prune_start;
-	else
-		start_idx = get_interleaved_start_idx(output);
-
-	if (start_idx)
-		discard_to_idx(output, start_idx);
-
-	return true;
-}
-
-static int find_first_packet_type_idx(struct obs_output *output,
-				      enum obs_encoder_type type,
-				      size_t audio_idx)
-{
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-
-		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
-				continue;
-			}
-
-			return (int)i;
-		}
+	else if (prune != 0)
+		interleave_discard_to(&output->interleave, &start, true);
+	else {
+		start = get_interleaved_start_packet(output);
+		interleave_discard_to(&output->interleave, &start, false);
 	}
 
-	return -1;
-}
-
-static int find_last_packet_type_idx(struct obs_output *output,
-				     enum obs_encoder_type type,
-				     size_t audio_idx)
-{
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i - 1];
-
-		if (packet->type == type) {
-			if (type == OBS_ENCODER_AUDIO &&
-			    packet->track_idx != audio_idx) {
-				continue;
-			}
-
-			return (int)(i - 1);
-		}
-	}
-
-	return -1;
-}
-
-static inline struct encoder_packet *
-find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		       size_t audio_idx)
-{
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
-
-static inline struct encoder_packet *
-find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
-		      size_t audio_idx)
-{
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return true;
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output,
@@ -1519,8 +1472,8 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	struct encoder_packet *video;
 	struct encoder_packet *audio[MAX_AUDIO_MIXES];
 	struct encoder_packet *last_audio[MAX_AUDIO_MIXES];
+	struct encoder_packet start;
 	size_t audio_mixes = num_audio_mixes(output);
-	size_t start_idx;
 
 	if (!get_audio_and_video_packets(output, &video, audio, audio_mixes))
 		return false;
@@ -1538,13 +1491,10 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	}
 
 	/* clear out excess starting audio if it hasn't been already */
-	start_idx = get_interleaved_start_idx(output);
-	if (start_idx) {
-		discard_to_idx(output, start_idx);
-		if (!get_audio_and_video_packets(output, &video, audio,
-						 audio_mixes))
-			return false;
-	}
+	start = get_interleaved_start_packet(output);
+	interleave_discard_to(&output->interleave, &start, false);
+	if (!get_audio_and_video_packets(output, &video, audio, audio_mixes))
+		return false;
 
 	/* get new offsets */
 	output->video_offset = video->pts;
@@ -1567,63 +1517,15 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	output->highest_video_ts -= video->dts_usec;
 
 	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet =
-			&output->interleaved_packets.array[i];
-		apply_interleaved_packet_offset(output, packet);
-	}
-
-	return true;
-}
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++) {
+		struct interleave_queue *queue = &output->interleave.queues[i];
 
-static inline void insert_interleaved_packet(struct obs_output *output,
-					     struct encoder_packet *out)
-{
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		if (out->dts_usec == cur_packet->dts_usec &&
-		    out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
+		for (size_t j = queue->head; j < queue->packets.num; j++)
+			apply_interleaved_packet_offset(
+				output, queue->packets.array + j);
 	}
 
-	da_insert(output->interleaved_packets, idx, out);
-}
-
-static void resort_interleaved_packets(struct obs_output *output)
-{
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0,
-	       sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++)
-		insert_interleaved_packet(output, &old_array.array[i]);
-
-	da_free(old_array);
-}
-
-static void discard_unused_audio_packets(struct obs_output *output,
-					 int64_t dts_usec)
-{
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p =
-			&output->interleaved_packets.array[idx];
-
-		if (p->dts_usec >= dts_usec)
-			break;
-	}
-
-	if (idx)
-		discard_to_idx(output, idx);
+	return true;
 }
 
 static void interleave_packets(void *data, struct encoder_packet *packet)
@@ -1643,7 +1545,8 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	/* if first video frame is not a keyframe, discard until received */
 	if (!output->received_video && packet->type == OBS_ENCODER_VIDEO &&
 	    !packet->keyframe) {
-		discard_unused_audio_packets(output, packet->dts_usec);
+		interleave_discard_before(&output->interleave,
+					  packet->dts_usec);
 		pthread_mutex_unlock(&output->interleaved_mutex);
 
 		if (output->active_delay_ns)
@@ -1656,14 +1559,14 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	if (output->active_delay_ns)
 		out = *packet;
 	else
-		obs_encoder_packet_create_instance(&out, packet);
+		obs_encoder_packet_ref(&out, packet);
 
 	if (was_started)
 		apply_interleaved_packet_offset(output, &out);
 	else
 		check_received(output, packet);
 
-	insert_interleaved_packet(output, &out);
+	interleave_insert(&output->interleave, &out);
 	set_higher_ts(output, &out);
 
 	/* when both video and audio have been received, we're ready
@@ -1672,7 +1575,9 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 		if (!was_started) {
 			if (prune_interleaved_packets(output)) {
 				if (initialize_interleaved_packets(output)) {
-					resort_interleaved_packets(output);
+					/* the offsets differ per track */
+					interleave_rebuild(
+						&output->interleave);
 					send_interleaved(output);
 				}
 			}
@@ -1848,7 +1753,7 @@ static void reset_packet_data(obs_output_t *output)
 	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
 		output->audio_offsets[i] = 0;
 
-	free_packets(output);
+	interleave_free(&output->interleave);
 }
 
 static inline bool preserve_active(struct obs_output *output)
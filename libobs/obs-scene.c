@@ -416,6 +416,8 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 	if (!update_tex)
 		return;
 
+	item->cache_valid = false;
+
 	if (item->item_render && !item_texture_enabled(item)) {
 		obs_enter_graphics();
 		gs_texrender_destroy(item->item_render);
@@ -460,9 +462,10 @@ static inline bool item_texture_enabled(const struct obs_scene_item *item)
 	       (item_is_scene(item) && !item->is_group);
 }
 
-static void render_item_texture(struct obs_scene_item *item)
+static void render_item_texture(struct obs_scene_item *item,
+				gs_texrender_t *texrender)
 {
-	gs_texture_t *tex = gs_texrender_get_texture(item->item_render);
+	gs_texture_t *tex = gs_texrender_get_texture(texrender);
 	if (!tex) {
 		return;
 	}
@@ -532,8 +535,299 @@ static void render_item_texture(struct obs_scene_item *item)
 	GS_DEBUG_MARKER_END();
 }
 
+/* ------------------------------------------------------------------------- */
+/* batched drawing of item textures
+ *
+ * Consecutive items whose textures are drawn with the plain Draw technique of
+ * render_item_texture are queued into one sprite batch, which is drawn once an
+ * item needs anything else (or the scene is done), so the batch must always be
+ * flushed before rendering to another target or drawing anything directly. */
+
+static void flush_sprite_batch(void)
+{
+	gs_sprite_batch_t *batch = obs->video.sprite_batch;
+
+	if (!gs_sprite_batch_count(batch))
+		return;
+
+	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_ITEM_TEXTURE,
+			      "flush_sprite_batch");
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	gs_sprite_batch_draw(batch, obs->video.sprite_batch_effect, "Draw");
+
+	gs_blend_state_pop();
+
+	GS_DEBUG_MARKER_END();
+}
+
+static inline bool item_texture_batchable(const struct obs_scene_item *item)
+{
+	enum obs_scale_type type = item->scale_filter;
+
+	if (type == OBS_SCALE_DISABLE)
+		return true;
+
+	return type != OBS_SCALE_POINT &&
+	       close_float(item->output_scale.x, 1.0f, EPSILON) &&
+	       close_float(item->output_scale.y, 1.0f, EPSILON);
+}
+
+static bool batch_item_texture(struct obs_scene_item *item,
+			       gs_texrender_t *texrender)
+{
+	gs_sprite_batch_t *batch = obs->video.sprite_batch;
+	gs_texture_t *tex = gs_texrender_get_texture(texrender);
+
+	if (!batch || !tex || !item_texture_batchable(item))
+		return false;
+	if (gs_sprite_batch_add(batch, tex, 0))
+		return true;
+
+	/* batch is full */
+	flush_sprite_batch();
+	return gs_sprite_batch_add(batch, tex, 0);
+}
+
+static inline void draw_item_texture(struct obs_scene_item *item,
+				     gs_texrender_t *texrender)
+{
+	if (!batch_item_texture(item, texrender)) {
+		flush_sprite_batch();
+		render_item_texture(item, texrender);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* cached rendering of static items
+ *
+ * Items made only of sources and filters flagged OBS_SOURCE_STATIC_VIDEO (and
+ * scenes of such items) get a signature from the source video versions, sizes,
+ * filters and item transforms of everything they draw.  While the signature
+ * stays the same, the texture rendered for the item is drawn again as is. */
+
+enum item_cache_state {
+	ITEM_CACHE_NONE,
+	ITEM_CACHE_CHANGED,
+	ITEM_CACHE_UNCHANGED,
+};
+
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+static inline uint64_t hash_mix(uint64_t hash, uint64_t val)
+{
+	return hash ^ (val + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+static inline uint64_t hash_data(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+	uint32_t val;
+
+	for (; size >= sizeof(val); size -= sizeof(val)) {
+		memcpy(&val, bytes, sizeof(val));
+		hash = hash_mix(hash, val);
+		bytes += sizeof(val);
+	}
+	while (size--)
+		hash = hash_mix(hash, *(bytes++));
+
+	return hash;
+}
+
+static inline bool source_video_static(const obs_source_t *source)
+{
+	uint32_t flags = source->info.output_flags;
+	return (flags & OBS_SOURCE_STATIC_VIDEO) != 0 &&
+	       (flags & OBS_SOURCE_ASYNC) == 0;
+}
+
+static bool get_scene_signature(obs_scene_t *scene, uint64_t *hash);
+
+static bool get_source_signature(obs_source_t *source, uint64_t *hash)
+{
+	bool is_static = true;
+
+	if (source->info.type == OBS_SOURCE_TYPE_SCENE) {
+		if (!get_scene_signature(source->context.data, hash))
+			return false;
+	} else if (!source_video_static(source)) {
+		return false;
+	}
+
+	*hash = hash_mix(*hash, (uint64_t)(uintptr_t)source);
+	*hash = hash_mix(*hash, (uint64_t)os_atomic_load_long(
+					&source->video_version));
+	*hash = hash_mix(*hash, source->enabled);
+	*hash = hash_mix(*hash, obs_source_get_width(source));
+	*hash = hash_mix(*hash, obs_source_get_height(source));
+	*hash = hash_mix(*hash, obs_source_get_base_width(source));
+	*hash = hash_mix(*hash, obs_source_get_base_height(source));
+
+	pthread_mutex_lock(&source->filter_mutex);
+	for (size_t i = 0; i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+
+		if (!filter->enabled ||
+		    (filter->info.output_flags & OBS_SOURCE_VIDEO) == 0)
+			continue;
+		if (!source_video_static(filter)) {
+			is_static = false;
+			break;
+		}
+
+		*hash = hash_mix(*hash, (uint64_t)(uintptr_t)filter);
+		*hash = hash_mix(*hash, (uint64_t)os_atomic_load_long(
+						&filter->video_version));
+	}
+	pthread_mutex_unlock(&source->filter_mutex);
+
+	return is_static;
+}
+
+/* nested scenes only update their item transforms when they are rendered, so
+ * instead of updating them here, pending updates change the signature.  the
+ * item is then rendered again, which applies them. */
+static inline bool item_update_pending(struct obs_scene_item *item)
+{
+	return obs_source_removed(item->source) ||
+	       os_atomic_load_bool(&item->update_transform) ||
+	       os_atomic_load_bool(&item->update_group_resize) ||
+	       source_size_changed(item);
+}
+
+static bool get_scene_signature(obs_scene_t *scene, uint64_t *hash)
+{
+	struct obs_scene_item *item;
+	bool is_static = true;
+
+	if (!scene)
+		return false;
+
+	video_lock(scene);
+
+	item = scene->first_item;
+	while (item) {
+		*hash = hash_mix(*hash, item_update_pending(item));
+
+		if (item->user_visible) {
+			*hash = hash_mix(*hash, (uint64_t)(uintptr_t)item);
+			*hash = hash_data(*hash, &item->draw_transform,
+					  sizeof(item->draw_transform));
+			*hash = hash_data(*hash, &item->crop,
+					  sizeof(item->crop));
+			*hash = hash_mix(*hash, item->scale_filter);
+
+			if (!get_source_signature(item->source, hash)) {
+				is_static = false;
+				break;
+			}
+		}
+
+		item = item->next;
+	}
+
+	video_unlock(scene);
+	return is_static;
+}
+
+static enum item_cache_state update_item_cache(struct obs_scene_item *item)
+{
+	uint64_t hash = HASH_SEED;
+
+	hash = hash_data(hash, &item->crop, sizeof(item->crop));
+
+	if (!get_source_signature(item->source, &hash)) {
+		item->cache_hashed = false;
+		item->cache_valid = false;
+		return ITEM_CACHE_NONE;
+	}
+
+	if (!item->cache_hashed || item->cache_hash != hash) {
+		item->cache_hash = hash;
+		item->cache_hashed = true;
+		item->cache_valid = false;
+		return ITEM_CACHE_CHANGED;
+	}
+
+	return ITEM_CACHE_UNCHANGED;
+}
+
+/* the cache texture is drawn through the group's transform, which only gives
+ * the same result as drawing the group directly if it maps every texel onto
+ * exactly one pixel */
+static bool group_cache_pixel_aligned(const struct obs_scene_item *item)
+{
+	struct matrix4 mat;
+
+	gs_matrix_get(&mat);
+	matrix4_mul(&mat, &item->draw_transform, &mat);
+
+	return close_float(mat.x.x, 1.0f, EPSILON) &&
+	       close_float(mat.x.y, 0.0f, EPSILON) &&
+	       close_float(mat.y.x, 0.0f, EPSILON) &&
+	       close_float(mat.y.y, 1.0f, EPSILON) &&
+	       close_float(mat.t.x, roundf(mat.t.x), EPSILON) &&
+	       close_float(mat.t.y, roundf(mat.t.y), EPSILON);
+}
+
+/* groups are normally drawn directly, so they only get a cache texture once
+ * their signature has stayed the same for two frames */
+static bool render_group_cache(struct obs_scene_item *item)
+{
+	enum item_cache_state state = ITEM_CACHE_NONE;
+	uint32_t cx = obs_source_get_width(item->source);
+	uint32_t cy = obs_source_get_height(item->source);
+
+	if (group_cache_pixel_aligned(item)) {
+		state = update_item_cache(item);
+	} else {
+		item->cache_hashed = false;
+		item->cache_valid = false;
+	}
+
+	if (state != ITEM_CACHE_UNCHANGED || !cx || !cy) {
+		if (state == ITEM_CACHE_NONE && item->cache_render) {
+			gs_texrender_destroy(item->cache_render);
+			item->cache_render = NULL;
+		}
+		return false;
+	}
+
+	if (!item->cache_render) {
+		item->cache_render = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		if (!item->cache_render)
+			return false;
+	}
+
+	if (!item->cache_valid) {
+		gs_texrender_reset(item->cache_render);
+		flush_sprite_batch();
+
+		if (!gs_texrender_begin(item->cache_render, cx, cy))
+			return false;
+
+		struct vec4 clear_color;
+
+		vec4_zero(&clear_color);
+		gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+		gs_ortho(0.0f, (float)cx, 0.0f, (float)cy, -100.0f, 100.0f);
+
+		obs_source_video_render(item->source);
+
+		gs_texrender_end(item->cache_render);
+		item->cache_valid = true;
+	}
+
+	return true;
+}
+
 static inline void render_item(struct obs_scene_item *item)
 {
+	bool group_cached = false;
+
 	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item: %s",
 				     obs_source_get_name(item->source));
 
@@ -541,14 +835,29 @@ static inline void render_item(struct obs_scene_item *item)
 		uint32_t width = obs_source_get_width(item->source);
 		uint32_t height = obs_source_get_height(item->source);
 
+		/* a group drawn to item_render (crop or scale filter) no longer
+		 * uses its group cache, and cache_valid referred to that */
+		if (item->cache_render) {
+			gs_texrender_destroy(item->cache_render);
+			item->cache_render = NULL;
+			item->cache_valid = false;
+		}
+
 		if (!width || !height) {
 			goto cleanup;
 		}
 
 		uint32_t cx = calc_cx(item, width);
 		uint32_t cy = calc_cy(item, height);
+		enum item_cache_state state = update_item_cache(item);
+		bool cached = state == ITEM_CACHE_UNCHANGED &&
+			      item->cache_valid;
+
+		if (!cached)
+			flush_sprite_batch();
 
-		if (cx && cy && gs_texrender_begin(item->item_render, cx, cy)) {
+		if (!cached && cx && cy &&
+		    gs_texrender_begin(item->item_render, cx, cy)) {
 			float cx_scale = (float)width / (float)cx;
 			float cy_scale = (float)height / (float)cy;
 			struct vec4 clear_color;
@@ -565,14 +874,21 @@ static inline void render_item(struct obs_scene_item *item)
 			obs_source_video_render(item->source);
 
 			gs_texrender_end(item->item_render);
+			item->cache_valid = state != ITEM_CACHE_NONE;
 		}
+
+	} else if (item->is_group) {
+		group_cached = render_group_cache(item);
 	}
 
 	gs_matrix_push();
 	gs_matrix_mul(&item->draw_transform);
 	if (item->item_render) {
-		render_item_texture(item);
+		draw_item_texture(item, item->item_render);
+	} else if (group_cached) {
+		draw_item_texture(item, item->cache_render);
 	} else {
+		flush_sprite_batch();
 		obs_source_video_render(item->source);
 	}
 	gs_matrix_pop();
@@ -670,6 +986,8 @@ static void scene_video_render(void *data, gs_effect_t *effect)
 		item = item->next;
 	}
 
+	flush_sprite_batch();
+
 	gs_blend_state_pop();
 
 	video_unlock(scene);
@@ -1043,27 +1361,16 @@ static void process_all_audio_actions(struct obs_scene_item *item,
 		;
 }
 
-static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
-			       size_t pos, size_t count)
+static inline void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in,
+				      size_t pos, size_t count)
 {
-	register float *out = p_out;
-	register float *buf = buf_in + pos;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++) * *(buf++);
+	audio_mix_add_mul(p_out, p_in + pos, buf_in + pos, count);
 }
 
 static inline void mix_audio(float *p_out, float *p_in, size_t pos,
 			     size_t count)
 {
-	register float *out = p_out;
-	register float *in = p_in + pos;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
+	audio_mix_add(p_out, p_in + pos, count);
 }
 
 static bool scene_audio_render(void *data, uint64_t *ts_out,
@@ -1763,9 +2070,10 @@ obs_sceneitem_t *obs_scene_add(obs_scene_t *scene, obs_source_t *source)
 static void obs_sceneitem_destroy(obs_sceneitem_t *item)
 {
 	if (item) {
-		if (item->item_render) {
+		if (item->item_render || item->cache_render) {
 			obs_enter_graphics();
 			gs_texrender_destroy(item->item_render);
+			gs_texrender_destroy(item->cache_render);
 			obs_leave_graphics();
 		}
 		obs_data_release(item->private_settings);
@@ -51,6 +51,13 @@ struct obs_scene_item {
 	gs_texrender_t *item_render;
 	struct obs_sceneitem_crop crop;
 
+	/* signature of the last rendering of a static item, which lets
+	 * item_render (or cache_render for groups) be reused as is */
+	gs_texrender_t *cache_render;
+	uint64_t cache_hash;
+	bool cache_hashed;
+	bool cache_valid;
+
 	struct vec2 pos;
 	struct vec2 scale;
 	float rot;
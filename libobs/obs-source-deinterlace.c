@@ -19,7 +19,7 @@
 
 static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 {
-	struct obs_source_frame *next_frame = source->async_frames.array[0];
+	struct obs_source_frame *next_frame = async_frames_peek(source, 0);
 	struct obs_source_frame *prev_frame = NULL;
 	struct obs_source_frame *frame = NULL;
 	uint64_t sys_offset = sys_time - source->last_sys_timestamp;
@@ -28,20 +28,21 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 	size_t idx = 1;
 
 	if (source->async_unbuffered) {
-		while (source->async_frames.num > 2) {
-			da_erase(source->async_frames, 0);
+		while (async_frames_count(source) > 2) {
+			async_frames_pop(source);
 			remove_async_frame(source, next_frame);
-			next_frame = source->async_frames.array[0];
+			os_atomic_inc_long(&source->async_frames_late);
+			next_frame = async_frames_peek(source, 0);
 		}
 
-		if (source->async_frames.num == 2) {
+		if (async_frames_count(source) == 2) {
 			bool prev_frame = true;
 			if (source->async_unbuffered &&
 			    source->deinterlace_offset) {
 				const uint64_t timestamp =
-					source->async_frames.array[0]->timestamp;
+					async_frames_peek(source, 0)->timestamp;
 				const uint64_t after_timestamp =
-					source->async_frames.array[1]->timestamp;
+					async_frames_peek(source, 1)->timestamp;
 				const uint64_t duration =
 					after_timestamp - timestamp;
 				const uint64_t frame_end =
@@ -54,7 +55,7 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 						timestamp - duration;
 				}
 			}
-			source->async_frames.array[0]->prev_frame = prev_frame;
+			async_frames_peek(source, 0)->prev_frame = prev_frame;
 		}
 		source->deinterlace_offset = 0;
 		source->last_frame_ts = next_frame->timestamp;
@@ -81,17 +82,18 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 			break;
 
 		if (prev_frame) {
-			da_erase(source->async_frames, 0);
+			async_frames_pop(source);
 			remove_async_frame(source, prev_frame);
+			os_atomic_inc_long(&source->async_frames_late);
 		}
 
-		if (source->async_frames.num <= 2) {
+		if (async_frames_count(source) <= 2) {
 			bool exit = true;
 
 			if (prev_frame) {
 				prev_frame->prev_frame = true;
 
-			} else if (!frame && source->async_frames.num == 2) {
+			} else if (!frame && async_frames_count(source) == 2) {
 				exit = false;
 			}
 
@@ -108,7 +110,7 @@ static bool ready_deinterlace_frames(obs_source_t *source, uint64_t sys_time)
 
 		prev_frame = frame;
 		frame = next_frame;
-		next_frame = source->async_frames.array[idx];
+		next_frame = async_frames_peek(source, idx);
 
 		/* more timestamp checking and compensating */
 		if ((next_frame->timestamp - frame_time) > MAX_TS_VAR) {
@@ -132,8 +134,8 @@ static inline bool first_frame(obs_source_t *s)
 	if (s->last_frame_ts)
 		return false;
 
-	if (s->async_frames.num >= 2)
-		s->async_frames.array[0]->prev_frame = true;
+	if (async_frames_count(s) >= 2)
+		async_frames_peek(s, 0)->prev_frame = true;
 	return true;
 }
 
@@ -166,7 +168,7 @@ static inline void deinterlace_get_closest_frames(obs_source_t *s,
 		}
 	}
 
-	if (!s->async_frames.num)
+	if (!async_frames_count(s))
 		return;
 
 	info = video_output_get_info(obs->video.video);
@@ -177,15 +179,15 @@ static inline void deinterlace_get_closest_frames(obs_source_t *s,
 		uint64_t offset;
 
 		s->prev_async_frame = NULL;
-		s->cur_async_frame = s->async_frames.array[0];
+		s->cur_async_frame = async_frames_peek(s, 0);
 
-		da_erase(s->async_frames, 0);
+		async_frames_pop(s);
 
 		if (s->cur_async_frame->prev_frame) {
 			s->prev_async_frame = s->cur_async_frame;
-			s->cur_async_frame = s->async_frames.array[0];
+			s->cur_async_frame = async_frames_peek(s, 0);
 
-			da_erase(s->async_frames, 0);
+			async_frames_pop(s);
 
 			s->deinterlace_half_duration =
 				(uint32_t)((s->cur_async_frame->timestamp -
@@ -237,19 +239,20 @@ void set_deinterlace_texture_size(obs_source_t *source)
 			gs_texrender_create(GS_BGRX, GS_ZS_NONE);
 
 		for (int c = 0; c < source->async_channel_count; c++)
-			source->async_prev_textures[c] = gs_texture_create(
-				source->async_convert_width[c],
-				source->async_convert_height[c],
-				source->async_texture_formats[c], 1, NULL,
-				GS_DYNAMIC);
+			source->async_prev_textures[c] =
+				gs_texture_pool_acquire(
+					source->async_convert_width[c],
+					source->async_convert_height[c],
+					source->async_texture_formats[c],
+					GS_DYNAMIC);
 
 	} else {
 		enum gs_color_format format =
 			convert_video_format(source->async_format);
 
-		source->async_prev_textures[0] = gs_texture_create(
-			source->async_width, source->async_height, format, 1,
-			NULL, GS_DYNAMIC);
+		source->async_prev_textures[0] = gs_texture_pool_acquire(
+			source->async_width, source->async_height, format,
+			GS_DYNAMIC);
 	}
 }
 
@@ -412,9 +415,9 @@ static void enable_deinterlacing(obs_source_t *source,
 static void disable_deinterlacing(obs_source_t *source)
 {
 	obs_enter_graphics();
-	gs_texture_destroy(source->async_prev_textures[0]);
-	gs_texture_destroy(source->async_prev_textures[1]);
-	gs_texture_destroy(source->async_prev_textures[2]);
+	gs_texture_pool_release(source->async_prev_textures[0]);
+	gs_texture_pool_release(source->async_prev_textures[1]);
+	gs_texture_pool_release(source->async_prev_textures[2]);
 	gs_texrender_destroy(source->async_prev_texrender);
 	source->deinterlace_mode = OBS_DEINTERLACE_MODE_DISABLE;
 	source->async_prev_textures[0] = NULL;
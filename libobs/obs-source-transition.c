@@ -869,15 +869,15 @@ static inline float get_sample_time(obs_source_t *transition,
 	return calc_time(transition, i_ts);
 }
 
-static inline void mix_child(obs_source_t *transition, float *out, float *in,
-			     size_t count, size_t sample_rate, uint64_t ts,
-			     obs_transition_audio_mix_callback_t mix)
+static inline void calc_mix_buf(obs_source_t *transition, float *buf,
+				size_t count, size_t sample_rate, uint64_t ts,
+				obs_transition_audio_mix_callback_t mix)
 {
 	void *context_data = transition->context.data;
 
 	for (size_t i = 0; i < count; i++) {
 		float t = get_sample_time(transition, sample_rate, i, ts);
-		out[i] += in[i] * mix(context_data, t);
+		buf[i] = mix(context_data, t);
 	}
 }
 
@@ -888,8 +888,10 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 {
 	bool valid = child && !child->audio_pending;
 	struct obs_source_audio_mix child_audio;
+	float mix_buf[AUDIO_OUTPUT_FRAMES];
 	uint64_t ts;
 	size_t pos;
+	size_t count;
 
 	if (!valid)
 		return;
@@ -901,6 +903,11 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 	if (pos > AUDIO_OUTPUT_FRAMES)
 		return;
 
+	/* the mix curve only depends on time, so calculate it once and apply
+	 * it to every mix/channel */
+	count = AUDIO_OUTPUT_FRAMES - pos;
+	calc_mix_buf(transition, mix_buf, count, sample_rate, ts, mix);
+
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		struct audio_output_data *output = &audio->output[mix_idx];
 		struct audio_output_data *input = &child_audio.output[mix_idx];
@@ -912,9 +919,7 @@ static void process_audio(obs_source_t *transition, obs_source_t *child,
 			float *out = output->data[ch];
 			float *in = input->data[ch];
 
-			mix_child(transition, out + pos, in,
-				  AUDIO_OUTPUT_FRAMES - pos, sample_rate, ts,
-				  mix);
+			audio_mix_add_mul(out + pos, in, mix_buf, count);
 		}
 	}
 }
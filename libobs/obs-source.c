@@ -553,14 +553,55 @@ void obs_source_frame_init(struct obs_source_frame *frame,
 	}
 }
 
+/* frame whose data is owned by the source, see obs_source_output_video_owned.
+ * the wrappers are listed in async_owned_frames (protected by async_mutex),
+ * which is how they are told apart from frames of the cache */
+struct async_owned_frame {
+	struct obs_source_frame frame;
+	obs_source_frame_release_t release;
+	void *param;
+};
+
 static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
 		obs_source_frame_destroy(frame);
 }
 
+/* requires async_mutex */
+static size_t find_owned_frame(const obs_source_t *source,
+			       const struct obs_source_frame *frame)
+{
+	for (size_t i = 0; i < source->async_owned_frames.num; i++) {
+		if (&source->async_owned_frames.array[i]->frame == frame)
+			return i;
+	}
+
+	return DARRAY_INVALID;
+}
+
+/* requires async_mutex */
+static void async_frame_destroy(obs_source_t *source,
+				struct obs_source_frame *frame)
+{
+	size_t idx = find_owned_frame(source, frame);
+	struct async_owned_frame *owned_frame;
+
+	if (idx == DARRAY_INVALID) {
+		obs_source_frame_destroy(frame);
+		return;
+	}
+
+	owned_frame = source->async_owned_frames.array[idx];
+	da_erase(source->async_owned_frames, idx);
+
+	owned_frame->release(owned_frame->param);
+	bfree(owned_frame);
+}
+
 static bool obs_source_filter_remove_refless(obs_source_t *source,
 					     obs_source_t *filter);
+static inline void free_async_cache(struct obs_source *source);
 
 void obs_source_destroy(struct obs_source *source)
 {
@@ -605,8 +646,8 @@ void obs_source_destroy(struct obs_source *source)
 	obs_hotkey_unregister(source->push_to_mute_key);
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
-	for (i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	free_async_cache(source);
+	da_free(source->async_owned_frames);
 
 	gs_enter_context(obs->video.graphics);
 	if (source->async_texrender)
@@ -614,8 +655,8 @@ void obs_source_destroy(struct obs_source *source)
 	if (source->async_prev_texrender)
 		gs_texrender_destroy(source->async_prev_texrender);
 	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
-		gs_texture_destroy(source->async_textures[c]);
-		gs_texture_destroy(source->async_prev_textures[c]);
+		gs_texture_pool_release(source->async_textures[c]);
+		gs_texture_pool_release(source->async_prev_textures[c]);
 	}
 	if (source->filter_texrender)
 		gs_texrender_destroy(source->filter_texrender);
@@ -637,7 +678,6 @@ void obs_source_destroy(struct obs_source *source)
 	da_free(source->audio_actions);
 	da_free(source->audio_cb_list);
 	da_free(source->async_cache);
-	da_free(source->async_frames);
 	da_free(source->filters);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
@@ -844,6 +884,7 @@ static void obs_source_deferred_update(obs_source_t *source)
 				    source->context.settings);
 
 	source->defer_update = false;
+	os_atomic_inc_long(&source->video_version);
 }
 
 void obs_source_update(obs_source_t *source, obs_data_t *settings)
@@ -862,6 +903,14 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 	}
 }
 
+void obs_source_invalidate_video(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_invalidate_video"))
+		return;
+
+	os_atomic_inc_long(&source->video_version);
+}
+
 void obs_source_update_properties(obs_source_t *source)
 {
 	if (!obs_source_valid(source, "obs_source_update_properties"))
@@ -1691,9 +1740,9 @@ bool set_async_texture_size(struct obs_source *source,
 	gs_enter_context(obs->video.graphics);
 
 	for (size_t c = 0; c < MAX_AV_PLANES; c++) {
-		gs_texture_destroy(source->async_textures[c]);
+		gs_texture_pool_release(source->async_textures[c]);
 		source->async_textures[c] = NULL;
-		gs_texture_destroy(source->async_prev_textures[c]);
+		gs_texture_pool_release(source->async_prev_textures[c]);
 		source->async_prev_textures[c] = NULL;
 	}
 
@@ -1711,15 +1760,14 @@ bool set_async_texture_size(struct obs_source *source,
 			gs_texrender_create(format, GS_ZS_NONE);
 
 		for (int c = 0; c < source->async_channel_count; ++c)
-			source->async_textures[c] = gs_texture_create(
+			source->async_textures[c] = gs_texture_pool_acquire(
 				source->async_convert_width[c],
 				source->async_convert_height[c],
-				source->async_texture_formats[c], 1, NULL,
-				GS_DYNAMIC);
+				source->async_texture_formats[c], GS_DYNAMIC);
 	} else {
 		source->async_textures[0] =
-			gs_texture_create(frame->width, frame->height, format,
-					  1, NULL, GS_DYNAMIC);
+			gs_texture_pool_acquire(frame->width, frame->height,
+						format, GS_DYNAMIC);
 	}
 
 	if (deinterlacing_enabled(source))
@@ -1986,9 +2034,9 @@ static void recreate_async_texture(obs_source_t *source,
 {
 	uint32_t cx = gs_texture_get_width(source->async_textures[0]);
 	uint32_t cy = gs_texture_get_height(source->async_textures[0]);
-	gs_texture_destroy(source->async_textures[0]);
+	gs_texture_pool_release(source->async_textures[0]);
 	source->async_textures[0] =
-		gs_texture_create(cx, cy, format, 1, NULL, GS_DYNAMIC);
+		gs_texture_pool_acquire(cx, cy, format, GS_DYNAMIC);
 }
 
 static inline void check_to_swap_bgrx_bgra(obs_source_t *source,
@@ -2629,13 +2677,29 @@ static inline bool async_texture_changed(struct obs_source *source,
 	       source->async_cache_height != frame->height || prev != cur;
 }
 
+static inline void release_owned_frame(obs_source_t *source,
+				       struct obs_source_frame *frame)
+{
+	if (frame && find_owned_frame(source, frame) != DARRAY_INVALID)
+		remove_async_frame(source, frame);
+}
+
 static inline void free_async_cache(struct obs_source *source)
 {
+	size_t queued = async_frames_count(source);
+
+	/* owned frames aren't part of the cache, so they have to be given back
+	 * to the source individually */
+	for (size_t i = 0; i < queued; i++)
+		release_owned_frame(source, async_frames_peek(source, i));
+	release_owned_frame(source, source->cur_async_frame);
+	release_owned_frame(source, source->prev_async_frame);
+
 	for (size_t i = 0; i < source->async_cache.num; i++)
 		obs_source_frame_decref(source->async_cache.array[i].frame);
 
 	da_resize(source->async_cache, 0);
-	da_resize(source->async_frames, 0);
+	async_frames_clear(source);
 	source->cur_async_frame = NULL;
 	source->prev_async_frame = NULL;
 }
@@ -2643,38 +2707,70 @@ static inline void free_async_cache(struct obs_source *source)
 #define MAX_UNUSED_FRAME_DURATION 5
 
 /* frees frame allocations if they haven't been used for a specific period
- * of time */
+ * of time.  the cache array is only ever modified by the producer, so the
+ * lock is only needed when actually removing something from it. */
 static void clean_cache(obs_source_t *source)
 {
 	for (size_t i = source->async_cache.num; i > 0; i--) {
 		struct async_frame *af = &source->async_cache.array[i - 1];
-		if (!af->used) {
+		if (!os_atomic_load_bool(&af->used)) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
+				pthread_mutex_lock(&source->async_mutex);
 				obs_source_frame_destroy(af->frame);
 				da_erase(source->async_cache, i - 1);
+				pthread_mutex_unlock(&source->async_mutex);
 			}
 		}
 	}
 }
 
+static inline void add_async_frames_lost(struct obs_source *source,
+					 size_t count)
+{
+	long lost;
+
+	do {
+		lost = os_atomic_load_long(&source->async_frames_lost);
+	} while (!os_atomic_compare_swap_long(&source->async_frames_lost, lost,
+					      lost + (long)count));
+}
+
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+
+/* if too many frames are queued, everything is flushed and the new frame is
+ * dropped as well */
+static inline bool async_frames_overflow(struct obs_source *source)
+{
+	size_t queued = async_frames_count(source);
+
+	if (queued < MAX_ASYNC_FRAMES)
+		return false;
+
+	pthread_mutex_lock(&source->async_mutex);
+	free_async_cache(source);
+	source->last_frame_ts = 0;
+	pthread_mutex_unlock(&source->async_mutex);
+
+	add_async_frames_lost(source, queued + 1);
+	return true;
+}
+
+/* must only be called from one thread at a time (the frame producer).  the
+ * common path is lock-free, async_mutex is only taken when the cache has to
+ * be flushed, grown or trimmed. */
 static inline struct obs_source_frame *
 cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 {
 	struct obs_source_frame *new_frame = NULL;
 
-	pthread_mutex_lock(&source->async_mutex);
-
-	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
-		free_async_cache(source);
-		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
+	if (async_frames_overflow(source))
 		return NULL;
-	}
 
 	if (async_texture_changed(source, frame)) {
+		pthread_mutex_lock(&source->async_mutex);
 		free_async_cache(source);
+		pthread_mutex_unlock(&source->async_mutex);
+
 		source->async_cache_width = frame->width;
 		source->async_cache_height = frame->height;
 	}
@@ -2685,10 +2781,10 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
-		if (!af->used) {
+		if (!os_atomic_load_bool(&af->used)) {
 			new_frame = af->frame;
 			new_frame->format = format;
-			af->used = true;
+			os_atomic_set_bool(&af->used, true);
 			af->unused_count = 0;
 			break;
 		}
@@ -2706,13 +2802,11 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 		new_af.unused_count = 0;
 		new_frame->refs = 1;
 
+		pthread_mutex_lock(&source->async_mutex);
 		da_push_back(source->async_cache, &new_af);
+		pthread_mutex_unlock(&source->async_mutex);
 	}
 
-	os_atomic_inc_long(&new_frame->refs);
-
-	pthread_mutex_unlock(&source->async_mutex);
-
 	copy_frame_data(new_frame, frame);
 
 	return new_frame;
@@ -2730,21 +2824,20 @@ obs_source_output_video_internal(obs_source_t *source,
 		return;
 	}
 
-	struct obs_source_frame *output = !!frame ? cache_video(source, frame)
-						  : NULL;
+	struct obs_source_frame *output = cache_video(source, frame);
 
 	/* ------------------------------------------- */
-	pthread_mutex_lock(&source->async_mutex);
 	if (output) {
-		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			da_push_back(source->async_frames, &output);
-			source->async_active = true;
+		if (!async_frames_push(source, output)) {
+			pthread_mutex_lock(&source->async_mutex);
+			remove_async_frame(source, output);
+			pthread_mutex_unlock(&source->async_mutex);
+			add_async_frames_lost(source, 1);
+			return;
 		}
+
+		source->async_active = true;
 	}
-	pthread_mutex_unlock(&source->async_mutex);
 }
 
 void obs_source_output_video(obs_source_t *source,
@@ -2796,6 +2889,64 @@ void obs_source_output_video2(obs_source_t *source,
 	obs_source_output_video_internal(source, &new_frame);
 }
 
+void obs_source_output_video_owned(obs_source_t *source,
+				   const struct obs_source_frame *frame,
+				   obs_source_frame_release_t release,
+				   void *param)
+{
+	struct async_owned_frame *owned_frame;
+
+	if (!frame || !release) {
+		obs_source_output_video(source, frame);
+		return;
+	}
+
+	if (!obs_source_valid(source, "obs_source_output_video_owned") ||
+	    async_frames_overflow(source)) {
+		release(param);
+		return;
+	}
+
+	owned_frame = bmalloc(sizeof(*owned_frame));
+	owned_frame->frame = *frame;
+	owned_frame->frame.full_range =
+		format_is_yuv(frame->format) ? frame->full_range : true;
+	owned_frame->frame.refs = 1;
+	owned_frame->frame.prev_frame = false;
+	owned_frame->release = release;
+	owned_frame->param = param;
+
+	pthread_mutex_lock(&source->async_mutex);
+	da_push_back(source->async_owned_frames, &owned_frame);
+	pthread_mutex_unlock(&source->async_mutex);
+
+	if (!async_frames_push(source, &owned_frame->frame)) {
+		pthread_mutex_lock(&source->async_mutex);
+		async_frame_destroy(source, &owned_frame->frame);
+		pthread_mutex_unlock(&source->async_mutex);
+		add_async_frames_lost(source, 1);
+		return;
+	}
+
+	source->async_active = true;
+}
+
+uint32_t obs_source_get_async_frames_lost(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_frames_lost")
+		       ? (uint32_t)os_atomic_load_long(
+				 &source->async_frames_lost)
+		       : 0;
+}
+
+uint32_t obs_source_get_async_frames_late(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_get_async_frames_late")
+		       ? (uint32_t)os_atomic_load_long(
+				 &source->async_frames_late)
+		       : 0;
+}
+
 static inline bool preload_frame_changed(obs_source_t *source,
 					 const struct obs_source_frame *in)
 {
@@ -3114,11 +3265,19 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 	if (frame)
 		frame->prev_frame = false;
 
+	/* owned frames hold one reference for as long as they're queued or
+	 * current, releasing that gives the data back to the source */
+	if (frame && find_owned_frame(source, frame) != DARRAY_INVALID) {
+		if (os_atomic_dec_long(&frame->refs) == 0)
+			async_frame_destroy(source, frame);
+		return;
+	}
+
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *f = &source->async_cache.array[i];
 
 		if (f->frame == frame) {
-			f->used = false;
+			os_atomic_set_bool(&f->used, false);
 			break;
 		}
 	}
@@ -3128,17 +3287,18 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 
 static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 {
-	struct obs_source_frame *next_frame = source->async_frames.array[0];
+	struct obs_source_frame *next_frame = async_frames_peek(source, 0);
 	struct obs_source_frame *frame = NULL;
 	uint64_t sys_offset = sys_time - source->last_sys_timestamp;
 	uint64_t frame_time = next_frame->timestamp;
 	uint64_t frame_offset = 0;
 
 	if (source->async_unbuffered) {
-		while (source->async_frames.num > 1) {
-			da_erase(source->async_frames, 0);
+		while (async_frames_count(source) > 1) {
+			async_frames_pop(source);
 			remove_async_frame(source, next_frame);
-			next_frame = source->async_frames.array[0];
+			os_atomic_inc_long(&source->async_frames_late);
+			next_frame = async_frames_peek(source, 0);
 		}
 
 		source->last_frame_ts = next_frame->timestamp;
@@ -3152,7 +3312,7 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 	     "number of frames: %lu",
 	     source->last_frame_ts, frame_time, sys_offset,
 	     frame_time - source->last_frame_ts,
-	     (unsigned long)source->async_frames.num);
+	     (unsigned long)async_frames_count(source));
 #endif
 
 	/* account for timestamp invalidation */
@@ -3176,8 +3336,10 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 		if ((source->last_frame_ts - next_frame->timestamp) < 2000000)
 			break;
 
-		if (frame)
-			da_erase(source->async_frames, 0);
+		if (frame) {
+			async_frames_pop(source);
+			os_atomic_inc_long(&source->async_frames_late);
+		}
 
 #if DEBUG_ASYNC_FRAMES
 		blog(LOG_DEBUG,
@@ -3189,11 +3351,11 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 
 		remove_async_frame(source, frame);
 
-		if (source->async_frames.num == 1)
+		if (async_frames_count(source) == 1)
 			return true;
 
 		frame = next_frame;
-		next_frame = source->async_frames.array[1];
+		next_frame = async_frames_peek(source, 1);
 
 		/* more timestamp checking and compensating */
 		if ((next_frame->timestamp - frame_time) > MAX_TS_VAR) {
@@ -3219,12 +3381,12 @@ static bool ready_async_frame(obs_source_t *source, uint64_t sys_time)
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source,
 							 uint64_t sys_time)
 {
-	if (!source->async_frames.num)
+	if (!async_frames_count(source))
 		return NULL;
 
 	if (!source->last_frame_ts || ready_async_frame(source, sys_time)) {
-		struct obs_source_frame *frame = source->async_frames.array[0];
-		da_erase(source->async_frames, 0);
+		struct obs_source_frame *frame = async_frames_peek(source, 0);
+		async_frames_pop(source);
 
 		if (!source->last_frame_ts)
 			source->last_frame_ts = frame->timestamp;
@@ -3274,7 +3436,7 @@ void obs_source_release_frame(obs_source_t *source,
 		pthread_mutex_lock(&source->async_mutex);
 
 		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
+			async_frame_destroy(source, frame);
 		else
 			remove_async_frame(source, frame);
 
@@ -4291,8 +4453,8 @@ static inline void apply_audio_action(obs_source_t *source,
 	}
 }
 
-static void apply_audio_actions(obs_source_t *source, size_t channels,
-				size_t sample_rate)
+static void apply_audio_actions(obs_source_t *source, uint32_t mixers,
+				size_t channels, size_t sample_rate)
 {
 	float *vol_data = malloc(sizeof(float) * AUDIO_OUTPUT_FRAMES);
 	float cur_vol = get_source_volume(source, source->audio_ts);
@@ -4332,7 +4494,9 @@ static void apply_audio_actions(obs_source_t *source, size_t channels,
 	pthread_mutex_unlock(&source->audio_actions_mutex);
 
 	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-		if ((source->audio_mixers & (1 << mix)) != 0)
+		uint32_t mix_and_val = (1 << mix);
+		if ((source->audio_mixers & mix_and_val) != 0 &&
+		    (mixers & mix_and_val) != 0)
 			multiply_vol_data(source, mix, channels, vol_data);
 	}
 
@@ -4359,7 +4523,8 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
 			conv_frames_to_time(sample_rate, AUDIO_OUTPUT_FRAMES);
 
 		if (action.timestamp < (source->audio_ts + duration)) {
-			apply_audio_actions(source, channels, sample_rate);
+			apply_audio_actions(source, mixers, channels,
+					    sample_rate);
 			return;
 		}
 	}
@@ -4369,9 +4534,13 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
 		return;
 
 	if (vol == 0.0f || mixers == 0) {
-		memset(source->audio_output_buf[0][0], 0,
-		       AUDIO_OUTPUT_FRAMES * sizeof(float) *
-			       MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
+		/* only the active mixes are ever read */
+		for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
+			if ((mixers & (1 << mix)) != 0)
+				memset(source->audio_output_buf[mix][0], 0,
+				       AUDIO_OUTPUT_FRAMES * sizeof(float) *
+					       channels);
+		}
 		return;
 	}
 
@@ -4490,8 +4659,11 @@ static inline void process_audio_source_tick(obs_source_t *source,
 			mix_and_val = 1;
 		}
 
-		if ((source->audio_mixers & mix_and_val) == 0 ||
-		    (mixers & mix_and_val) == 0) {
+		/* inactive mixes are never read, so skip them entirely */
+		if ((mixers & mix_and_val) == 0)
+			continue;
+
+		if ((source->audio_mixers & mix_and_val) == 0) {
 			memset(source->audio_output_buf[mix][0], 0,
 			       size * channels);
 			continue;
@@ -4507,7 +4679,7 @@ static inline void process_audio_source_tick(obs_source_t *source,
 		return;
 	}
 
-	if ((source->audio_mixers & 1) == 0 || (mixers & 1) == 0)
+	if ((source->audio_mixers & 1) == 0 && (mixers & 1) != 0)
 		memset(source->audio_output_buf[0][0], 0, size * channels);
 
 	apply_audio_volume(source, mixers, channels, sample_rate);
@@ -186,6 +186,13 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_CONTROLLABLE_MEDIA (1 << 13)
 
+/**
+ * Source video only changes when its settings are updated, or when the source
+ * calls obs_source_invalidate_video.  Scenes cache the rendering of items
+ * made only of such sources and filters.
+ */
+#define OBS_SOURCE_STATIC_VIDEO (1 << 14)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
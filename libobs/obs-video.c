@@ -677,6 +677,20 @@ static inline void copy_rgbx_frame(struct video_frame *output,
 	}
 }
 
+/* CPU fallback for when GPU conversion isn't available, the rows are
+ * converted in parallel on the shared task pool */
+static inline void convert_rgbx_frame(struct obs_core_video *video,
+				      struct video_frame *output,
+				      const struct video_data *input,
+				      const struct video_output_info *info)
+{
+	convert_rgbx_to_nv12_mt(obs->task_pool, input->data[0],
+				input->linesize[0], info->width, 0,
+				info->height, output->data,
+				output->linesize,
+				&video->cpu_conversion_coeffs);
+}
+
 static inline void output_video_data(struct obs_core_video *video,
 				     struct video_data *input_frame, int count)
 {
@@ -692,6 +706,9 @@ static inline void output_video_data(struct obs_core_video *video,
 		if (video->gpu_conversion) {
 			set_gpu_converted_data(video, &output_frame,
 					       input_frame, info);
+		} else if (info->format == VIDEO_FORMAT_NV12) {
+			convert_rgbx_frame(video, &output_frame, input_frame,
+					   info);
 		} else {
 			copy_rgbx_frame(&output_frame, input_frame, info);
 		}
@@ -814,9 +831,12 @@ static void clear_gpu_frame_data(void)
 static const char *tick_sources_name = "tick_sources";
 static const char *render_displays_name = "render_displays";
 static const char *output_frame_name = "output_frame";
+static const char *draw_calls_name = "draw calls per frame";
+static const char *texture_pool_name = "texture pool bytes held";
 void *obs_graphics_thread(void *param)
 {
 	uint64_t last_time = 0;
+	uint64_t last_draw_calls = 0;
 	uint64_t interval = video_output_get_frame_time(obs->video.video);
 	uint64_t frame_time_total_ns = 0;
 	uint64_t fps_total_ns = 0;
@@ -868,8 +888,21 @@ void *obs_graphics_thread(void *param)
 
 		gs_enter_context(obs->video.graphics);
 		gs_begin_frame();
+		uint64_t draw_calls = gs_get_draw_call_count();
+		struct gs_texture_pool_stats pool_stats;
+		gs_texture_pool_get_stats(&pool_stats);
 		gs_leave_context();
 
+		profile_record_value(texture_pool_name,
+				     (int64_t)pool_stats.bytes_held);
+		os_task_pool_record_stats(obs->task_pool);
+
+		if (last_draw_calls)
+			profile_record_value(
+				draw_calls_name,
+				(int64_t)(draw_calls - last_draw_calls));
+		last_draw_calls = draw_calls;
+
 		profile_start(tick_sources_name);
 		last_time = tick_sources(obs->video.video_time, last_time);
 		profile_end(tick_sources_name);
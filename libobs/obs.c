@@ -40,6 +40,7 @@ static inline void make_video_info(struct video_output_info *vi,
 	vi->range = ovi->range;
 	vi->colorspace = ovi->colorspace;
 	vi->cache_size = 6;
+	vi->parallel_inputs = os_atomic_load_bool(&obs->parallel_video_inputs);
 }
 
 static inline void calc_gpu_conversion_sizes(const struct obs_video_info *ovi)
@@ -281,6 +282,7 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 	}
 
 	gs_enter_context(video->graphics);
+	gs_set_cache_path(obs->shader_cache_path);
 
 	char *filename = obs_find_data_file("default.effect");
 	video->default_effect = gs_effect_create_from_file(filename, NULL);
@@ -331,6 +333,14 @@ static int obs_init_graphics(struct obs_video_info *ovi)
 		gs_effect_create_from_file(filename, NULL);
 	bfree(filename);
 
+	/* scenes draw items one at a time if batching is unavailable */
+	filename = obs_find_data_file("sprite_batch.effect");
+	video->sprite_batch_effect = gs_effect_create_from_file(filename, NULL);
+	bfree(filename);
+
+	if (video->sprite_batch_effect)
+		video->sprite_batch = gs_sprite_batch_create(0);
+
 	point_sampler.max_anisotropy = 1;
 	video->point_sampler = gs_samplerstate_create(&point_sampler);
 
@@ -418,6 +428,11 @@ static int obs_init_video(struct obs_video_info *ovi)
 	if (!obs_init_textures(ovi))
 		return OBS_VIDEO_FAIL;
 
+	if (!video->gpu_conversion)
+		rgb_to_yuv_coeffs_init(&video->cpu_conversion_coeffs,
+				       VIDEO_FORMAT_RGBA, ovi->colorspace,
+				       ovi->range);
+
 	gs_leave_context();
 
 	if (pthread_mutexattr_init(&attr) != 0)
@@ -531,12 +546,23 @@ static void obs_free_graphics(void)
 	struct obs_core_video *video = &obs->video;
 
 	if (video->graphics) {
+		struct gs_texture_pool_stats stats;
+
 		gs_enter_context(video->graphics);
 
+		gs_texture_pool_get_stats(&stats);
+		blog(LOG_INFO,
+		     "Texture pool: %" PRIu64 " hits, %" PRIu64 " misses, "
+		     "%" PRIu64 " evictions",
+		     stats.hits, stats.misses, stats.evictions);
+
 		gs_texture_destroy(video->transparent_texture);
 
 		gs_samplerstate_destroy(video->point_sampler);
 
+		gs_sprite_batch_destroy(video->sprite_batch);
+		video->sprite_batch = NULL;
+
 		gs_effect_destroy(video->default_effect);
 		gs_effect_destroy(video->default_rect_effect);
 		gs_effect_destroy(video->opaque_effect);
@@ -547,6 +573,7 @@ static void obs_free_graphics(void)
 		gs_effect_destroy(video->lanczos_effect);
 		gs_effect_destroy(video->area_effect);
 		gs_effect_destroy(video->bilinear_lowres_effect);
+		gs_effect_destroy(video->sprite_batch_effect);
 		video->default_effect = NULL;
 
 		gs_leave_context();
@@ -577,6 +604,8 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
 
+	audio_mix_init();
+
 	errorcode = audio_output_open(&audio->audio, ai);
 	if (errorcode == AUDIO_OUTPUT_SUCCESS)
 		return true;
@@ -597,6 +626,9 @@ static void obs_free_audio(void)
 	circlebuf_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
+	da_free(audio->render_level);
+	da_free(audio->render_levels);
+	da_free(audio->render_edges);
 
 	da_free(audio->monitors);
 	bfree(audio->monitoring_device_name);
@@ -853,6 +885,11 @@ static bool obs_init(const char *locale, const char *module_config_path,
 
 	log_system_info();
 
+	int cores = os_get_logical_cores();
+	obs->task_pool = os_task_pool_create("libobs",
+					     cores > 1 ? (size_t)cores - 1 : 0);
+	obs->parallel_audio_render = true;
+
 	if (!obs_init_data())
 		return false;
 	if (!obs_init_handlers())
@@ -1020,10 +1057,13 @@ void obs_shutdown(void)
 	obs_free_video();
 	obs_free_hotkeys();
 	obs_free_graphics();
+	free_encoder_packet_pool();
 	proc_handler_destroy(obs->procs);
 	signal_handler_destroy(obs->signals);
+	os_task_pool_destroy(obs->task_pool);
 	obs->procs = NULL;
 	obs->signals = NULL;
+	obs->task_pool = NULL;
 
 	core = obs;
 	obs = NULL;
@@ -1044,6 +1084,7 @@ void obs_shutdown(void)
 		profiler_name_store_free(core->name_store);
 
 	bfree(core->module_config_path);
+	bfree(core->shader_cache_path);
 	bfree(core->locale);
 	bfree(core);
 	bfree(cmdline_args.argv);
@@ -1093,6 +1134,21 @@ const char *obs_get_locale(void)
 	return obs ? obs->locale : NULL;
 }
 
+void obs_set_shader_cache_path(const char *path)
+{
+	if (!obs)
+		return;
+
+	bfree(obs->shader_cache_path);
+	obs->shader_cache_path = path ? bstrdup(path) : NULL;
+
+	if (obs->video.graphics) {
+		gs_enter_context(obs->video.graphics);
+		gs_set_cache_path(obs->shader_cache_path);
+		gs_leave_context();
+	}
+}
+
 #define OBS_SIZE_MIN 2
 #define OBS_SIZE_MAX (32 * 1024)
 
@@ -2203,6 +2259,41 @@ profiler_name_store_t *obs_get_profiler_name_store(void)
 	return obs->name_store;
 }
 
+os_task_pool_t *obs_get_task_pool(void)
+{
+	return obs ? obs->task_pool : NULL;
+}
+
+void obs_set_parallel_audio_render(bool enable)
+{
+	if (!obs)
+		return;
+
+	os_atomic_set_bool(&obs->parallel_audio_render, enable);
+	blog(LOG_INFO, "Parallel audio rendering %s",
+	     enable ? "enabled" : "disabled");
+}
+
+bool obs_get_parallel_audio_render(void)
+{
+	return obs ? os_atomic_load_bool(&obs->parallel_audio_render) : false;
+}
+
+void obs_set_parallel_video_inputs(bool enable)
+{
+	if (!obs)
+		return;
+
+	os_atomic_set_bool(&obs->parallel_video_inputs, enable);
+	blog(LOG_INFO, "Parallel video inputs %s",
+	     enable ? "enabled" : "disabled");
+}
+
+bool obs_get_parallel_video_inputs(void)
+{
+	return obs ? os_atomic_load_bool(&obs->parallel_video_inputs) : false;
+}
+
 uint64_t obs_get_video_frame_time(void)
 {
 	return obs ? obs->video.video_time : 0;
@@ -20,6 +20,7 @@
 #include "util/c99defs.h"
 #include "util/bmem.h"
 #include "util/profiler.h"
+#include "util/task-pool.h"
 #include "util/text-lookup.h"
 #include "graphics/graphics.h"
 #include "graphics/vec2.h"
@@ -345,6 +346,15 @@ EXPORT void obs_set_locale(const char *locale);
 /** @return the current locale */
 EXPORT const char *obs_get_locale(void);
 
+/**
+ * Sets the directory used to cache parsed effects and compiled shaders
+ * between sessions.  Should be called before obs_reset_video so the default
+ * effects can be loaded from the cache.
+ *
+ * @param  path  The cache directory, or NULL to disable the cache
+ */
+EXPORT void obs_set_shader_cache_path(const char *path);
+
 /** Initialize the Windows-specific crash handler */
 
 #ifdef _WIN32
@@ -358,6 +368,27 @@ EXPORT void obs_init_win32_crash_handler(void);
  */
 EXPORT profiler_name_store_t *obs_get_profiler_name_store(void);
 
+/**
+ * Returns the task pool (see util/task-pool.h) shared by libobs and plugins,
+ * or NULL in case obs_initialized() returns false.
+ */
+EXPORT os_task_pool_t *obs_get_task_pool(void);
+
+/**
+ * Enables or disables rendering the audio of independent sources (including
+ * their audio filters) on the task pool.  Enabled by default.
+ */
+EXPORT void obs_set_parallel_audio_render(bool enable);
+EXPORT bool obs_get_parallel_audio_render(void);
+
+/**
+ * Enables or disables giving each encoder and raw video callback its own
+ * thread, so a slow one only skips frames for itself.  Takes effect on the
+ * next call to obs_reset_video.  Disabled by default.
+ */
+EXPORT void obs_set_parallel_video_inputs(bool enable);
+EXPORT bool obs_get_parallel_video_inputs(void);
+
 /**
  * Sets base video output base resolution/fps/format.
  *
@@ -1166,6 +1197,11 @@ EXPORT void obs_source_draw(gs_texture_t *image, int x, int y, uint32_t cx,
 /**
  * Outputs asynchronous video data.  Set to NULL to deactivate the texture
  *
+ * Frames of a source are queued without locking, so for each source this
+ * function (and obs_source_output_video2/obs_source_output_video_owned) must
+ * only be called from one thread at a time.  Sources that output video from
+ * several threads have to serialize the calls themselves.
+ *
  * NOTE: Non-YUV formats will always be treated as full range with this
  * function!  Use obs_source_output_video2 instead if partial range support is
  * desired for non-YUV video formats.
@@ -1175,6 +1211,30 @@ EXPORT void obs_source_output_video(obs_source_t *source,
 EXPORT void obs_source_output_video2(obs_source_t *source,
 				     const struct obs_source_frame2 *frame);
 
+typedef void (*obs_source_frame_release_t)(void *param);
+
+/**
+ * Outputs asynchronous video data without copying it.  The frame data must
+ * remain valid until libobs calls release, which can happen from any thread
+ * (usually the graphics thread, once the frame has been uploaded or skipped).
+ * If the frame cannot be queued it is released immediately.
+ *
+ * NOTE: Like obs_source_output_video, non-YUV formats are always treated as
+ * full range.
+ */
+EXPORT void obs_source_output_video_owned(obs_source_t *source,
+					  const struct obs_source_frame *frame,
+					  obs_source_frame_release_t release,
+					  void *param);
+
+/**
+ * Gets the number of async video frames that were lost because too many
+ * frames were queued, and the number of frames that were skipped because a
+ * newer frame was already due when they would have been displayed.
+ */
+EXPORT uint32_t obs_source_get_async_frames_lost(const obs_source_t *source);
+EXPORT uint32_t obs_source_get_async_frames_late(const obs_source_t *source);
+
 /**
  * Preloads asynchronous video data to allow instantaneous playback
  *
@@ -1197,6 +1257,12 @@ EXPORT void obs_source_output_audio(obs_source_t *source,
 /** Signal an update to any currently used properties via 'update_properties' */
 EXPORT void obs_source_update_properties(obs_source_t *source);
 
+/**
+ * Signals that the video of a source with the OBS_SOURCE_STATIC_VIDEO flag
+ * changed outside of a settings update, so cached renderings are redrawn
+ */
+EXPORT void obs_source_invalidate_video(obs_source_t *source);
+
 /** Gets the current async video frame */
 EXPORT struct obs_source_frame *obs_source_get_frame(obs_source_t *source);
 
@@ -1693,6 +1759,15 @@ EXPORT uint32_t obs_output_get_delay(const obs_output_t *output);
 /** If delay is active, gets the currently active delay value, in seconds. */
 EXPORT uint32_t obs_output_get_active_delay(const obs_output_t *output);
 
+/**
+ * Limits the amount of delayed packet data kept in memory.  Packets that don't
+ * fit are written to temporary files in spill_dir and read back shortly before
+ * they're sent.  A limit of 0 or a NULL directory keeps everything in memory.
+ */
+EXPORT void obs_output_set_delay_memory_limit(obs_output_t *output,
+					      uint64_t max_bytes,
+					      const char *spill_dir);
+
 /** Forces the output to stop.  Usually only used with delay. */
 EXPORT void obs_output_force_stop(obs_output_t *output);
 
@@ -2065,12 +2140,30 @@ EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst,
 				   struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/** Returns the number of bytes allocated for encoder packet buffers */
+EXPORT uint64_t obs_get_encoder_packet_bytes_allocated(void);
+
+/** Returns the number of bytes of encoder packet data copied */
+EXPORT uint64_t obs_get_encoder_packet_bytes_copied(void);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder,
 					 const char *reroute_id);
 
 /** Returns whether encoder is paused */
 EXPORT bool obs_encoder_paused(const obs_encoder_t *output);
 
+/**
+ * Returns the number of raw frames waiting to be encoded.  Only encoders that
+ * encode on their own thread queue frames, this is always 0 for the others.
+ */
+EXPORT uint32_t obs_encoder_get_queued_frames(const obs_encoder_t *encoder);
+
+/**
+ * Returns the number of raw frames skipped since the encoder was started
+ * because its queue was full.
+ */
+EXPORT uint32_t obs_encoder_get_skipped_frames(const obs_encoder_t *encoder);
+
 /* ------------------------------------------------------------------------- */
 /* Stream Services */
 
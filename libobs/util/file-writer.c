@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "file-writer.h"
+#include "threading.h"
+#include "base.h"
+
+/* this file only depends on base.c and pthreads, so that programs that don't
+ * link against libobs, such as obs-ffmpeg-mux, can build it in directly */
+
+#define DEFAULT_BUFFER_SIZE (4 * 1024 * 1024)
+#define BUFFER_ALIGN 4096
+#define NUM_BUFFERS 2
+
+/* waits shorter than this for a free buffer are not counted as stalls */
+#define STALL_THRESHOLD_NS 1000000ULL
+
+struct write_buffer {
+	uint8_t *data;
+	size_t size;
+	int64_t offset;
+};
+
+struct buffer_queue {
+	struct write_buffer *buffers[NUM_BUFFERS];
+	size_t first;
+	size_t num;
+};
+
+struct os_file_writer {
+	FILE *file;
+	size_t buffer_size;
+	uint64_t sync_interval;
+
+	struct write_buffer buffers[NUM_BUFFERS];
+
+	/* buffer being filled by the caller */
+	struct write_buffer *cur;
+	int64_t pos;
+	int64_t size;
+
+	/* signaled whenever a buffer is queued, a write completes or the
+	 * writer is closed */
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct buffer_queue queued;
+	struct buffer_queue free_buffers;
+	bool writing;
+	bool stop;
+	pthread_t thread;
+	volatile bool error;
+
+	/* writer thread only */
+	int64_t file_pos;
+	uint64_t unsynced;
+
+	struct os_file_writer_stats stats;
+};
+
+static inline void queue_push(struct buffer_queue *queue,
+			      struct write_buffer *buf)
+{
+	queue->buffers[(queue->first + queue->num++) % NUM_BUFFERS] = buf;
+}
+
+static inline struct write_buffer *queue_pop(struct buffer_queue *queue)
+{
+	struct write_buffer *buf = queue->buffers[queue->first];
+
+	queue->first = (queue->first + 1) % NUM_BUFFERS;
+	queue->num--;
+	return buf;
+}
+
+static inline uint64_t get_time_ns(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (uint64_t)((double)count.QuadPart * 1000000000.0 /
+			  (double)freq.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static FILE *open_file(const char *path)
+{
+#ifdef _WIN32
+	wchar_t *wpath;
+	FILE *file;
+	int len;
+
+	len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+	if (!len)
+		return NULL;
+
+	wpath = malloc(len * sizeof(wchar_t));
+	if (!wpath)
+		return NULL;
+
+	MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+	file = _wfopen(wpath, L"w+b");
+	free(wpath);
+	return file;
+#else
+	return fopen(path, "w+b");
+#endif
+}
+
+static inline int seek_file(FILE *file, int64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, offset, SEEK_SET);
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static inline int sync_file(FILE *file)
+{
+	fflush(file);
+#ifdef _WIN32
+	return _commit(_fileno(file));
+#elif defined(__APPLE__)
+	return fsync(fileno(file));
+#else
+	return fdatasync(fileno(file));
+#endif
+}
+
+static inline size_t latency_bucket(uint64_t ns)
+{
+	uint64_t limit = 1000000ULL;
+
+	for (size_t i = 0; i < OS_FILE_WRITER_LATENCY_BUCKETS - 1; i++) {
+		if (ns < limit)
+			return i;
+		limit *= 4;
+	}
+
+	return OS_FILE_WRITER_LATENCY_BUCKETS - 1;
+}
+
+static bool write_buffer(struct os_file_writer *writer,
+			 struct write_buffer *buf)
+{
+	uint64_t start = get_time_ns();
+	uint64_t elapsed;
+	bool synced = false;
+
+	if (buf->offset != writer->file_pos &&
+	    seek_file(writer->file, buf->offset) != 0)
+		return false;
+
+	writer->file_pos = buf->offset;
+	if (fwrite(buf->data, 1, buf->size, writer->file) != buf->size) {
+		writer->file_pos = -1;
+		return false;
+	}
+
+	writer->file_pos += (int64_t)buf->size;
+	writer->unsynced += buf->size;
+
+	if (writer->sync_interval &&
+	    writer->unsynced >= writer->sync_interval) {
+		if (sync_file(writer->file) != 0)
+			return false;
+		writer->unsynced = 0;
+		synced = true;
+	}
+
+	elapsed = get_time_ns() - start;
+
+	pthread_mutex_lock(&writer->mutex);
+	writer->stats.bytes_written += buf->size;
+	writer->stats.writes++;
+	writer->stats.latency[latency_bucket(elapsed)]++;
+	if (elapsed > writer->stats.max_latency_ns)
+		writer->stats.max_latency_ns = elapsed;
+	if (synced)
+		writer->stats.syncs++;
+	pthread_mutex_unlock(&writer->mutex);
+
+	return true;
+}
+
+static void *writer_thread(void *data)
+{
+	struct os_file_writer *writer = data;
+
+#if defined(__linux__) && defined(__GLIBC__)
+	pthread_setname_np(pthread_self(), "file writer");
+#endif
+
+	pthread_mutex_lock(&writer->mutex);
+
+	for (;;) {
+		struct write_buffer *buf;
+
+		/* the writer is only stopped once everything queued before
+		 * closing has been written */
+		while (!writer->queued.num && !writer->stop)
+			pthread_cond_wait(&writer->cond, &writer->mutex);
+		if (!writer->queued.num)
+			break;
+
+		buf = queue_pop(&writer->queued);
+		writer->writing = true;
+		pthread_mutex_unlock(&writer->mutex);
+
+		if (!os_atomic_load_bool(&writer->error) &&
+		    !write_buffer(writer, buf)) {
+			blog(LOG_ERROR, "file writer: write failed");
+			os_atomic_set_bool(&writer->error, true);
+		}
+
+		buf->size = 0;
+
+		pthread_mutex_lock(&writer->mutex);
+		queue_push(&writer->free_buffers, buf);
+		writer->writing = false;
+		pthread_cond_broadcast(&writer->cond);
+	}
+
+	pthread_mutex_unlock(&writer->mutex);
+	return NULL;
+}
+
+static void get_free_buffer(struct os_file_writer *writer)
+{
+	uint64_t start = get_time_ns();
+	struct write_buffer *buf;
+
+	pthread_mutex_lock(&writer->mutex);
+	while (!writer->free_buffers.num)
+		pthread_cond_wait(&writer->cond, &writer->mutex);
+
+	buf = queue_pop(&writer->free_buffers);
+	if (get_time_ns() - start >= STALL_THRESHOLD_NS)
+		writer->stats.stalls++;
+	pthread_mutex_unlock(&writer->mutex);
+
+	buf->offset = writer->pos;
+	writer->cur = buf;
+}
+
+static void submit_buffer(struct os_file_writer *writer)
+{
+	struct write_buffer *buf = writer->cur;
+
+	if (!buf->size) {
+		buf->offset = writer->pos;
+		return;
+	}
+
+	pthread_mutex_lock(&writer->mutex);
+	queue_push(&writer->queued, buf);
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+
+	get_free_buffer(writer);
+}
+
+static void free_writer(struct os_file_writer *writer)
+{
+	for (size_t i = 0; i < NUM_BUFFERS; i++)
+		free(writer->buffers[i].data);
+
+	pthread_cond_destroy(&writer->cond);
+	pthread_mutex_destroy(&writer->mutex);
+	free(writer);
+}
+
+os_file_writer_t *os_file_writer_open(const char *path, size_t buffer_size,
+				      uint64_t sync_interval)
+{
+	struct os_file_writer *writer;
+
+	if (!buffer_size)
+		buffer_size = DEFAULT_BUFFER_SIZE;
+	buffer_size = (buffer_size + BUFFER_ALIGN - 1) & ~(BUFFER_ALIGN - 1);
+
+	writer = calloc(1, sizeof(struct os_file_writer));
+	if (!writer)
+		return NULL;
+
+	writer->buffer_size = buffer_size;
+	writer->sync_interval = sync_interval;
+	pthread_mutex_init_value(&writer->mutex);
+
+	if (pthread_mutex_init(&writer->mutex, NULL) != 0)
+		goto fail;
+	if (pthread_cond_init(&writer->cond, NULL) != 0)
+		goto fail;
+
+	for (size_t i = 0; i < NUM_BUFFERS; i++) {
+		struct write_buffer *buf = &writer->buffers[i];
+
+		buf->data = malloc(buffer_size);
+		if (!buf->data)
+			goto fail;
+		if (i > 0)
+			queue_push(&writer->free_buffers, buf);
+	}
+
+	writer->file = open_file(path);
+	if (!writer->file)
+		goto fail;
+
+	/* buffers are always written whole, so stdio buffering would only add
+	 * another copy */
+	setvbuf(writer->file, NULL, _IONBF, 0);
+
+	writer->cur = &writer->buffers[0];
+
+	if (pthread_create(&writer->thread, NULL, writer_thread, writer) != 0) {
+		fclose(writer->file);
+		goto fail;
+	}
+
+	return writer;
+
+fail:
+	blog(LOG_ERROR, "file writer: failed to open '%s'", path);
+	free_writer(writer);
+	return NULL;
+}
+
+bool os_file_writer_close(os_file_writer_t *writer)
+{
+	bool success;
+
+	if (!writer)
+		return false;
+
+	submit_buffer(writer);
+
+	pthread_mutex_lock(&writer->mutex);
+	writer->stop = true;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->mutex);
+	pthread_join(writer->thread, NULL);
+
+	success = !os_atomic_load_bool(&writer->error);
+	if (success && writer->sync_interval && writer->unsynced)
+		success = sync_file(writer->file) == 0;
+	if (fclose(writer->file) != 0)
+		success = false;
+
+	free_writer(writer);
+	return success;
+}
+
+bool os_file_writer_write(os_file_writer_t *writer, const void *data,
+			  size_t size)
+{
+	const uint8_t *in = data;
+
+	if (!writer || os_atomic_load_bool(&writer->error))
+		return false;
+
+	while (size) {
+		struct write_buffer *buf = writer->cur;
+		size_t space = writer->buffer_size - buf->size;
+		size_t copy = size < space ? size : space;
+
+		memcpy(buf->data + buf->size, in, copy);
+		buf->size += copy;
+		writer->pos += (int64_t)copy;
+		in += copy;
+		size -= copy;
+
+		if (writer->pos > writer->size)
+			writer->size = writer->pos;
+		if (buf->size == writer->buffer_size)
+			submit_buffer(writer);
+	}
+
+	return !os_atomic_load_bool(&writer->error);
+}
+
+size_t os_file_writer_read(os_file_writer_t *writer, void *data, size_t size)
+{
+	size_t read;
+
+	if (!os_file_writer_flush(writer))
+		return 0;
+
+	/* the writer thread is idle, so the file can be used directly */
+	writer->file_pos = -1;
+	if (seek_file(writer->file, writer->pos) != 0)
+		return 0;
+
+	read = fread(data, 1, size, writer->file);
+	writer->pos += (int64_t)read;
+	writer->cur->offset = writer->pos;
+	return read;
+}
+
+bool os_file_writer_seek(os_file_writer_t *writer, int64_t offset)
+{
+	if (!writer || offset < 0)
+		return false;
+
+	if (offset != writer->pos) {
+		submit_buffer(writer);
+		writer->pos = offset;
+		writer->cur->offset = offset;
+	}
+
+	return true;
+}
+
+int64_t os_file_writer_tell(const os_file_writer_t *writer)
+{
+	return writer ? writer->pos : -1;
+}
+
+int64_t os_file_writer_get_size(const os_file_writer_t *writer)
+{
+	return writer ? writer->size : -1;
+}
+
+bool os_file_writer_flush(os_file_writer_t *writer)
+{
+	if (!writer)
+		return false;
+
+	submit_buffer(writer);
+
+	pthread_mutex_lock(&writer->mutex);
+	while (writer->queued.num || writer->writing)
+		pthread_cond_wait(&writer->cond, &writer->mutex);
+	pthread_mutex_unlock(&writer->mutex);
+
+	return !os_atomic_load_bool(&writer->error);
+}
+
+void os_file_writer_get_stats(os_file_writer_t *writer,
+			      struct os_file_writer_stats *stats)
+{
+	if (!writer) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	pthread_mutex_lock(&writer->mutex);
+	*stats = writer->stats;
+	pthread_mutex_unlock(&writer->mutex);
+}
+
+void os_file_writer_log_stats(os_file_writer_t *writer, const char *name)
+{
+	static const char *bucket_names[OS_FILE_WRITER_LATENCY_BUCKETS] = {
+		"<1ms",   "<4ms",    "<16ms",   "<64ms",
+		"<256ms", "<1024ms", "<4096ms", ">=4096ms",
+	};
+	struct os_file_writer_stats stats;
+
+	os_file_writer_get_stats(writer, &stats);
+
+	blog(LOG_INFO,
+	     "%s: %" PRIu64 " bytes in %" PRIu64 " writes, %" PRIu64
+	     " syncs, %" PRIu64 " stalls, slowest write %" PRIu64 "ms",
+	     name, stats.bytes_written, stats.writes, stats.syncs, stats.stalls,
+	     stats.max_latency_ns / 1000000);
+
+	for (size_t i = 0; i < OS_FILE_WRITER_LATENCY_BUCKETS; i++) {
+		if (stats.latency[i])
+			blog(LOG_INFO, "%s: write latency %-8s %" PRIu64, name,
+			     bucket_names[i], stats.latency[i]);
+	}
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+/*
+ *   Buffered file writer that does its disk writes on a separate thread.
+ *
+ *   Data is collected into large buffers, which are written out whole by the
+ * writer thread while the next buffer is filled, so a slow disk only blocks
+ * the caller once every buffer is waiting to be written.  Seeking and reading
+ * back are supported for muxers that patch headers when finishing a file.
+ */
+
+#include "c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OS_FILE_WRITER_LATENCY_BUCKETS 8
+
+struct os_file_writer;
+typedef struct os_file_writer os_file_writer_t;
+
+struct os_file_writer_stats {
+	uint64_t bytes_written;
+	uint64_t writes;
+	uint64_t syncs;
+
+	/** Number of times the caller had to wait for a free buffer */
+	uint64_t stalls;
+
+	/**
+	 * Histogram of the time taken by each disk write.  Bucket 0 counts
+	 * writes under 1ms, every following bucket is 4 times wider, and the
+	 * last bucket counts everything slower.
+	 */
+	uint64_t latency[OS_FILE_WRITER_LATENCY_BUCKETS];
+	uint64_t max_latency_ns;
+};
+
+/**
+ * Opens a file for writing, truncating it if it already exists.
+ *
+ * @param  path           Path of the file
+ * @param  buffer_size    Size of each write buffer, or 0 for the default.
+ *                        Rounded up to a multiple of 4096.
+ * @param  sync_interval  Number of bytes after which the writer thread flushes
+ *                        the file to disk, or 0 to never sync before closing
+ */
+EXPORT os_file_writer_t *os_file_writer_open(const char *path,
+					     size_t buffer_size,
+					     uint64_t sync_interval);
+
+/** Waits for pending writes and closes the file, returns false on error */
+EXPORT bool os_file_writer_close(os_file_writer_t *writer);
+
+/** Queues data to be written, returns false if a write has failed */
+EXPORT bool os_file_writer_write(os_file_writer_t *writer, const void *data,
+				 size_t size);
+
+/**
+ * Reads back data at the current position.  Waits for all pending writes
+ * first, so this should only be used when finalizing a file.
+ */
+EXPORT size_t os_file_writer_read(os_file_writer_t *writer, void *data,
+				  size_t size);
+
+/** Sets the position of the next write */
+EXPORT bool os_file_writer_seek(os_file_writer_t *writer, int64_t offset);
+
+/** Returns the position of the next write */
+EXPORT int64_t os_file_writer_tell(const os_file_writer_t *writer);
+
+/** Returns the size of the file, including data not yet written */
+EXPORT int64_t os_file_writer_get_size(const os_file_writer_t *writer);
+
+/** Waits until all data queued so far has been written */
+EXPORT bool os_file_writer_flush(os_file_writer_t *writer);
+
+EXPORT void os_file_writer_get_stats(os_file_writer_t *writer,
+				     struct os_file_writer_stats *stats);
+
+/** Logs the write statistics, each line prefixed with the specified name */
+EXPORT void os_file_writer_log_stats(os_file_writer_t *writer,
+				     const char *name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -256,9 +256,18 @@ static void merge_call(profile_entry *entry, profile_call *call,
 #endif
 }
 
+typedef struct profile_value_entry {
+	char *name;
+	uint64_t count;
+	int64_t sum;
+	int64_t min;
+	int64_t max;
+} profile_value_entry;
+
 static bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
+static DARRAY(profile_value_entry) value_entries;
 
 static THREAD_LOCAL profile_call *thread_context = NULL;
 static THREAD_LOCAL bool thread_enabled = true;
@@ -334,6 +343,37 @@ void profile_register_root(const char *name,
 	pthread_mutex_unlock(&root_mutex);
 }
 
+void profile_record_value(const char *name, int64_t value)
+{
+	profile_value_entry *entry = NULL;
+
+	if (!name || !thread_enabled || !lock_root())
+		return;
+
+	for (size_t i = 0; i < value_entries.num; i++) {
+		if (strcmp(value_entries.array[i].name, name) == 0) {
+			entry = &value_entries.array[i];
+			break;
+		}
+	}
+
+	if (!entry) {
+		entry = da_push_back_new(value_entries);
+		entry->name = bstrdup(name);
+		entry->min = value;
+		entry->max = value;
+	}
+
+	entry->count++;
+	entry->sum += value;
+	if (value < entry->min)
+		entry->min = value;
+	if (value > entry->max)
+		entry->max = value;
+
+	pthread_mutex_unlock(&root_mutex);
+}
+
 static void free_call_context(profile_call *context);
 
 static void merge_context(profile_call *context)
@@ -759,6 +799,31 @@ void profiler_print_time_between_calls(profiler_snapshot_t *snap)
 			   profile_print_entry_expected, snap);
 }
 
+void profiler_print_values(void)
+{
+	struct dstr output_buffer = {0};
+
+	pthread_mutex_lock(&root_mutex);
+
+	blog(LOG_INFO, "== Profiler Values ==============================");
+	for (size_t i = 0; i < value_entries.num; i++) {
+		profile_value_entry *entry = &value_entries.array[i];
+		double avg = (double)entry->sum / (double)entry->count;
+
+		dstr_printf(&output_buffer,
+			    "%s: min=%" PRId64 ", avg=%g, max=%" PRId64
+			    ", %" PRIu64 " samples",
+			    entry->name, entry->min, avg, entry->max,
+			    entry->count);
+		blog(LOG_INFO, "%s", output_buffer.array);
+	}
+	blog(LOG_INFO, "=================================================");
+
+	pthread_mutex_unlock(&root_mutex);
+
+	dstr_free(&output_buffer);
+}
+
 static void free_call_children(profile_call *call)
 {
 	if (!call)
@@ -802,12 +867,18 @@ static void free_profile_entry(profile_entry *entry)
 void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
+	DARRAY(profile_value_entry) old_value_entries = {0};
 
 	pthread_mutex_lock(&root_mutex);
 	enabled = false;
 	da_move(old_root_entries, root_entries);
+	da_move(old_value_entries, value_entries);
 	pthread_mutex_unlock(&root_mutex);
 
+	for (size_t i = 0; i < old_value_entries.num; i++)
+		bfree(old_value_entries.array[i].name);
+	da_free(old_value_entries);
+
 	for (size_t i = 0; i < old_root_entries.num; i++) {
 		profile_root_entry *entry = &old_root_entries.array[i];
 
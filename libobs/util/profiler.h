@@ -22,6 +22,11 @@ EXPORT void profile_end(const char *name);
 
 EXPORT void profile_reenable_thread(void);
 
+/* ------------------------------------------------------------------------- */
+/* Recorded values, such as queue depths */
+
+EXPORT void profile_record_value(const char *name, int64_t value);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler control */
 
@@ -30,6 +35,7 @@ EXPORT void profiler_stop(void);
 
 EXPORT void profiler_print(profiler_snapshot_t *snap);
 EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
+EXPORT void profiler_print_values(void);
 
 EXPORT void profiler_free(void);
 
@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "task-pool.h"
+#include "threading.h"
+#include "circlebuf.h"
+#include "profiler.h"
+#include "bmem.h"
+#include "dstr.h"
+#include "base.h"
+
+#define CHUNKS_PER_THREAD 4
+
+struct task {
+	os_task_func_t func;
+	void *param;
+	struct os_task_group *group;
+};
+
+struct task_worker {
+	struct os_task_pool *pool;
+	size_t idx;
+
+	pthread_mutex_t mutex;
+	struct circlebuf tasks;
+};
+
+struct os_task_group {
+	struct os_task_pool *pool;
+
+	pthread_mutex_t mutex;
+	os_event_t *done;
+	volatile long pending;
+};
+
+struct os_task_pool {
+	char *name;
+	char *depth_name;
+	char *steals_name;
+
+	/* accumulated between os_task_pool_record_stats() calls */
+	volatile long peak_depth;
+	volatile long steals;
+
+	struct task_worker *workers;
+	size_t num_workers;
+	volatile long next_worker;
+
+	os_sem_t *work_sem;
+	volatile bool stop;
+
+	pthread_t *threads;
+	size_t num_threads;
+};
+
+/* worker of the current thread, NULL if it isn't a task pool thread */
+static THREAD_LOCAL struct task_worker *cur_worker = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static inline struct task_worker *get_own_worker(os_task_pool_t *pool)
+{
+	return (cur_worker && cur_worker->pool == pool) ? cur_worker : NULL;
+}
+
+static void task_pool_push(os_task_pool_t *pool, struct task *task)
+{
+	struct task_worker *worker = get_own_worker(pool);
+	long depth;
+
+	if (!worker) {
+		long next = os_atomic_inc_long(&pool->next_worker);
+		worker = &pool->workers[(unsigned long)next %
+					pool->num_workers];
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	circlebuf_push_back(&worker->tasks, task, sizeof(*task));
+	depth = (long)(worker->tasks.size / sizeof(*task));
+	pthread_mutex_unlock(&worker->mutex);
+
+	/* racy, but a missed peak only makes the statistic slightly low */
+	if (depth > os_atomic_load_long(&pool->peak_depth))
+		os_atomic_set_long(&pool->peak_depth, depth);
+	os_sem_post(pool->work_sem);
+}
+
+/* the owner takes the newest task, thieves take the oldest */
+static bool task_worker_pop(struct task_worker *worker, struct task *task,
+			    bool steal)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->tasks.size) {
+		if (steal)
+			circlebuf_pop_front(&worker->tasks, task,
+					    sizeof(*task));
+		else
+			circlebuf_pop_back(&worker->tasks, task, sizeof(*task));
+		found = true;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return found;
+}
+
+static void task_group_finish(struct os_task_group *group)
+{
+	pthread_mutex_lock(&group->mutex);
+	if (os_atomic_dec_long(&group->pending) == 0)
+		os_event_signal(group->done);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+/* runs one queued task, taken from the calling worker's own queue when
+ * possible, otherwise stolen from the other queues */
+static bool task_pool_run_one(os_task_pool_t *pool)
+{
+	struct task_worker *self = get_own_worker(pool);
+	struct task task;
+	bool stolen = false;
+
+	if (!self || !task_worker_pop(self, &task, false)) {
+		size_t first =
+			self ? self->idx + 1
+			     : (size_t)os_atomic_load_long(&pool->next_worker);
+		size_t i;
+
+		for (i = 0; i < pool->num_workers; i++) {
+			size_t idx = (first + i) % pool->num_workers;
+			struct task_worker *victim = &pool->workers[idx];
+
+			if (victim != self &&
+			    task_worker_pop(victim, &task, true))
+				break;
+		}
+
+		if (i == pool->num_workers)
+			return false;
+
+		stolen = true;
+	}
+
+	task.func(task.param);
+
+	if (stolen)
+		os_atomic_inc_long(&pool->steals);
+	task_group_finish(task.group);
+	return true;
+}
+
+static void *task_pool_thread(void *param)
+{
+	struct task_worker *worker = param;
+	os_task_pool_t *pool = worker->pool;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s: task pool", pool->name);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	cur_worker = worker;
+
+	while (os_sem_wait(pool->work_sem) == 0) {
+		if (pool->stop)
+			break;
+
+		while (task_pool_run_one(pool))
+			;
+	}
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+os_task_pool_t *os_task_pool_create(const char *name, size_t threads)
+{
+	struct os_task_pool *pool = bzalloc(sizeof(struct os_task_pool));
+	struct dstr stat_name = {0};
+
+	pool->name = bstrdup(name ? name : "libobs");
+
+	dstr_printf(&stat_name, "%s: task queue depth", pool->name);
+	pool->depth_name = stat_name.array;
+	dstr_init(&stat_name);
+	dstr_printf(&stat_name, "%s: tasks stolen", pool->name);
+	pool->steals_name = stat_name.array;
+
+	if (os_sem_init(&pool->work_sem, 0) != 0)
+		goto fail;
+
+	if (!threads)
+		return pool;
+
+	pool->workers = bzalloc(sizeof(struct task_worker) * threads);
+	pool->threads = bzalloc(sizeof(pthread_t) * threads);
+
+	for (; pool->num_workers < threads; pool->num_workers++) {
+		struct task_worker *worker = &pool->workers[pool->num_workers];
+
+		worker->pool = pool;
+		worker->idx = pool->num_workers;
+
+		pthread_mutex_init_value(&worker->mutex);
+		if (pthread_mutex_init(&worker->mutex, NULL) != 0)
+			goto fail;
+	}
+
+	/* every worker needs its queue before the first thread starts
+	 * stealing, so threads that fail to start leave their queue to be
+	 * emptied by the others */
+	for (size_t i = 0; i < threads; i++) {
+		pthread_t *thread = &pool->threads[pool->num_threads];
+		int ret = pthread_create(thread, NULL, task_pool_thread,
+					 &pool->workers[i]);
+
+		if (ret != 0)
+			continue;
+
+		pool->num_threads++;
+	}
+
+	if (pool->num_threads < threads)
+		blog(LOG_WARNING,
+		     "os_task_pool_create: Only %zu of %zu "
+		     "threads could be created",
+		     pool->num_threads, threads);
+	if (!pool->num_threads)
+		goto fail;
+
+	return pool;
+
+fail:
+	os_task_pool_destroy(pool);
+	return NULL;
+}
+
+void os_task_pool_destroy(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	pool->stop = true;
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->work_sem);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		circlebuf_free(&pool->workers[i].tasks);
+		pthread_mutex_destroy(&pool->workers[i].mutex);
+	}
+
+	os_sem_destroy(pool->work_sem);
+	bfree(pool->workers);
+	bfree(pool->threads);
+	bfree(pool->steals_name);
+	bfree(pool->depth_name);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_task_pool_get_threads(const os_task_pool_t *pool)
+{
+	return pool ? pool->num_threads : 0;
+}
+
+void os_task_pool_record_stats(os_task_pool_t *pool)
+{
+	if (!pool || !pool->num_threads)
+		return;
+
+	profile_record_value(pool->depth_name,
+			     os_atomic_set_long(&pool->peak_depth, 0));
+	profile_record_value(pool->steals_name,
+			     os_atomic_set_long(&pool->steals, 0));
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool task_group_init(struct os_task_group *group, os_task_pool_t *pool)
+{
+	group->pool = os_task_pool_get_threads(pool) ? pool : NULL;
+
+	if (!group->pool)
+		return true;
+
+	pthread_mutex_init_value(&group->mutex);
+	if (pthread_mutex_init(&group->mutex, NULL) != 0)
+		return false;
+	if (os_event_init(&group->done, OS_EVENT_TYPE_MANUAL) != 0) {
+		pthread_mutex_destroy(&group->mutex);
+		return false;
+	}
+
+	os_event_signal(group->done);
+	return true;
+}
+
+static void task_group_free(struct os_task_group *group)
+{
+	if (!group->pool)
+		return;
+
+	os_task_group_wait(group);
+	os_event_destroy(group->done);
+	pthread_mutex_destroy(&group->mutex);
+}
+
+os_task_group_t *os_task_group_create(os_task_pool_t *pool)
+{
+	struct os_task_group *group = bzalloc(sizeof(struct os_task_group));
+
+	if (!task_group_init(group, pool)) {
+		bfree(group);
+		return NULL;
+	}
+
+	return group;
+}
+
+void os_task_group_destroy(os_task_group_t *group)
+{
+	if (group) {
+		task_group_free(group);
+		bfree(group);
+	}
+}
+
+void os_task_group_run(os_task_group_t *group, os_task_func_t func,
+		       void *param)
+{
+	struct task task = {func, param, group};
+
+	if (!group->pool) {
+		func(param);
+		return;
+	}
+
+	pthread_mutex_lock(&group->mutex);
+	if (os_atomic_inc_long(&group->pending) == 1)
+		os_event_reset(group->done);
+	pthread_mutex_unlock(&group->mutex);
+
+	task_pool_push(group->pool, &task);
+}
+
+void os_task_group_wait(os_task_group_t *group)
+{
+	os_task_pool_t *pool = group->pool;
+
+	if (!pool)
+		return;
+
+	while (os_atomic_load_long(&group->pending)) {
+		if (!task_pool_run_one(pool))
+			os_event_wait(group->done);
+	}
+
+	/* make sure the thread that finished the last task is done with the
+	 * group before it can be destroyed */
+	pthread_mutex_lock(&group->mutex);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* a single parallel_for call, lives on the stack of the calling thread */
+struct range_job {
+	os_task_range_t func;
+	void *param;
+
+	size_t start;
+	size_t end;
+	size_t chunk_size;
+	long num_chunks;
+
+	volatile long next_chunk;
+};
+
+static bool range_job_run_next(struct range_job *job)
+{
+	long chunk = os_atomic_inc_long(&job->next_chunk) - 1;
+	size_t start, end;
+
+	if (chunk >= job->num_chunks)
+		return false;
+
+	start = job->start + (size_t)chunk * job->chunk_size;
+	end = start + job->chunk_size;
+	if (end > job->end)
+		end = job->end;
+
+	job->func(job->param, start, end);
+	return true;
+}
+
+static void range_job_task(void *param)
+{
+	range_job_run_next(param);
+}
+
+void os_task_pool_parallel_for(os_task_pool_t *pool, size_t start,
+			       size_t end, size_t grain, os_task_range_t func,
+			       void *param)
+{
+	struct os_task_group group = {0};
+	struct range_job job = {0};
+	size_t count, chunk_grains, num_grains;
+	size_t max_chunks;
+
+	if (end <= start)
+		return;
+
+	if (!grain)
+		grain = 1;
+
+	count = end - start;
+	num_grains = (count + grain - 1) / grain;
+	max_chunks = (os_task_pool_get_threads(pool) + 1) * CHUNKS_PER_THREAD;
+
+	if (!os_task_pool_get_threads(pool) || num_grains == 1 ||
+	    !task_group_init(&group, pool)) {
+		func(param, start, end);
+		return;
+	}
+
+	if (max_chunks > num_grains)
+		max_chunks = num_grains;
+
+	chunk_grains = (num_grains + max_chunks - 1) / max_chunks;
+
+	job.func = func;
+	job.param = param;
+	job.start = start;
+	job.end = end;
+	job.chunk_size = chunk_grains * grain;
+	job.num_chunks = (long)((count + job.chunk_size - 1) / job.chunk_size);
+
+	for (long i = 1; i < job.num_chunks; i++)
+		os_task_group_run(&group, range_job_task, &job);
+
+	/* help out with this job until every chunk has been claimed */
+	while (range_job_run_next(&job))
+		;
+
+	task_group_free(&group);
+}
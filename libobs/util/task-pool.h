@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+/*
+ *   Pool of worker threads for short jobs that can be split up, such as
+ * converting the rows of a frame.
+ *
+ *   Each worker has its own queue.  Tasks queued from a worker go to the back
+ * of its own queue and are run newest first, tasks queued from other threads
+ * are spread over the workers, and idle workers steal the oldest tasks from
+ * the other queues.
+ *
+ *   Threads waiting on a task group (including os_task_pool_parallel_for())
+ * run queued tasks while they wait, so groups can safely be waited on from
+ * one of the pool's own threads.
+ */
+
+#include "c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_task_pool;
+struct os_task_group;
+typedef struct os_task_pool os_task_pool_t;
+typedef struct os_task_group os_task_group_t;
+
+typedef void (*os_task_func_t)(void *param);
+typedef void (*os_task_range_t)(void *param, size_t start, size_t end);
+
+/**
+ * Creates a pool with the specified number of threads.  A pool without
+ * threads is valid, it just processes everything on the calling thread.
+ */
+EXPORT os_task_pool_t *os_task_pool_create(const char *name, size_t threads);
+EXPORT void os_task_pool_destroy(os_task_pool_t *pool);
+
+EXPORT size_t os_task_pool_get_threads(const os_task_pool_t *pool);
+
+/**
+ * Records the peak queue depth and the number of stolen tasks since the
+ * previous call to the profiler.  Meant to be called once per frame.
+ */
+EXPORT void os_task_pool_record_stats(os_task_pool_t *pool);
+
+/**
+ * Creates a group of tasks that can be waited on together.  If pool is NULL
+ * or has no threads, tasks are run immediately when they are added.
+ */
+EXPORT os_task_group_t *os_task_group_create(os_task_pool_t *pool);
+
+/** Waits for any remaining tasks and destroys the group */
+EXPORT void os_task_group_destroy(os_task_group_t *group);
+
+EXPORT void os_task_group_run(os_task_group_t *group, os_task_func_t func,
+			      void *param);
+
+/**
+ * Waits until every task added to the group has finished, running queued
+ * tasks in the meantime.  The group can be reused afterwards.
+ */
+EXPORT void os_task_group_wait(os_task_group_t *group);
+
+/**
+ * Calls func for consecutive sub-ranges of [start, end) in parallel.  Each
+ * sub-range other than the last starts at a multiple of grain from start.
+ * If pool is NULL, func is called once for the whole range.
+ */
+EXPORT void os_task_pool_parallel_for(os_task_pool_t *pool, size_t start,
+				      size_t end, size_t grain,
+				      os_task_range_t func, void *param);
+
+#ifdef __cplusplus
+}
+#endif
@@ -60,6 +60,8 @@ static void image_source_load(struct image_source *context)
 		if (!context->if2.image.loaded)
 			warn("failed to load texture '%s'", file);
 	}
+
+	obs_source_invalidate_video(context->source);
 }
 
 static void image_source_unload(struct image_source *context)
@@ -67,6 +69,8 @@ static void image_source_unload(struct image_source *context)
 	obs_enter_graphics();
 	gs_image_file2_free(&context->if2);
 	obs_leave_graphics();
+
+	obs_source_invalidate_video(context->source);
 }
 
 static void image_source_update(void *data, obs_data_t *settings)
@@ -186,6 +190,8 @@ static void image_source_tick(void *data, float seconds)
 				obs_enter_graphics();
 				gs_image_file2_update_texture(&context->if2);
 				obs_leave_graphics();
+
+				obs_source_invalidate_video(context->source);
 			}
 
 			context->active = false;
@@ -202,6 +208,8 @@ static void image_source_tick(void *data, float seconds)
 			obs_enter_graphics();
 			gs_image_file2_update_texture(&context->if2);
 			obs_leave_graphics();
+
+			obs_source_invalidate_video(context->source);
 		}
 	}
 
@@ -253,7 +261,7 @@ uint64_t image_source_get_memory_usage(void *data)
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
@@ -62,6 +62,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define blog(level, msg, ...) blog(level, "v4l2-input: " msg, ##__VA_ARGS__)
 
+/**
+ * Data structure for mapped buffers that are shared with libobs
+ *
+ * Frames are passed to libobs without copying, so a buffer is only queued
+ * again once libobs releases the frame, and the buffers are only unmapped
+ * when the last frame has been released, which can be after the capture has
+ * been stopped.
+ */
+struct v4l2_buffer_set {
+	volatile long refs;
+	volatile long outstanding;
+	pthread_mutex_t mutex;
+	int_fast32_t dev;
+	struct v4l2_buffer_data data;
+	struct v4l2_frame_ref *frames;
+};
+
+struct v4l2_frame_ref {
+	struct v4l2_buffer_set *set;
+	struct v4l2_buffer buf;
+};
+
 /**
  * Data structure for the v4l2 source
  */
@@ -85,7 +107,7 @@ struct v4l2_data {
 	int width;
 	int height;
 	int linesize;
-	struct v4l2_buffer_data buffers;
+	struct v4l2_buffer_set *buffers;
 };
 
 /* forward declarations */
@@ -143,6 +165,84 @@ static void v4l2_prep_obs_frame(struct v4l2_data *data,
 	}
 }
 
+static struct v4l2_buffer_set *v4l2_buffer_set_create(int_fast32_t dev)
+{
+	struct v4l2_buffer_set *set = bzalloc(sizeof(struct v4l2_buffer_set));
+	set->refs = 1;
+	set->dev = dev;
+	pthread_mutex_init_value(&set->mutex);
+
+	if (pthread_mutex_init(&set->mutex, NULL) != 0) {
+		bfree(set);
+		return NULL;
+	}
+
+	if (v4l2_create_mmap(dev, &set->data) < 0) {
+		v4l2_destroy_mmap(&set->data);
+		pthread_mutex_destroy(&set->mutex);
+		bfree(set);
+		return NULL;
+	}
+
+	set->frames = bzalloc(set->data.count * sizeof(struct v4l2_frame_ref));
+	for (uint_fast32_t i = 0; i < set->data.count; ++i)
+		set->frames[i].set = set;
+
+	return set;
+}
+
+static void v4l2_buffer_set_release(struct v4l2_buffer_set *set)
+{
+	if (os_atomic_dec_long(&set->refs) != 0)
+		return;
+
+	v4l2_destroy_mmap(&set->data);
+	pthread_mutex_destroy(&set->mutex);
+	bfree(set->frames);
+	bfree(set);
+}
+
+/* stops frames released after this from being queued on the device again */
+static void v4l2_buffer_set_stop(struct v4l2_buffer_set *set)
+{
+	pthread_mutex_lock(&set->mutex);
+	set->dev = -1;
+	pthread_mutex_unlock(&set->mutex);
+}
+
+static int v4l2_buffer_set_queue(struct v4l2_buffer_set *set,
+				 struct v4l2_buffer *buf)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&set->mutex);
+	if (set->dev != -1)
+		ret = v4l2_ioctl(set->dev, VIDIOC_QBUF, buf);
+	pthread_mutex_unlock(&set->mutex);
+
+	return ret;
+}
+
+/* always keep at least two buffers with the driver, frames are copied
+ * instead of handed over if libobs is holding on to the rest */
+static inline bool v4l2_buffer_set_can_lend(struct v4l2_buffer_set *set)
+{
+	long outstanding = os_atomic_load_long(&set->outstanding);
+	return outstanding + 2 < (long)set->data.count;
+}
+
+static void v4l2_release_frame(void *param)
+{
+	struct v4l2_frame_ref *ref = param;
+	struct v4l2_buffer_set *set = ref->set;
+
+	if (v4l2_buffer_set_queue(set, &ref->buf) < 0)
+		blog(LOG_DEBUG, "failed to enqueue released buffer");
+
+	os_atomic_dec_long(&set->outstanding);
+	v4l2_buffer_set_release(set);
+}
+
 /*
  * Worker thread to get video data
  */
@@ -158,8 +258,9 @@ static void *v4l2_thread(void *vptr)
 	struct v4l2_buffer buf;
 	struct obs_source_frame out;
 	size_t plane_offsets[MAX_AV_PLANES];
+	struct v4l2_buffer_set *set = data->buffers;
 
-	if (v4l2_start_capture(data->dev, &data->buffers) < 0)
+	if (v4l2_start_capture(data->dev, &set->data) < 0)
 		goto exit;
 
 	frames = 0;
@@ -198,14 +299,26 @@ static void *v4l2_thread(void *vptr)
 			first_ts = out.timestamp;
 		out.timestamp -= first_ts;
 
-		start = (uint8_t *)data->buffers.info[buf.index].start;
+		start = (uint8_t *)set->data.info[buf.index].start;
 		for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i)
 			out.data[i] = start + plane_offsets[i];
-		obs_source_output_video(data->source, &out);
 
-		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &buf) < 0) {
-			blog(LOG_DEBUG, "failed to enqueue buffer");
-			break;
+		if (v4l2_buffer_set_can_lend(set)) {
+			struct v4l2_frame_ref *ref = &set->frames[buf.index];
+			ref->buf = buf;
+
+			os_atomic_inc_long(&set->outstanding);
+			os_atomic_inc_long(&set->refs);
+			obs_source_output_video_owned(data->source, &out,
+						      v4l2_release_frame, ref);
+
+		} else {
+			obs_source_output_video(data->source, &out);
+
+			if (v4l2_buffer_set_queue(set, &buf) < 0) {
+				blog(LOG_DEBUG, "failed to enqueue buffer");
+				break;
+			}
 		}
 
 		frames++;
@@ -807,7 +920,11 @@ static void v4l2_terminate(struct v4l2_data *data)
 		data->thread = 0;
 	}
 
-	v4l2_destroy_mmap(&data->buffers);
+	if (data->buffers) {
+		v4l2_buffer_set_stop(data->buffers);
+		v4l2_buffer_set_release(data->buffers);
+		data->buffers = NULL;
+	}
 
 	if (data->dev != -1) {
 		v4l2_close(data->dev);
@@ -915,7 +1032,8 @@ static void v4l2_init(struct v4l2_data *data)
 	blog(LOG_INFO, "Framerate: %.2f fps", (float)fps_denom / fps_num);
 
 	/* map buffers */
-	if (v4l2_create_mmap(data->dev, &data->buffers) < 0) {
+	data->buffers = v4l2_buffer_set_create(data->dev);
+	if (!data->buffers) {
 		blog(LOG_ERROR, "Failed to map buffers");
 		goto fail;
 	}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+/*
+ * Shared memory ring used to hand packets to the muxer process without
+ * going through the stdin pipe.  The pipe is still used for the codec
+ * headers, and closing it tells the muxer that obs has gone away.
+ *
+ * The producer copies packet info and data into the ring once.  The muxer
+ * passes packets that don't wrap around to ffmpeg from the ring, which skips
+ * the copy into its own buffer, although ffmpeg still copies them since they
+ * aren't reference counted.  Futexes on sequence counters inside the mapping
+ * act as the doorbell in both directions, and are only woken when the other
+ * side is waiting.
+ *
+ * Only implemented on Linux, other platforms always use the pipe.
+ */
+
+#if defined(__linux__)
+#define FFM_RING_SUPPORTED 1
+#endif
+
+#ifdef FFM_RING_SUPPORTED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/* large enough to ride out short muxer stalls, small enough to stay mostly
+ * in cache, which matters more for throughput than avoiding waits */
+#define FFM_RING_DEFAULT_SIZE (4 * 1024 * 1024)
+#define FFM_RING_DATA_OFFSET 64
+#define FFM_RING_WAIT_MS 100
+#define FFM_RING_READY_TIMEOUT_MS 10000
+
+struct ffm_ring_header {
+	uint32_t size;
+	uint32_t ready;
+	uint32_t closed;
+	uint32_t data_seq;
+	uint32_t space_seq;
+	uint32_t reader_waiting;
+	uint32_t writer_waiting;
+	uint32_t reserved;
+	uint64_t write_pos;
+	uint64_t read_pos;
+};
+
+struct ffm_ring {
+	struct ffm_ring_header *header;
+	uint8_t *data;
+	size_t map_size;
+	int fd;
+	int ready_wait_ms;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static inline int ffm_futex_wait(uint32_t *addr, uint32_t val, int ms)
+{
+	struct timespec ts = {ms / 1000, (ms % 1000) * 1000000};
+	return (int)syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static inline void ffm_futex_wake(uint32_t *addr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/* bumps a sequence counter and wakes the other side if it's waiting on it */
+static inline void ffm_ring_signal(uint32_t *seq, uint32_t *waiting)
+{
+	__atomic_add_fetch(seq, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST))
+		ffm_futex_wake(seq);
+}
+
+/* waits for a sequence counter to change from the value loaded before the
+ * caller checked its condition, returns false on timeout */
+static inline bool ffm_ring_wait(uint32_t *seq, uint32_t *waiting,
+				 uint32_t cur_seq)
+{
+	int ret;
+
+	__atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+	ret = ffm_futex_wait(seq, cur_seq, FFM_RING_WAIT_MS);
+	__atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+
+	return ret == 0 || errno != ETIMEDOUT;
+}
+
+static inline bool ffm_ring_map(struct ffm_ring *ring, int fd, size_t size)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	ring->header = map;
+	ring->data = (uint8_t *)map + FFM_RING_DATA_OFFSET;
+	ring->map_size = size;
+	ring->fd = fd;
+	return true;
+}
+
+static inline void ffm_ring_free(struct ffm_ring *ring)
+{
+	if (ring->header) {
+		munmap(ring->header, ring->map_size);
+		close(ring->fd);
+	}
+
+	memset(ring, 0, sizeof(*ring));
+}
+
+/* ------------------------------------------------------------------------- */
+/* producer (obs)                                                            */
+
+static inline bool ffm_ring_create(struct ffm_ring *ring, const char *name,
+				   uint32_t size)
+{
+	size_t map_size = FFM_RING_DATA_OFFSET + (size_t)size;
+	int fd;
+
+	memset(ring, 0, sizeof(*ring));
+
+	/* the size must be a power of two so positions can be masked */
+	if (!size || (size & (size - 1)) != 0)
+		return false;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (fd == -1)
+		return false;
+
+	if (ftruncate(fd, (off_t)map_size) != 0 ||
+	    !ffm_ring_map(ring, fd, map_size)) {
+		close(fd);
+		shm_unlink(name);
+		return false;
+	}
+
+	ring->header->size = size;
+	return true;
+}
+
+/* the muxer holds a shared lock on the mapping for as long as it runs, so
+ * being able to take it exclusively means it has exited */
+static inline bool ffm_ring_consumer_alive(struct ffm_ring *ring)
+{
+	if (!__atomic_load_n(&ring->header->ready, __ATOMIC_ACQUIRE)) {
+		ring->ready_wait_ms += FFM_RING_WAIT_MS;
+		return ring->ready_wait_ms < FFM_RING_READY_TIMEOUT_MS;
+	}
+
+	if (flock(ring->fd, LOCK_EX | LOCK_NB) == 0) {
+		flock(ring->fd, LOCK_UN);
+		return false;
+	}
+
+	return true;
+}
+
+static inline bool ffm_ring_write(struct ffm_ring *ring, const void *vdata,
+				  size_t size)
+{
+	struct ffm_ring_header *h = ring->header;
+	const uint8_t *data = vdata;
+	const uint64_t mask = h->size - 1;
+
+	while (size) {
+		uint32_t seq = __atomic_load_n(&h->space_seq, __ATOMIC_SEQ_CST);
+		uint64_t read_pos =
+			__atomic_load_n(&h->read_pos, __ATOMIC_ACQUIRE);
+		uint64_t write_pos = h->write_pos;
+		size_t space = (size_t)(h->size - (write_pos - read_pos));
+		size_t offset = (size_t)(write_pos & mask);
+		size_t part;
+
+		if (!space) {
+			if (!ffm_ring_wait(&h->space_seq, &h->writer_waiting,
+					   seq) &&
+			    !ffm_ring_consumer_alive(ring))
+				return false;
+			continue;
+		}
+
+		if (space > size)
+			space = size;
+
+		part = h->size - offset;
+		if (part > space)
+			part = space;
+
+		memcpy(ring->data + offset, data, part);
+		memcpy(ring->data, data + part, space - part);
+
+		__atomic_store_n(&h->write_pos, write_pos + space,
+				 __ATOMIC_RELEASE);
+		ffm_ring_signal(&h->data_seq, &h->reader_waiting);
+
+		data += space;
+		size -= space;
+	}
+
+	return true;
+}
+
+/* tells the muxer no more data will be written, it exits once it has drained
+ * the ring */
+static inline void ffm_ring_close(struct ffm_ring *ring)
+{
+	struct ffm_ring_header *h = ring->header;
+
+	__atomic_store_n(&h->closed, 1, __ATOMIC_RELEASE);
+	ffm_ring_signal(&h->data_seq, &h->reader_waiting);
+}
+
+/* ------------------------------------------------------------------------- */
+/* consumer (obs-ffmpeg-mux)                                                 */
+
+static inline bool ffm_ring_open(struct ffm_ring *ring, const char *name)
+{
+	struct stat st;
+	int fd;
+
+	memset(ring, 0, sizeof(*ring));
+
+	fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+	if (fd == -1)
+		return false;
+
+	/* the mapping stays valid after unlinking, and this way it doesn't
+	 * outlive both processes if obs crashes */
+	shm_unlink(name);
+
+	if (fstat(fd, &st) != 0 ||
+	    (size_t)st.st_size <= FFM_RING_DATA_OFFSET ||
+	    flock(fd, LOCK_SH) != 0 ||
+	    !ffm_ring_map(ring, fd, (size_t)st.st_size)) {
+		close(fd);
+		return false;
+	}
+
+	if (FFM_RING_DATA_OFFSET + (size_t)ring->header->size >
+	    ring->map_size) {
+		ffm_ring_free(ring);
+		return false;
+	}
+
+	__atomic_store_n(&ring->header->ready, 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/* the pipe is never written to once the ring is in use, so stdin becoming
+ * readable means it was closed */
+static inline bool ffm_ring_producer_gone(void)
+{
+	struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+	return poll(&pfd, 1, 0) > 0;
+}
+
+/* waits until at least the specified number of bytes can be read (or the ring
+ * is full) and returns how much can be read, which is less only if the
+ * producer closed the ring or went away */
+static inline size_t ffm_ring_wait_data(struct ffm_ring *ring, size_t size)
+{
+	struct ffm_ring_header *h = ring->header;
+
+	if (size > h->size)
+		size = h->size;
+
+	for (;;) {
+		uint32_t seq = __atomic_load_n(&h->data_seq, __ATOMIC_SEQ_CST);
+		bool closed = __atomic_load_n(&h->closed, __ATOMIC_ACQUIRE);
+		uint64_t write_pos =
+			__atomic_load_n(&h->write_pos, __ATOMIC_ACQUIRE);
+		size_t avail = (size_t)(write_pos - h->read_pos);
+
+		if (avail >= size || closed)
+			return avail;
+
+		if (!ffm_ring_wait(&h->data_seq, &h->reader_waiting, seq) &&
+		    ffm_ring_producer_gone())
+			__atomic_store_n(&h->closed, 1, __ATOMIC_RELEASE);
+	}
+}
+
+static inline void ffm_ring_advance(struct ffm_ring *ring, size_t size)
+{
+	struct ffm_ring_header *h = ring->header;
+
+	__atomic_store_n(&h->read_pos, h->read_pos + size, __ATOMIC_RELEASE);
+	ffm_ring_signal(&h->space_seq, &h->writer_waiting);
+}
+
+/* returns a pointer to the next bytes in the ring if they can be used in
+ * place, the caller advances the ring once it's done with them */
+static inline const uint8_t *ffm_ring_peek(struct ffm_ring *ring, size_t size)
+{
+	struct ffm_ring_header *h = ring->header;
+	size_t offset = (size_t)(h->read_pos & (h->size - 1));
+
+	if (size > h->size - offset)
+		return NULL;
+	if (ffm_ring_wait_data(ring, size) < size)
+		return NULL;
+
+	return ring->data + offset;
+}
+
+static inline bool ffm_ring_read(struct ffm_ring *ring, void *vdata,
+				 size_t size)
+{
+	struct ffm_ring_header *h = ring->header;
+	uint8_t *data = vdata;
+
+	while (size) {
+		size_t avail = ffm_ring_wait_data(ring, size);
+		size_t offset = (size_t)(h->read_pos & (h->size - 1));
+		size_t part;
+
+		if (!avail)
+			return false;
+		if (avail > size)
+			avail = size;
+
+		part = h->size - offset;
+		if (part > avail)
+			part = avail;
+
+		memcpy(data, ring->data + offset, part);
+		memcpy(data + part, ring->data, avail - part);
+		ffm_ring_advance(ring, avail);
+
+		data += avail;
+		size -= avail;
+	}
+
+	return true;
+}
+
+#endif
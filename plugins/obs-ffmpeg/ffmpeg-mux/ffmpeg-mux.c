@@ -25,9 +25,12 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ffmpeg-mux.h"
+#include "ffmpeg-mux-ring.h"
 
 #include <libavformat/avformat.h>
+#include <util/file-writer.h>
 
 #if LIBAVCODEC_VERSION_MAJOR >= 58
 #define CODEC_FLAG_GLOBAL_H AV_CODEC_FLAG_GLOBAL_HEADER
@@ -35,6 +38,12 @@
 #define CODEC_FLAG_GLOBAL_H CODEC_FLAG_GLOBAL_HEADER
 #endif
 
+/* large writes on a separate thread, flushed to disk every 64MB so the
+ * system doesn't accumulate a huge amount of dirty pages */
+#define FILE_BUFFER_SIZE (4 * 1024 * 1024)
+#define FILE_SYNC_INTERVAL (64ULL * 1024 * 1024)
+#define AVIO_BUFFER_SIZE 65536
+
 /* ------------------------------------------------------------------------- */
 
 struct resize_buf {
@@ -81,6 +90,7 @@ struct main_params {
 	int fps_den;
 	char *acodec;
 	char *muxer_settings;
+	char *ring_name;
 };
 
 struct audio_params {
@@ -105,7 +115,11 @@ struct ffmpeg_mux {
 	struct header *audio_header;
 	int num_audio_streams;
 	bool initialized;
+	os_file_writer_t *writer;
 	char error[4096];
+#ifdef FFM_RING_SUPPORTED
+	struct ffm_ring ring;
+#endif
 };
 
 static void header_free(struct header *header)
@@ -113,10 +127,33 @@ static void header_free(struct header *header)
 	free(header->data);
 }
 
+static void close_file_writer(struct ffmpeg_mux *ffm)
+{
+	AVIOContext *pb = ffm->output->pb;
+
+	if (pb) {
+		avio_flush(pb);
+		av_freep(&pb->buffer);
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 80, 100)
+		avio_context_free(&pb);
+#else
+		av_freep(&pb);
+#endif
+		ffm->output->pb = NULL;
+	}
+
+	os_file_writer_log_stats(ffm->writer, "ffmpeg-mux");
+	if (!os_file_writer_close(ffm->writer))
+		fprintf(stderr, "Failed to write '%s'\n", ffm->params.file);
+	ffm->writer = NULL;
+}
+
 static void free_avformat(struct ffmpeg_mux *ffm)
 {
 	if (ffm->output) {
-		if ((ffm->output->oformat->flags & AVFMT_NOFILE) == 0)
+		if (ffm->writer)
+			close_file_writer(ffm);
+		else if ((ffm->output->oformat->flags & AVFMT_NOFILE) == 0)
 			avio_close(ffm->output->pb);
 
 		avformat_free_context(ffm->output);
@@ -154,6 +191,10 @@ static void ffmpeg_mux_free(struct ffmpeg_mux *ffm)
 		free(ffm->audio);
 	}
 
+#ifdef FFM_RING_SUPPORTED
+	ffm_ring_free(&ffm->ring);
+#endif
+
 	memset(ffm, 0, sizeof(*ffm));
 }
 
@@ -259,6 +300,10 @@ static bool init_params(int *argc, char ***argv, struct main_params *params,
 
 	get_opt_str(argc, argv, &params->muxer_settings, "muxer settings");
 
+	/* optional, packets are read from stdin without it */
+	if (*argc)
+		get_opt_str(argc, argv, &params->ring_name, "ring name");
+
 	return true;
 }
 
@@ -462,17 +507,112 @@ static inline bool ffmpeg_mux_get_extra_data(struct ffmpeg_mux *ffm)
 #pragma warning(disable : 4996)
 #endif
 
+static int file_writer_write(void *opaque, uint8_t *buf, int buf_size)
+{
+	struct ffmpeg_mux *ffm = opaque;
+
+	if (!os_file_writer_write(ffm->writer, buf, buf_size))
+		return AVERROR(EIO);
+	return buf_size;
+}
+
+static int file_writer_read(void *opaque, uint8_t *buf, int buf_size)
+{
+	struct ffmpeg_mux *ffm = opaque;
+	size_t size = os_file_writer_read(ffm->writer, buf, buf_size);
+
+	return size ? (int)size : AVERROR_EOF;
+}
+
+static int64_t file_writer_seek(void *opaque, int64_t offset, int whence)
+{
+	struct ffmpeg_mux *ffm = opaque;
+	os_file_writer_t *writer = ffm->writer;
+
+	switch (whence & ~AVSEEK_FORCE) {
+	case AVSEEK_SIZE:
+		return os_file_writer_get_size(writer);
+	case SEEK_CUR:
+		offset += os_file_writer_tell(writer);
+		break;
+	case SEEK_END:
+		offset += os_file_writer_get_size(writer);
+		break;
+	case SEEK_SET:
+		break;
+	default:
+		return AVERROR(EINVAL);
+	}
+
+	if (!os_file_writer_seek(writer, offset))
+		return AVERROR(EINVAL);
+	return offset;
+}
+
+/* the mov/mp4 "faststart" and "global_sidx" flags make the muxer move data
+ * when finishing the file, by opening it again by path, which would miss
+ * any data the file writer hasn't written yet */
+static bool muxer_reopens_file(AVDictionary *dict)
+{
+	AVDictionaryEntry *entry = av_dict_get(dict, "movflags", NULL, 0);
+
+	return entry && (strstr(entry->value, "faststart") ||
+			 strstr(entry->value, "global_sidx"));
+}
+
+/* local files are written through the threaded file writer so a slow disk
+ * doesn't stall reading packets from obs */
+static int open_file_writer(struct ffmpeg_mux *ffm, AVDictionary *dict)
+{
+	const char *protocol = avio_find_protocol_name(ffm->params.file);
+	uint8_t *buf;
+
+	if (!protocol || strcmp(protocol, "file") != 0 ||
+	    muxer_reopens_file(dict))
+		return avio_open(&ffm->output->pb, ffm->params.file,
+				 AVIO_FLAG_WRITE);
+
+	ffm->writer = os_file_writer_open(ffm->params.file, FILE_BUFFER_SIZE,
+					  FILE_SYNC_INTERVAL);
+	if (!ffm->writer)
+		return AVERROR(EIO);
+
+	buf = av_malloc(AVIO_BUFFER_SIZE);
+	ffm->output->pb = avio_alloc_context(buf, AVIO_BUFFER_SIZE, 1, ffm,
+					     file_writer_read,
+					     file_writer_write,
+					     file_writer_seek);
+	if (!ffm->output->pb) {
+		av_free(buf);
+		os_file_writer_close(ffm->writer);
+		ffm->writer = NULL;
+		return AVERROR(ENOMEM);
+	}
+
+	ffm->output->flags |= AVFMT_FLAG_CUSTOM_IO;
+	return 0;
+}
+
 static inline int open_output_file(struct ffmpeg_mux *ffm)
 {
 	AVOutputFormat *format = ffm->output->oformat;
 	int ret;
 
+	AVDictionary *dict = NULL;
+	if ((ret = av_dict_parse_string(&dict, ffm->params.muxer_settings, "=",
+					" ", 0))) {
+		fprintf(stderr, "Failed to parse muxer settings: %s\n%s",
+			av_err2str(ret), ffm->params.muxer_settings);
+
+		av_dict_free(&dict);
+	}
+
 	if ((format->flags & AVFMT_NOFILE) == 0) {
-		ret = avio_open(&ffm->output->pb, ffm->params.file,
-				AVIO_FLAG_WRITE);
+		ret = open_file_writer(ffm, dict);
 		if (ret < 0) {
 			fprintf(stderr, "Couldn't open '%s', %s",
 				ffm->params.file, av_err2str(ret));
+			av_dict_free(&dict);
 			return FFM_ERROR;
 		}
 	}
@@ -481,15 +621,6 @@ static inline int open_output_file(struct ffmpeg_mux *ffm)
 		sizeof(ffm->output->filename));
 	ffm->output->filename[sizeof(ffm->output->filename) - 1] = 0;
 
-	AVDictionary *dict = NULL;
-	if ((ret = av_dict_parse_string(&dict, ffm->params.muxer_settings, "=",
-					" ", 0))) {
-		fprintf(stderr, "Failed to parse muxer settings: %s\n%s",
-			av_err2str(ret), ffm->params.muxer_settings);
-
-		av_dict_free(&dict);
-	}
-
 	if (av_dict_count(dict) > 0) {
 		printf("Using muxer settings:");
 
@@ -566,6 +697,16 @@ static int ffmpeg_mux_init_internal(struct ffmpeg_mux *ffm, int argc,
 			calloc(1, sizeof(struct header) * ffm->params.tracks);
 	}
 
+#ifdef FFM_RING_SUPPORTED
+	/* opened before reading the headers so obs knows we're alive */
+	if (ffm->params.ring_name &&
+	    !ffm_ring_open(&ffm->ring, ffm->params.ring_name)) {
+		fprintf(stderr, "Couldn't open shared memory ring '%s'\n",
+			ffm->params.ring_name);
+		return FFM_ERROR;
+	}
+#endif
+
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
 	av_register_all();
 #endif
@@ -645,6 +786,47 @@ static inline bool ffmpeg_mux_packet(struct ffmpeg_mux *ffm, uint8_t *buf,
 	return av_interleaved_write_frame(ffm->output, &packet) >= 0;
 }
 
+static void ffmpeg_mux_read_pipe(struct ffmpeg_mux *ffm, struct resize_buf *rb)
+{
+	struct ffm_packet_info info = {0};
+
+	while (safe_read(&info, sizeof(info)) == sizeof(info)) {
+		resize_buf_resize(rb, info.size);
+
+		if (safe_read(rb->buf, info.size) != info.size)
+			break;
+
+		ffmpeg_mux_packet(ffm, rb->buf, &info);
+	}
+}
+
+#ifdef FFM_RING_SUPPORTED
+static void ffmpeg_mux_read_ring(struct ffmpeg_mux *ffm, struct resize_buf *rb)
+{
+	struct ffm_packet_info info = {0};
+
+	while (ffm_ring_read(&ffm->ring, &info, sizeof(info))) {
+		const uint8_t *data = ffm_ring_peek(&ffm->ring, info.size);
+
+		/* unless the packet wraps around, pass it to ffmpeg from the
+		 * ring instead of copying it into the resize buffer first.
+		 * ffmpeg copies it again since it isn't reference counted */
+		if (data) {
+			ffmpeg_mux_packet(ffm, (uint8_t *)data, &info);
+			ffm_ring_advance(&ffm->ring, info.size);
+			continue;
+		}
+
+		resize_buf_resize(rb, info.size);
+
+		if (!ffm_ring_read(&ffm->ring, rb->buf, info.size))
+			break;
+
+		ffmpeg_mux_packet(ffm, rb->buf, &info);
+	}
+}
+#endif
+
 /* ------------------------------------------------------------------------- */
 
 #ifdef _WIN32
@@ -653,10 +835,8 @@ int wmain(int argc, wchar_t *argv_w[])
 int main(int argc, char *argv[])
 #endif
 {
-	struct ffm_packet_info info = {0};
 	struct ffmpeg_mux ffm = {0};
 	struct resize_buf rb = {0};
-	bool fail = false;
 	int ret;
 
 #ifdef _WIN32
@@ -687,15 +867,14 @@ int main(int argc, char *argv[])
 		return ret;
 	}
 
-	while (!fail && safe_read(&info, sizeof(info)) == sizeof(info)) {
-		resize_buf_resize(&rb, info.size);
-
-		if (safe_read(rb.buf, info.size) == info.size) {
-			ffmpeg_mux_packet(&ffm, rb.buf, &info);
-		} else {
-			fail = true;
-		}
-	}
+#ifdef FFM_RING_SUPPORTED
+	if (ffm.ring.header)
+		ffmpeg_mux_read_ring(&ffm, &rb);
+	else
+		ffmpeg_mux_read_pipe(&ffm, &rb);
+#else
+	ffmpeg_mux_read_pipe(&ffm, &rb);
+#endif
 
 	ffmpeg_mux_free(&ffm);
 	resize_buf_free(&rb);
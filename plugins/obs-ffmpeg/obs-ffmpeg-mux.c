@@ -25,9 +25,15 @@
 #include <util/circlebuf.h>
 #include <util/threading.h>
 #include "ffmpeg-mux/ffmpeg-mux.h"
+#include "ffmpeg-mux/ffmpeg-mux-ring.h"
 
 #ifdef _WIN32
 #include "util/windows/win-version.h"
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 #include <libavformat/avformat.h>
@@ -39,6 +45,28 @@
 #define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
 #define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
 
+/* replay buffer packets that are older than the RAM window are spilled to a
+ * preallocated ring file, their data pointer is NULL after that */
+struct replay_packet {
+	struct encoder_packet packet;
+	uint64_t offset;
+};
+
+struct disk_buffer {
+	FILE *file;
+	struct dstr path;
+	pthread_mutex_t mutex;
+	uint64_t capacity;
+
+	/* positions only ever increase, file offsets wrap at capacity */
+	uint64_t head;
+	uint64_t tail;
+
+	/* space held by the replay currently being saved */
+	uint64_t pin;
+	bool pinned;
+};
+
 struct ffmpeg_muxer {
 	obs_output_t *output;
 	os_process_pipe_t *pipe;
@@ -60,10 +88,24 @@ struct ffmpeg_muxer {
 	int keyframes;
 	obs_hotkey_id hotkey;
 
-	DARRAY(struct encoder_packet) mux_packets;
+	struct disk_buffer disk;
+	bool use_disk;
+	int64_t ram_time;
+	size_t num_spilled;
+	bool disk_error;
+	bool disk_full_warned;
+
+	DARRAY(struct replay_packet) mux_packets;
 	pthread_t mux_thread;
 	bool mux_thread_joinable;
 	volatile bool muxing;
+
+#ifdef FFM_RING_SUPPORTED
+	/* packets go through shared memory once the headers are sent */
+	struct ffm_ring ring;
+	struct dstr ring_name;
+	bool use_ring;
+#endif
 };
 
 static const char *ffmpeg_mux_getname(void *type)
@@ -72,15 +114,25 @@ static const char *ffmpeg_mux_getname(void *type)
 	return obs_module_text("FFmpegMuxer");
 }
 
+static void disk_buffer_close(struct disk_buffer *disk);
+static inline void purge(struct ffmpeg_muxer *stream);
+
 static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 {
 	while (stream->packets.size > 0) {
-		struct encoder_packet pkt;
+		struct replay_packet pkt;
 		circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
-		obs_encoder_packet_release(&pkt);
+		obs_encoder_packet_release(&pkt.packet);
+	}
+
+	if (stream->use_disk) {
+		pthread_mutex_lock(&stream->disk.mutex);
+		stream->disk.tail = stream->disk.head;
+		pthread_mutex_unlock(&stream->disk.mutex);
 	}
 
 	circlebuf_free(&stream->packets);
+	stream->num_spilled = 0;
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
@@ -89,6 +141,28 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	stream->keyframes = 0;
 }
 
+static int close_pipe(struct ffmpeg_muxer *stream)
+{
+	int ret;
+
+#ifdef FFM_RING_SUPPORTED
+	if (stream->ring.header)
+		ffm_ring_close(&stream->ring);
+#endif
+
+	ret = os_process_pipe_destroy(stream->pipe);
+	stream->pipe = NULL;
+
+#ifdef FFM_RING_SUPPORTED
+	if (stream->ring.header) {
+		ffm_ring_free(&stream->ring);
+		shm_unlink(stream->ring_name.array);
+	}
+	stream->use_ring = false;
+#endif
+	return ret;
+}
+
 static void ffmpeg_mux_destroy(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -98,8 +172,11 @@ static void ffmpeg_mux_destroy(void *data)
 		pthread_join(stream->mux_thread, NULL);
 	da_free(stream->mux_packets);
 
-	os_process_pipe_destroy(stream->pipe);
+	close_pipe(stream);
 	dstr_free(&stream->path);
+#ifdef FFM_RING_SUPPORTED
+	dstr_free(&stream->ring_name);
+#endif
 	bfree(stream);
 }
 
@@ -254,14 +331,45 @@ static void build_command_line(struct ffmpeg_muxer *stream, struct dstr *cmd,
 	}
 
 	add_muxer_params(cmd, stream);
+
+#ifdef FFM_RING_SUPPORTED
+	if (stream->ring.header)
+		dstr_catf(cmd, "\"%s\" ", stream->ring_name.array);
+#endif
+}
+
+#ifdef FFM_RING_SUPPORTED
+static volatile long ring_counter = 0;
+
+static void create_ring(struct ffmpeg_muxer *stream)
+{
+	long id = os_atomic_inc_long(&ring_counter);
+
+	dstr_printf(&stream->ring_name, "/obs-ffmpeg-mux-%d-%ld",
+		    (int)getpid(), id);
+
+	if (!ffm_ring_create(&stream->ring, stream->ring_name.array,
+			     FFM_RING_DEFAULT_SIZE))
+		warn("Failed to create shared memory ring '%s', "
+		     "falling back to pipe",
+		     stream->ring_name.array);
 }
+#endif
 
 static inline void start_pipe(struct ffmpeg_muxer *stream, const char *path)
 {
 	struct dstr cmd;
+
+#ifdef FFM_RING_SUPPORTED
+	create_ring(stream);
+#endif
+
 	build_command_line(stream, &cmd, path);
 	stream->pipe = os_process_pipe_create(cmd.array, "w");
 	dstr_free(&cmd);
+
+	if (!stream->pipe)
+		close_pipe(stream);
 }
 
 static bool ffmpeg_mux_start(void *data)
@@ -330,8 +438,7 @@ static int deactivate(struct ffmpeg_muxer *stream, int code)
 	int ret = -1;
 
 	if (active(stream)) {
-		ret = os_process_pipe_destroy(stream->pipe);
-		stream->pipe = NULL;
+		ret = close_pipe(stream);
 
 		os_atomic_set_bool(&stream->active, false);
 		os_atomic_set_bool(&stream->sent_headers, false);
@@ -391,11 +498,20 @@ static void signal_failure(struct ffmpeg_muxer *stream)
 	os_atomic_set_bool(&stream->capturing, false);
 }
 
+static inline bool write_data(struct ffmpeg_muxer *stream, const void *data,
+			      size_t size)
+{
+#ifdef FFM_RING_SUPPORTED
+	if (stream->use_ring)
+		return ffm_ring_write(&stream->ring, data, size);
+#endif
+	return os_process_pipe_write(stream->pipe, data, size) == size;
+}
+
 static bool write_packet(struct ffmpeg_muxer *stream,
 			 struct encoder_packet *packet)
 {
 	bool is_video = packet->type == OBS_ENCODER_VIDEO;
-	size_t ret;
 
 	struct ffm_packet_info info = {.pts = packet->pts,
 				       .dts = packet->dts,
@@ -405,17 +521,14 @@ static bool write_packet(struct ffmpeg_muxer *stream,
 							: FFM_PACKET_AUDIO,
 				       .keyframe = packet->keyframe};
 
-	ret = os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
-				    sizeof(info));
-	if (ret != sizeof(info)) {
-		warn("os_process_pipe_write for info structure failed");
+	if (!write_data(stream, &info, sizeof(info))) {
+		warn("Failed to write info structure to muxer");
 		signal_failure(stream);
 		return false;
 	}
 
-	ret = os_process_pipe_write(stream->pipe, packet->data, packet->size);
-	if (ret != packet->size) {
-		warn("os_process_pipe_write for packet data failed");
+	if (!write_data(stream, packet->data, packet->size)) {
+		warn("Failed to write packet data to muxer");
 		signal_failure(stream);
 		return false;
 	}
@@ -463,6 +576,9 @@ static bool send_headers(struct ffmpeg_muxer *stream)
 		}
 	} while (aencoder);
 
+#ifdef FFM_RING_SUPPORTED
+	stream->use_ring = stream->ring.header != NULL;
+#endif
 	return true;
 }
 
@@ -578,6 +694,11 @@ static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 	struct ffmpeg_muxer *stream = bzalloc(sizeof(*stream));
 	stream->output = output;
 
+	if (pthread_mutex_init(&stream->disk.mutex, NULL) != 0) {
+		bfree(stream);
+		return NULL;
+	}
+
 	stream->hotkey =
 		obs_hotkey_register_output(output, "ReplayBuffer.Save",
 					   obs_module_text("ReplayBuffer.Save"),
@@ -591,11 +712,313 @@ static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 	return stream;
 }
 
+/* ------------------------------------------------------------------------ */
+/* disk buffer                                                              */
+
+#define DISK_BUFFER_MIN_SIZE (64ULL * 1024 * 1024)
+#define DISK_BUFFER_PREFIX ".obs-replay-buffer-"
+#define DISK_BUFFER_EXT ".tmp"
+
+static void disk_buffer_close(struct disk_buffer *disk)
+{
+	if (disk->file) {
+		fclose(disk->file);
+#ifdef _WIN32
+		os_unlink(disk->path.array);
+#endif
+		disk->file = NULL;
+	}
+
+	dstr_free(&disk->path);
+}
+
+/* the highest bitrate an encoder can produce in kbps, or 0 if its rate
+ * control isn't limited by a bitrate */
+static int64_t encoder_max_bitrate(obs_encoder_t *encoder)
+{
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	const char *rate_control = obs_data_get_string(settings,
+						       "rate_control");
+	int64_t bitrate = obs_data_get_int(settings, "bitrate");
+	int64_t max_bitrate = obs_data_get_int(settings, "max_bitrate");
+
+	if (*rate_control && astrcmpi(rate_control, "CBR") != 0 &&
+	    astrcmpi(rate_control, "VBR") != 0 &&
+	    astrcmpi(rate_control, "ABR") != 0)
+		bitrate = 0;
+	else if (max_bitrate > bitrate)
+		bitrate = max_bitrate;
+
+	obs_data_release(settings);
+	return bitrate;
+}
+
+/* the size limit if there is one, otherwise the time limit at the maximum
+ * bitrates with a quarter on top for rate control peaks.  returns 0 if
+ * neither is known */
+static uint64_t disk_buffer_size(struct ffmpeg_muxer *stream)
+{
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	obs_encoder_t *aencoder;
+	int64_t kbps = vencoder ? encoder_max_bitrate(vencoder) : 0;
+	uint64_t size;
+
+	if (stream->max_size)
+		return (uint64_t)stream->max_size;
+	if (!kbps)
+		return 0;
+
+	for (size_t idx = 0; idx < MAX_AUDIO_MIXES; idx++) {
+		aencoder = obs_output_get_audio_encoder(stream->output, idx);
+		if (!aencoder)
+			break;
+		kbps += encoder_max_bitrate(aencoder);
+	}
+
+	size = (uint64_t)kbps * 1000 / 8 * (uint64_t)stream->max_time /
+	       1000000 * 5 / 4;
+	return size < DISK_BUFFER_MIN_SIZE ? DISK_BUFFER_MIN_SIZE : size;
+}
+
+/* allocates the whole file up front rather than leaving it sparse, so
+ * spilling never has to wait for the file system to find space */
+static bool disk_buffer_allocate(FILE *file, uint64_t size)
+{
+#ifdef _WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+	FILE_ALLOCATION_INFO alloc_info;
+	FILE_END_OF_FILE_INFO eof_info;
+
+	alloc_info.AllocationSize.QuadPart = (LONGLONG)size;
+	eof_info.EndOfFile.QuadPart = (LONGLONG)size;
+
+	return SetFileInformationByHandle(handle, FileAllocationInfo,
+					  &alloc_info, sizeof(alloc_info)) &&
+	       SetFileInformationByHandle(handle, FileEndOfFileInfo,
+					  &eof_info, sizeof(eof_info));
+#elif defined(__APPLE__)
+	int fd = fileno(file);
+	fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0,
+			  (off_t)size, 0};
+
+	if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+		store.fst_flags = F_ALLOCATEALL;
+		if (fcntl(fd, F_PREALLOCATE, &store) == -1)
+			return false;
+	}
+
+	return ftruncate(fd, (off_t)size) == 0;
+#else
+	return posix_fallocate(fileno(file), 0, (off_t)size) == 0;
+#endif
+}
+
+/* removes disk buffers left behind by a crash.  disk buffers in use can't be
+ * deleted on windows, and elsewhere they are unlinked as soon as they have
+ * been created */
+static void disk_buffer_remove_stale(struct ffmpeg_muxer *stream,
+				     const char *dir)
+{
+	const size_t prefix_len = sizeof(DISK_BUFFER_PREFIX) - 1;
+	const size_t ext_len = sizeof(DISK_BUFFER_EXT) - 1;
+	os_dir_t *d = os_opendir(dir);
+	struct os_dirent *ent;
+	struct dstr path = {0};
+
+	if (!d)
+		return;
+
+	while ((ent = os_readdir(d)) != NULL) {
+		size_t len = strlen(ent->d_name);
+
+		if (ent->directory || len <= prefix_len + ext_len ||
+		    strncmp(ent->d_name, DISK_BUFFER_PREFIX, prefix_len) != 0 ||
+		    strcmp(ent->d_name + len - ext_len, DISK_BUFFER_EXT) != 0)
+			continue;
+
+		dstr_copy(&path, dir);
+		if (dstr_end(&path) != '/')
+			dstr_cat_ch(&path, '/');
+		dstr_cat(&path, ent->d_name);
+
+		if (os_unlink(path.array) == 0)
+			info("Removed stale replay disk buffer '%s'",
+			     path.array);
+	}
+
+	dstr_free(&path);
+	os_closedir(d);
+}
+
+static bool disk_buffer_open(struct ffmpeg_muxer *stream, const char *dir)
+{
+	struct disk_buffer *disk = &stream->disk;
+	uint64_t size = disk_buffer_size(stream);
+
+	if (!size) {
+		warn("Replay disk buffer needs a bitrate or a maximum size, "
+		     "keeping the replay buffer in memory");
+		return false;
+	}
+
+	dstr_copy(&disk->path, dir);
+	dstr_replace(&disk->path, "\\", "/");
+	if (dstr_end(&disk->path) != '/')
+		dstr_cat_ch(&disk->path, '/');
+
+	disk_buffer_remove_stale(stream, disk->path.array);
+
+	dstr_catf(&disk->path, DISK_BUFFER_PREFIX "%llu" DISK_BUFFER_EXT,
+		  (unsigned long long)os_gettime_ns());
+
+	disk->file = os_fopen(disk->path.array, "w+b");
+	if (!disk->file) {
+		warn("Failed to create replay disk buffer '%s'",
+		     disk->path.array);
+		disk_buffer_close(disk);
+		return false;
+	}
+
+#ifndef _WIN32
+	/* the file stays usable, and can't be left behind by a crash */
+	os_unlink(disk->path.array);
+#endif
+
+	if (!disk_buffer_allocate(disk->file, size)) {
+		warn("Failed to allocate %llu bytes for replay disk buffer "
+		     "'%s'",
+		     (unsigned long long)size, disk->path.array);
+		disk_buffer_close(disk);
+		return false;
+	}
+
+	disk->capacity = size;
+	disk->head = 0;
+	disk->tail = 0;
+	disk->pinned = false;
+
+	info("Using %llu MB replay disk buffer '%s'",
+	     (unsigned long long)(size / (1024 * 1024)), disk->path.array);
+	return true;
+}
+
+/* reads or writes at a ring position, must be called with the mutex held */
+static bool disk_buffer_io(struct disk_buffer *disk, uint64_t pos,
+			   uint8_t *data, size_t size, bool write)
+{
+	while (size) {
+		uint64_t offset = pos % disk->capacity;
+		size_t part = size;
+		size_t ret;
+
+		if ((uint64_t)part > disk->capacity - offset)
+			part = (size_t)(disk->capacity - offset);
+
+		if (os_fseeki64(disk->file, (int64_t)offset, SEEK_SET) != 0)
+			return false;
+
+		ret = write ? fwrite(data, 1, part, disk->file)
+			    : fread(data, 1, part, disk->file);
+		if (ret != part)
+			return false;
+
+		pos += part;
+		data += part;
+		size -= part;
+	}
+
+	return true;
+}
+
+static void warn_disk_buffer_full(struct ffmpeg_muxer *stream, bool pinned)
+{
+	if (stream->disk_full_warned)
+		return;
+
+	if (pinned)
+		warn("Replay disk buffer is full while a replay is being "
+		     "saved, keeping packets in memory");
+	else
+		warn("Replay disk buffer is full, the replay will be shorter "
+		     "than the maximum time");
+	stream->disk_full_warned = true;
+}
+
+/* moves the data of packets that have left the RAM window to the disk
+ * buffer.  if the ring is full the oldest packets are purged to make room,
+ * unless a replay that is being saved still needs the space, in which case
+ * packets stay in RAM until it has been written */
+static void replay_buffer_spill(struct ffmpeg_muxer *stream, int64_t dts_usec)
+{
+	const size_t size = sizeof(struct replay_packet);
+	struct disk_buffer *disk = &stream->disk;
+
+	pthread_mutex_lock(&disk->mutex);
+
+	while (!stream->disk_error &&
+	       stream->num_spilled < stream->packets.size / size) {
+		struct replay_packet *pkt = circlebuf_data(
+			&stream->packets, stream->num_spilled * size);
+		uint64_t start = disk->pinned ? disk->pin : disk->tail;
+		struct encoder_packet data_ref = pkt->packet;
+
+		if (dts_usec - pkt->packet.dts_usec < stream->ram_time)
+			break;
+
+		if (disk->head + pkt->packet.size - start > disk->capacity) {
+			bool pinned = disk->pinned;
+
+			warn_disk_buffer_full(stream, pinned);
+			if (pinned || !stream->num_spilled ||
+			    stream->keyframes <= 2)
+				break;
+
+			/* purge_front locks the disk mutex itself */
+			pthread_mutex_unlock(&disk->mutex);
+			purge(stream);
+			pthread_mutex_lock(&disk->mutex);
+			continue;
+		}
+
+		if (!disk_buffer_io(disk, disk->head, pkt->packet.data,
+				    pkt->packet.size, true)) {
+			warn("Failed to write to replay disk buffer, keeping "
+			     "packets in memory");
+			stream->disk_error = true;
+			break;
+		}
+
+		pkt->offset = disk->head;
+		pkt->packet.data = NULL;
+		disk->head += pkt->packet.size;
+		obs_encoder_packet_release(&data_ref);
+
+		stream->num_spilled++;
+	}
+
+	pthread_mutex_unlock(&disk->mutex);
+}
+
+static void replay_buffer_close_disk(struct ffmpeg_muxer *stream)
+{
+	if (stream->mux_thread_joinable) {
+		pthread_join(stream->mux_thread, NULL);
+		stream->mux_thread_joinable = false;
+	}
+
+	disk_buffer_close(&stream->disk);
+	stream->use_disk = false;
+}
+
+/* ------------------------------------------------------------------------ */
+
 static void replay_buffer_destroy(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
 	if (stream->hotkey)
 		obs_hotkey_unregister(stream->hotkey);
+	replay_buffer_close_disk(stream);
+	pthread_mutex_destroy(&stream->disk.mutex);
 	ffmpeg_mux_destroy(data);
 }
 
@@ -611,6 +1034,14 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+	stream->ram_time = obs_data_get_int(s, "ram_buffer_sec") * 1000000LL;
+
+	replay_buffer_close_disk(stream);
+	stream->disk_error = false;
+	stream->disk_full_warned = false;
+	if (obs_data_get_bool(s, "disk_buffer"))
+		stream->use_disk = disk_buffer_open(
+			stream, obs_data_get_string(s, "directory"));
 	obs_data_release(s);
 
 	os_atomic_set_bool(&stream->active, true);
@@ -623,12 +1054,20 @@ static bool replay_buffer_start(void *data)
 
 static bool purge_front(struct ffmpeg_muxer *stream)
 {
-	struct encoder_packet pkt;
+	struct replay_packet pkt;
 	bool keyframe;
 
 	circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
 
-	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
+	if (stream->num_spilled) {
+		stream->num_spilled--;
+
+		pthread_mutex_lock(&stream->disk.mutex);
+		stream->disk.tail = pkt.offset + pkt.packet.size;
+		pthread_mutex_unlock(&stream->disk.mutex);
+	}
+
+	keyframe = pkt.packet.type == OBS_ENCODER_VIDEO && pkt.packet.keyframe;
 
 	if (keyframe)
 		stream->keyframes--;
@@ -637,25 +1076,26 @@ static bool purge_front(struct ffmpeg_muxer *stream)
 		stream->cur_size = 0;
 		stream->cur_time = 0;
 	} else {
-		struct encoder_packet first;
+		struct replay_packet first;
 		circlebuf_peek_front(&stream->packets, &first, sizeof(first));
-		stream->cur_time = first.dts_usec;
-		stream->cur_size -= (int64_t)pkt.size;
+		stream->cur_time = first.packet.dts_usec;
+		stream->cur_size -= (int64_t)pkt.packet.size;
 	}
 
-	obs_encoder_packet_release(&pkt);
+	obs_encoder_packet_release(&pkt.packet);
 	return keyframe;
 }
 
 static inline void purge(struct ffmpeg_muxer *stream)
 {
 	if (purge_front(stream)) {
-		struct encoder_packet pkt;
+		struct replay_packet pkt;
 
 		for (;;) {
 			circlebuf_peek_front(&stream->packets, &pkt,
 					     sizeof(pkt));
-			if (pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe)
+			if (pkt.packet.type == OBS_ENCODER_VIDEO &&
+			    pkt.packet.keyframe)
 				return;
 
 			purge_front(stream);
@@ -682,30 +1122,32 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 		purge(stream);
 }
 
-static void insert_packet(struct darray *array, struct encoder_packet *packet,
+static void insert_packet(struct darray *array, struct replay_packet *packet,
 			  int64_t video_offset, int64_t *audio_offsets,
 			  int64_t video_dts_offset, int64_t *audio_dts_offsets)
 {
-	struct encoder_packet pkt;
-	DARRAY(struct encoder_packet) packets;
+	struct replay_packet pkt;
+	DARRAY(struct replay_packet) packets;
 	packets.da = *array;
 	size_t idx;
 
-	obs_encoder_packet_ref(&pkt, packet);
+	obs_encoder_packet_ref(&pkt.packet, &packet->packet);
+	pkt.offset = packet->offset;
 
-	if (pkt.type == OBS_ENCODER_VIDEO) {
-		pkt.dts_usec -= video_offset;
-		pkt.dts -= video_dts_offset;
-		pkt.pts -= video_dts_offset;
+	if (pkt.packet.type == OBS_ENCODER_VIDEO) {
+		pkt.packet.dts_usec -= video_offset;
+		pkt.packet.dts -= video_dts_offset;
+		pkt.packet.pts -= video_dts_offset;
 	} else {
-		pkt.dts_usec -= audio_offsets[pkt.track_idx];
-		pkt.dts -= audio_dts_offsets[pkt.track_idx];
-		pkt.pts -= audio_dts_offsets[pkt.track_idx];
+		size_t track_idx = pkt.packet.track_idx;
+		pkt.packet.dts_usec -= audio_offsets[track_idx];
+		pkt.packet.dts -= audio_dts_offsets[track_idx];
+		pkt.packet.pts -= audio_dts_offsets[track_idx];
 	}
 
 	for (idx = packets.num; idx > 0; idx--) {
-		struct encoder_packet *p = packets.array + (idx - 1);
-		if (p->dts_usec < pkt.dts_usec)
+		struct replay_packet *p = packets.array + (idx - 1);
+		if (p->packet.dts_usec < pkt.packet.dts_usec)
 			break;
 	}
 
@@ -713,9 +1155,42 @@ static void insert_packet(struct darray *array, struct encoder_packet *packet,
 	*array = packets.da;
 }
 
+/* packets that were spilled to the disk buffer are read back one at a time,
+ * the space they use is pinned until the replay has been written */
+static bool write_replay_packet(struct ffmpeg_muxer *stream,
+				struct replay_packet *pkt, struct darray *buf)
+{
+	DARRAY(uint8_t) data;
+	struct encoder_packet disk_pkt;
+	bool success;
+
+	if (pkt->packet.data || !pkt->packet.size)
+		return write_packet(stream, &pkt->packet);
+
+	data.da = *buf;
+	da_resize(data, pkt->packet.size);
+	*buf = data.da;
+
+	pthread_mutex_lock(&stream->disk.mutex);
+	success = disk_buffer_io(&stream->disk, pkt->offset, data.array,
+				 pkt->packet.size, false);
+	pthread_mutex_unlock(&stream->disk.mutex);
+
+	if (!success) {
+		warn("Failed to read packet from replay disk buffer");
+		return false;
+	}
+
+	disk_pkt = pkt->packet;
+	disk_pkt.data = data.array;
+	return write_packet(stream, &disk_pkt);
+}
+
 static void *replay_buffer_mux_thread(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
+	DARRAY(uint8_t) buf = {0};
+	size_t i = 0;
 
 	start_pipe(stream, stream->path.array);
 
@@ -730,17 +1205,27 @@ static void *replay_buffer_mux_thread(void *data)
 		goto error;
 	}
 
-	for (size_t i = 0; i < stream->mux_packets.num; i++) {
-		struct encoder_packet *pkt = &stream->mux_packets.array[i];
-		write_packet(stream, pkt);
-		obs_encoder_packet_release(pkt);
+	for (; i < stream->mux_packets.num; i++) {
+		struct replay_packet *pkt = &stream->mux_packets.array[i];
+		if (!write_replay_packet(stream, pkt, &buf.da))
+			goto error;
+		obs_encoder_packet_release(&pkt->packet);
 	}
 
 	info("Wrote replay buffer to '%s'", stream->path.array);
 
 error:
-	os_process_pipe_destroy(stream->pipe);
-	stream->pipe = NULL;
+	for (; i < stream->mux_packets.num; i++) {
+		struct replay_packet *pkt = &stream->mux_packets.array[i];
+		obs_encoder_packet_release(&pkt->packet);
+	}
+
+	pthread_mutex_lock(&stream->disk.mutex);
+	stream->disk.pinned = false;
+	pthread_mutex_unlock(&stream->disk.mutex);
+
+	close_pipe(stream);
+	da_free(buf);
 	da_free(stream->mux_packets);
 	os_atomic_set_bool(&stream->muxing, false);
 	return NULL;
@@ -748,7 +1233,7 @@ error:
 
 static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
-	const size_t size = sizeof(struct encoder_packet);
+	const size_t size = sizeof(struct replay_packet);
 	size_t num_packets = stream->packets.size / size;
 
 	da_reserve(stream->mux_packets, num_packets);
@@ -764,8 +1249,10 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
 
 	for (size_t i = 0; i < num_packets; i++) {
+		struct replay_packet *replay_pkt;
 		struct encoder_packet *pkt;
-		pkt = circlebuf_data(&stream->packets, i * size);
+		replay_pkt = circlebuf_data(&stream->packets, i * size);
+		pkt = &replay_pkt->packet;
 
 		if (pkt->type == OBS_ENCODER_VIDEO) {
 			if (!found_video) {
@@ -781,11 +1268,20 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 			}
 		}
 
-		insert_packet(&stream->mux_packets.da, pkt, video_offset,
-			      audio_offsets, video_dts_offset,
+		insert_packet(&stream->mux_packets.da, replay_pkt,
+			      video_offset, audio_offsets, video_dts_offset,
 			      audio_dts_offsets);
 	}
 
+	/* keep the spilled packets from being overwritten until they've been
+	 * written to the file */
+	if (stream->use_disk) {
+		pthread_mutex_lock(&stream->disk.mutex);
+		stream->disk.pin = stream->disk.tail;
+		stream->disk.pinned = true;
+		pthread_mutex_unlock(&stream->disk.mutex);
+	}
+
 	/* ---------------------------- */
 	/* generate filename */
 
@@ -826,12 +1322,15 @@ static void deactivate_replay_buffer(struct ffmpeg_muxer *stream, int code)
 	os_atomic_set_bool(&stream->sent_headers, false);
 	os_atomic_set_bool(&stream->stopping, false);
 	replay_buffer_clear(stream);
+
+	if (stream->use_disk)
+		replay_buffer_close_disk(stream);
 }
 
 static void replay_buffer_data(void *data, struct encoder_packet *packet)
 {
 	struct ffmpeg_muxer *stream = data;
-	struct encoder_packet pkt;
+	struct replay_packet pkt = {0};
 
 	if (!active(stream))
 		return;
@@ -849,14 +1348,17 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 		}
 	}
 
-	obs_encoder_packet_ref(&pkt, packet);
-	replay_buffer_purge(stream, &pkt);
+	obs_encoder_packet_ref(&pkt.packet, packet);
+	replay_buffer_purge(stream, &pkt.packet);
 
 	if (!stream->packets.size)
-		stream->cur_time = pkt.dts_usec;
-	stream->cur_size += pkt.size;
+		stream->cur_time = pkt.packet.dts_usec;
+	stream->cur_size += pkt.packet.size;
+
+	circlebuf_push_back(&stream->packets, &pkt, sizeof(pkt));
 
-	circlebuf_push_back(&stream->packets, packet, sizeof(*packet));
+	if (stream->use_disk)
+		replay_buffer_spill(stream, pkt.packet.dts_usec);
 
 	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
 		stream->keyframes++;
@@ -882,6 +1384,8 @@ static void replay_buffer_defaults(obs_data_t *s)
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
+	obs_data_set_default_bool(s, "disk_buffer", false);
+	obs_data_set_default_int(s, "ram_buffer_sec", 5);
 }
 
 struct obs_output_info replay_buffer = {
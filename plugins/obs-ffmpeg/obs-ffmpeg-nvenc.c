@@ -342,6 +342,80 @@ static inline void copy_data(AVFrame *pic, const struct encoder_frame *frame,
 	}
 }
 
+static void parse_packet(struct nvenc_encoder *enc,
+			 struct encoder_packet *packet, AVPacket *av_pkt)
+{
+	if (enc->first_packet) {
+		uint8_t *new_packet;
+		size_t size;
+
+		enc->first_packet = false;
+		obs_extract_avc_headers(av_pkt->data, av_pkt->size, &new_packet,
+					&size, &enc->header, &enc->header_size,
+					&enc->sei, &enc->sei_size);
+
+		da_copy_array(enc->buffer, new_packet, size);
+		bfree(new_packet);
+	} else {
+		da_copy_array(enc->buffer, av_pkt->data, av_pkt->size);
+	}
+
+	packet->pts = av_pkt->pts;
+	packet->dts = av_pkt->dts;
+	packet->data = enc->buffer.array;
+	packet->size = enc->buffer.num;
+	packet->type = OBS_ENCODER_VIDEO;
+	packet->keyframe = obs_avc_keyframe(packet->data, packet->size);
+}
+
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
+static bool nvenc_submit_frame(void *data, struct encoder_frame *frame)
+{
+	struct nvenc_encoder *enc = data;
+	int ret;
+
+	copy_data(enc->vframe, frame, enc->height, enc->context->pix_fmt);
+
+	enc->vframe->pts = frame->pts;
+	ret = avcodec_send_frame(enc->context, enc->vframe);
+	if (ret < 0) {
+		warn("nvenc_submit_frame: Error encoding: %s",
+		     av_err2str(ret));
+		return false;
+	}
+
+	return true;
+}
+
+static bool nvenc_receive_packet(void *data, struct encoder_packet *packet,
+				 bool *received_packet)
+{
+	struct nvenc_encoder *enc = data;
+	AVPacket av_pkt = {0};
+	int ret;
+
+	av_init_packet(&av_pkt);
+
+	ret = avcodec_receive_packet(enc->context, &av_pkt);
+	if (ret == AVERROR_EOF || ret == AVERROR(EAGAIN)) {
+		*received_packet = false;
+		return true;
+	}
+	if (ret < 0) {
+		warn("nvenc_receive_packet: Error encoding: %s",
+		     av_err2str(ret));
+		return false;
+	}
+
+	*received_packet = av_pkt.size != 0;
+	if (*received_packet)
+		parse_packet(enc, packet, &av_pkt);
+
+	av_packet_unref(&av_pkt);
+	return true;
+}
+#endif
+
 static bool nvenc_encode(void *data, struct encoder_frame *frame,
 			 struct encoder_packet *packet, bool *received_packet)
 {
@@ -374,28 +448,7 @@ static bool nvenc_encode(void *data, struct encoder_frame *frame,
 	}
 
 	if (got_packet && av_pkt.size) {
-		if (enc->first_packet) {
-			uint8_t *new_packet;
-			size_t size;
-
-			enc->first_packet = false;
-			obs_extract_avc_headers(av_pkt.data, av_pkt.size,
-						&new_packet, &size,
-						&enc->header, &enc->header_size,
-						&enc->sei, &enc->sei_size);
-
-			da_copy_array(enc->buffer, new_packet, size);
-			bfree(new_packet);
-		} else {
-			da_copy_array(enc->buffer, av_pkt.data, av_pkt.size);
-		}
-
-		packet->pts = av_pkt.pts;
-		packet->dts = av_pkt.dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
-		packet->type = OBS_ENCODER_VIDEO;
-		packet->keyframe = obs_avc_keyframe(packet->data, packet->size);
+		parse_packet(enc, packet, &av_pkt);
 		*received_packet = true;
 	} else {
 		*received_packet = false;
@@ -564,6 +617,10 @@ struct obs_encoder_info nvenc_encoder_info = {
 	.create = nvenc_create,
 	.destroy = nvenc_destroy,
 	.encode = nvenc_encode,
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
+	.submit_frame = nvenc_submit_frame,
+	.receive_packet = nvenc_receive_packet,
+#endif
 	.update = nvenc_reconfigure,
 	.get_defaults = nvenc_defaults,
 	.get_properties = nvenc_properties_ffmpeg,
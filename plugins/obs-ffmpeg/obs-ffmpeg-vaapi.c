@@ -381,19 +381,16 @@ static inline void copy_data(AVFrame *pic, const struct encoder_frame *frame,
 	}
 }
 
-static bool vaapi_encode(void *data, struct encoder_frame *frame,
-			 struct encoder_packet *packet, bool *received_packet)
+static AVFrame *upload_frame(struct vaapi_encoder *enc,
+			     struct encoder_frame *frame)
 {
-	struct vaapi_encoder *enc = data;
 	AVFrame *hwframe = NULL;
-	AVPacket av_pkt;
-	int got_packet;
 	int ret;
 
 	hwframe = av_frame_alloc();
 	if (!hwframe) {
 		warn("vaapi_encode: failed to allocate hw frame");
-		return false;
+		return NULL;
 	}
 
 	ret = av_hwframe_get_buffer(enc->vaframes_ref, hwframe, 0);
@@ -424,6 +421,106 @@ static bool vaapi_encode(void *data, struct encoder_frame *frame,
 		goto fail;
 	}
 
+	return hwframe;
+
+fail:
+	av_frame_free(&hwframe);
+	return NULL;
+}
+
+static void parse_packet(struct vaapi_encoder *enc,
+			 struct encoder_packet *packet, AVPacket *av_pkt)
+{
+	if (enc->first_packet) {
+		uint8_t *new_packet;
+		size_t size;
+
+		enc->first_packet = false;
+		obs_extract_avc_headers(av_pkt->data, av_pkt->size, &new_packet,
+					&size, &enc->header, &enc->header_size,
+					&enc->sei, &enc->sei_size);
+
+		da_copy_array(enc->buffer, new_packet, size);
+		bfree(new_packet);
+	} else {
+		da_copy_array(enc->buffer, av_pkt->data, av_pkt->size);
+	}
+
+	packet->pts = av_pkt->pts;
+	packet->dts = av_pkt->dts;
+	packet->data = enc->buffer.array;
+	packet->size = enc->buffer.num;
+	packet->type = OBS_ENCODER_VIDEO;
+	packet->keyframe = obs_avc_keyframe(packet->data, packet->size);
+}
+
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
+static bool vaapi_submit_frame(void *data, struct encoder_frame *frame)
+{
+	struct vaapi_encoder *enc = data;
+	AVFrame *hwframe;
+	int ret;
+
+	hwframe = upload_frame(enc, frame);
+	if (!hwframe)
+		return false;
+
+	ret = avcodec_send_frame(enc->context, hwframe);
+	av_frame_free(&hwframe);
+
+	if (ret < 0) {
+		warn("vaapi_submit_frame: Error encoding: %s",
+		     av_err2str(ret));
+		return false;
+	}
+
+	return true;
+}
+
+static bool vaapi_receive_packet(void *data, struct encoder_packet *packet,
+				 bool *received_packet)
+{
+	struct vaapi_encoder *enc = data;
+	AVPacket av_pkt;
+	int ret;
+
+	av_init_packet(&av_pkt);
+	av_pkt.data = NULL;
+	av_pkt.size = 0;
+
+	ret = avcodec_receive_packet(enc->context, &av_pkt);
+	if (ret == AVERROR_EOF || ret == AVERROR(EAGAIN)) {
+		*received_packet = false;
+		return true;
+	}
+	if (ret < 0) {
+		warn("vaapi_receive_packet: Error encoding: %s",
+		     av_err2str(ret));
+		return false;
+	}
+
+	*received_packet = av_pkt.size != 0;
+	if (*received_packet)
+		parse_packet(enc, packet, &av_pkt);
+
+	av_packet_unref(&av_pkt);
+	return true;
+}
+#endif
+
+static bool vaapi_encode(void *data, struct encoder_frame *frame,
+			 struct encoder_packet *packet, bool *received_packet)
+{
+	struct vaapi_encoder *enc = data;
+	AVFrame *hwframe = NULL;
+	AVPacket av_pkt;
+	int got_packet;
+	int ret;
+
+	hwframe = upload_frame(enc, frame);
+	if (!hwframe)
+		return false;
+
 	av_init_packet(&av_pkt);
 
 #if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
@@ -445,28 +542,7 @@ static bool vaapi_encode(void *data, struct encoder_frame *frame,
 	}
 
 	if (got_packet && av_pkt.size) {
-		if (enc->first_packet) {
-			uint8_t *new_packet;
-			size_t size;
-
-			enc->first_packet = false;
-			obs_extract_avc_headers(av_pkt.data, av_pkt.size,
-						&new_packet, &size,
-						&enc->header, &enc->header_size,
-						&enc->sei, &enc->sei_size);
-
-			da_copy_array(enc->buffer, new_packet, size);
-			bfree(new_packet);
-		} else {
-			da_copy_array(enc->buffer, av_pkt.data, av_pkt.size);
-		}
-
-		packet->pts = av_pkt.pts;
-		packet->dts = av_pkt.dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
-		packet->type = OBS_ENCODER_VIDEO;
-		packet->keyframe = obs_avc_keyframe(packet->data, packet->size);
+		parse_packet(enc, packet, &av_pkt);
 		*received_packet = true;
 	} else {
 		*received_packet = false;
@@ -614,6 +690,10 @@ struct obs_encoder_info vaapi_encoder_info = {
 	.create = vaapi_create,
 	.destroy = vaapi_destroy,
 	.encode = vaapi_encode,
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
+	.submit_frame = vaapi_submit_frame,
+	.receive_packet = vaapi_receive_packet,
+#endif
 	.get_defaults = vaapi_defaults,
 	.get_properties = vaapi_properties,
 	.get_extra_data = vaapi_extra_data,
@@ -214,7 +214,7 @@ static uint32_t crop_filter_height(void *data)
 struct obs_source_info crop_filter = {
 	.id = "crop_filter",
 	.type = OBS_SOURCE_TYPE_FILTER,
-	.output_flags = OBS_SOURCE_VIDEO,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = crop_filter_get_name,
 	.create = crop_filter_create,
 	.destroy = crop_filter_destroy,
@@ -42,18 +42,19 @@ static inline double encoder_bitrate(obs_encoder_t *encoder)
 
 #define FLV_INFO_SIZE_OFFSET 42
 
-void write_file_info(FILE *file, int64_t duration_ms, int64_t size)
+void write_file_info(os_file_writer_t *file, int64_t duration_ms,
+		     int64_t size)
 {
 	char buf[64];
 	char *enc = buf;
 	char *end = enc + sizeof(buf);
 
-	fseek(file, FLV_INFO_SIZE_OFFSET, SEEK_SET);
+	os_file_writer_seek(file, FLV_INFO_SIZE_OFFSET);
 
 	enc_num_val(&enc, end, "duration", (double)duration_ms / 1000.0);
 	enc_num_val(&enc, end, "fileSize", (double)size);
 
-	fwrite(buf, 1, enc - buf, file);
+	os_file_writer_write(file, buf, enc - buf);
 }
 
 static bool build_flv_meta_data(obs_output_t *context, uint8_t **output,
@@ -264,3 +265,32 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
+
+size_t flv_packet_prefix(struct encoder_packet *packet, int32_t dts_offset,
+			 uint8_t *prefix, uint32_t *timestamp, bool is_header)
+{
+	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
+
+	if (!packet->data || !packet->size)
+		return 0;
+
+	/* same timestamp layout as the flv tag: 24 bits plus 7 extended */
+	*timestamp = ((uint32_t)time_ms & 0xFFFFFF) |
+		     ((uint32_t)((time_ms >> 24) & 0x7F) << 24);
+
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		int32_t offset_ms =
+			get_ms_time(packet, packet->pts - packet->dts);
+
+		prefix[0] = packet->keyframe ? 0x17 : 0x27;
+		prefix[1] = is_header ? 0 : 1;
+		prefix[2] = (uint8_t)(offset_ms >> 16);
+		prefix[3] = (uint8_t)(offset_ms >> 8);
+		prefix[4] = (uint8_t)offset_ms;
+		return VIDEO_HEADER_SIZE;
+	}
+
+	prefix[0] = 0xaf;
+	prefix[1] = is_header ? 0 : 1;
+	return 2;
+}
@@ -18,17 +18,29 @@
 #pragma once
 
 #include <obs.h>
+#include <util/file-writer.h>
 
 #define MILLISECOND_DEN 1000
+#define FLV_PACKET_PREFIX_MAX_SIZE 5
+
+/* tag header plus the previous tag size that follows each tag */
+#define FLV_TAG_OVERHEAD_SIZE 15
 
 static int32_t get_ms_time(struct encoder_packet *packet, int64_t val)
 {
 	return (int32_t)(val * MILLISECOND_DEN / packet->timebase_den);
 }
 
-extern void write_file_info(FILE *file, int64_t duration_ms, int64_t size);
+extern void write_file_info(os_file_writer_t *file, int64_t duration_ms,
+			    int64_t size);
 
 extern bool flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size,
 			  bool write_header, size_t audio_idx);
 extern void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset,
 			   uint8_t **output, size_t *size, bool is_header);
+
+/* writes the bytes that precede the packet data within the flv tag body and
+ * returns their size, or 0 if the packet is empty and must not be sent */
+extern size_t flv_packet_prefix(struct encoder_packet *packet,
+				int32_t dts_offset, uint8_t *prefix,
+				uint32_t *timestamp, bool is_header);
@@ -31,10 +31,15 @@
 #define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
 #define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
 
+/* large writes on a separate thread, flushed to disk every 64MB so the
+ * system doesn't accumulate a huge amount of dirty pages */
+#define FILE_BUFFER_SIZE (4 * 1024 * 1024)
+#define FILE_SYNC_INTERVAL (64ULL * 1024 * 1024)
+
 struct flv_output {
 	obs_output_t *output;
 	struct dstr path;
-	FILE *file;
+	os_file_writer_t *file;
 	volatile bool active;
 	volatile bool stopping;
 	uint64_t stop_ts;
@@ -95,7 +100,8 @@ static int write_packet(struct flv_output *stream,
 
 	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data,
 		       &size, is_header);
-	fwrite(data, 1, size, stream->file);
+	if (!os_file_writer_write(stream->file, data, size))
+		ret = -1;
 	bfree(data);
 
 	return ret;
@@ -107,7 +113,7 @@ static void write_meta_data(struct flv_output *stream)
 	size_t meta_data_size;
 
 	flv_meta_data(stream->output, &meta_data, &meta_data_size, true, 0);
-	fwrite(meta_data, 1, meta_data_size, stream->file);
+	os_file_writer_write(stream->file, meta_data, meta_data_size);
 	bfree(meta_data);
 }
 
@@ -167,7 +173,8 @@ static bool flv_output_start(void *data)
 	dstr_copy(&stream->path, path);
 	obs_data_release(settings);
 
-	stream->file = os_fopen(stream->path.array, "wb");
+	stream->file = os_file_writer_open(stream->path.array, FILE_BUFFER_SIZE,
+					   FILE_SYNC_INTERVAL);
 	if (!stream->file) {
 		warn("Unable to open FLV file '%s'", stream->path.array);
 		return false;
@@ -194,9 +201,13 @@ static void flv_output_actual_stop(struct flv_output *stream, int code)
 
 	if (stream->file) {
 		write_file_info(stream->file, stream->last_packet_ts,
-				os_ftelli64(stream->file));
+				os_file_writer_get_size(stream->file));
 
-		fclose(stream->file);
+		os_file_writer_log_stats(stream->file, "flv output");
+		if (!os_file_writer_close(stream->file))
+			warn("Failed to write FLV file '%s'",
+			     stream->path.array);
+		stream->file = NULL;
 	}
 	if (code) {
 		obs_output_signal_stop(stream->output, code);
@@ -211,6 +222,7 @@ static void flv_output_data(void *data, struct encoder_packet *packet)
 {
 	struct flv_output *stream = data;
 	struct encoder_packet parsed_packet;
+	int ret;
 
 	pthread_mutex_lock(&stream->mutex);
 
@@ -242,10 +254,15 @@ static void flv_output_data(void *data, struct encoder_packet *packet)
 		}
 
 		obs_parse_avc_packet(&parsed_packet, packet);
-		write_packet(stream, &parsed_packet, false);
+		ret = write_packet(stream, &parsed_packet, false);
 		obs_encoder_packet_release(&parsed_packet);
 	} else {
-		write_packet(stream, packet, false);
+		ret = write_packet(stream, packet, false);
+	}
+
+	if (ret < 0) {
+		warn("Failed to write to FLV file '%s'", stream->path.array);
+		flv_output_actual_stop(stream, OBS_OUTPUT_ERROR);
 	}
 
 unlock:
@@ -32,6 +32,10 @@
 #include "rtmp_sys.h"
 #include "log.h"
 
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
 #include <util/platform.h>
 
 #if !defined(MSG_NOSIGNAL)
@@ -1597,6 +1601,115 @@ WriteN(RTMP *r, const char *buffer, int n)
     return n == 0;
 }
 
+/* sends several buffers with a single system call where possible */
+static int
+WriteV(RTMP *r, RTMPBatchBuf *bufs, int numBufs, int size)
+{
+#ifdef _WIN32
+    WSABUF vec[RTMP_BATCH_MAX_BUFS];
+#else
+    struct iovec vec[RTMP_BATCH_MAX_BUFS];
+    struct msghdr msg;
+#endif
+
+    /* data that has to be transformed or sent some other way is sent as a
+     * single buffer instead */
+    int transform = (r->Link.protocol & RTMP_FEATURE_HTTP) ||
+                    r->m_bCustomSend || r->m_sb.sb_ssl;
+
+#ifdef CRYPTO
+    if (r->Link.rc4keyOut)
+        transform = TRUE;
+#endif
+
+    if (transform)
+    {
+        char *buf = malloc(size), *ptr = buf;
+        int ret;
+
+        if (!buf)
+            return FALSE;
+
+        for (int i = 0; i < numBufs; i++)
+        {
+            memcpy(ptr, bufs[i].data, bufs[i].size);
+            ptr += bufs[i].size;
+        }
+
+        ret = WriteN(r, buf, size);
+        free(buf);
+        return ret;
+    }
+
+    while (numBufs)
+    {
+        int nBytes;
+
+#ifdef _WIN32
+        DWORD sent = 0;
+
+        for (int i = 0; i < numBufs; i++)
+        {
+            vec[i].buf = (CHAR *)bufs[i].data;
+            vec[i].len = (ULONG)bufs[i].size;
+        }
+
+        if (WSASend(r->m_sb.sb_socket, vec, (DWORD)numBufs, &sent, 0, NULL,
+                    NULL) == SOCKET_ERROR)
+            nBytes = -1;
+        else
+            nBytes = (int)sent;
+#else
+        for (int i = 0; i < numBufs; i++)
+        {
+            vec[i].iov_base = (void *)bufs[i].data;
+            vec[i].iov_len = (size_t)bufs[i].size;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec;
+        msg.msg_iovlen = numBufs;
+        nBytes = (int)sendmsg(r->m_sb.sb_socket, &msg, MSG_NOSIGNAL);
+#endif
+
+        if (nBytes < 0)
+        {
+            int sockerr = GetSockError();
+            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", __FUNCTION__,
+                     sockerr, size);
+
+            if (sockerr == EINTR && !RTMP_ctrlC)
+                continue;
+
+            r->last_error_code = sockerr;
+
+            RTMP_Close(r);
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        size -= nBytes;
+
+        /* skip past what has been sent */
+        while (numBufs && nBytes >= bufs->size)
+        {
+            nBytes -= bufs->size;
+            bufs++;
+            numBufs--;
+        }
+
+        if (numBufs)
+        {
+            bufs->data += nBytes;
+            bufs->size -= nBytes;
+        }
+    }
+
+    return TRUE;
+}
+
 #define SAVC(x)	static const AVal av_##x = AVC(#x)
 
 SAVC(app);
@@ -4034,18 +4147,19 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+/* encodes the header of the first chunk of a packet into hbuf, which must be
+ * RTMP_MAX_HEADER_SIZE bytes long, and returns its size or 0 on failure.  *c
+ * receives the first header byte and *cSize the number of extra channel id
+ * bytes, which the headers of the following chunks repeat */
+static int
+EncodeChunkHeader(RTMP *r, RTMPPacket *packet, char *hbuf, char *c, int *cSize)
 {
     const RTMPPacket *prevPacket;
     uint32_t last = 0;
     int nSize;
-    int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    int hSize;
+    char *hptr, *hend = hbuf + RTMP_MAX_HEADER_SIZE;
     uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4056,7 +4170,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
             free(r->m_vecChannelsOut);
             r->m_vecChannelsOut = NULL;
             r->m_channelsAllocatedOut = 0;
-            return FALSE;
+            return 0;
         }
         r->m_vecChannelsOut = packets;
         memset(r->m_vecChannelsOut + r->m_channelsAllocatedOut, 0, sizeof(RTMPPacket*) * (n - r->m_channelsAllocatedOut));
@@ -4082,60 +4196,42 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     {
         RTMP_Log(RTMP_LOGERROR, "sanity failed!! trying to send header of type: 0x%02x.",
                  (unsigned char)packet->m_headerType);
-        return FALSE;
+        return 0;
     }
 
     nSize = packetSize[packet->m_headerType];
     hSize = nSize;
-    cSize = 0;
+    *cSize = 0;
     t = packet->m_nTimeStamp - last;
 
-    if (packet->m_body)
-    {
-        header = packet->m_body - nSize;
-        hend = packet->m_body;
-    }
-    else
-    {
-        header = hbuf + 6;
-        hend = hbuf + sizeof(hbuf);
-    }
-
     if (packet->m_nChannel > 319)
-        cSize = 2;
+        *cSize = 2;
     else if (packet->m_nChannel > 63)
-        cSize = 1;
-    if (cSize)
-    {
-        header -= cSize;
-        hSize += cSize;
-    }
+        *cSize = 1;
+    hSize += *cSize;
 
     if (nSize > 1 && t >= 0xffffff)
-    {
-        header -= 4;
         hSize += 4;
-    }
 
-    hptr = header;
-    c = packet->m_headerType << 6;
-    switch (cSize)
+    hptr = hbuf;
+    *c = packet->m_headerType << 6;
+    switch (*cSize)
     {
     case 0:
-        c |= packet->m_nChannel;
+        *c |= packet->m_nChannel;
         break;
     case 1:
         break;
     case 2:
-        c |= 1;
+        *c |= 1;
         break;
     }
-    *hptr++ = c;
-    if (cSize)
+    *hptr++ = *c;
+    if (*cSize)
     {
         int tmp = packet->m_nChannel - 64;
         *hptr++ = tmp & 0xff;
-        if (cSize == 2)
+        if (*cSize == 2)
             *hptr++ = tmp >> 8;
     }
 
@@ -4156,6 +4252,46 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     if (nSize > 1 && t >= 0xffffff)
         hptr = AMF_EncodeInt32(hptr, hend, t);
 
+    return hSize;
+}
+
+/* remembers the packet so the headers of the next packets of its channel can
+ * be compressed */
+static int
+StoreSentPacket(RTMP *r, RTMPPacket *packet)
+{
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        return FALSE;
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    return TRUE;
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    int nSize;
+    int hSize, cSize;
+    char *header, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    hSize = EncodeChunkHeader(r, packet, hbuf, &c, &cSize);
+    if (!hSize)
+        return FALSE;
+
+    if (packet->m_body)
+    {
+        header = packet->m_body - hSize;
+        memcpy(header, hbuf, hSize);
+    }
+    else
+    {
+        header = hbuf;
+    }
+
     nSize = packet->m_nBodySize;
     buffer = packet->m_body;
     nChunkSize = r->m_outChunkSize;
@@ -4245,10 +4381,142 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
         }
     }
 
-    if (!r->m_vecChannelsOut[packet->m_nChannel])
-        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
-    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
-    return TRUE;
+    return StoreSentPacket(r, packet);
+}
+
+/* makes sure the batch has room for the specified number of buffers and
+ * arena bytes, sending what's already in it if it doesn't */
+static int
+BatchReserve(RTMP *r, RTMPBatch *batch, int bufs, int bytes)
+{
+    if (batch->num_bufs + bufs > RTMP_BATCH_MAX_BUFS ||
+            batch->arena_used + bytes > RTMP_BATCH_ARENA_SIZE)
+    {
+        if (!RTMP_BatchFlush(r, batch))
+            return FALSE;
+    }
+
+    return bytes <= RTMP_BATCH_ARENA_SIZE;
+}
+
+static void
+BatchAdd(RTMPBatch *batch, const char *data, int size)
+{
+    RTMPBatchBuf *last = NULL;
+
+    if (batch->num_bufs)
+        last = &batch->bufs[batch->num_bufs - 1];
+
+    if (last && last->data + last->size == data)
+    {
+        last->size += size;
+    }
+    else
+    {
+        batch->bufs[batch->num_bufs].data = data;
+        batch->bufs[batch->num_bufs].size = size;
+        batch->num_bufs++;
+    }
+
+    batch->size += size;
+}
+
+static void
+BatchAddCopy(RTMPBatch *batch, const char *data, int size)
+{
+    char *copy = batch->arena + batch->arena_used;
+
+    memcpy(copy, data, size);
+    batch->arena_used += size;
+    BatchAdd(batch, copy, size);
+}
+
+void
+RTMP_BatchReset(RTMPBatch *batch)
+{
+    batch->num_bufs = 0;
+    batch->arena_used = 0;
+    batch->size = 0;
+}
+
+int
+RTMP_BatchPacket(RTMP *r, RTMPBatch *batch, RTMPPacket *packet,
+                 const char *prefix, int prefixSize,
+                 const char *payload, int payloadSize)
+{
+    char hbuf[RTMP_MAX_HEADER_SIZE], c;
+    int hSize, cSize;
+    int nChunkSize = r->m_outChunkSize;
+    int nSize = prefixSize + payloadSize;
+    int offset = 0;
+
+    packet->m_body = NULL;
+    packet->m_nBodySize = nSize;
+
+    hSize = EncodeChunkHeader(r, packet, hbuf, &c, &cSize);
+    if (!hSize)
+        return FALSE;
+
+    do
+    {
+        int chunkSize = nSize - offset;
+        int prefixPart = 0;
+
+        if (chunkSize > nChunkSize)
+            chunkSize = nChunkSize;
+        if (offset < prefixSize)
+        {
+            prefixPart = prefixSize - offset;
+            if (prefixPart > chunkSize)
+                prefixPart = chunkSize;
+        }
+
+        /* headers and prefix are copied into the arena, the payload is
+         * only referenced */
+        if (!BatchReserve(r, batch, 2, hSize + prefixPart))
+            return FALSE;
+
+        if (!offset)
+        {
+            BatchAddCopy(batch, hbuf, hSize);
+        }
+        else
+        {
+            hbuf[0] = (0xc0 | c);
+            if (cSize)
+            {
+                int tmp = packet->m_nChannel - 64;
+                hbuf[1] = tmp & 0xff;
+                if (cSize == 2)
+                    hbuf[2] = tmp >> 8;
+            }
+            BatchAddCopy(batch, hbuf, 1 + cSize);
+        }
+
+        if (prefixPart)
+            BatchAddCopy(batch, prefix + offset, prefixPart);
+        if (chunkSize > prefixPart)
+            BatchAdd(batch, payload + offset + prefixPart - prefixSize,
+                     chunkSize - prefixPart);
+
+        offset += chunkSize;
+        hSize = 1 + cSize;
+    }
+    while (offset < nSize);
+
+    return StoreSentPacket(r, packet);
+}
+
+int
+RTMP_BatchFlush(RTMP *r, RTMPBatch *batch)
+{
+    int ret = TRUE;
+
+    if (batch->num_bufs)
+        ret = WriteV(r, batch->bufs, batch->num_bufs, batch->size);
+
+    RTMP_BatchReset(batch);
+    return ret;
 }
 
 void
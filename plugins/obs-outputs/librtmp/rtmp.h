@@ -264,6 +264,26 @@ extern "C"
         char *m_body;
     } RTMPPacket;
 
+#define RTMP_BATCH_MAX_BUFS 512
+#define RTMP_BATCH_ARENA_SIZE 4096
+
+    typedef struct RTMPBatchBuf
+    {
+        const char *data;
+        int size;
+    } RTMPBatchBuf;
+
+    /* packets queued for sending with a single system call, chunk headers
+     * are kept in the arena and packet payloads are only referenced */
+    typedef struct RTMPBatch
+    {
+        RTMPBatchBuf bufs[RTMP_BATCH_MAX_BUFS];
+        int num_bufs;
+        int size;
+        char arena[RTMP_BATCH_ARENA_SIZE];
+        int arena_used;
+    } RTMPBatch;
+
     typedef struct RTMPSockBuf
     {
         SOCKET sb_socket;
@@ -493,6 +513,15 @@ extern "C"
 
     int RTMP_ReadPacket(RTMP *r, RTMPPacket *packet);
     int RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue);
+
+    /* packet bodies are a copied prefix followed by a payload which is only
+     * referenced, and must stay valid until the batch has been flushed */
+    int RTMP_BatchPacket(RTMP *r, RTMPBatch *batch, RTMPPacket *packet,
+                         const char *prefix, int prefixSize,
+                         const char *payload, int payloadSize);
+    int RTMP_BatchFlush(RTMP *r, RTMPBatch *batch);
+    void RTMP_BatchReset(RTMPBatch *batch);
+
     int RTMP_SendChunk(RTMP *r, RTMPChunk *chunk);
     int RTMP_IsConnected(RTMP *r);
     SOCKET RTMP_Socket(RTMP *r);
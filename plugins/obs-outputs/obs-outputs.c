@@ -17,6 +17,9 @@ MODULE_EXPORT const char *obs_module_description(void)
 extern struct obs_output_info rtmp_output_info;
 extern struct obs_output_info null_output_info;
 extern struct obs_output_info flv_output_info;
+#ifdef __linux__
+extern struct obs_output_info rtmp_fanout_output_info;
+#endif
 #if COMPILE_FTL
 extern struct obs_output_info ftl_output_info;
 #endif
@@ -31,6 +34,9 @@ bool obs_module_load(void)
 	obs_register_output(&rtmp_output_info);
 	obs_register_output(&null_output_info);
 	obs_register_output(&flv_output_info);
+#ifdef __linux__
+	obs_register_output(&rtmp_fanout_output_info);
+#endif
 #if COMPILE_FTL
 	obs_register_output(&ftl_output_info);
 #endif
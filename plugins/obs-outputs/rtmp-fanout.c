@@ -0,0 +1,1127 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * Streams the same packets to several RTMP servers at once.  Every packet is
+ * queued once, and each destination has its own cursor into the queue, so
+ * packets are only released once every destination has sent them.  All
+ * sockets are non-blocking and driven from a single epoll thread, and each
+ * destination drops frames on its own based on how far behind it is.
+ */
+
+#ifdef __linux__
+
+#include <obs-module.h>
+#include <obs-avc.h>
+#include <util/platform.h>
+#include <util/circlebuf.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "librtmp/rtmp.h"
+#include "flv-mux.h"
+#include "net-if.h"
+
+#define do_log(level, format, ...)                 \
+	blog(level, "[rtmp fanout: '%s'] " format, \
+	     obs_output_get_name(fanout->output), ##__VA_ARGS__)
+
+#define warn(format, ...) do_log(LOG_WARNING, format, ##__VA_ARGS__)
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
+#define OPT_DESTINATIONS "destinations"
+#define OPT_DROP_THRESHOLD "drop_threshold_ms"
+#define OPT_PFRAME_DROP_THRESHOLD "pframe_drop_threshold_ms"
+#define OPT_MAX_SHUTDOWN_TIME_SEC "max_shutdown_time_sec"
+#define OPT_BIND_IP "bind_ip"
+
+#define MAX_EPOLL_EVENTS 16
+#define EPOLL_TIMEOUT_MS 100
+
+/* stop muxing packets for a destination once this much is waiting to be
+ * written to its socket */
+#define WRITE_BUF_LOW_WATER (64 * 1024)
+
+/* destinations that fall this far behind are disconnected so they don't keep
+ * the packets of every other destination in memory */
+#define MAX_BACKLOG_USEC (30 * 1000000LL)
+
+enum dest_state {
+	DEST_CONNECTING,
+	DEST_CONNECTED,
+	DEST_ACTIVE,
+	DEST_CLOSED,
+};
+
+struct fanout_dest {
+	struct rtmp_fanout *fanout;
+	struct dstr url, key;
+	struct dstr username, password;
+
+	RTMP rtmp;
+	pthread_t connect_thread;
+	bool connect_thread_created;
+	volatile long state;
+
+	/* sequence number of the next packet in the shared queue */
+	uint64_t next_seq;
+	bool sent_headers;
+	bool got_keyframe;
+	bool finished;
+	int min_priority;
+	float congestion;
+
+	DARRAY(uint8_t) write_buf;
+	size_t write_pos;
+	bool want_write;
+
+	uint64_t total_bytes_sent;
+	int dropped_frames;
+};
+
+struct rtmp_fanout {
+	obs_output_t *output;
+
+	struct fanout_dest *dests;
+	size_t num_dests;
+
+	pthread_mutex_t packets_mutex;
+	struct circlebuf packets;
+	uint64_t first_seq;
+	int64_t last_dts_usec;
+
+	bool got_first_video;
+	int64_t start_dts_offset;
+
+	int epoll_fd;
+	int event_fd;
+	pthread_t io_thread;
+	bool io_thread_joinable;
+
+	volatile bool active;
+	volatile bool capturing;
+	volatile bool stopping;
+	volatile bool encode_error;
+	uint64_t stop_ts;
+	uint64_t shutdown_timeout_ts;
+	int max_shutdown_time_sec;
+
+	int64_t drop_threshold_usec;
+	int64_t pframe_drop_threshold_usec;
+	struct dstr bind_ip;
+};
+
+static const char *rtmp_fanout_getname(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return obs_module_text("RTMPFanout");
+}
+
+static inline void set_rtmp_str(AVal *val, const char *str)
+{
+	bool valid = (str && *str);
+	val->av_val = valid ? (char *)str : NULL;
+	val->av_len = valid ? (int)strlen(str) : 0;
+}
+
+static inline void set_rtmp_dstr(AVal *val, struct dstr *str)
+{
+	bool valid = !dstr_is_empty(str);
+	val->av_val = valid ? str->array : NULL;
+	val->av_len = valid ? (int)str->len : 0;
+}
+
+static inline void wake_io_thread(struct rtmp_fanout *fanout)
+{
+	uint64_t val = 1;
+	if (write(fanout->event_fd, &val, sizeof(val)) < 0) {
+		/* the counter can only be full if the thread is already
+		 * being woken */
+	}
+}
+
+static inline long dest_state(struct fanout_dest *dest)
+{
+	return os_atomic_load_long(&dest->state);
+}
+
+static void free_packets(struct rtmp_fanout *fanout)
+{
+	pthread_mutex_lock(&fanout->packets_mutex);
+	while (fanout->packets.size) {
+		struct encoder_packet packet;
+		circlebuf_pop_front(&fanout->packets, &packet, sizeof(packet));
+		obs_encoder_packet_release(&packet);
+	}
+	fanout->first_seq = 0;
+	pthread_mutex_unlock(&fanout->packets_mutex);
+}
+
+static void free_dests(struct rtmp_fanout *fanout)
+{
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		struct fanout_dest *dest = fanout->dests + i;
+
+		RTMP_TLS_Free(&dest->rtmp);
+		dstr_free(&dest->url);
+		dstr_free(&dest->key);
+		dstr_free(&dest->username);
+		dstr_free(&dest->password);
+		da_free(dest->write_buf);
+	}
+
+	bfree(fanout->dests);
+	fanout->dests = NULL;
+	fanout->num_dests = 0;
+}
+
+static void stop_io_thread(struct rtmp_fanout *fanout)
+{
+	if (!fanout->io_thread_joinable)
+		return;
+
+	fanout->stop_ts = 0;
+	os_atomic_set_bool(&fanout->stopping, true);
+	wake_io_thread(fanout);
+
+	pthread_join(fanout->io_thread, NULL);
+	fanout->io_thread_joinable = false;
+}
+
+static void rtmp_fanout_destroy(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+
+	stop_io_thread(fanout);
+	free_packets(fanout);
+	free_dests(fanout);
+
+	if (fanout->epoll_fd != -1)
+		close(fanout->epoll_fd);
+	if (fanout->event_fd != -1)
+		close(fanout->event_fd);
+
+	dstr_free(&fanout->bind_ip);
+	circlebuf_free(&fanout->packets);
+	pthread_mutex_destroy(&fanout->packets_mutex);
+	bfree(fanout);
+}
+
+static void *rtmp_fanout_create(obs_data_t *settings, obs_output_t *output)
+{
+	struct rtmp_fanout *fanout = bzalloc(sizeof(struct rtmp_fanout));
+	fanout->output = output;
+	fanout->epoll_fd = -1;
+	fanout->event_fd = -1;
+	pthread_mutex_init_value(&fanout->packets_mutex);
+
+	if (pthread_mutex_init(&fanout->packets_mutex, NULL) != 0)
+		goto fail;
+
+	fanout->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (fanout->epoll_fd == -1) {
+		warn("Failed to create epoll instance: %d", errno);
+		goto fail;
+	}
+
+	fanout->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fanout->event_fd == -1) {
+		warn("Failed to create event fd: %d", errno);
+		goto fail;
+	}
+
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+	if (epoll_ctl(fanout->epoll_fd, EPOLL_CTL_ADD, fanout->event_fd,
+		      &ev) != 0) {
+		warn("Failed to watch event fd: %d", errno);
+		goto fail;
+	}
+
+	UNUSED_PARAMETER(settings);
+	return fanout;
+
+fail:
+	rtmp_fanout_destroy(fanout);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------ */
+/* connecting                                                               */
+
+static bool send_meta_data(struct fanout_dest *dest)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	bool next = true;
+
+	for (size_t idx = 0; next; idx++) {
+		uint8_t *meta_data;
+		size_t meta_data_size;
+		bool success = true;
+
+		next = flv_meta_data(fanout->output, &meta_data,
+				     &meta_data_size, false, idx);
+		if (next) {
+			success = RTMP_Write(&dest->rtmp, (char *)meta_data,
+					     (int)meta_data_size,
+					     (int)idx) >= 0;
+			bfree(meta_data);
+		}
+
+		if (!success)
+			return false;
+	}
+
+	return true;
+}
+
+static bool try_connect(struct fanout_dest *dest)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	RTMP *rtmp = &dest->rtmp;
+
+	info("Connecting to RTMP URL %s...", dest->url.array);
+
+	if (!RTMP_SetupURL(rtmp, dest->url.array))
+		return false;
+
+	RTMP_EnableWrite(rtmp);
+
+	set_rtmp_dstr(&rtmp->Link.pubUser, &dest->username);
+	set_rtmp_dstr(&rtmp->Link.pubPasswd, &dest->password);
+	set_rtmp_str(&rtmp->Link.flashVer, "FMLE/3.0 (compatible; FMSc/1.0)");
+	rtmp->Link.swfUrl = rtmp->Link.tcUrl;
+
+	if (!dstr_is_empty(&fanout->bind_ip) &&
+	    dstr_cmp(&fanout->bind_ip, "default") != 0)
+		netif_str_to_addr(&rtmp->m_bindIP.addr,
+				  &rtmp->m_bindIP.addrLen,
+				  fanout->bind_ip.array);
+
+	RTMP_AddStream(rtmp, dest->key.array);
+
+	for (size_t idx = 1;; idx++) {
+		obs_encoder_t *encoder =
+			obs_output_get_audio_encoder(fanout->output, idx);
+		if (!encoder)
+			break;
+
+		RTMP_AddStream(rtmp, obs_encoder_get_name(encoder));
+	}
+
+	rtmp->m_outChunkSize = 4096;
+	rtmp->m_bSendChunkSizeInfo = true;
+	rtmp->m_bUseNagle = true;
+
+	if (!RTMP_Connect(rtmp, NULL))
+		return false;
+
+	if (!RTMP_ConnectStream(rtmp, 0)) {
+		RTMP_Close(rtmp);
+		return false;
+	}
+
+	/* metadata is still sent blocking, the socket is only handed to the
+	 * io thread once the stream is fully set up */
+	if (!send_meta_data(dest)) {
+		RTMP_Close(rtmp);
+		return false;
+	}
+
+	info("Connection to %s successful", dest->url.array);
+	return true;
+}
+
+static void *connect_thread(void *data)
+{
+	struct fanout_dest *dest = data;
+	struct rtmp_fanout *fanout = dest->fanout;
+
+	os_set_thread_name("rtmp-fanout: connect_thread");
+
+	if (try_connect(dest)) {
+		os_atomic_set_long(&dest->state, DEST_CONNECTED);
+	} else {
+		warn("Connection to %s failed", dest->url.array);
+		os_atomic_set_long(&dest->state, DEST_CLOSED);
+	}
+
+	wake_io_thread(fanout);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------ */
+/* sending                                                                  */
+
+/* everything librtmp writes once the socket belongs to the io thread goes
+ * into the destination's write buffer instead of the socket */
+static int dest_queue_data(RTMPSockBuf *sb, const char *data, int len,
+			   void *arg)
+{
+	struct fanout_dest *dest = arg;
+
+	UNUSED_PARAMETER(sb);
+
+	da_push_back_array(dest->write_buf, (const uint8_t *)data,
+			   (size_t)len);
+	return len;
+}
+
+static inline bool would_block(int ret)
+{
+#ifdef USE_MBEDTLS
+	if (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+	    ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+		return true;
+#else
+	UNUSED_PARAMETER(ret);
+#endif
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static bool flush_dest(struct fanout_dest *dest);
+
+/* used while closing after a clean stop.  the unpublish messages are only
+ * sent if the socket takes them right away, they're dropped rather than ever
+ * blocking the io thread or failing the close */
+static int dest_send_closing(RTMPSockBuf *sb, const char *data, int len,
+			     void *arg)
+{
+	struct fanout_dest *dest = arg;
+	int ret;
+
+	if (dest->write_pos < dest->write_buf.num)
+		return len;
+
+	do {
+		ret = RTMPSockBuf_Send(sb, data, len);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret > 0 ? ret : len;
+}
+
+/* the socket stays non-blocking.  a destination that failed or fell behind
+ * most likely has a full send buffer, so its socket is closed without
+ * unpublishing */
+static void close_dest(struct fanout_dest *dest, bool error)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	RTMP *rtmp = &dest->rtmp;
+	int sock = rtmp->m_sb.sb_socket;
+
+	if (dest_state(dest) == DEST_CLOSED)
+		return;
+
+	if (error)
+		warn("Disconnected from %s", dest->url.array);
+
+	if (!error && rtmp->m_bCustomSend)
+		flush_dest(dest);
+	if (sock != -1)
+		epoll_ctl(fanout->epoll_fd, EPOLL_CTL_DEL, sock, NULL);
+
+	if (error || !rtmp->m_bCustomSend) {
+		RTMPSockBuf_Close(&rtmp->m_sb);
+		rtmp->m_sb.sb_socket = -1;
+	} else {
+		rtmp->m_customSendFunc = dest_send_closing;
+	}
+
+	RTMP_Close(rtmp);
+	rtmp->m_bCustomSend = false;
+
+	da_free(dest->write_buf);
+	dest->write_pos = 0;
+	os_atomic_set_long(&dest->state, DEST_CLOSED);
+}
+
+/* makes a newly connected destination part of the fan-out, it starts from the
+ * most recent keyframe still in the queue */
+static void activate_dest(struct fanout_dest *dest)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	RTMP *rtmp = &dest->rtmp;
+	int sock = rtmp->m_sb.sb_socket;
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = dest};
+	size_t count;
+
+	if (fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK) != 0 ||
+	    epoll_ctl(fanout->epoll_fd, EPOLL_CTL_ADD, sock, &ev) != 0) {
+		warn("Failed to set up socket for %s", dest->url.array);
+		close_dest(dest, true);
+		return;
+	}
+
+	rtmp->m_bCustomSend = true;
+	rtmp->m_customSendFunc = dest_queue_data;
+	rtmp->m_customSendParam = dest;
+
+	pthread_mutex_lock(&fanout->packets_mutex);
+	count = fanout->packets.size / sizeof(struct encoder_packet);
+	dest->next_seq = fanout->first_seq + count;
+
+	for (size_t i = count; i > 0; i--) {
+		struct encoder_packet *packet = circlebuf_data(
+			&fanout->packets, (i - 1) * sizeof(*packet));
+		if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe) {
+			dest->next_seq = fanout->first_seq + i - 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&fanout->packets_mutex);
+
+	os_atomic_set_long(&dest->state, DEST_ACTIVE);
+
+	if (!os_atomic_set_bool(&fanout->capturing, true))
+		obs_output_begin_data_capture(fanout->output, 0);
+}
+
+static bool get_dest_packet(struct fanout_dest *dest,
+			    struct encoder_packet *packet,
+			    int64_t *last_dts_usec)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	const size_t size = sizeof(struct encoder_packet);
+	bool found = false;
+
+	pthread_mutex_lock(&fanout->packets_mutex);
+
+	if (dest->next_seq < fanout->first_seq)
+		dest->next_seq = fanout->first_seq;
+
+	size_t idx = (size_t)(dest->next_seq - fanout->first_seq);
+	if (idx * size < fanout->packets.size) {
+		struct encoder_packet *cur =
+			circlebuf_data(&fanout->packets, idx * size);
+		obs_encoder_packet_ref(packet, cur);
+		*last_dts_usec = fanout->last_dts_usec;
+		dest->next_seq++;
+		found = true;
+	}
+
+	pthread_mutex_unlock(&fanout->packets_mutex);
+	return found;
+}
+
+/* same thresholds as rtmp_stream, but based on how far this destination's
+ * cursor is behind the newest packet rather than on its own queue */
+static bool should_send_video(struct fanout_dest *dest,
+			      struct encoder_packet *packet,
+			      int64_t backlog_usec)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+
+	if (!dest->got_keyframe) {
+		if (!packet->keyframe)
+			return false;
+		dest->got_keyframe = true;
+	}
+
+	dest->congestion =
+		(float)backlog_usec / (float)fanout->drop_threshold_usec;
+
+	if (backlog_usec > fanout->pframe_drop_threshold_usec)
+		dest->min_priority = OBS_NAL_PRIORITY_HIGHEST;
+	else if (backlog_usec > fanout->drop_threshold_usec &&
+		 dest->min_priority < OBS_NAL_PRIORITY_HIGH)
+		dest->min_priority = OBS_NAL_PRIORITY_HIGH;
+
+	if (packet->drop_priority < dest->min_priority) {
+		dest->dropped_frames++;
+		return false;
+	}
+
+	dest->min_priority = 0;
+	return true;
+}
+
+static bool send_packet(struct fanout_dest *dest,
+			struct encoder_packet *packet, bool is_header,
+			size_t idx)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	uint8_t *data;
+	size_t size;
+	int ret;
+
+	flv_packet_mux(packet, is_header ? 0 : fanout->start_dts_offset, &data,
+		       &size, is_header);
+	ret = RTMP_Write(&dest->rtmp, (char *)data, (int)size, (int)idx);
+	bfree(data);
+
+	dest->total_bytes_sent += size;
+	return ret >= 0;
+}
+
+static bool send_headers(struct fanout_dest *dest)
+{
+	obs_output_t *context = dest->fanout->output;
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(context);
+	struct encoder_packet packet = {
+		.type = OBS_ENCODER_VIDEO, .timebase_den = 1, .keyframe = true};
+	uint8_t *header;
+	size_t size;
+	bool success;
+
+	obs_encoder_get_extra_data(vencoder, &header, &size);
+	packet.size = obs_parse_avc_header(&packet.data, header, size);
+	success = send_packet(dest, &packet, true, 0);
+	bfree(packet.data);
+
+	for (size_t idx = 0; success; idx++) {
+		obs_encoder_t *aencoder =
+			obs_output_get_audio_encoder(context, idx);
+		if (!aencoder)
+			break;
+
+		packet = (struct encoder_packet){.type = OBS_ENCODER_AUDIO,
+						 .timebase_den = 1};
+		obs_encoder_get_extra_data(aencoder, &packet.data,
+					   &packet.size);
+		success = send_packet(dest, &packet, true, idx);
+	}
+
+	dest->sent_headers = true;
+	return success;
+}
+
+static bool flush_dest(struct fanout_dest *dest)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	RTMP *rtmp = &dest->rtmp;
+	bool want_write;
+
+	while (dest->write_pos < dest->write_buf.num) {
+		int ret = RTMPSockBuf_Send(
+			&rtmp->m_sb,
+			(const char *)dest->write_buf.array + dest->write_pos,
+			(int)(dest->write_buf.num - dest->write_pos));
+
+		if (ret > 0) {
+			dest->write_pos += (size_t)ret;
+		} else if (ret < 0 && errno == EINTR) {
+			continue;
+		} else if (ret < 0 && would_block(ret)) {
+			break;
+		} else {
+			return false;
+		}
+	}
+
+	if (dest->write_pos == dest->write_buf.num) {
+		da_resize(dest->write_buf, 0);
+		dest->write_pos = 0;
+	}
+
+	/* only wait for the socket to become writable while data is stuck */
+	want_write = dest->write_pos < dest->write_buf.num;
+	if (want_write != dest->want_write) {
+		struct epoll_event ev = {
+			.events = EPOLLIN | (want_write ? EPOLLOUT : 0),
+			.data.ptr = dest};
+		epoll_ctl(fanout->epoll_fd, EPOLL_CTL_MOD, rtmp->m_sb.sb_socket,
+			  &ev);
+		dest->want_write = want_write;
+	}
+
+	return true;
+}
+
+static bool send_dest_packets(struct fanout_dest *dest)
+{
+	struct rtmp_fanout *fanout = dest->fanout;
+	struct encoder_packet packet;
+	int64_t last_dts_usec;
+
+	while (!dest->finished &&
+	       dest->write_buf.num - dest->write_pos < WRITE_BUF_LOW_WATER &&
+	       get_dest_packet(dest, &packet, &last_dts_usec)) {
+		int64_t backlog_usec = last_dts_usec - packet.dts_usec;
+		bool success = true;
+
+		if (os_atomic_load_bool(&fanout->stopping) &&
+		    packet.sys_dts_usec >= (int64_t)fanout->stop_ts) {
+			dest->finished = true;
+
+		} else if (backlog_usec > MAX_BACKLOG_USEC) {
+			warn("%s fell too far behind, disconnecting",
+			     dest->url.array);
+			success = false;
+
+		} else if (packet.type == OBS_ENCODER_AUDIO ||
+			   should_send_video(dest, &packet, backlog_usec)) {
+			if (!dest->sent_headers)
+				success = send_headers(dest);
+			if (success)
+				success = send_packet(dest, &packet, false,
+						      packet.track_idx);
+		}
+
+		obs_encoder_packet_release(&packet);
+
+		if (!success)
+			return false;
+	}
+
+	return flush_dest(dest);
+}
+
+/* drains anything the server sends, nothing it sends is needed while
+ * publishing */
+static bool discard_recv_data(struct fanout_dest *dest)
+{
+	RTMPSockBuf *sb = &dest->rtmp.m_sb;
+
+	for (;;) {
+		int ret;
+
+		sb->sb_timedout = false;
+		ret = RTMPSockBuf_Fill(sb);
+		sb->sb_size = 0;
+
+		if (ret <= 0)
+			return ret == 0 && sb->sb_timedout;
+	}
+}
+
+/* releases the packets every active destination has already sent */
+static void trim_packets(struct rtmp_fanout *fanout)
+{
+	uint64_t min_seq = UINT64_MAX;
+
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		struct fanout_dest *dest = fanout->dests + i;
+		if (dest_state(dest) == DEST_ACTIVE && dest->next_seq < min_seq)
+			min_seq = dest->next_seq;
+	}
+
+	pthread_mutex_lock(&fanout->packets_mutex);
+	while (fanout->packets.size && fanout->first_seq < min_seq) {
+		struct encoder_packet packet;
+		circlebuf_pop_front(&fanout->packets, &packet, sizeof(packet));
+		obs_encoder_packet_release(&packet);
+		fanout->first_seq++;
+	}
+	pthread_mutex_unlock(&fanout->packets_mutex);
+}
+
+static void handle_events(struct rtmp_fanout *fanout,
+			  struct epoll_event *events, int count)
+{
+	for (int i = 0; i < count; i++) {
+		struct fanout_dest *dest = events[i].data.ptr;
+		uint32_t flags = events[i].events;
+
+		if (!dest) {
+			uint64_t val;
+			if (read(fanout->event_fd, &val, sizeof(val)) < 0) {
+				/* already drained */
+			}
+			continue;
+		}
+
+		if (dest_state(dest) != DEST_ACTIVE)
+			continue;
+
+		if ((flags & (EPOLLERR | EPOLLHUP)) != 0 ||
+		    ((flags & EPOLLIN) != 0 && !discard_recv_data(dest)))
+			close_dest(dest, true);
+	}
+}
+
+static void *io_thread(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+	bool disconnected = false;
+
+	os_set_thread_name("rtmp-fanout: io_thread");
+
+	for (;;) {
+		bool any_open = false;
+		bool all_finished = true;
+		int count;
+
+		count = epoll_wait(fanout->epoll_fd, events, MAX_EPOLL_EVENTS,
+				   EPOLL_TIMEOUT_MS);
+		if (count > 0)
+			handle_events(fanout, events, count);
+
+		if (os_atomic_load_bool(&fanout->stopping) &&
+		    fanout->stop_ts == 0)
+			break;
+		if (os_atomic_load_bool(&fanout->encode_error))
+			break;
+
+		for (size_t i = 0; i < fanout->num_dests; i++) {
+			struct fanout_dest *dest = fanout->dests + i;
+			long state = dest_state(dest);
+
+			if (state == DEST_CONNECTED) {
+				activate_dest(dest);
+				state = dest_state(dest);
+			}
+			if (state == DEST_ACTIVE && !send_dest_packets(dest)) {
+				close_dest(dest, true);
+				state = DEST_CLOSED;
+			}
+
+			if (state != DEST_CLOSED)
+				any_open = true;
+			if (state == DEST_ACTIVE &&
+			    (!dest->finished ||
+			     dest->write_pos < dest->write_buf.num))
+				all_finished = false;
+			if (state == DEST_CONNECTING)
+				all_finished = false;
+		}
+
+		trim_packets(fanout);
+
+		if (!any_open) {
+			disconnected = true;
+			break;
+		}
+
+		if (os_atomic_load_bool(&fanout->stopping)) {
+			if (all_finished)
+				break;
+
+			if (os_gettime_ns() >= fanout->shutdown_timeout_ts) {
+				info("Stream shutdown timeout reached "
+				     "(%d second(s))",
+				     fanout->max_shutdown_time_sec);
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		struct fanout_dest *dest = fanout->dests + i;
+
+		if (dest->connect_thread_created)
+			pthread_join(dest->connect_thread, NULL);
+		close_dest(dest, false);
+	}
+
+	free_packets(fanout);
+	os_atomic_set_bool(&fanout->active, false);
+
+	bool encode_error = os_atomic_load_bool(&fanout->encode_error);
+	bool capturing = os_atomic_set_bool(&fanout->capturing, false);
+
+	if (disconnected) {
+		info("Disconnected from all destinations");
+	} else if (encode_error) {
+		info("Encoder error, disconnecting");
+	} else {
+		info("User stopped the stream");
+	}
+
+	if (encode_error)
+		obs_output_signal_stop(fanout->output, OBS_OUTPUT_ENCODE_ERROR);
+	else if (!os_atomic_load_bool(&fanout->stopping))
+		obs_output_signal_stop(fanout->output, OBS_OUTPUT_DISCONNECTED);
+	else if (capturing)
+		obs_output_end_data_capture(fanout->output);
+	else
+		obs_output_signal_stop(fanout->output, OBS_OUTPUT_SUCCESS);
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static void add_dest(struct rtmp_fanout *fanout, const char *url,
+		     const char *key, const char *username,
+		     const char *password)
+{
+	struct fanout_dest *dest = fanout->dests + fanout->num_dests++;
+
+	dest->fanout = fanout;
+	dstr_copy(&dest->url, url);
+	dstr_copy(&dest->key, key);
+	dstr_copy(&dest->username, username);
+	dstr_copy(&dest->password, password);
+	dstr_depad(&dest->url);
+	dstr_depad(&dest->key);
+
+	RTMP_Init(&dest->rtmp);
+	os_atomic_set_long(&dest->state, DEST_CONNECTING);
+}
+
+static bool init_dests(struct rtmp_fanout *fanout, obs_data_t *settings)
+{
+	obs_data_array_t *array;
+	size_t count;
+
+	array = obs_data_get_array(settings, OPT_DESTINATIONS);
+	count = obs_data_array_count(array);
+
+	free_dests(fanout);
+	fanout->dests = bzalloc(sizeof(struct fanout_dest) * (count + 1));
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const char *url = obs_data_get_string(item, "server");
+
+		if (url && *url)
+			add_dest(fanout, url, obs_data_get_string(item, "key"),
+				 obs_data_get_string(item, "username"),
+				 obs_data_get_string(item, "password"));
+
+		obs_data_release(item);
+	}
+
+	obs_data_array_release(array);
+	return fanout->num_dests > 0;
+}
+
+static bool rtmp_fanout_start(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	obs_data_t *settings;
+	int64_t drop_p;
+	int64_t drop_b;
+	bool success;
+
+	stop_io_thread(fanout);
+
+	if (!obs_output_can_begin_data_capture(fanout->output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(fanout->output, 0))
+		return false;
+
+	settings = obs_output_get_settings(fanout->output);
+	success = init_dests(fanout, settings);
+	drop_b = (int64_t)obs_data_get_int(settings, OPT_DROP_THRESHOLD);
+	drop_p = (int64_t)obs_data_get_int(settings, OPT_PFRAME_DROP_THRESHOLD);
+	fanout->max_shutdown_time_sec =
+		(int)obs_data_get_int(settings, OPT_MAX_SHUTDOWN_TIME_SEC);
+	dstr_copy(&fanout->bind_ip, obs_data_get_string(settings, OPT_BIND_IP));
+	obs_data_release(settings);
+
+	if (!success) {
+		warn("No destinations set");
+		return false;
+	}
+
+	if (drop_p < (drop_b + 200))
+		drop_p = drop_b + 200;
+
+	fanout->drop_threshold_usec = 1000 * drop_b;
+	fanout->pframe_drop_threshold_usec = 1000 * drop_p;
+
+	free_packets(fanout);
+	fanout->last_dts_usec = 0;
+	fanout->got_first_video = false;
+	fanout->stop_ts = 0;
+	os_atomic_set_bool(&fanout->stopping, false);
+	os_atomic_set_bool(&fanout->encode_error, false);
+	os_atomic_set_bool(&fanout->capturing, false);
+	os_atomic_set_bool(&fanout->active, true);
+
+	if (pthread_create(&fanout->io_thread, NULL, io_thread, fanout) != 0) {
+		warn("Failed to create io thread");
+		os_atomic_set_bool(&fanout->active, false);
+		return false;
+	}
+	fanout->io_thread_joinable = true;
+
+	info("Streaming to %d destination(s)", (int)fanout->num_dests);
+
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		struct fanout_dest *dest = fanout->dests + i;
+
+		dest->connect_thread_created =
+			pthread_create(&dest->connect_thread, NULL,
+				       connect_thread, dest) == 0;
+		if (!dest->connect_thread_created)
+			os_atomic_set_long(&dest->state, DEST_CLOSED);
+	}
+
+	wake_io_thread(fanout);
+	return true;
+}
+
+static void rtmp_fanout_stop(void *data, uint64_t ts)
+{
+	struct rtmp_fanout *fanout = data;
+
+	if (os_atomic_load_bool(&fanout->stopping) && ts != 0)
+		return;
+
+	if (!os_atomic_load_bool(&fanout->active)) {
+		obs_output_signal_stop(fanout->output, OBS_OUTPUT_SUCCESS);
+		return;
+	}
+
+	fanout->stop_ts = ts / 1000ULL;
+	fanout->shutdown_timeout_ts =
+		ts + (uint64_t)fanout->max_shutdown_time_sec * 1000000000ULL;
+	os_atomic_set_bool(&fanout->stopping, true);
+	wake_io_thread(fanout);
+}
+
+static void rtmp_fanout_data(void *data, struct encoder_packet *packet)
+{
+	struct rtmp_fanout *fanout = data;
+	struct encoder_packet new_packet;
+
+	if (!os_atomic_load_bool(&fanout->active))
+		return;
+
+	/* encoder fail */
+	if (!packet) {
+		os_atomic_set_bool(&fanout->encode_error, true);
+		wake_io_thread(fanout);
+		return;
+	}
+
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		if (!fanout->got_first_video) {
+			fanout->start_dts_offset =
+				get_ms_time(packet, packet->dts);
+			fanout->got_first_video = true;
+		}
+
+		obs_parse_avc_packet(&new_packet, packet);
+	} else {
+		obs_encoder_packet_ref(&new_packet, packet);
+	}
+
+	pthread_mutex_lock(&fanout->packets_mutex);
+	circlebuf_push_back(&fanout->packets, &new_packet, sizeof(new_packet));
+	fanout->last_dts_usec = new_packet.dts_usec;
+	pthread_mutex_unlock(&fanout->packets_mutex);
+
+	wake_io_thread(fanout);
+}
+
+static void rtmp_fanout_defaults(obs_data_t *defaults)
+{
+	obs_data_set_default_int(defaults, OPT_DROP_THRESHOLD, 700);
+	obs_data_set_default_int(defaults, OPT_PFRAME_DROP_THRESHOLD, 900);
+	obs_data_set_default_int(defaults, OPT_MAX_SHUTDOWN_TIME_SEC, 30);
+	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
+}
+
+static obs_properties_t *rtmp_fanout_properties(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	obs_properties_t *props = obs_properties_create();
+	struct netif_saddr_data addrs = {0};
+	obs_property_t *p;
+
+	obs_properties_add_int(props, OPT_DROP_THRESHOLD,
+			       obs_module_text("RTMPStream.DropThreshold"), 200,
+			       10000, 100);
+
+	p = obs_properties_add_list(props, OPT_BIND_IP,
+				    obs_module_text("RTMPStream.BindIP"),
+				    OBS_COMBO_TYPE_LIST,
+				    OBS_COMBO_FORMAT_STRING);
+
+	obs_property_list_add_string(p, obs_module_text("Default"), "default");
+
+	netif_get_addrs(&addrs);
+	for (size_t i = 0; i < addrs.addrs.num; i++) {
+		struct netif_saddr_item item = addrs.addrs.array[i];
+		obs_property_list_add_string(p, item.name, item.addr);
+	}
+	netif_saddr_data_free(&addrs);
+
+	return props;
+}
+
+static uint64_t rtmp_fanout_total_bytes_sent(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	uint64_t total = 0;
+
+	for (size_t i = 0; i < fanout->num_dests; i++)
+		total += fanout->dests[i].total_bytes_sent;
+	return total;
+}
+
+static int rtmp_fanout_dropped_frames(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	int dropped = 0;
+
+	for (size_t i = 0; i < fanout->num_dests; i++)
+		dropped += fanout->dests[i].dropped_frames;
+	return dropped;
+}
+
+/* reports the most congested destination */
+static float rtmp_fanout_congestion(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	float congestion = 0.0f;
+
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		struct fanout_dest *dest = fanout->dests + i;
+		float val = dest->min_priority > 0 ? 1.0f : dest->congestion;
+
+		if (dest_state(dest) == DEST_ACTIVE && val > congestion)
+			congestion = val;
+	}
+
+	return congestion;
+}
+
+static int rtmp_fanout_connect_time(void *data)
+{
+	struct rtmp_fanout *fanout = data;
+	int connect_time = 0;
+
+	for (size_t i = 0; i < fanout->num_dests; i++) {
+		int val = fanout->dests[i].rtmp.connect_time_ms;
+		if (val > connect_time)
+			connect_time = val;
+	}
+
+	return connect_time;
+}
+
+struct obs_output_info rtmp_fanout_output_info = {
+	.id = "rtmp_fanout_output",
+	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_MULTI_TRACK,
+	.encoded_video_codecs = "h264",
+	.encoded_audio_codecs = "aac",
+	.get_name = rtmp_fanout_getname,
+	.create = rtmp_fanout_create,
+	.destroy = rtmp_fanout_destroy,
+	.start = rtmp_fanout_start,
+	.stop = rtmp_fanout_stop,
+	.encoded_packet = rtmp_fanout_data,
+	.get_defaults = rtmp_fanout_defaults,
+	.get_properties = rtmp_fanout_properties,
+	.get_total_bytes = rtmp_fanout_total_bytes_sent,
+	.get_congestion = rtmp_fanout_congestion,
+	.get_connect_time_ms = rtmp_fanout_connect_time,
+	.get_dropped_frames = rtmp_fanout_dropped_frames,
+};
+
+#endif
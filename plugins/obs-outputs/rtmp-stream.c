@@ -35,6 +35,10 @@
 #define MIN_ESTIMATE_DURATION_MS 1000
 #define MAX_ESTIMATE_DURATION_MS 2000
 
+/* send batching limits */
+#define SEND_BATCH_MAX_SIZE (256 * 1024)
+#define SEND_BATCH_MAX_DELAY_NS (10ULL * MSEC_TO_NSEC)
+
 static const char *rtmp_stream_getname(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -122,6 +126,7 @@ static void rtmp_stream_destroy(void *data)
 	os_sem_destroy(stream->send_sem);
 	pthread_mutex_destroy(&stream->packets_mutex);
 	circlebuf_free(&stream->packets);
+	da_free(stream->batch_packets);
 #ifdef TEST_FRAMEDROPS
 	circlebuf_free(&stream->droptest_info);
 #endif
@@ -398,28 +403,37 @@ retry_send:
 	return len;
 }
 
+static bool discard_pending_recv_data(struct rtmp_stream *stream)
+{
+	int recv_size = 0;
+	int ret;
+
+	if (stream->new_socket_loop)
+		return true;
+
+#ifdef _WIN32
+	ret = ioctlsocket(stream->rtmp.m_sb.sb_socket, FIONREAD,
+			  (u_long *)&recv_size);
+#else
+	ret = ioctl(stream->rtmp.m_sb.sb_socket, FIONREAD, &recv_size);
+#endif
+
+	if (ret >= 0 && recv_size > 0)
+		return discard_recv_data(stream, (size_t)recv_size);
+
+	return true;
+}
+
 static int send_packet(struct rtmp_stream *stream,
 		       struct encoder_packet *packet, bool is_header,
 		       size_t idx)
 {
 	uint8_t *data;
 	size_t size;
-	int recv_size = 0;
 	int ret = 0;
 
-	if (!stream->new_socket_loop) {
-#ifdef _WIN32
-		ret = ioctlsocket(stream->rtmp.m_sb.sb_socket, FIONREAD,
-				  (u_long *)&recv_size);
-#else
-		ret = ioctl(stream->rtmp.m_sb.sb_socket, FIONREAD, &recv_size);
-#endif
-
-		if (ret >= 0 && recv_size > 0) {
-			if (!discard_recv_data(stream, (size_t)recv_size))
-				return -1;
-		}
-	}
+	if (!discard_pending_recv_data(stream))
+		return -1;
 
 	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data,
 		       &size, is_header);
@@ -442,6 +456,159 @@ static int send_packet(struct rtmp_stream *stream,
 
 static inline bool send_headers(struct rtmp_stream *stream);
 
+static void release_batch(struct rtmp_stream *stream)
+{
+	for (size_t i = 0; i < stream->batch_packets.num; i++)
+		obs_encoder_packet_release(
+			&stream->batch_packets.array[i].packet);
+
+	da_resize(stream->batch_packets, 0);
+	RTMP_BatchReset(&stream->batch);
+	stream->batch_size = 0;
+}
+
+/* adds the packet to the current batch, chunk headers are generated right
+ * away but the packet data is referenced until the batch is flushed */
+static int batch_packet(struct rtmp_stream *stream,
+			struct encoder_packet *packet)
+{
+	uint8_t prefix[FLV_PACKET_PREFIX_MAX_SIZE];
+	RTMPPacket rtmp_packet = {0};
+	struct batched_packet batched;
+	uint32_t timestamp;
+	size_t prefix_size;
+
+	prefix_size = flv_packet_prefix(packet, stream->start_dts_offset,
+					prefix, &timestamp, false);
+	if (!prefix_size) {
+		obs_encoder_packet_release(packet);
+		return 0;
+	}
+
+	rtmp_packet.m_packetType = packet->type == OBS_ENCODER_VIDEO
+					   ? RTMP_PACKET_TYPE_VIDEO
+					   : RTMP_PACKET_TYPE_AUDIO;
+	rtmp_packet.m_headerType = timestamp ? RTMP_PACKET_SIZE_MEDIUM
+					     : RTMP_PACKET_SIZE_LARGE;
+	rtmp_packet.m_nChannel = 0x04;
+	rtmp_packet.m_nTimeStamp = timestamp;
+	rtmp_packet.m_nInfoField2 =
+		stream->rtmp.Link.streams[packet->track_idx].id;
+
+	/* each packet keeps the time it would have been sent without
+	 * batching and the size of its flv tag, for the statistics */
+	batched.packet = *packet;
+	batched.batch_ts = os_gettime_ns();
+	batched.tag_size = FLV_TAG_OVERHEAD_SIZE + prefix_size + packet->size;
+
+	if (!stream->batch_packets.num)
+		stream->batch_start_ns = batched.batch_ts;
+	da_push_back(stream->batch_packets, &batched);
+
+	if (!RTMP_BatchPacket(&stream->rtmp, &stream->batch, &rtmp_packet,
+			      (char *)prefix, (int)prefix_size,
+			      (char *)packet->data, (int)packet->size))
+		return -1;
+
+	stream->batch_size += prefix_size + packet->size;
+	return 0;
+}
+
+static inline bool batch_ready(struct rtmp_stream *stream)
+{
+	bool queue_empty;
+
+	if (stream->batch_size >= SEND_BATCH_MAX_SIZE)
+		return true;
+	if (os_gettime_ns() - stream->batch_start_ns >=
+	    SEND_BATCH_MAX_DELAY_NS)
+		return true;
+
+	pthread_mutex_lock(&stream->packets_mutex);
+	queue_empty = !stream->packets.size;
+	pthread_mutex_unlock(&stream->packets_mutex);
+
+	return queue_empty;
+}
+
+#ifdef __linux__
+/* keeps unsent data in our own packet queue rather than in the kernel's send
+ * buffer, so frame dropping and bitrate changes see it sooner */
+static void tcp_set_notsent_lowat(struct rtmp_stream *stream)
+{
+	if (!tcp_congestion_set_notsent_lowat(
+		    stream->rtmp.m_sb.sb_socket,
+		    stream->dbr_orig_bitrate + stream->audio_bitrate))
+		debug("Failed to set TCP_NOTSENT_LOWAT: %d", errno);
+}
+
+static void tcp_probe_congestion(struct rtmp_stream *stream)
+{
+	struct tcp_congestion *tc = &stream->tcp;
+
+	if (tcp_congestion_probe(tc, stream->rtmp.m_sb.sb_socket,
+				 stream->total_bytes_sent,
+				 stream->dbr_cur_bitrate,
+				 stream->audio_bitrate))
+		debug("tcp congestion: rtt %u (min %u) usec, cwnd %u, "
+		      "unsent %" PRIu64 " bytes, est %ld kbps",
+		      tc->rtt_usec, tc->min_rtt_usec, tc->cwnd, tc->unsent,
+		      tc->est_bitrate);
+}
+#endif
+
+static void dbr_add_frame(struct rtmp_stream *stream, struct dbr_frame *back);
+
+static int flush_batch(struct rtmp_stream *stream)
+{
+	uint64_t send_end;
+	int ret = 0;
+
+	if (!stream->batch_packets.num)
+		return 0;
+
+	if (!discard_pending_recv_data(stream)) {
+		ret = -1;
+		goto finish;
+	}
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, stream->batch_size);
+#endif
+
+	if (!RTMP_BatchFlush(&stream->rtmp, &stream->batch)) {
+		ret = -1;
+		goto finish;
+	}
+
+	send_end = os_gettime_ns();
+
+	for (size_t i = 0; i < stream->batch_packets.num; i++)
+		stream->total_bytes_sent +=
+			stream->batch_packets.array[i].tag_size;
+
+	if (stream->dbr_enabled) {
+		pthread_mutex_lock(&stream->dbr_mutex);
+		for (size_t i = 0; i < stream->batch_packets.num; i++) {
+			struct batched_packet *batched =
+				&stream->batch_packets.array[i];
+			struct dbr_frame dbr_frame = {
+				batched->batch_ts, send_end,
+				batched->packet.size};
+
+			dbr_add_frame(stream, &dbr_frame);
+		}
+#ifdef __linux__
+		tcp_probe_congestion(stream);
+#endif
+		pthread_mutex_unlock(&stream->dbr_mutex);
+	}
+
+finish:
+	release_batch(stream);
+	return ret;
+}
+
 static inline bool can_shutdown_stream(struct rtmp_stream *stream,
 				       struct encoder_packet *packet)
 {
@@ -569,7 +736,6 @@ static void *send_thread(void *data)
 
 	while (os_sem_wait(stream->send_sem) == 0) {
 		struct encoder_packet packet;
-		struct dbr_frame dbr_frame;
 
 		if (stopping(stream) && stream->stop_ts == 0) {
 			break;
@@ -592,25 +758,17 @@ static void *send_thread(void *data)
 			}
 		}
 
-		if (stream->dbr_enabled) {
-			dbr_frame.send_beg = os_gettime_ns();
-			dbr_frame.size = packet.size;
-		}
-
-		if (send_packet(stream, &packet, false, packet.track_idx) < 0) {
+		if (batch_packet(stream, &packet) < 0 ||
+		    (batch_ready(stream) && flush_batch(stream) < 0)) {
 			os_atomic_set_bool(&stream->disconnected, true);
 			break;
 		}
-
-		if (stream->dbr_enabled) {
-			dbr_frame.send_end = os_gettime_ns();
-
-			pthread_mutex_lock(&stream->dbr_mutex);
-			dbr_add_frame(stream, &dbr_frame);
-			pthread_mutex_unlock(&stream->dbr_mutex);
-		}
 	}
 
+	if (!disconnected(stream) && flush_batch(stream) < 0)
+		os_atomic_set_bool(&stream->disconnected, true);
+	release_batch(stream);
+
 	bool encode_error = os_atomic_load_bool(&stream->encode_error);
 
 	if (disconnected(stream)) {
@@ -764,6 +922,9 @@ static int init_send(struct rtmp_stream *stream)
 
 #if defined(_WIN32)
 	adjust_sndbuf_size(stream, MIN_SENDBUF_SIZE);
+#elif defined(__linux__)
+	if (stream->dbr_enabled && !stream->new_socket_loop)
+		tcp_set_notsent_lowat(stream);
 #endif
 
 	reset_semaphore(stream);
@@ -1058,6 +1219,7 @@ static bool init_connect(struct rtmp_stream *stream)
 	stream->dbr_inc_bitrate = stream->dbr_orig_bitrate / 10;
 	stream->dbr_inc_timeout = 0;
 	stream->dbr_enabled = obs_data_get_bool(settings, OPT_DYN_BITRATE);
+	tcp_congestion_reset(&stream->tcp);
 
 	caps = obs_encoder_get_caps(venc);
 	if ((caps & OBS_ENCODER_CAP_DYN_BITRATE) == 0) {
@@ -1212,15 +1374,23 @@ static bool find_first_video_packet(struct rtmp_stream *stream,
 static bool dbr_bitrate_lowered(struct rtmp_stream *stream)
 {
 	long prev_bitrate = stream->dbr_prev_bitrate;
+	long cur_est_bitrate = stream->dbr_est_bitrate;
 	long est_bitrate = 0;
 	long new_bitrate;
 
-	if (stream->dbr_est_bitrate &&
-	    stream->dbr_est_bitrate < stream->dbr_cur_bitrate) {
+	/* the tcp estimate reacts before the send rate average does */
+	if (stream->tcp.congested) {
+		stream->tcp.congested = false;
+		if (!cur_est_bitrate ||
+		    stream->tcp.est_bitrate < cur_est_bitrate)
+			cur_est_bitrate = stream->tcp.est_bitrate;
+	}
+
+	if (cur_est_bitrate && cur_est_bitrate < stream->dbr_cur_bitrate) {
 		stream->dbr_data_size = 0;
 		circlebuf_pop_front(&stream->dbr_frames, NULL,
 				    stream->dbr_frames.size);
-		est_bitrate = stream->dbr_est_bitrate / 100 * 100;
+		est_bitrate = cur_est_bitrate / 100 * 100;
 		if (est_bitrate < 50) {
 			est_bitrate = 50;
 		}
@@ -1272,6 +1442,18 @@ static bool dbr_bitrate_lowered(struct rtmp_stream *stream)
 	return true;
 }
 
+static bool dbr_tcp_congestion_lowered(struct rtmp_stream *stream)
+{
+	bool bitrate_changed = false;
+
+	pthread_mutex_lock(&stream->dbr_mutex);
+	if (stream->tcp.congested)
+		bitrate_changed = dbr_bitrate_lowered(stream);
+	pthread_mutex_unlock(&stream->dbr_mutex);
+
+	return bitrate_changed;
+}
+
 static void dbr_set_bitrate(struct rtmp_stream *stream)
 {
 	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
@@ -1320,6 +1502,11 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 				dbr_set_bitrate(stream);
 			}
 		}
+
+		/* lower the bitrate as soon as the socket predicts congestion
+		 * rather than waiting for packets to back up */
+		if (dbr_tcp_congestion_lowered(stream))
+			dbr_set_bitrate(stream);
 	}
 
 	if (num_packets < 5) {
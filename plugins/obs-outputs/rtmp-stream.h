@@ -2,6 +2,7 @@
 #include <obs-avc.h>
 #include <util/platform.h>
 #include <util/circlebuf.h>
+#include <util/darray.h>
 #include <util/dstr.h>
 #include <util/threading.h>
 #include <inttypes.h>
@@ -9,6 +10,7 @@
 #include "librtmp/log.h"
 #include "flv-mux.h"
 #include "net-if.h"
+#include "tcp-congestion.h"
 
 #ifdef _WIN32
 #include <Iphlpapi.h>
@@ -52,6 +54,12 @@ struct dbr_frame {
 	size_t size;
 };
 
+struct batched_packet {
+	struct encoder_packet packet;
+	uint64_t batch_ts;
+	size_t tag_size;
+};
+
 struct rtmp_stream {
 	obs_output_t *output;
 
@@ -112,8 +120,17 @@ struct rtmp_stream {
 	long dbr_inc_bitrate;
 	bool dbr_enabled;
 
+	/* congestion predicted from the kernel's tcp state (linux only) */
+	struct tcp_congestion tcp;
+
 	RTMP rtmp;
 
+	/* packets written with a single send once the queue runs dry */
+	RTMPBatch batch;
+	DARRAY(struct batched_packet) batch_packets;
+	uint64_t batch_start_ns;
+	size_t batch_size;
+
 	bool new_socket_loop;
 	bool low_latency_mode;
 	bool disable_send_window_optimization;
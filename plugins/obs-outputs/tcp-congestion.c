@@ -0,0 +1,140 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifdef __linux__
+#include "tcp-congestion.h"
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/sockios.h>
+#include <util/platform.h>
+
+#define PROBE_INTERVAL_NS 100000000ULL
+#define QUEUE_TRIGGER_USEC 100000ULL
+#define RTT_INFLATION_USEC 50000ULL
+#define NOTSENT_LOWAT_MIN 32768
+#define MIN_EST_BITRATE 50
+#define DRAIN_WINDOW_MIN_NS 500000000ULL
+#define DRAIN_WINDOW_MAX_NS 2000000000ULL
+
+bool tcp_congestion_set_notsent_lowat(int fd, long bitrate)
+{
+	int lowat = (int)(bitrate * 1000 / 8 / 10);
+
+	if (lowat < NOTSENT_LOWAT_MIN)
+		lowat = NOTSENT_LOWAT_MIN;
+
+	return setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat,
+			  sizeof(lowat)) == 0;
+}
+
+/* the rate data has been acknowledged since unsent data started queuing, in
+ * kbps.  while nothing is queued the encoder rather than the connection
+ * limits the rate, so there is no estimate.  acknowledgements arrive in
+ * bursts, so the rate is only measured over at least half a second */
+static void update_drain_bitrate(struct tcp_congestion *tc, uint64_t ts,
+				 uint64_t bytes_sent, uint64_t outq,
+				 uint64_t unsent)
+{
+	uint64_t elapsed_usec, acked;
+
+	if (!unsent) {
+		tc->drain_ts = 0;
+		tc->drain_bitrate = 0;
+		return;
+	}
+
+	if (!tc->drain_ts || ts - tc->drain_ts >= DRAIN_WINDOW_MAX_NS) {
+		tc->drain_ts = ts;
+		tc->drain_bytes_sent = bytes_sent;
+		tc->drain_outq = outq;
+		return;
+	}
+
+	elapsed_usec = (ts - tc->drain_ts) / 1000;
+	if (elapsed_usec * 1000 < DRAIN_WINDOW_MIN_NS)
+		return;
+	if (bytes_sent - tc->drain_bytes_sent + tc->drain_outq < outq)
+		return;
+
+	acked = bytes_sent - tc->drain_bytes_sent + tc->drain_outq - outq;
+	tc->drain_bitrate = (long)(acked * 8 * 1000 / elapsed_usec);
+}
+
+bool tcp_congestion_probe(struct tcp_congestion *tc, int fd,
+			  uint64_t bytes_sent, long bitrate, long audio_bitrate)
+{
+	uint64_t ts = os_gettime_ns();
+	struct tcp_info tcp_info;
+	socklen_t len = sizeof(tcp_info);
+	uint64_t window, unacked, unsent, queue_usec;
+	long est_bitrate;
+	bool rtt_inflated;
+	bool was_congested = tc->congested;
+	int outq = 0;
+
+	if (tc->probe_ts && ts - tc->probe_ts < PROBE_INTERVAL_NS)
+		return false;
+
+	if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcp_info, &len) != 0 ||
+	    ioctl(fd, SIOCOUTQ, &outq) != 0)
+		return false;
+	if (!tcp_info.tcpi_rtt || !tcp_info.tcpi_snd_cwnd ||
+	    !tcp_info.tcpi_snd_mss)
+		return false;
+
+	if (!tc->min_rtt_usec || tcp_info.tcpi_rtt < tc->min_rtt_usec)
+		tc->min_rtt_usec = tcp_info.tcpi_rtt;
+
+	window = (uint64_t)tcp_info.tcpi_snd_cwnd * tcp_info.tcpi_snd_mss;
+	unacked = (uint64_t)tcp_info.tcpi_unacked * tcp_info.tcpi_snd_mss;
+	unsent = (uint64_t)outq > unacked ? (uint64_t)outq - unacked : 0;
+
+	/* one window per round trip, in kbps */
+	est_bitrate = (long)(window * 8 * 1000 / tcp_info.tcpi_rtt);
+
+	update_drain_bitrate(tc, ts, bytes_sent, (uint64_t)outq, unsent);
+	if (tc->drain_bitrate && tc->drain_bitrate < est_bitrate)
+		est_bitrate = tc->drain_bitrate;
+
+	tc->probe_ts = ts;
+	tc->rtt_usec = tcp_info.tcpi_rtt;
+	tc->cwnd = tcp_info.tcpi_snd_cwnd;
+	tc->unsent = unsent;
+
+	if (!est_bitrate)
+		return false;
+
+	queue_usec = unsent * 8 * 1000 / (uint64_t)est_bitrate;
+	rtt_inflated = tcp_info.tcpi_rtt >= tc->min_rtt_usec * 2 &&
+		       tcp_info.tcpi_rtt - tc->min_rtt_usec >=
+			       RTT_INFLATION_USEC;
+
+	est_bitrate -= audio_bitrate;
+	if (est_bitrate < MIN_EST_BITRATE)
+		est_bitrate = MIN_EST_BITRATE;
+
+	tc->est_bitrate = est_bitrate;
+
+	if (est_bitrate < bitrate &&
+	    (queue_usec >= QUEUE_TRIGGER_USEC || (rtt_inflated && unsent > 0)))
+		tc->congested = true;
+
+	return tc->congested && !was_congested;
+}
+#endif
@@ -0,0 +1,65 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ *   Predicts congestion of a tcp connection from the kernel's socket state
+ * (linux only).  The sustainable rate is estimated from the congestion window
+ * and round trip time, and from the rate data is acknowledged while unsent
+ * data is queued, which also covers links limited by the receive window or
+ * by a shaper.
+ */
+
+struct tcp_congestion {
+	uint64_t probe_ts;
+	uint32_t min_rtt_usec;
+
+	uint64_t drain_ts;
+	uint64_t drain_bytes_sent;
+	uint64_t drain_outq;
+	long drain_bitrate;
+
+	/* estimated video bitrate the connection can sustain, in kbps */
+	long est_bitrate;
+	bool congested;
+
+	/* state of the last probe, for logging */
+	uint32_t rtt_usec;
+	uint32_t cwnd;
+	uint64_t unsent;
+};
+
+static inline void tcp_congestion_reset(struct tcp_congestion *tc)
+{
+	memset(tc, 0, sizeof(*tc));
+}
+
+/* keeps roughly 100 ms of the specified bitrate (in kbps) unsent in the
+ * kernel's send buffer, so a backlog stays in our own queue instead */
+extern bool tcp_congestion_set_notsent_lowat(int fd, long bitrate);
+
+/* samples the socket at most every 100 ms.  bytes_sent is the total number
+ * of bytes written to the socket so far, and bitrate the current video
+ * bitrate.  returns true if congestion was newly detected */
+extern bool tcp_congestion_probe(struct tcp_congestion *tc, int fd,
+				 uint64_t bytes_sent, long bitrate,
+				 long audio_bitrate);
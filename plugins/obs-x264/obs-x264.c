@@ -47,6 +47,9 @@ struct obs_x264 {
 
 	DARRAY(uint8_t) packet_data;
 
+	struct encoder_packet pending_packet;
+	bool has_pending_packet;
+
 	uint8_t *extra_data;
 	uint8_t *sei;
 
@@ -701,9 +704,7 @@ static inline void init_pic_data(struct obs_x264 *obsx264, x264_picture_t *pic,
 	}
 }
 
-static bool obs_x264_encode(void *data, struct encoder_frame *frame,
-			    struct encoder_packet *packet,
-			    bool *received_packet)
+static bool obs_x264_submit_frame(void *data, struct encoder_frame *frame)
 {
 	struct obs_x264 *obsx264 = data;
 	x264_nal_t *nals;
@@ -711,25 +712,60 @@ static bool obs_x264_encode(void *data, struct encoder_frame *frame,
 	int ret;
 	x264_picture_t pic, pic_out;
 
-	if (!frame || !packet || !received_packet)
+	if (!frame)
 		return false;
 
-	if (frame)
-		init_pic_data(obsx264, &pic, frame);
+	init_pic_data(obsx264, &pic, frame);
 
-	ret = x264_encoder_encode(obsx264->context, &nals, &nal_count,
-				  (frame ? &pic : NULL), &pic_out);
+	ret = x264_encoder_encode(obsx264->context, &nals, &nal_count, &pic,
+				  &pic_out);
 	if (ret < 0) {
 		warn("encode failed");
 		return false;
 	}
 
-	*received_packet = (nal_count != 0);
-	parse_packet(obsx264, packet, nals, nal_count, &pic_out);
+	obsx264->has_pending_packet = (nal_count != 0);
+	parse_packet(obsx264, &obsx264->pending_packet, nals, nal_count,
+		     &pic_out);
+
+	return true;
+}
+
+static bool obs_x264_receive_packet(void *data, struct encoder_packet *packet,
+				    bool *received_packet)
+{
+	struct obs_x264 *obsx264 = data;
+	struct encoder_packet *pending = &obsx264->pending_packet;
+
+	if (!packet || !received_packet)
+		return false;
+
+	*received_packet = obsx264->has_pending_packet;
+	if (!obsx264->has_pending_packet)
+		return true;
+
+	packet->data = pending->data;
+	packet->size = pending->size;
+	packet->type = pending->type;
+	packet->pts = pending->pts;
+	packet->dts = pending->dts;
+	packet->keyframe = pending->keyframe;
 
+	obsx264->has_pending_packet = false;
 	return true;
 }
 
+static bool obs_x264_encode(void *data, struct encoder_frame *frame,
+			    struct encoder_packet *packet,
+			    bool *received_packet)
+{
+	if (!frame || !packet || !received_packet)
+		return false;
+
+	return obs_x264_submit_frame(data, frame) &&
+	       obs_x264_receive_packet(data, packet, received_packet);
+}
+
 static bool obs_x264_extra_data(void *data, uint8_t **extra_data, size_t *size)
 {
 	struct obs_x264 *obsx264 = data;
@@ -783,6 +819,8 @@ struct obs_encoder_info obs_x264_encoder = {
 	.create = obs_x264_create,
 	.destroy = obs_x264_destroy,
 	.encode = obs_x264_encode,
+	.submit_frame = obs_x264_submit_frame,
+	.receive_packet = obs_x264_receive_packet,
 	.update = obs_x264_update,
 	.get_properties = obs_x264_props,
 	.get_defaults = obs_x264_defaults,
@@ -39,7 +39,7 @@ static struct obs_source_info freetype2_source_info_v1 = {
 	.id = "text_ft2_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
 	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CAP_OBSOLETE |
-			OBS_SOURCE_CUSTOM_DRAW,
+			OBS_SOURCE_CUSTOM_DRAW | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = ft2_source_get_name,
 	.create = ft2_source_create_v1,
 	.destroy = ft2_source_destroy,
@@ -59,7 +59,7 @@ static struct obs_source_info freetype2_source_info_v2 = {
 #ifdef _WIN32
 			OBS_SOURCE_DEPRECATED |
 #endif
-			OBS_SOURCE_CUSTOM_DRAW,
+			OBS_SOURCE_CUSTOM_DRAW | OBS_SOURCE_STATIC_VIDEO,
 	.get_name = ft2_source_get_name,
 	.create = ft2_source_create_v2,
 	.destroy = ft2_source_destroy,
@@ -276,6 +276,8 @@ static void ft2_video_tick(void *data, float seconds)
 			cache_glyphs(srcdata, srcdata->text);
 			set_up_vertex_buffer(srcdata);
 			srcdata->update_file = false;
+
+			obs_source_invalidate_video(srcdata->src);
 		}
 
 		if (srcdata->m_timestamp != t) {
@@ -0,0 +1,331 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Measures how a slow video encoder affects the raw video thread, with the
+ * blocking encode callback and with the asynchronous submit_frame and
+ * receive_packet callbacks.
+ *
+ *   A 720p60 video output is driven at its frame rate without graphics, and a
+ * test encoder sleeps for a fixed time per frame, with a long spike every so
+ * often, as with scene changes.  Its average time fits in the frame interval.
+ * A second raw video callback connected after the encoder stands in for
+ * everything else that shares the video thread (other encoders, virtual
+ * camera), and records how late it receives each frame.
+ */
+
+#include <obs.h>
+#include <media-io/video-frame.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include "bench.h"
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define FPS 60
+#define FRAME_NS (1000000000ULL / FPS)
+#define NUM_FRAMES (FPS * 10)
+
+#define ENCODE_NS 8000000ULL
+#define SPIKE_NS 45000000ULL
+#define SPIKE_INTERVAL 30
+
+/* ------------------------------------------------------------------------- */
+/* test encoder */
+
+struct test_encoder {
+	uint64_t frames;
+	int64_t pts;
+	bool have_packet;
+	uint8_t data[64];
+};
+
+static void encode_delay(struct test_encoder *te)
+{
+	uint64_t ns = (te->frames++ % SPIKE_INTERVAL) == SPIKE_INTERVAL - 1
+			      ? SPIKE_NS
+			      : ENCODE_NS;
+	os_sleepto_ns(os_gettime_ns() + ns);
+}
+
+static void fill_packet(struct test_encoder *te, struct encoder_packet *packet,
+			int64_t pts)
+{
+	packet->data = te->data;
+	packet->size = sizeof(te->data);
+	packet->pts = pts;
+	packet->dts = pts;
+	packet->type = OBS_ENCODER_VIDEO;
+	packet->keyframe = pts == 0;
+}
+
+static const char *test_encoder_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Test encoder";
+}
+
+static void *test_encoder_create(obs_data_t *settings, obs_encoder_t *encoder)
+{
+	UNUSED_PARAMETER(settings);
+	UNUSED_PARAMETER(encoder);
+	return bzalloc(sizeof(struct test_encoder));
+}
+
+static void test_encoder_destroy(void *data)
+{
+	bfree(data);
+}
+
+static bool test_encoder_encode(void *data, struct encoder_frame *frame,
+				struct encoder_packet *packet,
+				bool *received_packet)
+{
+	struct test_encoder *te = data;
+
+	encode_delay(te);
+	fill_packet(te, packet, frame->pts);
+	*received_packet = true;
+	return true;
+}
+
+static bool test_encoder_submit_frame(void *data, struct encoder_frame *frame)
+{
+	struct test_encoder *te = data;
+
+	encode_delay(te);
+	te->pts = frame->pts;
+	te->have_packet = true;
+	return true;
+}
+
+static bool test_encoder_receive_packet(void *data,
+					struct encoder_packet *packet,
+					bool *received_packet)
+{
+	struct test_encoder *te = data;
+
+	*received_packet = te->have_packet;
+	if (te->have_packet)
+		fill_packet(te, packet, te->pts);
+	te->have_packet = false;
+	return true;
+}
+
+static void register_test_encoders(void)
+{
+	struct obs_encoder_info info = {
+		.id = "bench_sync_encoder",
+		.type = OBS_ENCODER_VIDEO,
+		.codec = "h264",
+		.get_name = test_encoder_name,
+		.create = test_encoder_create,
+		.destroy = test_encoder_destroy,
+		.encode = test_encoder_encode,
+	};
+
+	obs_register_encoder(&info);
+
+	info.id = "bench_async_encoder";
+	info.submit_frame = test_encoder_submit_frame;
+	info.receive_packet = test_encoder_receive_packet;
+	obs_register_encoder(&info);
+}
+
+/* ------------------------------------------------------------------------- */
+/* test output */
+
+static volatile long packets_received = 0;
+
+static const char *test_output_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Test output";
+}
+
+static void *test_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	UNUSED_PARAMETER(settings);
+	return output;
+}
+
+static void test_output_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static bool test_output_start(void *data)
+{
+	obs_output_t *output = data;
+
+	if (!obs_output_can_begin_data_capture(output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(output, 0))
+		return false;
+	return obs_output_begin_data_capture(output, 0);
+}
+
+static void test_output_stop(void *data, uint64_t ts)
+{
+	UNUSED_PARAMETER(ts);
+	obs_output_end_data_capture(data);
+}
+
+static void test_output_packet(void *data, struct encoder_packet *packet)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(packet);
+	os_atomic_inc_long(&packets_received);
+}
+
+static void register_test_output(void)
+{
+	struct obs_output_info info = {
+		.id = "bench_output",
+		.flags = OBS_OUTPUT_VIDEO | OBS_OUTPUT_ENCODED,
+		.get_name = test_output_name,
+		.create = test_output_create,
+		.destroy = test_output_destroy,
+		.start = test_output_start,
+		.stop = test_output_stop,
+		.encoded_packet = test_output_packet,
+	};
+
+	obs_register_output(&info);
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct latency {
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t frames;
+	uint32_t late_frames;
+};
+
+static void observe_frame(void *param, struct video_data *frame)
+{
+	struct latency *latency = param;
+	uint64_t ns = os_gettime_ns() - frame->timestamp;
+
+	latency->total_ns += ns;
+	latency->frames++;
+	if (ns > latency->max_ns)
+		latency->max_ns = ns;
+	if (ns > FRAME_NS)
+		latency->late_frames++;
+}
+
+static void run_case(const char *name, const char *encoder_id)
+{
+	struct video_output_info voi = {
+		.name = "bench",
+		.format = VIDEO_FORMAT_NV12,
+		.fps_num = FPS,
+		.fps_den = 1,
+		.width = WIDTH,
+		.height = HEIGHT,
+		.range = VIDEO_RANGE_PARTIAL,
+		.colorspace = VIDEO_CS_709,
+		.cache_size = 6,
+	};
+	struct latency latency = {0};
+	video_t *video;
+	obs_encoder_t *encoder;
+	obs_output_t *output;
+	uint64_t ts;
+
+	if (video_output_open(&video, &voi) != VIDEO_OUTPUT_SUCCESS) {
+		printf("failed to open video output\n");
+		return;
+	}
+
+	encoder = obs_video_encoder_create(encoder_id, name, NULL, NULL);
+	output = obs_output_create("bench_output", name, NULL, NULL);
+	obs_encoder_set_video(encoder, video);
+	obs_output_set_media(output, video, NULL);
+	obs_output_set_video_encoder(output, encoder);
+
+	os_atomic_set_long(&packets_received, 0);
+	if (!obs_output_start(output)) {
+		printf("failed to start output\n");
+		goto fail;
+	}
+
+	video_output_connect(video, NULL, observe_frame, &latency);
+
+	/* stands in for the graphics thread */
+	ts = os_gettime_ns();
+	for (int i = 0; i < NUM_FRAMES; i++) {
+		struct video_frame frame;
+
+		os_sleepto_ns(ts);
+		if (video_output_lock_frame(video, &frame, 1, ts)) {
+			memset(frame.data[0], 16, frame.linesize[0] * HEIGHT);
+			memset(frame.data[1], 128,
+			       frame.linesize[1] * HEIGHT / 2);
+			video_output_unlock_frame(video);
+		}
+		ts += FRAME_NS;
+	}
+
+	obs_output_stop(output);
+	video_output_disconnect(video, observe_frame, &latency);
+
+	printf("%s\n", name);
+	printf("  %-32s %10u / %u\n", "frames skipped by video thread",
+	       video_output_get_skipped_frames(video),
+	       video_output_get_total_frames(video));
+	printf("  %-32s %10u\n", "frames skipped by encode queue",
+	       obs_encoder_get_skipped_frames(encoder));
+	printf("  %-32s %10ld\n", "packets received",
+	       os_atomic_load_long(&packets_received));
+	printf("  %-32s %10.2f ms\n", "other callback latency, mean",
+	       latency.frames ? (double)latency.total_ns / latency.frames / 1e6
+			      : 0.0);
+	printf("  %-32s %10.2f ms\n", "other callback latency, max",
+	       (double)latency.max_ns / 1e6);
+	printf("  %-32s %10u / %u\n", "frames later than one interval",
+	       latency.late_frames, latency.frames);
+
+fail:
+	obs_output_release(output);
+	obs_encoder_release(encoder);
+	video_output_close(video);
+}
+
+int main(void)
+{
+	if (!obs_startup("en-US", NULL, NULL)) {
+		printf("failed to start libobs\n");
+		return 1;
+	}
+
+	register_test_encoders();
+	register_test_output();
+
+	printf("%dx%d at %d fps, encode %.0f ms per frame, %.0f ms every "
+	       "%dth frame\n",
+	       WIDTH, HEIGHT, FPS, ENCODE_NS / 1e6, SPIKE_NS / 1e6,
+	       SPIKE_INTERVAL);
+
+	run_case("blocking encode", "bench_sync_encoder");
+	run_case("submit_frame / receive_packet", "bench_async_encoder");
+
+	obs_shutdown();
+	return 0;
+}
@@ -0,0 +1,138 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Compares the audio mixing kernels of media-io/audio-mix.c on one output
+ * tick worth of samples per channel, and checks that every kernel produces
+ * the same result as the scalar version.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <util/bmem.h>
+#include <media-io/audio-io.h>
+#include <media-io/audio-mix.h>
+#include "bench.h"
+
+#define MIX_FRAMES AUDIO_OUTPUT_FRAMES
+#define MIX_ITERATIONS 200000
+
+struct mix_data {
+	float *dst;
+	float *src;
+	float *mul;
+};
+
+static void run_add(void *param)
+{
+	struct mix_data *data = param;
+	audio_mix_add(data->dst, data->src, MIX_FRAMES);
+}
+
+static void run_add_mul(void *param)
+{
+	struct mix_data *data = param;
+	audio_mix_add_mul(data->dst, data->src, data->mul, MIX_FRAMES);
+}
+
+static void fill(struct mix_data *data)
+{
+	for (size_t i = 0; i < MIX_FRAMES; i++) {
+		data->dst[i] = 0.0f;
+		data->src[i] = (float)rand() / (float)RAND_MAX - 0.5f;
+		data->mul[i] = (float)rand() / (float)RAND_MAX;
+	}
+}
+
+static bool matches_scalar(struct mix_data *data, enum audio_mix_kernel kernel)
+{
+	float *expected = bmalloc(MIX_FRAMES * sizeof(float));
+	bool match = true;
+
+	audio_mix_set_kernel(AUDIO_MIX_KERNEL_SCALAR);
+	fill(data);
+	audio_mix_add_mul(data->dst, data->src, data->mul, MIX_FRAMES);
+	audio_mix_add(data->dst, data->src, MIX_FRAMES);
+	memcpy(expected, data->dst, MIX_FRAMES * sizeof(float));
+
+	audio_mix_set_kernel(kernel);
+	memset(data->dst, 0, MIX_FRAMES * sizeof(float));
+	audio_mix_add_mul(data->dst, data->src, data->mul, MIX_FRAMES);
+	audio_mix_add(data->dst, data->src, MIX_FRAMES);
+
+	for (size_t i = 0; i < MIX_FRAMES; i++) {
+		if (fabsf(expected[i] - data->dst[i]) > 1e-6f) {
+			match = false;
+			break;
+		}
+	}
+
+	bfree(expected);
+	return match;
+}
+
+int main(void)
+{
+	static const struct {
+		enum audio_mix_kernel kernel;
+		const char *name;
+	} kernels[] = {
+		{AUDIO_MIX_KERNEL_SCALAR, "scalar"},
+		{AUDIO_MIX_KERNEL_SSE2, "sse2"},
+		{AUDIO_MIX_KERNEL_AVX, "avx"},
+	};
+	struct mix_data data;
+	double bytes = MIX_FRAMES * sizeof(float) * 2.0;
+	char name[64];
+	int ret = 0;
+
+	data.dst = bmalloc(MIX_FRAMES * sizeof(float));
+	data.src = bmalloc(MIX_FRAMES * sizeof(float));
+	data.mul = bmalloc(MIX_FRAMES * sizeof(float));
+
+	for (size_t i = 0; i < sizeof(kernels) / sizeof(*kernels); i++) {
+		if (!audio_mix_set_kernel(kernels[i].kernel)) {
+			printf("%-40s unsupported on this CPU\n",
+			       kernels[i].name);
+			continue;
+		}
+
+		if (!matches_scalar(&data, kernels[i].kernel)) {
+			printf("%s: result does not match scalar kernel\n",
+			       kernels[i].name);
+			ret = 1;
+		}
+
+		fill(&data);
+
+		snprintf(name, sizeof(name), "audio_mix_add (%s)",
+			 kernels[i].name);
+		bench_print(name, bench_run(run_add, &data, MIX_ITERATIONS),
+			    bytes);
+
+		snprintf(name, sizeof(name), "audio_mix_add_mul (%s)",
+			 kernels[i].name);
+		bench_print(name,
+			    bench_run(run_add_mul, &data, MIX_ITERATIONS),
+			    bytes * 1.5);
+	}
+
+	bfree(data.dst);
+	bfree(data.src);
+	bfree(data.mul);
+	return ret;
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Compares the same-size conversions of media-io/format-conversion.c with
+ * swscale on a 1080p frame, which is what the video scaler used for these
+ * formats before the native paths were added.
+ */
+
+#include <stdlib.h>
+#include <util/bmem.h>
+#include <util/task-pool.h>
+#include <media-io/format-conversion.h>
+#include <libswscale/swscale.h>
+#include "bench.h"
+
+#define FRAME_CX 1920
+#define FRAME_CY 1080
+#define FRAME_ITERATIONS 50
+
+#define BGRA_ROW (FRAME_CX * 4.0)
+#define I420_ROW (FRAME_CX * 1.5)
+
+struct frame_data {
+	uint8_t *bgra;
+	uint8_t *i420[3];
+	uint8_t *nv12[2];
+	uint32_t bgra_linesize;
+	uint32_t i420_linesize[3];
+	uint32_t nv12_linesize[2];
+
+	struct rgb_to_yuv_coeffs coeffs;
+	os_task_pool_t *pool;
+
+	struct SwsContext *sws_bgra;
+	struct SwsContext *sws_i420;
+};
+
+static void run_bgra_native(void *param)
+{
+	struct frame_data *data = param;
+	convert_rgbx_to_nv12(data->bgra, data->bgra_linesize, FRAME_CX, 0,
+			     FRAME_CY, data->nv12, data->nv12_linesize,
+			     &data->coeffs);
+}
+
+static void run_bgra_native_mt(void *param)
+{
+	struct frame_data *data = param;
+	convert_rgbx_to_nv12_mt(data->pool, data->bgra, data->bgra_linesize,
+				FRAME_CX, 0, FRAME_CY, data->nv12,
+				data->nv12_linesize, &data->coeffs);
+}
+
+static void run_bgra_swscale(void *param)
+{
+	struct frame_data *data = param;
+	const uint8_t *src[] = {data->bgra};
+	const int src_linesize[] = {(int)data->bgra_linesize};
+	const int dst_linesize[] = {(int)data->nv12_linesize[0],
+				    (int)data->nv12_linesize[1]};
+
+	sws_scale(data->sws_bgra, src, src_linesize, 0, FRAME_CY, data->nv12,
+		  dst_linesize);
+}
+
+static void run_i420_native(void *param)
+{
+	struct frame_data *data = param;
+	convert_i420_to_nv12((const uint8_t *const *)data->i420,
+			     data->i420_linesize, FRAME_CX, 0, FRAME_CY,
+			     data->nv12, data->nv12_linesize);
+}
+
+static void run_i420_swscale(void *param)
+{
+	struct frame_data *data = param;
+	const int src_linesize[] = {(int)data->i420_linesize[0],
+				    (int)data->i420_linesize[1],
+				    (int)data->i420_linesize[2]};
+	const int dst_linesize[] = {(int)data->nv12_linesize[0],
+				    (int)data->nv12_linesize[1]};
+
+	sws_scale(data->sws_i420, (const uint8_t *const *)data->i420,
+		  src_linesize, 0, FRAME_CY, data->nv12, dst_linesize);
+}
+
+static struct SwsContext *create_sws(enum AVPixelFormat src_format)
+{
+	struct SwsContext *sws = sws_getContext(FRAME_CX, FRAME_CY, src_format,
+						FRAME_CX, FRAME_CY,
+						AV_PIX_FMT_NV12, SWS_POINT,
+						NULL, NULL, NULL);
+	if (!sws)
+		return NULL;
+
+	/* match the BT.709 partial range coefficients used natively */
+	const int *coeffs = sws_getCoefficients(SWS_CS_ITU709);
+	sws_setColorspaceDetails(sws, coeffs, 1, coeffs, 0, 0, 1 << 16,
+				 1 << 16);
+	return sws;
+}
+
+static void fill(uint8_t *ptr, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		ptr[i] = (uint8_t)rand();
+}
+
+int main(void)
+{
+	static const struct {
+		bench_func_t func;
+		const char *name;
+		double bytes;
+	} cases[] = {
+		{run_bgra_native, "bgra -> nv12 (native)", BGRA_ROW},
+		{run_bgra_native_mt, "bgra -> nv12 (native mt)", BGRA_ROW},
+		{run_bgra_swscale, "bgra -> nv12 (swscale)", BGRA_ROW},
+		{run_i420_native, "i420 -> nv12 (native)", I420_ROW},
+		{run_i420_swscale, "i420 -> nv12 (swscale)", I420_ROW},
+	};
+	struct frame_data data;
+	int ret = 0;
+
+	data.bgra_linesize = FRAME_CX * 4;
+	data.i420_linesize[0] = FRAME_CX;
+	data.i420_linesize[1] = FRAME_CX / 2;
+	data.i420_linesize[2] = FRAME_CX / 2;
+	data.nv12_linesize[0] = FRAME_CX;
+	data.nv12_linesize[1] = FRAME_CX;
+
+	data.bgra = bmalloc(data.bgra_linesize * FRAME_CY);
+	data.i420[0] = bmalloc(FRAME_CX * FRAME_CY);
+	data.i420[1] = bmalloc(FRAME_CX * FRAME_CY / 4);
+	data.i420[2] = bmalloc(FRAME_CX * FRAME_CY / 4);
+	data.nv12[0] = bmalloc(FRAME_CX * FRAME_CY);
+	data.nv12[1] = bmalloc(FRAME_CX * FRAME_CY / 2);
+
+	fill(data.bgra, data.bgra_linesize * FRAME_CY);
+	fill(data.i420[0], FRAME_CX * FRAME_CY);
+	fill(data.i420[1], FRAME_CX * FRAME_CY / 4);
+	fill(data.i420[2], FRAME_CX * FRAME_CY / 4);
+
+	rgb_to_yuv_coeffs_init(&data.coeffs, VIDEO_FORMAT_BGRA, VIDEO_CS_709,
+			       VIDEO_RANGE_PARTIAL);
+	data.pool = os_task_pool_create("bench-format-conversion",
+					 (size_t)os_get_logical_cores());
+	data.sws_bgra = create_sws(AV_PIX_FMT_BGRA);
+	data.sws_i420 = create_sws(AV_PIX_FMT_YUV420P);
+
+	if (!data.sws_bgra || !data.sws_i420) {
+		printf("failed to create swscale contexts\n");
+		ret = 1;
+		goto fail;
+	}
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		double ns = bench_run(cases[i].func, &data, FRAME_ITERATIONS);
+		bench_print(cases[i].name, ns, cases[i].bytes * FRAME_CY);
+	}
+
+fail:
+	sws_freeContext(data.sws_bgra);
+	sws_freeContext(data.sws_i420);
+	os_task_pool_destroy(data.pool);
+	bfree(data.bgra);
+	bfree(data.i420[0]);
+	bfree(data.i420[1]);
+	bfree(data.i420[2]);
+	bfree(data.nv12[0]);
+	bfree(data.nv12[1]);
+	return ret;
+}
@@ -0,0 +1,260 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Replays a packet timeline through the output interleave queues of
+ * obs-interleave.c and through the single sorted array they replaced, and
+ * checks that both send the packets in the same order.
+ *
+ *   A timeline file can be passed as the only argument.  Each line holds one
+ * packet in arrival order: "v <dts_usec>" for video or "a <track> <dts_usec>"
+ * for audio.  Without a file, a timeline of 60 fps video and six audio
+ * tracks is generated, with video arriving half a second after audio of the
+ * same timestamp, as it does with encoder lookahead.
+ */
+
+#include <stdlib.h>
+#include <util/bmem.h>
+#include <util/darray.h>
+#include <obs-interleave.h>
+#include "bench.h"
+
+#define GEN_SECONDS 60
+#define GEN_AUDIO_TRACKS 6
+#define GEN_VIDEO_LAG_USEC 500000
+#define REPLAY_ITERATIONS 10
+
+struct timeline {
+	DARRAY(struct encoder_packet) packets;
+	DARRAY(struct encoder_packet) sent;
+};
+
+/* ------------------------------------------------------------------------- */
+/* timeline input */
+
+static void push_packet(struct timeline *tl, enum obs_encoder_type type,
+			size_t track, int64_t dts_usec)
+{
+	struct encoder_packet packet = {0};
+
+	packet.type = type;
+	packet.track_idx = track;
+	packet.dts_usec = dts_usec;
+	packet.dts = dts_usec;
+	packet.pts = dts_usec;
+	packet.timebase_num = 1;
+	packet.timebase_den = 1000000;
+	packet.keyframe = type == OBS_ENCODER_VIDEO;
+	da_push_back(tl->packets, &packet);
+}
+
+static bool load_timeline(struct timeline *tl, const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+
+	if (!file) {
+		printf("failed to open '%s'\n", path);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		long long dts;
+		unsigned track;
+
+		if (sscanf(line, "v %lld", &dts) == 1)
+			push_packet(tl, OBS_ENCODER_VIDEO, 0, dts);
+		else if (sscanf(line, "a %u %lld", &track, &dts) == 2 &&
+			 track < MAX_AUDIO_MIXES)
+			push_packet(tl, OBS_ENCODER_AUDIO, track, dts);
+	}
+
+	fclose(file);
+	return tl->packets.num > 0;
+}
+
+static void generate_timeline(struct timeline *tl)
+{
+	const int64_t video_step = 1000000 / 60;
+	const double audio_step = 1024.0 * 1000000.0 / 48000.0;
+	const int64_t end = GEN_SECONDS * 1000000LL;
+	int64_t video_ts = 0;
+	size_t audio_packet = 0;
+
+	/* packets are pushed in order of arrival */
+	for (;;) {
+		int64_t audio_ts = (int64_t)(audio_packet * audio_step);
+		bool video_next = video_ts + GEN_VIDEO_LAG_USEC <= audio_ts;
+
+		if (video_ts >= end && audio_ts >= end)
+			break;
+
+		if (video_next || audio_ts >= end) {
+			push_packet(tl, OBS_ENCODER_VIDEO, 0, video_ts);
+			video_ts += video_step;
+		} else {
+			for (size_t i = 0; i < GEN_AUDIO_TRACKS; i++)
+				push_packet(tl, OBS_ENCODER_AUDIO, i,
+					    audio_ts);
+			audio_packet++;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* same gating as send_interleaved in obs-output.c */
+
+struct send_state {
+	int64_t highest_video_ts;
+	int64_t highest_audio_ts;
+};
+
+static inline void set_higher_ts(struct send_state *state,
+				 const struct encoder_packet *packet)
+{
+	int64_t *ts = packet->type == OBS_ENCODER_VIDEO
+			      ? &state->highest_video_ts
+			      : &state->highest_audio_ts;
+	if (*ts < packet->dts_usec)
+		*ts = packet->dts_usec;
+}
+
+static inline bool can_send(const struct send_state *state,
+			    const struct encoder_packet *packet)
+{
+	return packet->type == OBS_ENCODER_VIDEO
+		       ? state->highest_audio_ts > packet->dts_usec
+		       : state->highest_video_ts > packet->dts_usec;
+}
+
+static void replay_queues(void *param)
+{
+	struct timeline *tl = param;
+	struct interleave_queues iq = {0};
+	struct send_state state = {-1, -1};
+
+	da_resize(tl->sent, 0);
+
+	for (size_t i = 0; i < tl->packets.num; i++) {
+		struct encoder_packet *first;
+
+		interleave_insert(&iq, tl->packets.array + i);
+		set_higher_ts(&state, tl->packets.array + i);
+
+		first = interleave_first(&iq);
+		if (first && can_send(&state, first)) {
+			da_push_back(tl->sent, first);
+			interleave_pop(&iq);
+		}
+	}
+
+	for (size_t i = 0; i < MAX_INTERLEAVE_QUEUES; i++)
+		da_free(iq.queues[i].packets);
+}
+
+/* the single array with a linear insert that the queues replaced */
+static void replay_sorted_array(void *param)
+{
+	struct timeline *tl = param;
+	DARRAY(struct encoder_packet) packets = {0};
+	struct send_state state = {-1, -1};
+
+	da_resize(tl->sent, 0);
+
+	for (size_t i = 0; i < tl->packets.num; i++) {
+		struct encoder_packet *out = tl->packets.array + i;
+		size_t idx;
+
+		for (idx = 0; idx < packets.num; idx++) {
+			struct encoder_packet *cur = packets.array + idx;
+
+			if (out->dts_usec == cur->dts_usec &&
+			    out->type == OBS_ENCODER_VIDEO)
+				break;
+			else if (out->dts_usec < cur->dts_usec)
+				break;
+		}
+
+		da_insert(packets, idx, out);
+		set_higher_ts(&state, out);
+
+		if (can_send(&state, packets.array)) {
+			da_push_back(tl->sent, packets.array);
+			da_erase(packets, 0);
+		}
+	}
+
+	da_free(packets);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* audio packets of different tracks with the same timestamp may be sent in
+ * a different order, so only the type and timestamp are compared */
+static bool same_order(const struct encoder_packet *a, size_t num_a,
+		       const struct encoder_packet *b, size_t num_b)
+{
+	if (num_a != num_b)
+		return false;
+
+	for (size_t i = 0; i < num_a; i++) {
+		if (a[i].type != b[i].type || a[i].dts_usec != b[i].dts_usec)
+			return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	struct timeline tl = {0};
+	DARRAY(struct encoder_packet) expected = {0};
+	double ns;
+	int ret = 0;
+
+	if (argc > 1) {
+		if (!load_timeline(&tl, argv[1]))
+			return 1;
+	} else {
+		generate_timeline(&tl);
+	}
+
+	printf("%zu packets\n", tl.packets.num);
+
+	replay_sorted_array(&tl);
+	da_copy(expected, tl.sent);
+	replay_queues(&tl);
+
+	if (!same_order(expected.array, expected.num, tl.sent.array,
+			tl.sent.num)) {
+		printf("interleave queues send a different order\n");
+		ret = 1;
+	}
+
+	ns = bench_run(replay_sorted_array, &tl, REPLAY_ITERATIONS);
+	bench_print("replay (sorted array)", ns, 0.0);
+	printf("%-40s %12.1f ns/packet\n", "", ns / (double)tl.packets.num);
+
+	ns = bench_run(replay_queues, &tl, REPLAY_ITERATIONS);
+	bench_print("replay (interleave queues)", ns, 0.0);
+	printf("%-40s %12.1f ns/packet\n", "", ns / (double)tl.packets.num);
+
+	da_free(expected);
+	da_free(tl.packets);
+	da_free(tl.sent);
+	return ret;
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Compares the throughput of the two ways packets are handed to the
+ * obs-ffmpeg-mux process: the stdin pipe, and the shared memory ring of
+ * ffmpeg-mux-ring.h.  A thread plays the muxer and reads packets the way
+ * ffmpeg-mux.c does, then copies them once more in place of the copy
+ * av_interleaved_write_frame makes.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <util/bmem.h>
+#include <util/threading.h>
+#include "ffmpeg-mux/ffmpeg-mux.h"
+#include "ffmpeg-mux/ffmpeg-mux-ring.h"
+#include "bench.h"
+
+#define TRANSFER_SIZE (512 * 1024 * 1024)
+#define RING_NAME "/obs-bench-mux-transport"
+
+struct transport {
+	size_t packet_size;
+	uint8_t *packet;
+	uint8_t *mux_buf;
+
+	int pipe_fds[2];
+	struct ffm_ring producer;
+	struct ffm_ring consumer;
+	bool consumer_open;
+};
+
+static bool read_all(int fd, void *vdata, size_t size)
+{
+	uint8_t *data = vdata;
+
+	while (size) {
+		ssize_t ret = read(fd, data, size);
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		size -= (size_t)ret;
+	}
+
+	return true;
+}
+
+static bool write_all(int fd, const void *vdata, size_t size)
+{
+	const uint8_t *data = vdata;
+
+	while (size) {
+		ssize_t ret = write(fd, data, size);
+		if (ret <= 0)
+			return false;
+
+		data += ret;
+		size -= (size_t)ret;
+	}
+
+	return true;
+}
+
+static inline size_t packet_count(struct transport *tr)
+{
+	return TRANSFER_SIZE / tr->packet_size;
+}
+
+static inline void init_info(struct transport *tr, size_t i,
+			     struct ffm_packet_info *info)
+{
+	info->pts = (int64_t)i;
+	info->dts = (int64_t)i;
+	info->size = (uint32_t)tr->packet_size;
+	info->index = 0;
+	info->type = FFM_PACKET_VIDEO;
+	info->keyframe = false;
+}
+
+/* ------------------------------------------------------------------------- */
+/* pipe */
+
+static void *pipe_consumer(void *param)
+{
+	struct transport *tr = param;
+	struct ffm_packet_info info;
+	uint8_t *buf = bmalloc(tr->packet_size);
+
+	while (read_all(tr->pipe_fds[0], &info, sizeof(info))) {
+		if (!read_all(tr->pipe_fds[0], buf, info.size))
+			break;
+		memcpy(tr->mux_buf, buf, info.size);
+	}
+
+	bfree(buf);
+	return NULL;
+}
+
+static void run_pipe(void *param)
+{
+	struct transport *tr = param;
+	size_t count = packet_count(tr);
+	pthread_t thread;
+
+	if (pipe(tr->pipe_fds) != 0)
+		return;
+
+	pthread_create(&thread, NULL, pipe_consumer, tr);
+
+	for (size_t i = 0; i < count; i++) {
+		struct ffm_packet_info info;
+
+		init_info(tr, i, &info);
+		if (!write_all(tr->pipe_fds[1], &info, sizeof(info)) ||
+		    !write_all(tr->pipe_fds[1], tr->packet, tr->packet_size))
+			break;
+	}
+
+	close(tr->pipe_fds[1]);
+	pthread_join(thread, NULL);
+	close(tr->pipe_fds[0]);
+}
+
+/* ------------------------------------------------------------------------- */
+/* shared memory ring */
+
+/* same as ffmpeg_mux_read_ring */
+static void *ring_consumer(void *param)
+{
+	struct transport *tr = param;
+	struct ffm_ring *ring = &tr->consumer;
+	struct ffm_packet_info info;
+	uint8_t *buf = bmalloc(tr->packet_size);
+
+	while (ffm_ring_read(ring, &info, sizeof(info))) {
+		const uint8_t *data = ffm_ring_peek(ring, info.size);
+
+		if (data) {
+			memcpy(tr->mux_buf, data, info.size);
+			ffm_ring_advance(ring, info.size);
+			continue;
+		}
+
+		if (!ffm_ring_read(ring, buf, info.size))
+			break;
+		memcpy(tr->mux_buf, buf, info.size);
+	}
+
+	bfree(buf);
+	return NULL;
+}
+
+static void run_ring(void *param)
+{
+	struct transport *tr = param;
+	size_t count = packet_count(tr);
+	pthread_t thread;
+
+	shm_unlink(RING_NAME);
+	if (!ffm_ring_create(&tr->producer, RING_NAME, FFM_RING_DEFAULT_SIZE))
+		return;
+	tr->consumer_open = ffm_ring_open(&tr->consumer, RING_NAME);
+	if (!tr->consumer_open) {
+		ffm_ring_free(&tr->producer);
+		return;
+	}
+
+	pthread_create(&thread, NULL, ring_consumer, tr);
+
+	for (size_t i = 0; i < count; i++) {
+		struct ffm_packet_info info;
+
+		init_info(tr, i, &info);
+		if (!ffm_ring_write(&tr->producer, &info, sizeof(info)) ||
+		    !ffm_ring_write(&tr->producer, tr->packet, tr->packet_size))
+			break;
+	}
+
+	ffm_ring_close(&tr->producer);
+	pthread_join(thread, NULL);
+
+	ffm_ring_free(&tr->consumer);
+	ffm_ring_free(&tr->producer);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void bench_packet_size(const char *name, size_t packet_size)
+{
+	struct transport tr = {0};
+	double bytes = (double)(TRANSFER_SIZE / packet_size * packet_size);
+	char case_name[64];
+	double ns;
+
+	tr.packet_size = packet_size;
+	tr.packet = bmalloc(packet_size);
+	tr.mux_buf = bmalloc(packet_size);
+	memset(tr.packet, 0xAB, packet_size);
+
+	snprintf(case_name, sizeof(case_name), "%s, pipe", name);
+	ns = bench_run(run_pipe, &tr, 1);
+	bench_print(case_name, ns, bytes);
+
+	snprintf(case_name, sizeof(case_name), "%s, shared memory ring", name);
+	ns = bench_run(run_ring, &tr, 1);
+	bench_print(case_name, ns, bytes);
+
+	bfree(tr.packet);
+	bfree(tr.mux_buf);
+}
+
+int main(void)
+{
+	/* 100 Mbps and roughly 1 Gbps at 60 fps */
+	bench_packet_size("208 KiB packets", 208 * 1024);
+	bench_packet_size("2 MiB packets", 2 * 1024 * 1024);
+	return 0;
+}
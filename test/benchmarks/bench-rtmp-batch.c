@@ -0,0 +1,203 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Compares sending RTMP packets one at a time (muxing each flv tag and
+ * writing it with RTMP_Write, which sends every chunk on its own) with
+ * batching them into a single sendmsg call through RTMP_BatchPacket and
+ * RTMP_BatchFlush, as rtmp-stream does.  The packets are written to a local
+ * socket that a second thread drains.  The number of send calls per round
+ * is counted once through a custom send function, with which a batch is
+ * sent as one buffer just like it is with sendmsg.
+ */
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <util/bmem.h>
+#include <util/threading.h>
+#include "librtmp/rtmp.h"
+#include "flv-mux.h"
+#include "bench.h"
+
+/* about 16 ms of a 6000 kbps, 60 fps stream with one audio track */
+#define VIDEO_PACKET_SIZE 12500
+#define AUDIO_PACKET_SIZE 427
+#define PACKETS_PER_ROUND 4
+#define CHUNK_SIZE 4096
+#define ROUND_ITERATIONS 2000
+
+struct batch_data {
+	RTMP rtmp;
+	RTMPBatch batch;
+	struct encoder_packet packets[PACKETS_PER_ROUND];
+	int64_t dts;
+
+	int fds[2];
+	pthread_t drain_thread;
+	volatile bool stop;
+};
+
+static void *drain_thread(void *param)
+{
+	struct batch_data *data = param;
+	char buf[65536];
+
+	while (!data->stop && read(data->fds[1], buf, sizeof(buf)) > 0)
+		;
+	return NULL;
+}
+
+static void init_packets(struct batch_data *data)
+{
+	for (size_t i = 0; i < PACKETS_PER_ROUND; i++) {
+		struct encoder_packet *packet = &data->packets[i];
+		bool video = (i % 2) == 0;
+
+		packet->type = video ? OBS_ENCODER_VIDEO : OBS_ENCODER_AUDIO;
+		packet->size = video ? VIDEO_PACKET_SIZE : AUDIO_PACKET_SIZE;
+		packet->data = bzalloc(packet->size);
+		packet->timebase_num = 1;
+		packet->timebase_den = 1000;
+		packet->keyframe = false;
+	}
+}
+
+/* each round sends the same packets with increasing timestamps */
+static inline void next_timestamps(struct batch_data *data)
+{
+	data->dts += 8;
+	for (size_t i = 0; i < PACKETS_PER_ROUND; i++) {
+		data->packets[i].dts = data->dts + (int64_t)i;
+		data->packets[i].pts = data->packets[i].dts;
+	}
+}
+
+static void run_per_packet(void *param)
+{
+	struct batch_data *data = param;
+
+	next_timestamps(data);
+
+	for (size_t i = 0; i < PACKETS_PER_ROUND; i++) {
+		uint8_t *tag;
+		size_t size;
+
+		flv_packet_mux(&data->packets[i], 0, &tag, &size, false);
+		RTMP_Write(&data->rtmp, (char *)tag, (int)size, 0);
+		bfree(tag);
+	}
+}
+
+static void run_batched(void *param)
+{
+	struct batch_data *data = param;
+	uint8_t prefix[FLV_PACKET_PREFIX_MAX_SIZE];
+
+	next_timestamps(data);
+
+	for (size_t i = 0; i < PACKETS_PER_ROUND; i++) {
+		struct encoder_packet *packet = &data->packets[i];
+		RTMPPacket rtmp_packet = {0};
+		uint32_t timestamp;
+		size_t prefix_size;
+
+		prefix_size = flv_packet_prefix(packet, 0, prefix, &timestamp,
+						false);
+
+		rtmp_packet.m_packetType = packet->type == OBS_ENCODER_VIDEO
+						   ? RTMP_PACKET_TYPE_VIDEO
+						   : RTMP_PACKET_TYPE_AUDIO;
+		rtmp_packet.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+		rtmp_packet.m_nChannel = 0x04;
+		rtmp_packet.m_nTimeStamp = timestamp;
+		rtmp_packet.m_nInfoField2 = data->rtmp.Link.streams[0].id;
+
+		RTMP_BatchPacket(&data->rtmp, &data->batch, &rtmp_packet,
+				 (char *)prefix, (int)prefix_size,
+				 (char *)packet->data, (int)packet->size);
+	}
+
+	RTMP_BatchFlush(&data->rtmp, &data->batch);
+}
+
+static volatile long send_calls = 0;
+
+static int counting_send(RTMPSockBuf *sb, const char *buf, int len,
+			 void *param)
+{
+	UNUSED_PARAMETER(param);
+	os_atomic_inc_long(&send_calls);
+	return (int)send(sb->sb_socket, buf, len, 0);
+}
+
+static void print_send_calls(const char *name, bench_func_t func,
+			     struct batch_data *data)
+{
+	long calls;
+
+	os_atomic_set_long(&send_calls, 0);
+	data->rtmp.m_bCustomSend = true;
+	func(data);
+	data->rtmp.m_bCustomSend = false;
+	calls = os_atomic_load_long(&send_calls);
+
+	printf("%-40s %12ld send calls/round\n", name, calls);
+}
+
+int main(void)
+{
+	struct batch_data data = {0};
+	double bytes = (VIDEO_PACKET_SIZE + AUDIO_PACKET_SIZE) *
+		       (PACKETS_PER_ROUND / 2.0);
+	double ns;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, data.fds) != 0) {
+		printf("failed to create socket pair\n");
+		return 1;
+	}
+
+	RTMP_Init(&data.rtmp);
+	data.rtmp.m_sb.sb_socket = data.fds[0];
+	data.rtmp.m_outChunkSize = CHUNK_SIZE;
+	data.rtmp.Link.nStreams = 1;
+	data.rtmp.Link.streams[0].id = 1;
+	data.rtmp.m_customSendFunc = counting_send;
+	RTMP_BatchReset(&data.batch);
+
+	init_packets(&data);
+	pthread_create(&data.drain_thread, NULL, drain_thread, &data);
+
+	print_send_calls("per packet", run_per_packet, &data);
+	print_send_calls("batched", run_batched, &data);
+
+	ns = bench_run(run_per_packet, &data, ROUND_ITERATIONS);
+	bench_print("per packet (RTMP_Write)", ns, bytes);
+
+	ns = bench_run(run_batched, &data, ROUND_ITERATIONS);
+	bench_print("batched (sendmsg)", ns, bytes);
+
+	data.stop = true;
+	shutdown(data.fds[0], SHUT_RDWR);
+	pthread_join(data.drain_thread, NULL);
+	close(data.fds[0]);
+	close(data.fds[1]);
+
+	for (size_t i = 0; i < PACKETS_PER_ROUND; i++)
+		bfree(data.packets[i].data);
+	return 0;
+}
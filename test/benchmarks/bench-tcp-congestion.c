@@ -0,0 +1,393 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ *   Measures how quickly dynamic bitrate recovers when the link bandwidth
+ * drops, with the tcp congestion probe of tcp-congestion.c and with only the
+ * local queue trigger that rtmp-stream used before it.
+ *
+ *   A stream is sent over loopback tcp to an in-process relay that reads at a
+ * throttled rate.  The sender produces 60 fps frames at the current bitrate
+ * into a local queue and writes them to the socket without blocking, as the
+ * send thread does.  After a few seconds the relay rate drops below the
+ * stream bitrate.  Whenever congestion is detected the bitrate is lowered to
+ * the estimate, and the stream counts as recovered once the local queue has
+ * stayed below one frame for a second.  All times are measured from the
+ * bandwidth drop.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <util/circlebuf.h>
+#include <util/threading.h>
+#include "tcp-congestion.h"
+#include "bench.h"
+
+#define VIDEO_BITRATE 6000
+#define AUDIO_BITRATE 160
+#define LINK_RATE_BEFORE 10000
+#define LINK_RATE_AFTER 3000
+#define FPS 60
+
+#define DROP_AFTER_NS (3ULL * 1000000000ULL)
+#define TIMEOUT_NS (15ULL * 1000000000ULL)
+#define RELAY_RCVBUF 65536
+
+/* same trigger and estimate window as the queue based path of
+ * rtmp-stream.c */
+#define QUEUE_TRIGGER_NS 200000000ULL
+#define RATE_WINDOW_SAMPLES 10
+#define RATE_SAMPLE_NS 100000000ULL
+#define RATE_WINDOW_NS (RATE_WINDOW_SAMPLES * RATE_SAMPLE_NS)
+
+#define RECOVERED_NS 1000000000ULL
+
+/* ------------------------------------------------------------------------- */
+/* throttled relay */
+
+struct relay {
+	int listen_fd;
+	int fd;
+	pthread_t thread;
+	volatile long rate;
+	volatile bool stop;
+};
+
+static void *relay_thread(void *param)
+{
+	struct relay *relay = param;
+	uint64_t start = os_gettime_ns();
+	uint64_t allowed_ts = start;
+	double credit = 0.0;
+	char buf[16384];
+
+	relay->fd = accept(relay->listen_fd, NULL, NULL);
+	if (relay->fd < 0)
+		return NULL;
+
+	while (!relay->stop) {
+		uint64_t ts = os_gettime_ns();
+		double bytes_per_ns = (double)relay->rate * 1000.0 / 8.0 / 1e9;
+		ssize_t size;
+
+		credit += (double)(ts - allowed_ts) * bytes_per_ns;
+		allowed_ts = ts;
+		if (credit > sizeof(buf))
+			credit = sizeof(buf);
+
+		if (credit < 1460.0) {
+			os_sleep_ms(1);
+			continue;
+		}
+
+		size = recv(relay->fd, buf, (size_t)credit, MSG_DONTWAIT);
+		if (size > 0)
+			credit -= (double)size;
+		else if (size == 0)
+			break;
+		else
+			os_sleep_ms(1);
+	}
+
+	return NULL;
+}
+
+static int relay_start(struct relay *relay, long rate)
+{
+	struct sockaddr_in addr = {0};
+	socklen_t len = sizeof(addr);
+	int rcvbuf = RELAY_RCVBUF;
+	int fd;
+
+	relay->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	relay->rate = rate;
+	relay->stop = false;
+
+	/* a small receive buffer keeps the backlog on the sending side, like
+	 * a slow link does */
+	setsockopt(relay->listen_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf,
+		   sizeof(rcvbuf));
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(relay->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(relay->listen_fd, 1) ||
+	    getsockname(relay->listen_fd, (struct sockaddr *)&addr, &len))
+		return -1;
+
+	pthread_create(&relay->thread, NULL, relay_thread, relay);
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static void relay_stop(struct relay *relay, int fd)
+{
+	relay->stop = true;
+	shutdown(fd, SHUT_RDWR);
+	close(fd);
+	pthread_join(relay->thread, NULL);
+	if (relay->fd >= 0)
+		close(relay->fd);
+	close(relay->listen_fd);
+}
+
+/* ------------------------------------------------------------------------- */
+/* sender */
+
+struct frame {
+	uint64_t ts;
+	size_t size;
+};
+
+struct sender {
+	int fd;
+	struct circlebuf frames;
+	size_t front_sent;
+	uint64_t bytes_sent;
+	long bitrate;
+
+	uint64_t rate_samples[RATE_WINDOW_SAMPLES];
+	size_t rate_sample_idx;
+	uint64_t rate_sample_ts;
+	uint64_t rate_valid_ts;
+};
+
+struct result {
+	uint64_t detect_ns;
+	uint64_t recover_ns;
+	uint64_t max_queue_ns;
+	long lowered_to;
+	int times_lowered;
+};
+
+static const char zeroes[65536];
+
+static void push_frame(struct sender *sender, uint64_t ts)
+{
+	struct frame frame;
+
+	frame.ts = ts;
+	frame.size = (size_t)((sender->bitrate + AUDIO_BITRATE) * 1000 / 8 /
+			      FPS);
+	circlebuf_push_back(&sender->frames, &frame, sizeof(frame));
+}
+
+static void send_frames(struct sender *sender)
+{
+	while (sender->frames.size) {
+		struct frame *frame = circlebuf_data(&sender->frames, 0);
+		size_t left = frame->size - sender->front_sent;
+		ssize_t size;
+
+		if (left > sizeof(zeroes))
+			left = sizeof(zeroes);
+
+		size = send(sender->fd, zeroes, left,
+			    MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (size <= 0)
+			break;
+
+		sender->bytes_sent += (uint64_t)size;
+		sender->front_sent += (size_t)size;
+
+		if (sender->front_sent == frame->size) {
+			circlebuf_pop_front(&sender->frames, NULL,
+					    sizeof(*frame));
+			sender->front_sent = 0;
+		}
+	}
+}
+
+static inline uint64_t queue_duration(struct sender *sender, uint64_t ts)
+{
+	struct frame *frame;
+
+	if (!sender->frames.size)
+		return 0;
+
+	frame = circlebuf_data(&sender->frames, 0);
+	return ts - frame->ts;
+}
+
+/* the send rate over the last second, as the dbr_frames average is */
+static long send_rate(struct sender *sender, uint64_t ts)
+{
+	size_t oldest = (sender->rate_sample_idx + 1) % RATE_WINDOW_SAMPLES;
+	uint64_t bytes;
+
+	if (ts - sender->rate_sample_ts >= RATE_SAMPLE_NS) {
+		sender->rate_sample_idx = oldest;
+		sender->rate_samples[oldest] = sender->bytes_sent;
+		sender->rate_sample_ts = ts;
+		oldest = (oldest + 1) % RATE_WINDOW_SAMPLES;
+	}
+
+	bytes = sender->bytes_sent - sender->rate_samples[oldest];
+	return (long)(bytes * 8 / (RATE_WINDOW_NS / 1000000ULL));
+}
+
+static long next_bitrate(bool use_tcp_probe, struct tcp_congestion *tc,
+			 struct sender *sender, uint64_t ts, uint64_t queue_ns)
+{
+	long rate = send_rate(sender, ts);
+
+	/* as in dbr_bitrate_lowered, the flag is consumed by lowering */
+	if (use_tcp_probe &&
+	    tcp_congestion_probe(tc, sender->fd, sender->bytes_sent,
+				 sender->bitrate, AUDIO_BITRATE)) {
+		tc->congested = false;
+		return tc->est_bitrate;
+	}
+
+	if (queue_ns >= QUEUE_TRIGGER_NS && ts >= sender->rate_valid_ts)
+		return rate - AUDIO_BITRATE;
+
+	return 0;
+}
+
+static bool run_scenario(bool use_tcp_probe, struct result *result)
+{
+	struct relay relay = {0};
+	struct sender sender = {0};
+	struct tcp_congestion tc;
+	uint64_t start, drop_ts, next_frame;
+	uint64_t empty_since = 0;
+
+	memset(result, 0, sizeof(*result));
+	tcp_congestion_reset(&tc);
+
+	sender.bitrate = VIDEO_BITRATE;
+	sender.fd = relay_start(&relay, LINK_RATE_BEFORE);
+	if (sender.fd < 0) {
+		printf("failed to start relay\n");
+		return false;
+	}
+
+	if (use_tcp_probe)
+		tcp_congestion_set_notsent_lowat(sender.fd,
+						 VIDEO_BITRATE + AUDIO_BITRATE);
+
+	start = os_gettime_ns();
+	drop_ts = start + DROP_AFTER_NS;
+	next_frame = start;
+
+	for (;;) {
+		uint64_t ts = os_gettime_ns();
+		uint64_t queue_ns;
+		long new_bitrate;
+
+		if (ts >= drop_ts && relay.rate == LINK_RATE_BEFORE)
+			relay.rate = LINK_RATE_AFTER;
+		if (ts - start >= TIMEOUT_NS)
+			break;
+
+		while (next_frame <= ts) {
+			push_frame(&sender, next_frame);
+			next_frame += 1000000000ULL / FPS;
+		}
+
+		send_frames(&sender);
+		queue_ns = queue_duration(&sender, ts);
+		new_bitrate = next_bitrate(use_tcp_probe, &tc, &sender, ts,
+					   queue_ns);
+
+		if (ts < drop_ts) {
+			os_sleep_ms(1);
+			continue;
+		}
+
+		if (queue_ns > result->max_queue_ns)
+			result->max_queue_ns = queue_ns;
+
+		new_bitrate = new_bitrate / 100 * 100;
+		if (new_bitrate > 0 && new_bitrate < sender.bitrate) {
+			sender.bitrate = new_bitrate;
+			sender.rate_valid_ts = ts + RATE_WINDOW_NS;
+			result->lowered_to = new_bitrate;
+			if (!result->times_lowered++)
+				result->detect_ns = ts - drop_ts;
+			empty_since = 0;
+		}
+
+		/* recovered once the queue stays below a frame for a while */
+		if (!result->times_lowered || queue_ns > 1000000000ULL / FPS) {
+			empty_since = 0;
+		} else if (!empty_since) {
+			empty_since = ts;
+		} else if (ts - empty_since >= RECOVERED_NS) {
+			result->recover_ns = empty_since - drop_ts;
+			break;
+		}
+
+		os_sleep_ms(1);
+	}
+
+	relay_stop(&relay, sender.fd);
+	circlebuf_free(&sender.frames);
+	return true;
+}
+
+static void print_result(const char *name, const struct result *result)
+{
+	printf("%s\n", name);
+	if (result->detect_ns)
+		printf("  %-30s %10.0f ms\n", "congestion detected after",
+		       (double)result->detect_ns / 1e6);
+	else
+		printf("  %-30s %10s\n", "congestion detected after",
+		       "never");
+
+	if (result->recover_ns)
+		printf("  %-30s %10.0f ms\n", "recovered after",
+		       (double)result->recover_ns / 1e6);
+	else
+		printf("  %-30s %10s\n", "recovered after", "never");
+
+	printf("  %-30s %10ld kbps (%d steps)\n", "bitrate lowered to",
+	       result->lowered_to, result->times_lowered);
+	printf("  %-30s %10.0f ms\n", "largest queue",
+	       (double)result->max_queue_ns / 1e6);
+}
+
+int main(void)
+{
+	struct result result;
+
+	printf("stream %d + %d kbps, link drops from %d to %d kbps\n",
+	       VIDEO_BITRATE, AUDIO_BITRATE, LINK_RATE_BEFORE,
+	       LINK_RATE_AFTER);
+
+	if (!run_scenario(false, &result))
+		return 1;
+	print_result("local queue trigger", &result);
+
+	if (!run_scenario(true, &result))
+		return 1;
+	print_result("tcp congestion probe", &result);
+
+	return 0;
+}
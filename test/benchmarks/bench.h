@@ -0,0 +1,62 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/*
+ *   Minimal timing helpers shared by the benchmarks in this directory.  Each
+ * benchmark is a standalone executable that prints one line per case with
+ * the best time per iteration out of BENCH_RUNS runs.
+ */
+
+#include <stdio.h>
+#include <util/platform.h>
+
+#define BENCH_RUNS 5
+
+typedef void (*bench_func_t)(void *param);
+
+static inline double bench_run(bench_func_t func, void *param,
+			       unsigned iterations)
+{
+	double best = 0.0;
+
+	/* warm up caches and lazily initialized state */
+	func(param);
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		uint64_t start = os_gettime_ns();
+		for (unsigned i = 0; i < iterations; i++)
+			func(param);
+		double ns = (double)(os_gettime_ns() - start) / iterations;
+
+		if (run == 0 || ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+static inline void bench_print(const char *name, double ns_per_iter,
+			       double bytes_per_iter)
+{
+	if (bytes_per_iter > 0.0)
+		printf("%-40s %12.1f ns/iter %10.2f MB/s\n", name, ns_per_iter,
+		       bytes_per_iter / ns_per_iter * 1000.0);
+	else
+		printf("%-40s %12.1f ns/iter\n", name, ns_per_iter);
+}